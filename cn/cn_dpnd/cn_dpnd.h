@@ -32,6 +32,9 @@
 //#define GEN_DSTPORT 0xc117 // UDP dport 6081(0x17c1) for Geneve overlay
 #define VXL_DSTPORT 0xb512 // UDP dport 4789(0x12b5) for VxLAN overlay
 
+/* Source host hint in VxLAN header, keep in-sync with trn_kern.h */
+#define TRN_VXLAN_HINT_FLAG 0x4
+
 #define __ALWAYS_INLINE__ __attribute__((__always_inline__))
 
 /* helper macro to place programs, maps, license in
@@ -167,6 +167,32 @@ static inline void trn_set_src_mac(void *data, unsigned char *src_mac)
 	trn_set_mac(data + 6, src_mac);
 }
 
+/*
+ * Read the source host hint carried in VxLAN reserved bits and clear
+ * them, the kernel VxLAN receive path drops frames with reserved bits set.
+ * Returns 0 if the header carries no hint.
+ */
+__ALWAYS_INLINE__
+static inline int trn_get_vxlan_hint(struct vxlanhdr *vxlan, __be32 *hip)
+{
+	__u8 *ip = (__u8 *)hip;
+
+	if (!(vxlan->rsvd2 & TRN_VXLAN_HINT_FLAG))
+		return 0;
+
+	ip[0] = vxlan->rsvd3[0];
+	ip[1] = vxlan->rsvd3[1];
+	ip[2] = vxlan->rsvd3[2];
+	ip[3] = vxlan->rsvd4;
+
+	vxlan->rsvd2 &= ~TRN_VXLAN_HINT_FLAG;
+	vxlan->rsvd3[0] = 0;
+	vxlan->rsvd3[1] = 0;
+	vxlan->rsvd3[2] = 0;
+	vxlan->rsvd4 = 0;
+	return 1;
+}
+
 static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 {
 	ipv4_flow_t *flow = &pkt->fctx.flow;
@@ -216,38 +242,49 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 	flow->dport = 0;
 	if (flow->protocol != IPPROTO_ICMP) {
 		struct xdp_hints_src *h_src;
-		__u8 offset = sizeof(*h_src);
-
-		__u16 ip_tot_len = bpf_ntohs(pkt->ip->tot_len);
-
-		if (ip_tot_len < 2) {
-			return XDP_DROP;
-		}
-
-		ip_tot_len &= 0xFFF; // Max 4095
-		if ((void *)pkt->data + ip_tot_len + offset + sizeof(struct ethhdr) > pkt->data_end) {
-			bpf_debug("[Dpnd::%d] XXXXX TX: not enough extra space %d.\n",
-					__LINE__, ip_tot_len);
-			return XDP_PASS;  // No extra fields, not relavant to us
-		}
-
-		h_src = (void *)pkt->data + ip_tot_len + sizeof(struct ethhdr);
-	    // signature check
-		if (h_src->flags != 0x5354 || h_src->vni != pkt->vni) {
-			bpf_debug("[Dpnd::%d] XXXXX TX: extra fields not recognized flags: %d -- vni: %d.\n",
-					__LINE__, h_src->flags, h_src->vni);
-			// not something we recognize
-			return XDP_PASS;
+		__be32 hip;
+		unsigned char *hmac;
+
+		if (trn_get_vxlan_hint(pkt->overlay.vxlan, &hip)) {
+			/* Header hint carries no MAC, it's the outer source MAC */
+			hmac = pkt->eth->h_source;
+		} else {
+			__u8 offset = sizeof(*h_src);
+
+			__u16 ip_tot_len = bpf_ntohs(pkt->ip->tot_len);
+
+			if (ip_tot_len < 2) {
+				return XDP_DROP;
+			}
+
+			ip_tot_len &= 0xFFF; // Max 4095
+			if ((void *)pkt->data + ip_tot_len + offset + sizeof(struct ethhdr) > pkt->data_end) {
+				bpf_debug("[Dpnd::%d] XXXXX TX: not enough extra space %d.\n",
+						__LINE__, ip_tot_len);
+				return XDP_PASS;  // No extra fields, not relavant to us
+			}
+
+			h_src = (void *)pkt->data + ip_tot_len + sizeof(struct ethhdr);
+			// signature check
+			if (h_src->flags != 0x5354 || h_src->vni != pkt->vni) {
+				bpf_debug("[Dpnd::%d] XXXXX TX: extra fields not recognized flags: %d -- vni: %d.\n",
+						__LINE__, h_src->flags, h_src->vni);
+				// not something we recognize
+				return XDP_PASS;
+			}
+
+			hip = h_src->saddr;
+			hmac = h_src->h_source;
 		}
 
 		/* Generate Direct Path request */
 		pkt->fctx.opcode = bpf_htonl(XDP_FLOW_OP_ENCAP);
 		pkt->fctx.opdata.encap.dip = pkt->inner_ip->saddr;
 		
-		pkt->fctx.opdata.encap.dhip = h_src->saddr;
+		pkt->fctx.opdata.encap.dhip = hip;
 		
 		trn_set_mac(pkt->fctx.opdata.encap.dmac, pkt->inner_eth->h_source);
-		trn_set_mac(pkt->fctx.opdata.encap.dhmac, h_src->h_source);
+		trn_set_mac(pkt->fctx.opdata.encap.dhmac, hmac);
 
 		pkt->fctx.opdata.encap.timeout = bpf_htons(TRAN_DP_FLOW_TIMEOUT);
 		len = sizeof(struct udphdr) + sizeof(pkt->fctx.opcode) +
@@ -272,7 +309,7 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 
 		bpf_debug("[Dpnd] XXXX : push map dip:0x%x dhip:0x%x,  dhmac:0x%x, \n",
 					bpf_ntohl(pkt->fctx.opdata.encap.dip),
-					bpf_ntohl(h_src->saddr),
+					bpf_ntohl(hip),
 					bpf_ntohl(*(__u32 *)pkt->fctx.opdata.encap.dhmac));
 	
 		ret = bpf_map_push_elem(&local_queue_map, &pkt->fctx, BPF_EXIST);
@@ -0,0 +1,357 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file test_xdp_chain.c
+ *
+ * @brief Transit XDP service chain forwarding test.
+ *
+ * Runs the forwarder transit XDP object through BPF_PROG_TEST_RUN with a
+ * VxLAN packet toward an endpoint the forwarder doesn't know. The DFT of
+ * the interface maps the flow to a chain, the packet must leave Geneve
+ * encapsulated toward the tail FTN of that chain with its inner frame
+ * untouched. Skipped where the object can't be loaded, e.g. unprivileged.
+ *
+ *   test_xdp_chain build/xdp/trn_transit_xdp_fwd_ebpf.o
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+
+#include "bpf/bpf.h"
+#include "bpf/libbpf.h"
+#include "extern/linux/err.h"
+
+#include "trn_datamodel.h"
+
+#define TEST_VXLAN_PORT 4789
+#define TEST_GENEVE_PORT 6081
+#define TEST_DFT_ID 1
+#define TEST_CHAIN_ID 2
+#define TEST_OTHER_CHAIN_ID 3
+#define TEST_TAIL_FTN_ID 4
+#define TEST_OTHER_FTN_ID 5
+#define TEST_VNI 7
+
+struct test_vxlanhdr {
+	__u8 flags;
+	__u8 rsvd1[3];
+	__u8 vni[3];
+	__u8 rsvd2;
+} __attribute__((packed));
+
+struct test_inner_frame {
+	struct ethhdr eth;
+	struct iphdr ip;
+	struct udphdr udp;
+	char payload[16];
+} __attribute__((packed));
+
+struct test_pkt {
+	struct ethhdr eth;
+	struct iphdr ip;
+	struct udphdr udp;
+	struct test_vxlanhdr vxlan;
+	struct test_inner_frame inner;
+} __attribute__((packed));
+
+struct test_obj {
+	const char *path;
+	struct bpf_object *obj;
+	int prog_fd;
+	int inner_fds[2];
+};
+
+static const char *test_obj_path = "xdp/trn_transit_xdp_fwd_ebpf.o";
+
+static const __u8 test_ent_mac[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 0x01 };
+static const __u8 test_tail_mac[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 0x04 };
+static const __u8 test_other_mac[ETH_ALEN] = { 0x02, 0, 0, 0, 0, 0x05 };
+
+static int test_map_fd(struct test_obj *to, const char *name)
+{
+	struct bpf_map *map = bpf_object__find_map_by_name(to->obj, name);
+
+	return map ? bpf_map__fd(map) : -1;
+}
+
+static int test_map_update(struct test_obj *to, const char *name,
+			   const void *key, const void *val)
+{
+	int fd = test_map_fd(to, name);
+
+	if (fd < 0 || bpf_map_update_elem(fd, key, val, 0)) {
+		fprintf(stderr, "Failed to update %s\n", name);
+		return 1;
+	}
+	return 0;
+}
+
+static void test_build_pkt(struct test_pkt *pkt)
+{
+	memset(pkt, 0, sizeof(*pkt));
+
+	memcpy(pkt->eth.h_dest, test_ent_mac, ETH_ALEN);
+	memcpy(pkt->eth.h_source, "\x02\x00\x00\x00\xff\x01", ETH_ALEN);
+	pkt->eth.h_proto = htons(ETH_P_IP);
+
+	pkt->ip.version = 4;
+	pkt->ip.ihl = 5;
+	pkt->ip.ttl = 64;
+	pkt->ip.protocol = IPPROTO_UDP;
+	pkt->ip.tot_len = htons(sizeof(*pkt) - sizeof(pkt->eth));
+	pkt->ip.saddr = htonl(0xc0a80001);
+	pkt->ip.daddr = htonl(0x0a000001);
+
+	pkt->udp.source = htons(50000);
+	pkt->udp.dest = htons(TEST_VXLAN_PORT);
+	pkt->udp.len = htons(sizeof(*pkt) - sizeof(pkt->eth) - sizeof(pkt->ip));
+
+	pkt->vxlan.flags = 0x08;
+	pkt->vxlan.vni[2] = TEST_VNI;
+
+	memcpy(pkt->inner.eth.h_dest, "\x02\x00\x00\x00\xfe\x02", ETH_ALEN);
+	memcpy(pkt->inner.eth.h_source, "\x02\x00\x00\x00\xfe\x01", ETH_ALEN);
+	pkt->inner.eth.h_proto = htons(ETH_P_IP);
+
+	pkt->inner.ip.version = 4;
+	pkt->inner.ip.ihl = 5;
+	pkt->inner.ip.ttl = 64;
+	pkt->inner.ip.protocol = IPPROTO_UDP;
+	pkt->inner.ip.tot_len = htons(sizeof(pkt->inner) - sizeof(pkt->inner.eth));
+	pkt->inner.ip.saddr = htonl(0x0a0a0001);
+	pkt->inner.ip.daddr = htonl(0x0a0a00fe);
+
+	pkt->inner.udp.source = htons(40000);
+	pkt->inner.udp.dest = htons(80);
+	pkt->inner.udp.len = htons(sizeof(pkt->inner.udp) +
+				   sizeof(pkt->inner.payload));
+	memcpy(pkt->inner.payload, "service chain", 13);
+}
+
+/* One forwarder interface on loopback, its DFT maps every flow to a chain */
+static int test_set_chain(struct test_obj *to)
+{
+	static struct dft_t dft;
+	struct tunnel_iface_t itf;
+	struct chain_t chain;
+	struct ftn_t ftn;
+	entrance_key_t entkey;
+	entrance_t ent;
+	__u32 key, iface_index;
+
+	iface_index = if_nametoindex("lo");
+	if (!iface_index)
+		return 1;
+
+	memset(&itf, 0, sizeof(itf));
+	itf.iface_index = iface_index;
+	itf.role = XDP_FWD;
+	itf.protocol = XDP_TUNNEL_VXLAN;
+	itf.num_entrances = 1;
+	itf.dft_id = TEST_DFT_ID;
+	itf.ftn_id = TRAN_UNUSED_FTN_ID;
+	itf.entrances[0].ip = htonl(0x0a000001);
+	memcpy(itf.entrances[0].mac, test_ent_mac, ETH_ALEN);
+	if (test_map_update(to, "if_config_map", &iface_index, &itf))
+		return 1;
+
+	memset(&entkey, 0, sizeof(entkey));
+	entkey.iface_index = iface_index;
+	memcpy(entkey.mac, test_ent_mac, ETH_ALEN);
+	memset(&ent, 0, sizeof(ent));
+	ent.ip = itf.entrances[0].ip;
+	if (test_map_update(to, "entrances_map", &entkey, &ent))
+		return 1;
+
+	memset(&dft, 0, sizeof(dft));
+	dft.table_len = 1;
+	dft.table[0] = TEST_CHAIN_ID;
+	key = TEST_DFT_ID;
+	if (test_map_update(to, "dfts_map", &key, &dft))
+		return 1;
+
+	key = TEST_CHAIN_ID;
+	chain.tail_ftn = TEST_TAIL_FTN_ID;
+	if (test_map_update(to, "chains_map", &key, &chain))
+		return 1;
+
+	key = TEST_OTHER_CHAIN_ID;
+	chain.tail_ftn = TEST_OTHER_FTN_ID;
+	if (test_map_update(to, "chains_map", &key, &chain))
+		return 1;
+
+	memset(&ftn, 0, sizeof(ftn));
+	ftn.position = TRAN_FTN_TYPE_TAIL;
+	ftn.ip = htonl(0x0a000004);
+	memcpy(ftn.mac, test_tail_mac, ETH_ALEN);
+	key = TEST_TAIL_FTN_ID;
+	if (test_map_update(to, "ftns_map", &key, &ftn))
+		return 1;
+
+	ftn.ip = htonl(0x0a000005);
+	memcpy(ftn.mac, test_other_mac, ETH_ALEN);
+	key = TEST_OTHER_FTN_ID;
+	return test_map_update(to, "ftns_map", &key, &ftn);
+}
+
+static int test_open(struct test_obj *to)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts,
+		.map_flags = BPF_F_INNER_MAP,
+	);
+	struct bpf_program *prog, *transit = NULL;
+	struct bpf_map *map;
+
+	/* Inner map templates of the map-in-maps, as transitd sets them */
+	to->inner_fds[0] = bpf_map_create(BPF_MAP_TYPE_ARRAY, NULL,
+					  sizeof(__u32), sizeof(__u32), 1,
+					  &opts);
+	to->inner_fds[1] = bpf_map_create(BPF_MAP_TYPE_DEVMAP, NULL,
+					  sizeof(__u32),
+					  sizeof(struct bpf_devmap_val),
+					  TRAN_MAX_FLOOD, NULL);
+	if (to->inner_fds[0] < 0 || to->inner_fds[1] < 0)
+		return 1;
+
+	to->obj = bpf_object__open_file(to->path, NULL);
+	if (IS_ERR_OR_NULL(to->obj)) {
+		to->obj = NULL;
+		return 1;
+	}
+
+	/* Only the RX program is run, like transitd without spreading */
+	bpf_object__for_each_program(prog, to->obj) {
+		bpf_program__set_type(prog, BPF_PROG_TYPE_XDP);
+		if (!strcmp(bpf_program__name(prog), "_transit"))
+			transit = prog;
+		else
+			bpf_program__set_autoload(prog, false);
+	}
+	if (!transit)
+		return 1;
+
+	map = bpf_object__find_map_by_name(to->obj, "dft_tables_map");
+	if (map && bpf_map__set_inner_map_fd(map, to->inner_fds[0]))
+		return 1;
+	map = bpf_object__find_map_by_name(to->obj, "flood_devmaps_map");
+	if (map && bpf_map__set_inner_map_fd(map, to->inner_fds[1]))
+		return 1;
+
+	if (bpf_object__load(to->obj))
+		return 1;
+	to->prog_fd = bpf_program__fd(transit);
+
+	return test_set_chain(to);
+}
+
+static int groupSetup(void **state)
+{
+	static struct test_obj to;
+	struct rlimit r = { RLIM_INFINITY, RLIM_INFINITY };
+
+	memset(&to, 0, sizeof(to));
+	to.path = test_obj_path;
+	to.inner_fds[0] = to.inner_fds[1] = -1;
+	setrlimit(RLIMIT_MEMLOCK, &r);
+
+	if (test_open(&to)) {
+		fprintf(stderr, "Can't load %s, chain test skipped\n", to.path);
+		bpf_object__close(to.obj);
+		to.obj = NULL;
+	}
+
+	*state = &to;
+	return 0;
+}
+
+static int groupTeardown(void **state)
+{
+	struct test_obj *to = *state;
+
+	bpf_object__close(to->obj);
+	for (int i = 0; i < 2; i++) {
+		if (to->inner_fds[i] >= 0)
+			close(to->inner_fds[i]);
+	}
+	return 0;
+}
+
+static void test_miss_to_chain_tail(void **state)
+{
+	struct test_obj *to = *state;
+	struct test_pkt pkt;
+	__u8 out[sizeof(pkt) + 256];
+	struct ethhdr *eth = (void *)out;
+	struct iphdr *ip = (void *)(eth + 1);
+	struct udphdr *udp = (void *)(ip + 1);
+	__u8 *gnv = (void *)(udp + 1);
+	DECLARE_LIBBPF_OPTS(bpf_test_run_opts, opts,
+		.data_in = &pkt,
+		.data_size_in = sizeof(pkt),
+		.data_out = out,
+		.data_size_out = sizeof(out),
+		.repeat = 1,
+	);
+	__u32 opt_len;
+
+	if (!to->obj)
+		skip();
+
+	test_build_pkt(&pkt);
+	assert_int_equal(bpf_prog_test_run_opts(to->prog_fd, &opts), 0);
+	assert_int_equal(opts.retval, XDP_TX);
+
+	/* Outer headers lead to the tail FTN of the chain the DFT picked */
+	assert_memory_equal(eth->h_dest, test_tail_mac, ETH_ALEN);
+	assert_memory_equal(eth->h_source, test_ent_mac, ETH_ALEN);
+	assert_int_equal(ip->daddr, htonl(0x0a000004));
+	assert_int_equal(ip->saddr, pkt.ip.daddr);
+	assert_int_equal(udp->dest, htons(TEST_GENEVE_PORT));
+	assert_int_equal(udp->source, pkt.udp.source);
+
+	/* Geneve carries the VNI and the inner frame as it came in */
+	opt_len = (gnv[0] & 0x3f) * 4;
+	assert_int_equal(gnv[6], TEST_VNI);
+	assert_int_equal(opts.data_size_out, sizeof(pkt) + opt_len);
+	assert_int_equal(ntohs(ip->tot_len),
+			 opts.data_size_out - sizeof(*eth));
+	assert_memory_equal(gnv + 8 + opt_len, &pkt.inner, sizeof(pkt.inner));
+}
+
+int main(int argc, char *argv[])
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_miss_to_chain_tail),
+	};
+
+	if (argc > 1)
+		test_obj_path = argv[1];
+
+	return cmocka_run_group_tests(tests, groupSetup, groupTeardown);
+}
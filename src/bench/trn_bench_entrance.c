@@ -0,0 +1,317 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_bench_entrance.c
+ *
+ * @brief Microbenchmark of transit XDP entrance matching.
+ *
+ * Runs a transit XDP object through BPF_PROG_TEST_RUN with a droplet
+ * announcing 1, 16 and 128 entrances. The packet is a VxLAN encapsulated
+ * ARP request sent to the MAC of the last entrance, the worst case of a
+ * linear entrance scan, and ends in a drop after the endpoint lookup so
+ * the rest of the path costs the same at every entrance count.
+ *
+ * Pass objects built before and after entrances_map was introduced to
+ * compare both lookups on the same host:
+ *   trn_bench_entrance baseline/trn_transit_xdp_ebpf.o build/xdp/trn_transit_xdp_ebpf.o
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <linux/bpf.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/udp.h>
+
+#include "bpf/bpf.h"
+#include "bpf/libbpf.h"
+#include "extern/linux/err.h"
+
+#include "trn_datamodel.h"
+
+#define BENCH_REPEAT 1000000
+#define BENCH_VXLAN_PORT 4789
+#define BENCH_MAX_OBJS 4
+
+static const __u32 bench_entrances[] = { 1, 16, 128 };
+
+struct bench_vxlanhdr {
+	__u8 flags;
+	__u8 rsvd1[3];
+	__u8 vni[3];
+	__u8 rsvd2;
+} __attribute__((packed));
+
+struct bench_arp {
+	__u16 ar_hrd;
+	__u16 ar_pro;
+	__u8 ar_hln;
+	__u8 ar_pln;
+	__u16 ar_op;
+	__u8 sha[ETH_ALEN];
+	__u32 sip;
+	__u8 tha[ETH_ALEN];
+	__u32 tip;
+} __attribute__((packed));
+
+struct bench_pkt {
+	struct ethhdr eth;
+	struct iphdr ip;
+	struct udphdr udp;
+	struct bench_vxlanhdr vxlan;
+	struct ethhdr inner_eth;
+	struct bench_arp arp;
+} __attribute__((packed));
+
+struct bench_obj {
+	const char *path;
+	struct bpf_object *obj;
+	int prog_fd;
+	int if_config_fd;
+	int entrances_fd;    // -1 for objects scanning entrances linearly
+};
+
+static void bench_entrance_addr(__u32 i, __u32 *ip, __u8 *mac)
+{
+	__u8 entrance_mac[ETH_ALEN] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+	entrance_mac[4] = (__u8)(i >> 8);
+	entrance_mac[5] = (__u8)i;
+	memcpy(mac, entrance_mac, ETH_ALEN);
+	*ip = htonl(0x0a000001 + i);
+}
+
+static void bench_build_pkt(struct bench_pkt *pkt, __u32 num_entrances)
+{
+	__u32 ent_ip;
+	__u8 ent_mac[ETH_ALEN];
+
+	memset(pkt, 0, sizeof(*pkt));
+
+	/* Target the last entrance */
+	bench_entrance_addr(num_entrances - 1, &ent_ip, ent_mac);
+
+	memcpy(pkt->eth.h_dest, ent_mac, ETH_ALEN);
+	memcpy(pkt->eth.h_source, "\x02\x00\x00\x00\xff\x01", ETH_ALEN);
+	pkt->eth.h_proto = htons(ETH_P_IP);
+
+	pkt->ip.version = 4;
+	pkt->ip.ihl = 5;
+	pkt->ip.ttl = 64;
+	pkt->ip.protocol = IPPROTO_UDP;
+	pkt->ip.tot_len = htons(sizeof(*pkt) - sizeof(pkt->eth));
+	pkt->ip.saddr = htonl(0xc0a80001);
+	pkt->ip.daddr = ent_ip;
+
+	pkt->udp.source = htons(50000);
+	pkt->udp.dest = htons(BENCH_VXLAN_PORT);
+	pkt->udp.len = htons(sizeof(*pkt) - sizeof(pkt->eth) - sizeof(pkt->ip));
+
+	pkt->vxlan.flags = 0x08;
+	pkt->vxlan.vni[2] = 1;
+
+	memset(pkt->inner_eth.h_dest, 0xff, ETH_ALEN);
+	memcpy(pkt->inner_eth.h_source, "\x02\x00\x00\x00\xfe\x01", ETH_ALEN);
+	pkt->inner_eth.h_proto = htons(ETH_P_ARP);
+
+	pkt->arp.ar_hrd = htons(1);
+	pkt->arp.ar_pro = htons(ETH_P_IP);
+	pkt->arp.ar_hln = ETH_ALEN;
+	pkt->arp.ar_pln = 4;
+	pkt->arp.ar_op = htons(1);
+	memcpy(pkt->arp.sha, pkt->inner_eth.h_source, ETH_ALEN);
+	pkt->arp.sip = htonl(0x0a0a0001);
+	pkt->arp.tip = htonl(0x0a0a00fe);
+}
+
+static int bench_set_entrances(struct bench_obj *bo, __u32 iface_index,
+			       __u32 num_entrances)
+{
+	struct tunnel_iface_t itf;
+	entrance_key_t entkey;
+	entrance_t ent;
+
+	memset(&itf, 0, sizeof(itf));
+	itf.iface_index = iface_index;
+	itf.role = XDP_FWD;
+	itf.protocol = XDP_TUNNEL_VXLAN;
+	itf.num_entrances = num_entrances;
+
+	for (__u32 i = 0; i < num_entrances; i++) {
+		bench_entrance_addr(i, &itf.entrances[i].ip,
+				    itf.entrances[i].mac);
+
+		if (bo->entrances_fd < 0)
+			continue;
+
+		memset(&entkey, 0, sizeof(entkey));
+		entkey.iface_index = iface_index;
+		memcpy(entkey.mac, itf.entrances[i].mac, ETH_ALEN);
+		memset(&ent, 0, sizeof(ent));
+		ent.ip = itf.entrances[i].ip;
+		ent.idx = i;
+
+		if (bpf_map_update_elem(bo->entrances_fd, &entkey, &ent, 0)) {
+			fprintf(stderr, "Failed to update entrances_map: %s\n",
+				strerror(errno));
+			return 1;
+		}
+	}
+
+	if (bpf_map_update_elem(bo->if_config_fd, &iface_index, &itf, 0)) {
+		fprintf(stderr, "Failed to update if_config_map: %s\n",
+			strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
+
+static int bench_open(struct bench_obj *bo)
+{
+	struct bpf_program *prog;
+	struct bpf_map *map;
+
+	bo->obj = bpf_object__open_file(bo->path, NULL);
+	if (IS_ERR_OR_NULL(bo->obj)) {
+		fprintf(stderr, "Failed to open %s\n", bo->path);
+		bo->obj = NULL;
+		return 1;
+	}
+
+	prog = bpf_object__find_program_by_name(bo->obj, "_transit");
+	if (!prog) {
+		fprintf(stderr, "No transit program in %s\n", bo->path);
+		return 1;
+	}
+	bpf_program__set_type(prog, BPF_PROG_TYPE_XDP);
+
+	if (bpf_object__load(bo->obj)) {
+		fprintf(stderr, "Failed to load %s\n", bo->path);
+		return 1;
+	}
+	bo->prog_fd = bpf_program__fd(prog);
+
+	map = bpf_object__find_map_by_name(bo->obj, "if_config_map");
+	if (!map) {
+		fprintf(stderr, "No if_config_map in %s\n", bo->path);
+		return 1;
+	}
+	bo->if_config_fd = bpf_map__fd(map);
+
+	map = bpf_object__find_map_by_name(bo->obj, "entrances_map");
+	bo->entrances_fd = map ? bpf_map__fd(map) : -1;
+
+	return 0;
+}
+
+static int bench_run(struct bench_obj *bo, __u32 iface_index,
+		     __u32 num_entrances, __u32 *ns_per_pkt)
+{
+	struct bench_pkt pkt, pkt_out;
+	DECLARE_LIBBPF_OPTS(bpf_test_run_opts, opts,
+		.data_in = &pkt,
+		.data_size_in = sizeof(pkt),
+		.data_out = &pkt_out,
+		.data_size_out = sizeof(pkt_out),
+		.repeat = BENCH_REPEAT,
+	);
+
+	if (bench_set_entrances(bo, iface_index, num_entrances))
+		return 1;
+
+	bench_build_pkt(&pkt, num_entrances);
+
+	if (bpf_prog_test_run_opts(bo->prog_fd, &opts)) {
+		fprintf(stderr, "Test run of %s failed: %s\n", bo->path,
+			strerror(errno));
+		return 1;
+	}
+
+	if (opts.retval == XDP_ABORTED) {
+		fprintf(stderr, "%s aborted the packet, entrance not matched\n",
+			bo->path);
+		return 1;
+	}
+
+	*ns_per_pkt = opts.duration;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rlimit r = { RLIM_INFINITY, RLIM_INFINITY };
+	struct bench_obj objs[BENCH_MAX_OBJS];
+	int num_objs = argc - 1, rc = 0;
+	__u32 iface_index, ns;
+
+	if (num_objs < 1 || num_objs > BENCH_MAX_OBJS) {
+		fprintf(stderr, "Usage: %s <transit xdp object> [...]\n", argv[0]);
+		return 1;
+	}
+
+	if (setrlimit(RLIMIT_MEMLOCK, &r)) {
+		fprintf(stderr, "setrlimit(RLIMIT_MEMLOCK) failed\n");
+		return 1;
+	}
+
+	/* Test runs are received on the loopback device */
+	iface_index = if_nametoindex("lo");
+	if (!iface_index) {
+		fprintf(stderr, "Failed to get loopback ifindex\n");
+		return 1;
+	}
+
+	memset(objs, 0, sizeof(objs));
+	for (int i = 0; i < num_objs; i++) {
+		objs[i].path = argv[i + 1];
+		if (bench_open(&objs[i])) {
+			rc = 1;
+			goto cleanup;
+		}
+	}
+
+	printf("%-10s", "entrances");
+	for (int i = 0; i < num_objs; i++)
+		printf("  %s (%s)", objs[i].path,
+		       objs[i].entrances_fd < 0 ? "scan" : "hash");
+	printf("\n");
+
+	for (size_t n = 0; n < sizeof(bench_entrances) / sizeof(bench_entrances[0]); n++) {
+		printf("%-10u", bench_entrances[n]);
+		for (int i = 0; i < num_objs; i++) {
+			if (bench_run(&objs[i], iface_index, bench_entrances[n], &ns)) {
+				rc = 1;
+				goto cleanup;
+			}
+			printf("  %u ns/pkt", ns);
+		}
+		printf("\n");
+	}
+
+cleanup:
+	for (int i = 0; i < num_objs; i++)
+		bpf_object__close(objs[i].obj);
+
+	return rc;
+}
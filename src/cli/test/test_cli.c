@@ -80,6 +80,250 @@ int *__wrap_delete_ep_1(rpc_endpoint_key_t *argp, CLIENT *clnt)
 	return retval;
 }
 
+rpc_trn_xsk_stats_t *__wrap_get_xsk_stats_1(rpc_intf_name *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	check_expected_ptr(clnt);
+	rpc_trn_xsk_stats_t *retval = mock_ptr_type(rpc_trn_xsk_stats_t *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_ep_miss_list_t *__wrap_get_ep_misses_1(void *argp, CLIENT *clnt)
+{
+	UNUSED(argp);
+	UNUSED(clnt);
+	rpc_trn_ep_miss_list_t *retval = mock_ptr_type(rpc_trn_ep_miss_list_t *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_flow_cache_stats_t *__wrap_get_flow_cache_stats_1(void *argp, CLIENT *clnt)
+{
+	UNUSED(argp);
+	UNUSED(clnt);
+	rpc_trn_flow_cache_stats_t *retval = mock_ptr_type(rpc_trn_flow_cache_stats_t *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_cpu_spread_stats_list_t *__wrap_get_cpu_spread_stats_1(void *argp,
+								CLIENT *clnt)
+{
+	UNUSED(argp);
+	UNUSED(clnt);
+	rpc_trn_cpu_spread_stats_list_t *retval =
+		mock_ptr_type(rpc_trn_cpu_spread_stats_list_t *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_xdp_mode_t *__wrap_get_xdp_mode_1(rpc_intf_name *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	check_expected_ptr(clnt);
+	rpc_trn_xdp_mode_t *retval = mock_ptr_type(rpc_trn_xdp_mode_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_insert_xdp_stage_1(rpc_trn_xdp_stage_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_remove_xdp_stage_1(rpc_trn_xdp_stage_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_xdp_stage_stats_list_t *__wrap_get_xdp_stage_stats_1(void *argp,
+							      CLIENT *clnt)
+{
+	UNUSED(argp);
+	UNUSED(clnt);
+	rpc_trn_xdp_stage_stats_list_t *retval =
+		mock_ptr_type(rpc_trn_xdp_stage_stats_list_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_dft_1(rpc_trn_dft_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_dft_t *__wrap_get_dft_1(rpc_trn_arion_key_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	rpc_trn_dft_t *retval = mock_ptr_type(rpc_trn_dft_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_delete_dft_1(rpc_trn_arion_key_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_chain_1(rpc_trn_chain_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_ftn_1(rpc_trn_ftn_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_scaled_ep_1(rpc_trn_scaled_ep_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_scaled_ep_t *__wrap_get_scaled_ep_1(rpc_endpoint_key_t *argp,
+					    CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	rpc_trn_scaled_ep_t *retval = mock_ptr_type(rpc_trn_scaled_ep_t *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_scaled_ep_stats_t *__wrap_get_scaled_ep_stats_1(void *argp,
+							CLIENT *clnt)
+{
+	UNUSED(argp);
+	UNUSED(clnt);
+	rpc_trn_scaled_ep_stats_t *retval =
+		mock_ptr_type(rpc_trn_scaled_ep_stats_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_flood_list_1(rpc_trn_flood_list_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_flood_stats_t *__wrap_get_flood_stats_1(rpc_trn_vni_key_t *argp,
+						CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	rpc_trn_flood_stats_t *retval = mock_ptr_type(rpc_trn_flood_stats_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_eip_1(rpc_trn_eip_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_eip_gateway_1(rpc_trn_eip_gw_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_ep6_1(rpc_trn_endpoint6_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_endpoint6_t *__wrap_get_ep6_1(rpc_endpoint6_key_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	rpc_trn_endpoint6_t *retval = mock_ptr_type(rpc_trn_endpoint6_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_sg_rules_1(rpc_trn_sg_rules_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+rpc_trn_ct_list_t *__wrap_dump_conntrack_1(rpc_trn_ct_filter_t *argp,
+					    CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	rpc_trn_ct_list_t *retval = mock_ptr_type(rpc_trn_ct_list_t *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_sg_identity_rules_1(rpc_trn_sg_identity_rules_t *argp,
+				       CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
+int *__wrap_update_rate_limit_1(rpc_trn_rate_limit_t *argp, CLIENT *clnt)
+{
+	check_expected_ptr(argp);
+	UNUSED(clnt);
+	int *retval = mock_ptr_type(int *);
+	function_called();
+	return retval;
+}
+
 static inline int cmpfunc(const void *a, const void *b)
 {
 	return (*(int *)a - *(int *)b);
@@ -299,6 +543,80 @@ static void test_trn_cli_load_transit_subcmd(void **state)
 				"ibo_port": 8888
 			  	}) };
 
+	/* test data with RX spreading over worker cpus */
+	char *argv4[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"spread_cpus": [2, 3, 4, 5],
+				"cpumap_qsize": 4096
+			  	}) };
+
+	/* test data with per interface XDP modes */
+	char *argv6[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"xdp_mode_tenant": "native",
+				"xdp_mode_zgc": "generic"
+			  	}) };
+
+	/* test data with unknown XDP mode */
+	char *argv7[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"xdp_mode_tenant": "offload"
+			  	}) };
+
+	/* test data with load time feature selection */
+	char *argv8[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"sg_support": 0,
+				"conn_track": 1,
+				"append_tail": 1,
+				"scaled_ep": 1,
+				"bum_flood": 1,
+				"eip": 1
+			  	}) };
+
+	/* test data with malformed feature switch */
+	char *argv9[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"sg_support": "off"
+			  	}) };
+
+	/* test data with miss guard and its upcall budgets */
+	char *argv10[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"miss_guard": 1,
+				"upcall_host_pps": 1000,
+				"upcall_vni_pps": 4000
+			  	}) };
+
+	/* test data with malformed upcall budget */
+	char *argv11[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"miss_guard": 1,
+				"upcall_host_pps": "high"
+			  	}) };
+
+	/* test data with malformed spread_cpus */
+	char *argv5[] = { "load-transit-xdp", "-j", QUOTE({
+				"itf_tenant": "eth0",
+				"itf_zgc": "eth1",
+				"ibo_port": 8888,
+				"spread_cpus": 2
+			  	}) };
+
 	/* Test call load_transit_xdp_1 successfully */
 	TEST_CASE("load_transit_xdp should succeed with well formed input");
 	load_transit_xdp_ret_val = 0;
@@ -318,27 +636,71 @@ static void test_trn_cli_load_transit_subcmd(void **state)
 	rc = trn_cli_load_transit_subcmd(NULL, argc, argv3);
 	assert_int_equal(rc, 0);
 
-	TEST_CASE("load_transit_xdp should fail if rpc returns Error");
-	load_transit_xdp_ret_val = -EINVAL;
+	TEST_CASE("load_transit_xdp should succeed with spread_cpus");
+	load_transit_xdp_ret_val = 0;
 	expect_function_call(__wrap_load_transit_xdp_1);
 	will_return(__wrap_load_transit_xdp_1, &load_transit_xdp_ret_val);
-	rc = trn_cli_load_transit_subcmd(NULL, argc, argv3);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv4);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("load_transit_xdp should fail if spread_cpus is not array");
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv5);
 	assert_int_equal(rc, -EINVAL);
 
-	/* Test call load_transit_xdp return NULL*/
-	TEST_CASE("load_transit_xdp should  fail if rpc returns NULl");
+	TEST_CASE("load_transit_xdp should succeed with xdp modes");
+	load_transit_xdp_ret_val = 0;
 	expect_function_call(__wrap_load_transit_xdp_1);
-	will_return(__wrap_load_transit_xdp_1, NULL);
-	rc = trn_cli_load_transit_subcmd(NULL, argc, argv1);
+	will_return(__wrap_load_transit_xdp_1, &load_transit_xdp_ret_val);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv6);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("load_transit_xdp should fail with unknown xdp mode");
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv7);
 	assert_int_equal(rc, -EINVAL);
-}
 
-static void test_trn_cli_unload_transit_subcmd(void **state)
-{
-	UNUSED(state);
-	int rc;
-	int argc = 3;
-	int unload_transit_xdp_ret_val = 0;
+	TEST_CASE("load_transit_xdp should succeed with feature selection");
+	load_transit_xdp_ret_val = 0;
+	expect_function_call(__wrap_load_transit_xdp_1);
+	will_return(__wrap_load_transit_xdp_1, &load_transit_xdp_ret_val);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv8);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("load_transit_xdp should fail with malformed feature switch");
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv9);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("load_transit_xdp should succeed with upcall budgets");
+	load_transit_xdp_ret_val = 0;
+	expect_function_call(__wrap_load_transit_xdp_1);
+	will_return(__wrap_load_transit_xdp_1, &load_transit_xdp_ret_val);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv10);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("load_transit_xdp should fail with malformed upcall budget");
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv11);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("load_transit_xdp should fail if rpc returns Error");
+	load_transit_xdp_ret_val = -EINVAL;
+	expect_function_call(__wrap_load_transit_xdp_1);
+	will_return(__wrap_load_transit_xdp_1, &load_transit_xdp_ret_val);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+
+	/* Test call load_transit_xdp return NULL*/
+	TEST_CASE("load_transit_xdp should  fail if rpc returns NULl");
+	expect_function_call(__wrap_load_transit_xdp_1);
+	will_return(__wrap_load_transit_xdp_1, NULL);
+	rc = trn_cli_load_transit_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_unload_transit_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int unload_transit_xdp_ret_val = 0;
 
 	/* Test cases */
 	char *argv1[] = { "load-transit-xdp", "-j", QUOTE({
@@ -509,6 +871,1314 @@ static void test_trn_cli_delete_ep_subcmd(void **state)
 	assert_int_equal(rc, -EINVAL);
 }
 
+static int check_itf_name_equal(const LargestIntegralType value,
+				const LargestIntegralType check_value_data)
+{
+	rpc_intf_name *itf = (rpc_intf_name *)value;
+	char *c_itf = (char *)check_value_data;
+
+	assert_string_equal(*itf, c_itf);
+	return true;
+}
+
+static void test_trn_cli_get_xsk_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	char exp_itf[] = "eth0";
+
+	rpc_trn_xsk_queue_stats_t queues[2] = {
+		{ .queue_id = 0, .upcalls = 10, .resolved = 8,
+		  .unresolved = 2, .parked = 3, .reinjected = 8,
+		  .tx_errors = 0 },
+		{ .queue_id = 1, .upcalls = 3, .resolved = 3,
+		  .unresolved = 0, .parked = 0, .reinjected = 2,
+		  .tx_errors = 1 },
+	};
+	rpc_trn_xsk_stats_t get_xsk_stats_1_ret_val = {
+		.queues.queues_len = 2,
+		.queues.queues_val = queues,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-xsk-stats", "-j", QUOTE({
+				"interface": "eth0"
+				}) };
+
+	char *argv2[] = { "get-xsk-stats", "-j", QUOTE({
+				"interface": 0
+				}) };
+
+	/* Test call get_xsk_stats_1 successfully */
+	TEST_CASE("get_xsk_stats succeed with well formed input");
+	expect_function_call(__wrap_get_xsk_stats_1);
+	will_return(__wrap_get_xsk_stats_1, &get_xsk_stats_1_ret_val);
+	expect_check(__wrap_get_xsk_stats_1, argp, check_itf_name_equal, exp_itf);
+	expect_any(__wrap_get_xsk_stats_1, clnt);
+	rc = trn_cli_get_xsk_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	/* Test parse interface input error */
+	TEST_CASE("get_xsk_stats is not called with non-string interface");
+	rc = trn_cli_get_xsk_stats_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	/* Test call get_xsk_stats_1 return NULL */
+	TEST_CASE("get_xsk_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_xsk_stats_1);
+	will_return(__wrap_get_xsk_stats_1, NULL);
+	expect_any(__wrap_get_xsk_stats_1, argp);
+	expect_any(__wrap_get_xsk_stats_1, clnt);
+	rc = trn_cli_get_xsk_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_ep_misses_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 1;
+
+	rpc_trn_ep_miss_t misses[2] = {
+		{ .vni = 3, .ip = 0x0300000a, .packets = 4 },
+		{ .vni = 5, .ip = 0x0500000a, .packets = 1 },
+	};
+	rpc_trn_ep_miss_list_t get_ep_misses_1_ret_val = {
+		.misses.misses_len = 2,
+		.misses.misses_val = misses,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-ep-misses" };
+
+	/* Test call get_ep_misses_1 successfully */
+	TEST_CASE("get_ep_misses succeed");
+	expect_function_call(__wrap_get_ep_misses_1);
+	will_return(__wrap_get_ep_misses_1, &get_ep_misses_1_ret_val);
+	rc = trn_cli_get_ep_misses_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	/* Test call get_ep_misses_1 return NULL */
+	TEST_CASE("get_ep_misses subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_ep_misses_1);
+	will_return(__wrap_get_ep_misses_1, NULL);
+	rc = trn_cli_get_ep_misses_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_flow_cache_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 1;
+
+	rpc_trn_flow_cache_stats_t get_flow_cache_stats_1_ret_val = {
+		.hit = 990,
+		.miss = 10,
+		.evict = 2,
+		.insert = 8,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-flow-cache-stats" };
+
+	/* Test call get_flow_cache_stats_1 successfully */
+	TEST_CASE("get_flow_cache_stats succeed");
+	expect_function_call(__wrap_get_flow_cache_stats_1);
+	will_return(__wrap_get_flow_cache_stats_1, &get_flow_cache_stats_1_ret_val);
+	rc = trn_cli_get_flow_cache_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	/* Test call get_flow_cache_stats_1 return NULL */
+	TEST_CASE("get_flow_cache_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_flow_cache_stats_1);
+	will_return(__wrap_get_flow_cache_stats_1, NULL);
+	rc = trn_cli_get_flow_cache_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_cpu_spread_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 1;
+
+	rpc_trn_cpu_spread_stats_t cpus[2] = {
+		{ .cpu = 2, .redirected = 0, .processed = 500, .missed = 0 },
+		{ .cpu = 3, .redirected = 1000, .processed = 500, .missed = 2 },
+	};
+	rpc_trn_cpu_spread_stats_list_t get_cpu_spread_stats_1_ret_val = {
+		.cpus.cpus_len = 2,
+		.cpus.cpus_val = cpus,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-cpu-spread-stats" };
+
+	/* Test call get_cpu_spread_stats_1 successfully */
+	TEST_CASE("get_cpu_spread_stats succeed");
+	expect_function_call(__wrap_get_cpu_spread_stats_1);
+	will_return(__wrap_get_cpu_spread_stats_1, &get_cpu_spread_stats_1_ret_val);
+	rc = trn_cli_get_cpu_spread_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	/* Test call get_cpu_spread_stats_1 return NULL */
+	TEST_CASE("get_cpu_spread_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_cpu_spread_stats_1);
+	will_return(__wrap_get_cpu_spread_stats_1, NULL);
+	rc = trn_cli_get_cpu_spread_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_xdp_mode_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	char exp_itf[] = "eth0";
+
+	rpc_trn_xdp_mode_t get_xdp_mode_1_ret_val = {
+		.mode = TRAN_XDP_MODE_NATIVE,
+		.prog_id = 42,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-xdp-mode", "-j", QUOTE({
+				"interface": "eth0"
+				}) };
+
+	char *argv2[] = { "get-xdp-mode", "-j", QUOTE({
+				"itf": "eth0"
+				}) };
+
+	/* Test call get_xdp_mode_1 successfully */
+	TEST_CASE("get_xdp_mode succeed with well formed input");
+	expect_function_call(__wrap_get_xdp_mode_1);
+	will_return(__wrap_get_xdp_mode_1, &get_xdp_mode_1_ret_val);
+	expect_check(__wrap_get_xdp_mode_1, argp, check_itf_name_equal, exp_itf);
+	expect_any(__wrap_get_xdp_mode_1, clnt);
+	rc = trn_cli_get_xdp_mode_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	/* Test parse interface input error */
+	TEST_CASE("get_xdp_mode is not called with missing interface");
+	rc = trn_cli_get_xdp_mode_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	/* Test call get_xdp_mode_1 return NULL */
+	TEST_CASE("get_xdp_mode subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_xdp_mode_1);
+	will_return(__wrap_get_xdp_mode_1, NULL);
+	expect_any(__wrap_get_xdp_mode_1, argp);
+	expect_any(__wrap_get_xdp_mode_1, clnt);
+	rc = trn_cli_get_xdp_mode_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_xdp_stage_equal(const LargestIntegralType value,
+				 const LargestIntegralType check_value_data)
+{
+	rpc_trn_xdp_stage_t *stage = (rpc_trn_xdp_stage_t *)value;
+	rpc_trn_xdp_stage_t *c_stage = (rpc_trn_xdp_stage_t *)check_value_data;
+
+	if (strcmp(stage->name, c_stage->name) != 0 ||
+	    strcmp(stage->path, c_stage->path) != 0 ||
+	    stage->prog_idx != c_stage->prog_idx ||
+	    stage->position != c_stage->position) {
+		return false;
+	}
+	return true;
+}
+
+static void test_trn_cli_xdp_stage_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int insert_xdp_stage_1_ret_val = 0;
+
+	rpc_trn_xdp_stage_t exp_insert = {
+		.name = "count",
+		.path = "/trn_xdp/count_stage.o",
+		.prog_idx = TRAN_PASS_PROG,
+		.position = 0,
+	};
+	rpc_trn_xdp_stage_t exp_remove = {
+		.name = "count",
+		.path = "",
+		.prog_idx = TRAN_PASS_PROG,
+		.position = TRAN_MAX_STAGES,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "insert-xdp-stage", "-j", QUOTE({
+				"name": "count",
+				"path": "/trn_xdp/count_stage.o",
+				"verdict": "xdp_pass",
+				"position": 0
+				}) };
+
+	char *argv2[] = { "insert-xdp-stage", "-j", QUOTE({
+				"name": "count",
+				"verdict": "xdp_pass"
+				}) };
+
+	char *argv3[] = { "insert-xdp-stage", "-j", QUOTE({
+				"name": "count",
+				"path": "/trn_xdp/count_stage.o",
+				"verdict": "xdp_abort"
+				}) };
+
+	TEST_CASE("insert_xdp_stage succeed with well formed input");
+	expect_function_call(__wrap_insert_xdp_stage_1);
+	will_return(__wrap_insert_xdp_stage_1, &insert_xdp_stage_1_ret_val);
+	expect_check(__wrap_insert_xdp_stage_1, argp, check_xdp_stage_equal,
+		     &exp_insert);
+	rc = trn_cli_insert_xdp_stage_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("insert_xdp_stage is not called with missing path");
+	rc = trn_cli_insert_xdp_stage_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("insert_xdp_stage is not called with unknown verdict");
+	rc = trn_cli_insert_xdp_stage_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("insert_xdp_stage subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_insert_xdp_stage_1);
+	will_return(__wrap_insert_xdp_stage_1, NULL);
+	expect_any(__wrap_insert_xdp_stage_1, argp);
+	rc = trn_cli_insert_xdp_stage_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("remove_xdp_stage ignores path and position");
+	expect_function_call(__wrap_remove_xdp_stage_1);
+	will_return(__wrap_remove_xdp_stage_1, &insert_xdp_stage_1_ret_val);
+	expect_check(__wrap_remove_xdp_stage_1, argp, check_xdp_stage_equal,
+		     &exp_remove);
+	rc = trn_cli_remove_xdp_stage_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+}
+
+static void test_trn_cli_get_xdp_stage_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 1;
+
+	rpc_trn_xdp_stage_stats_t stages[2] = {
+		{ .name = "count", .prog_idx = TRAN_PASS_PROG, .position = 0,
+		  .runs = 100, .run_ns = 5000 },
+		{ .name = "xdp_pass", .prog_idx = TRAN_PASS_PROG, .position = 1,
+		  .runs = 0, .run_ns = 0 },
+	};
+	rpc_trn_xdp_stage_stats_list_t get_xdp_stage_stats_1_ret_val = {
+		.stages.stages_len = 2,
+		.stages.stages_val = stages,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-xdp-stage-stats" };
+
+	TEST_CASE("get_xdp_stage_stats succeed");
+	expect_function_call(__wrap_get_xdp_stage_stats_1);
+	will_return(__wrap_get_xdp_stage_stats_1, &get_xdp_stage_stats_1_ret_val);
+	rc = trn_cli_get_xdp_stage_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_xdp_stage_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_xdp_stage_stats_1);
+	will_return(__wrap_get_xdp_stage_stats_1, NULL);
+	rc = trn_cli_get_xdp_stage_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_dft_equal(const LargestIntegralType value,
+			   const LargestIntegralType check_value_data)
+{
+	rpc_trn_dft_t *dft = (rpc_trn_dft_t *)value;
+	rpc_trn_dft_t *c_dft = (rpc_trn_dft_t *)check_value_data;
+
+	assert_int_equal(dft->id, c_dft->id);
+	assert_int_equal(dft->table.table_len, c_dft->table.table_len);
+	for (unsigned int i = 0; i < c_dft->table.table_len; i++) {
+		assert_int_equal(dft->table.table_val[i],
+				 c_dft->table.table_val[i]);
+	}
+
+	return true;
+}
+
+static void test_trn_cli_dft_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_dft_1_ret_val = 0;
+	int delete_dft_1_ret_val = 0;
+	uint32_t table[7] = { 1, 2, 1, 2, 1, 2, 3 };
+
+	rpc_trn_dft_t exp_dft = {
+		.id = 3,
+		.table.table_len = 7,
+		.table.table_val = table,
+	};
+	rpc_trn_arion_key_t exp_key = { .id = 3 };
+
+	/* Test cases */
+	char *argv1[] = { "update-dft", "-j", QUOTE({
+				"id": "3",
+				"table": ["1", "2", "1", "2", "1", "2", 3]
+				}) };
+
+	char *argv2[] = { "update-dft", "-j", QUOTE({
+				"id": "3",
+				"table": []
+				}) };
+
+	char *argv3[] = { "get-dft", "-j", QUOTE({
+				"id": "3"
+				}) };
+
+	TEST_CASE("update_dft succeed with well formed input");
+	expect_function_call(__wrap_update_dft_1);
+	will_return(__wrap_update_dft_1, &update_dft_1_ret_val);
+	expect_check(__wrap_update_dft_1, argp, check_dft_equal, &exp_dft);
+	rc = trn_cli_update_dft_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_dft is not called with empty table");
+	rc = trn_cli_update_dft_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_dft subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_dft_1);
+	will_return(__wrap_update_dft_1, NULL);
+	expect_any(__wrap_update_dft_1, argp);
+	rc = trn_cli_update_dft_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("get_dft succeed with well formed input");
+	expect_function_call(__wrap_get_dft_1);
+	will_return(__wrap_get_dft_1, &exp_dft);
+	expect_check(__wrap_get_dft_1, argp, check_arion_key_equal, &exp_key);
+	rc = trn_cli_get_dft_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_dft subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_dft_1);
+	will_return(__wrap_get_dft_1, NULL);
+	expect_any(__wrap_get_dft_1, argp);
+	rc = trn_cli_get_dft_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("delete_dft succeed with well formed input");
+	expect_function_call(__wrap_delete_dft_1);
+	will_return(__wrap_delete_dft_1, &delete_dft_1_ret_val);
+	expect_check(__wrap_delete_dft_1, argp, check_arion_key_equal, &exp_key);
+	rc = trn_cli_delete_dft_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+}
+
+static int check_ftn_equal(const LargestIntegralType value,
+			   const LargestIntegralType check_value_data)
+{
+	rpc_trn_ftn_t *ftn = (rpc_trn_ftn_t *)value;
+	rpc_trn_ftn_t *c_ftn = (rpc_trn_ftn_t *)check_value_data;
+
+	assert_int_equal(ftn->id, c_ftn->id);
+	assert_int_equal(ftn->position, c_ftn->position);
+	assert_int_equal(ftn->ip, c_ftn->ip);
+	assert_int_equal(ftn->next_ip, c_ftn->next_ip);
+	assert_memory_equal(ftn->mac, c_ftn->mac, sizeof(c_ftn->mac));
+	assert_memory_equal(ftn->next_mac, c_ftn->next_mac,
+			    sizeof(c_ftn->next_mac));
+
+	return true;
+}
+
+static int check_chain_equal(const LargestIntegralType value,
+			     const LargestIntegralType check_value_data)
+{
+	rpc_trn_chain_t *chain = (rpc_trn_chain_t *)value;
+	rpc_trn_chain_t *c_chain = (rpc_trn_chain_t *)check_value_data;
+
+	assert_int_equal(chain->id, c_chain->id);
+	assert_int_equal(chain->tail_ftn, c_chain->tail_ftn);
+
+	return true;
+}
+
+static void test_trn_cli_chain_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_1_ret_val = 0;
+
+	rpc_trn_ftn_t exp_ftn = {
+		.id = 4,
+		.position = TRAN_FTN_TYPE_MIDDLE,
+		.ip = 0x0200000a,
+		.mac = { 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f },
+		.next_ip = 0x0300000a,
+		.next_mac = { 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x10 },
+	};
+	rpc_trn_chain_t exp_chain = { .id = 2, .tail_ftn = 5 };
+
+	/* Test cases */
+	char *argv1[] = { "update-ftn", "-j", QUOTE({
+				"id": "4",
+				"ftn_position": 1,
+				"ip": "10.0.0.2",
+				"mac": "0a:0b:0c:0d:0e:0f",
+				"next_ip": "10.0.0.3",
+				"next_mac": "0a:0b:0c:0d:0e:10"
+				}) };
+
+	char *argv2[] = { "update-ftn", "-j", QUOTE({
+				"id": "4",
+				"ftn_position": 3,
+				"ip": "10.0.0.2",
+				"mac": "0a:0b:0c:0d:0e:0f",
+				"next_ip": "10.0.0.3",
+				"next_mac": "0a:0b:0c:0d:0e:10"
+				}) };
+
+	char *argv3[] = { "update-chain", "-j", QUOTE({
+				"id": "2",
+				"tail_ftn": "5"
+				}) };
+
+	TEST_CASE("update_ftn succeed with well formed input");
+	expect_function_call(__wrap_update_ftn_1);
+	will_return(__wrap_update_ftn_1, &update_1_ret_val);
+	expect_check(__wrap_update_ftn_1, argp, check_ftn_equal, &exp_ftn);
+	rc = trn_cli_update_ftn_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_ftn is not called with unknown position");
+	rc = trn_cli_update_ftn_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_ftn subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_ftn_1);
+	will_return(__wrap_update_ftn_1, NULL);
+	expect_any(__wrap_update_ftn_1, argp);
+	rc = trn_cli_update_ftn_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_chain succeed with well formed input");
+	expect_function_call(__wrap_update_chain_1);
+	will_return(__wrap_update_chain_1, &update_1_ret_val);
+	expect_check(__wrap_update_chain_1, argp, check_chain_equal, &exp_chain);
+	rc = trn_cli_update_chain_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+}
+
+static int check_scaled_ep_equal(const LargestIntegralType value,
+				 const LargestIntegralType check_value_data)
+{
+	rpc_trn_scaled_ep_t *sep = (rpc_trn_scaled_ep_t *)value;
+	rpc_trn_scaled_ep_t *c_sep = (rpc_trn_scaled_ep_t *)check_value_data;
+
+	assert_int_equal(sep->vni, c_sep->vni);
+	assert_int_equal(sep->ip, c_sep->ip);
+	assert_int_equal(sep->flags, c_sep->flags);
+	assert_int_equal(sep->remote_ips.remote_ips_len,
+			 c_sep->remote_ips.remote_ips_len);
+	for (unsigned int i = 0; i < c_sep->remote_ips.remote_ips_len; i++) {
+		assert_int_equal(sep->remote_ips.remote_ips_val[i],
+				 c_sep->remote_ips.remote_ips_val[i]);
+	}
+
+	return true;
+}
+
+static void test_trn_cli_scaled_ep_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_scaled_ep_1_ret_val = 0;
+
+	uint32_t remote_ips[] = { 0x0200000a, 0x0300000a, 0x0400000a };
+	rpc_trn_scaled_ep_t exp_sep = {
+		.vni = 3,
+		.ip = 0x6400000a,
+		.flags = TRAN_SCALED_EP_DSR,
+		.remote_ips = { .remote_ips_len = 3, .remote_ips_val = remote_ips },
+	};
+	rpc_endpoint_key_t exp_key = { .vni = 3, .ip = 0x6400000a };
+
+	/* Test cases */
+	char *argv1[] = { "update-scaled-ep", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.100",
+				"dsr": 1,
+				"remote_ips": ["10.0.0.2", "10.0.0.3", "10.0.0.4"]
+				}) };
+
+	char *argv2[] = { "update-scaled-ep", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.100",
+				"remote_ips": ["10.0.0.2", "host3"]
+				}) };
+
+	char *argv3[] = { "get-scaled-ep", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.100"
+				}) };
+
+	TEST_CASE("update_scaled_ep succeed with well formed input");
+	expect_function_call(__wrap_update_scaled_ep_1);
+	will_return(__wrap_update_scaled_ep_1, &update_scaled_ep_1_ret_val);
+	expect_check(__wrap_update_scaled_ep_1, argp, check_scaled_ep_equal,
+		     &exp_sep);
+	rc = trn_cli_update_scaled_ep_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_scaled_ep is not called with malformed remote ip");
+	rc = trn_cli_update_scaled_ep_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_scaled_ep subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_scaled_ep_1);
+	will_return(__wrap_update_scaled_ep_1, NULL);
+	expect_any(__wrap_update_scaled_ep_1, argp);
+	rc = trn_cli_update_scaled_ep_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("get_scaled_ep succeed with well formed input");
+	expect_function_call(__wrap_get_scaled_ep_1);
+	will_return(__wrap_get_scaled_ep_1, &exp_sep);
+	expect_check(__wrap_get_scaled_ep_1, argp, check_ep_key_equal, &exp_key);
+	rc = trn_cli_get_scaled_ep_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_scaled_ep subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_scaled_ep_1);
+	will_return(__wrap_get_scaled_ep_1, NULL);
+	expect_any(__wrap_get_scaled_ep_1, argp);
+	rc = trn_cli_get_scaled_ep_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_scaled_ep_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 1;
+
+	rpc_trn_scaled_ep_stats_t get_scaled_ep_stats_1_ret_val = {
+		.dsr_flows = 12,
+		.dsr_bytes = 1048576,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-scaled-ep-stats" };
+
+	TEST_CASE("get_scaled_ep_stats succeed");
+	expect_function_call(__wrap_get_scaled_ep_stats_1);
+	will_return(__wrap_get_scaled_ep_stats_1,
+		    &get_scaled_ep_stats_1_ret_val);
+	rc = trn_cli_get_scaled_ep_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_scaled_ep_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_scaled_ep_stats_1);
+	will_return(__wrap_get_scaled_ep_stats_1, NULL);
+	rc = trn_cli_get_scaled_ep_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_flood_list_equal(const LargestIntegralType value,
+				  const LargestIntegralType check_value_data)
+{
+	rpc_trn_flood_list_t *fl = (rpc_trn_flood_list_t *)value;
+	rpc_trn_flood_list_t *c_fl = (rpc_trn_flood_list_t *)check_value_data;
+
+	assert_int_equal(fl->vni, c_fl->vni);
+	assert_int_equal(fl->cap, c_fl->cap);
+	assert_int_equal(fl->hosts.hosts_len, c_fl->hosts.hosts_len);
+	for (unsigned int i = 0; i < c_fl->hosts.hosts_len; i++) {
+		assert_int_equal(fl->hosts.hosts_val[i].ip,
+				 c_fl->hosts.hosts_val[i].ip);
+		assert_memory_equal(fl->hosts.hosts_val[i].mac,
+				    c_fl->hosts.hosts_val[i].mac,
+				    sizeof(c_fl->hosts.hosts_val[i].mac));
+	}
+
+	return true;
+}
+
+static void test_trn_cli_update_flood_list_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_flood_list_1_ret_val = 0;
+
+	rpc_addr_t hosts[] = {
+		{ .ip = 0x0200000a, .mac = { 1, 2, 3, 4, 5, 6 } },
+		{ .ip = 0x0300000a, .mac = { 1, 2, 3, 4, 5, 7 } },
+	};
+	rpc_trn_flood_list_t exp_fl = {
+		.vni = 3,
+		.cap = 1,
+		.hosts = { .hosts_len = 2, .hosts_val = hosts },
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-flood-list", "-j", QUOTE({
+				"vni": 3,
+				"cap": 1,
+				"hosts": [
+					{"ip": "10.0.0.2", "mac": "1:2:3:4:5:6"},
+					{"ip": "10.0.0.3", "mac": "1:2:3:4:5:7"}
+				]
+				}) };
+
+	char *argv2[] = { "update-flood-list", "-j", QUOTE({
+				"vni": 3,
+				"hosts": [
+					{"ip": "10.0.0.2"}
+				]
+				}) };
+
+	TEST_CASE("update_flood_list succeed with well formed input");
+	expect_function_call(__wrap_update_flood_list_1);
+	will_return(__wrap_update_flood_list_1, &update_flood_list_1_ret_val);
+	expect_check(__wrap_update_flood_list_1, argp, check_flood_list_equal,
+		     &exp_fl);
+	rc = trn_cli_update_flood_list_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_flood_list is not called with host missing mac");
+	rc = trn_cli_update_flood_list_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_flood_list subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_flood_list_1);
+	will_return(__wrap_update_flood_list_1, NULL);
+	expect_any(__wrap_update_flood_list_1, argp);
+	rc = trn_cli_update_flood_list_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static void test_trn_cli_get_flood_stats_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+
+	rpc_trn_flood_stats_t get_flood_stats_1_ret_val = {
+		.frames = 10,
+		.copies = 25,
+		.capped = 2,
+		.dropped = 1,
+		.rejected = 3,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "get-flood-stats", "-j", QUOTE({
+				"vni": 3
+				}) };
+
+	TEST_CASE("get_flood_stats succeed");
+	expect_function_call(__wrap_get_flood_stats_1);
+	will_return(__wrap_get_flood_stats_1, &get_flood_stats_1_ret_val);
+	expect_any(__wrap_get_flood_stats_1, argp);
+	rc = trn_cli_get_flood_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_flood_stats subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_flood_stats_1);
+	will_return(__wrap_get_flood_stats_1, NULL);
+	expect_any(__wrap_get_flood_stats_1, argp);
+	rc = trn_cli_get_flood_stats_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_eip_equal(const LargestIntegralType value,
+			   const LargestIntegralType check_value_data)
+{
+	rpc_trn_eip_t *eip = (rpc_trn_eip_t *)value;
+	rpc_trn_eip_t *c_eip = (rpc_trn_eip_t *)check_value_data;
+
+	assert_int_equal(eip->vni, c_eip->vni);
+	assert_int_equal(eip->ip, c_eip->ip);
+	assert_int_equal(eip->eip, c_eip->eip);
+
+	return true;
+}
+
+static int check_eip_gw_equal(const LargestIntegralType value,
+			      const LargestIntegralType check_value_data)
+{
+	rpc_trn_eip_gw_t *gw = (rpc_trn_eip_gw_t *)value;
+	rpc_trn_eip_gw_t *c_gw = (rpc_trn_eip_gw_t *)check_value_data;
+
+	assert_string_equal(gw->interface, c_gw->interface);
+	assert_int_equal(gw->xdp_mode, c_gw->xdp_mode);
+	assert_memory_equal(gw->mac, c_gw->mac, sizeof(c_gw->mac));
+	assert_memory_equal(gw->gw_mac, c_gw->gw_mac, sizeof(c_gw->gw_mac));
+	assert_int_equal(gw->tunnel_ip, c_gw->tunnel_ip);
+	assert_memory_equal(gw->tunnel_mac, c_gw->tunnel_mac,
+			    sizeof(c_gw->tunnel_mac));
+
+	return true;
+}
+
+static void test_trn_cli_eip_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_eip_1_ret_val = 0;
+	int update_eip_gateway_1_ret_val = 0;
+
+	rpc_trn_eip_t exp_eip = {
+		.vni = 3,
+		.ip = 0x0500000a,
+		.eip = 0x050071cb,
+	};
+	rpc_trn_eip_gw_t exp_gw = {
+		.interface = "eth2",
+		.xdp_mode = TRAN_XDP_MODE_NATIVE,
+		.mac = { 1, 2, 3, 4, 5, 6 },
+		.gw_mac = { 1, 2, 3, 4, 5, 7 },
+		.tunnel_ip = 0x0100000a,
+		.tunnel_mac = { 1, 2, 3, 4, 5, 8 },
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-eip", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.5",
+				"eip": "203.113.0.5"
+				}) };
+
+	char *argv2[] = { "update-eip", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.5"
+				}) };
+
+	char *argv3[] = { "update-eip-gateway", "-j", QUOTE({
+				"interface": "eth2",
+				"xdp_mode": "native",
+				"mac": "1:2:3:4:5:6",
+				"gw_mac": "1:2:3:4:5:7",
+				"tunnel_ip": "10.0.0.1",
+				"tunnel_mac": "1:2:3:4:5:8"
+				}) };
+
+	TEST_CASE("update_eip succeed with well formed input");
+	expect_function_call(__wrap_update_eip_1);
+	will_return(__wrap_update_eip_1, &update_eip_1_ret_val);
+	expect_check(__wrap_update_eip_1, argp, check_eip_equal, &exp_eip);
+	rc = trn_cli_update_eip_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_eip is not called without elastic IP");
+	rc = trn_cli_update_eip_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_eip subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_eip_1);
+	will_return(__wrap_update_eip_1, NULL);
+	expect_any(__wrap_update_eip_1, argp);
+	rc = trn_cli_update_eip_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_eip_gateway succeed with well formed input");
+	expect_function_call(__wrap_update_eip_gateway_1);
+	will_return(__wrap_update_eip_gateway_1, &update_eip_gateway_1_ret_val);
+	expect_check(__wrap_update_eip_gateway_1, argp, check_eip_gw_equal,
+		     &exp_gw);
+	rc = trn_cli_update_eip_gateway_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+}
+
+static int check_ep6_equal(const LargestIntegralType value,
+			   const LargestIntegralType check_value_data)
+{
+	rpc_trn_endpoint6_t *ep = (rpc_trn_endpoint6_t *)value;
+	rpc_trn_endpoint6_t *c_ep = (rpc_trn_endpoint6_t *)check_value_data;
+
+	assert_int_equal(ep->vni, c_ep->vni);
+	assert_memory_equal(ep->ip, c_ep->ip, sizeof(c_ep->ip));
+	assert_int_equal(ep->hip, c_ep->hip);
+	assert_memory_equal(ep->mac, c_ep->mac, sizeof(c_ep->mac));
+	assert_memory_equal(ep->hmac, c_ep->hmac, sizeof(c_ep->hmac));
+
+	return true;
+}
+
+static int check_ep6_key_equal(const LargestIntegralType value,
+			       const LargestIntegralType check_value_data)
+{
+	rpc_endpoint6_key_t *key = (rpc_endpoint6_key_t *)value;
+	rpc_endpoint6_key_t *c_key = (rpc_endpoint6_key_t *)check_value_data;
+
+	assert_int_equal(key->vni, c_key->vni);
+	assert_memory_equal(key->ip, c_key->ip, sizeof(c_key->ip));
+
+	return true;
+}
+
+static void test_trn_cli_ep6_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_ep6_1_ret_val = 0;
+
+	/* fd00::5 in network byte order */
+	rpc_trn_endpoint6_t exp_ep = {
+		.vni = 3,
+		.ip = { 0x000000fd, 0, 0, 0x05000000 },
+		.hip = 0x0200000a,
+		.mac = { 1, 2, 3, 4, 5, 6 },
+		.hmac = { 1, 2, 3, 4, 5, 7 },
+	};
+	rpc_endpoint6_key_t exp_key = {
+		.vni = 3,
+		.ip = { 0x000000fd, 0, 0, 0x05000000 },
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-ep6", "-j", QUOTE({
+				"vni": 3,
+				"ip": "fd00::5",
+				"hip": "10.0.0.2",
+				"mac": "1:2:3:4:5:6",
+				"hmac": "1:2:3:4:5:7"
+				}) };
+
+	char *argv2[] = { "update-ep6", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.5",
+				"hip": "10.0.0.2",
+				"mac": "1:2:3:4:5:6",
+				"hmac": "1:2:3:4:5:7"
+				}) };
+
+	char *argv3[] = { "get-ep6", "-j", QUOTE({
+				"vni": 3,
+				"ip": "fd00::5"
+				}) };
+
+	TEST_CASE("update_ep6 succeed with well formed input");
+	expect_function_call(__wrap_update_ep6_1);
+	will_return(__wrap_update_ep6_1, &update_ep6_1_ret_val);
+	expect_check(__wrap_update_ep6_1, argp, check_ep6_equal, &exp_ep);
+	rc = trn_cli_update_ep6_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_ep6 is not called with an IPv4 address");
+	rc = trn_cli_update_ep6_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_ep6 subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_ep6_1);
+	will_return(__wrap_update_ep6_1, NULL);
+	expect_any(__wrap_update_ep6_1, argp);
+	rc = trn_cli_update_ep6_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("get_ep6 succeed with well formed input");
+	expect_function_call(__wrap_get_ep6_1);
+	will_return(__wrap_get_ep6_1, &exp_ep);
+	expect_check(__wrap_get_ep6_1, argp, check_ep6_key_equal, &exp_key);
+	rc = trn_cli_get_ep6_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("get_ep6 subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_get_ep6_1);
+	will_return(__wrap_get_ep6_1, NULL);
+	expect_any(__wrap_get_ep6_1, argp);
+	rc = trn_cli_get_ep6_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_sg_rules_equal(const LargestIntegralType value,
+				const LargestIntegralType check_value_data)
+{
+	rpc_trn_sg_rules_t *sg = (rpc_trn_sg_rules_t *)value;
+	rpc_trn_sg_rules_t *c_sg = (rpc_trn_sg_rules_t *)check_value_data;
+	u_int i;
+
+	assert_int_equal(sg->vni, c_sg->vni);
+	assert_int_equal(sg->append, c_sg->append);
+	assert_int_equal(sg->rules.rules_len, c_sg->rules.rules_len);
+
+	for (i = 0; i < c_sg->rules.rules_len; i++) {
+		rpc_trn_sg_rule_t *r = &sg->rules.rules_val[i];
+		rpc_trn_sg_rule_t *c_r = &c_sg->rules.rules_val[i];
+
+		assert_int_equal(r->direction, c_r->direction);
+		assert_int_equal(r->protocol, c_r->protocol);
+		assert_int_equal(r->cidr, c_r->cidr);
+		assert_int_equal(r->prefixlen, c_r->prefixlen);
+		assert_int_equal(r->port_min, c_r->port_min);
+		assert_int_equal(r->port_max, c_r->port_max);
+	}
+
+	return true;
+}
+
+static void test_trn_cli_update_sg_rules_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_sg_rules_1_ret_val = 0;
+
+	rpc_trn_sg_rule_t exp_rules[] = {
+		{
+			.direction = TRAN_SG_EGRESS,
+			.protocol = IPPROTO_TCP,
+			.cidr = 0x0000000a,
+			.prefixlen = 8,
+			.port_min = 80,
+			.port_max = 443,
+		},
+		{
+			.direction = TRAN_SG_INGRESS,
+			.protocol = TRAN_SG_PROTO_ANY,
+			.cidr = 0x0101a8c0,
+			.prefixlen = 32,
+			.port_min = 0,
+			.port_max = 65535,
+		},
+	};
+	rpc_trn_sg_rules_t exp_sg = {
+		.vni = 3,
+		.append = 1,
+		.rules = { .rules_len = 2, .rules_val = exp_rules },
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-sg-rules", "-j", QUOTE({
+				"vni": 3,
+				"append": true,
+				"rules": [{
+					"direction": "egress",
+					"protocol": "tcp",
+					"cidr": "10.0.0.0/8",
+					"port_min": 80,
+					"port_max": 443
+				}, {
+					"direction": "ingress",
+					"cidr": "192.168.1.1"
+				}]
+				}) };
+
+	char *argv2[] = { "update-sg-rules", "-j", QUOTE({
+				"vni": 3,
+				"rules": [{
+					"direction": "egress",
+					"protocol": "tcp",
+					"cidr": "10.0.0.0/8",
+					"port_min": 443,
+					"port_max": 80
+				}]
+				}) };
+
+	char *argv3[] = { "update-sg-rules", "-j", QUOTE({
+				"vni": 3,
+				"rules": [{
+					"direction": "both",
+					"cidr": "10.0.0.0/8"
+				}]
+				}) };
+
+	TEST_CASE("update_sg_rules succeed with well formed input");
+	expect_function_call(__wrap_update_sg_rules_1);
+	will_return(__wrap_update_sg_rules_1, &update_sg_rules_1_ret_val);
+	expect_check(__wrap_update_sg_rules_1, argp, check_sg_rules_equal,
+		     &exp_sg);
+	rc = trn_cli_update_sg_rules_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_sg_rules is not called with an inverted port range");
+	rc = trn_cli_update_sg_rules_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_sg_rules is not called with an unknown direction");
+	rc = trn_cli_update_sg_rules_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_sg_rules subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_sg_rules_1);
+	will_return(__wrap_update_sg_rules_1, NULL);
+	expect_any(__wrap_update_sg_rules_1, argp);
+	rc = trn_cli_update_sg_rules_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_sg_identity_rules_equal(const LargestIntegralType value,
+					 const LargestIntegralType check_value_data)
+{
+	rpc_trn_sg_identity_rules_t *sg = (rpc_trn_sg_identity_rules_t *)value;
+	rpc_trn_sg_identity_rules_t *c_sg =
+		(rpc_trn_sg_identity_rules_t *)check_value_data;
+	u_int i;
+
+	assert_int_equal(sg->rules.rules_len, c_sg->rules.rules_len);
+
+	for (i = 0; i < c_sg->rules.rules_len; i++) {
+		rpc_trn_sg_identity_rule_t *r = &sg->rules.rules_val[i];
+		rpc_trn_sg_identity_rule_t *c_r = &c_sg->rules.rules_val[i];
+
+		assert_int_equal(r->vni, c_r->vni);
+		assert_int_equal(r->src_id, c_r->src_id);
+		assert_int_equal(r->dst_id, c_r->dst_id);
+		assert_int_equal(r->protocol, c_r->protocol);
+		assert_int_equal(r->port, c_r->port);
+		assert_int_equal(r->verdict, c_r->verdict);
+	}
+
+	return true;
+}
+
+static void test_trn_cli_update_sg_identity_rules_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_sg_identity_rules_1_ret_val = 0;
+
+	rpc_trn_sg_identity_rule_t exp_rules[] = {
+		{
+			.vni = 3,
+			.src_id = 10,
+			.dst_id = 20,
+			.protocol = IPPROTO_TCP,
+			.port = 443,
+			.verdict = TRAN_SG_ALLOW,
+		},
+		{
+			.vni = 3,
+			.src_id = 10,
+			.dst_id = 30,
+			.protocol = TRAN_SG_PROTO_ANY,
+			.port = 0,
+			.verdict = TRAN_SG_DENY,
+		},
+	};
+	rpc_trn_sg_identity_rules_t exp_sg = {
+		.rules = { .rules_len = 2, .rules_val = exp_rules },
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-sg-identity-rules", "-j", QUOTE({
+				"rules": [{
+					"vni": 3,
+					"src_id": 10,
+					"dst_id": 20,
+					"protocol": "tcp",
+					"port": 443
+				}, {
+					"vni": 3,
+					"src_id": 10,
+					"dst_id": 30,
+					"verdict": "deny"
+				}]
+				}) };
+
+	char *argv2[] = { "update-sg-identity-rules", "-j", QUOTE({
+				"rules": [{
+					"vni": 3,
+					"src_id": 0,
+					"dst_id": 20
+				}]
+				}) };
+
+	TEST_CASE("update_sg_identity_rules succeed with well formed input");
+	expect_function_call(__wrap_update_sg_identity_rules_1);
+	will_return(__wrap_update_sg_identity_rules_1,
+		    &update_sg_identity_rules_1_ret_val);
+	expect_check(__wrap_update_sg_identity_rules_1, argp,
+		     check_sg_identity_rules_equal, &exp_sg);
+	rc = trn_cli_update_sg_identity_rules_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_sg_identity_rules is not called with identity 0");
+	rc = trn_cli_update_sg_identity_rules_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_sg_identity_rules subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_sg_identity_rules_1);
+	will_return(__wrap_update_sg_identity_rules_1, NULL);
+	expect_any(__wrap_update_sg_identity_rules_1, argp);
+	rc = trn_cli_update_sg_identity_rules_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_rate_limit_equal(const LargestIntegralType value,
+				  const LargestIntegralType check_value_data)
+{
+	rpc_trn_rate_limit_t *rl = (rpc_trn_rate_limit_t *)value;
+	rpc_trn_rate_limit_t *c_rl = (rpc_trn_rate_limit_t *)check_value_data;
+
+	assert_int_equal(rl->vni, c_rl->vni);
+	assert_int_equal(rl->ip, c_rl->ip);
+	assert_int_equal(rl->pps, c_rl->pps);
+	assert_int_equal(rl->bps, c_rl->bps);
+	assert_int_equal(rl->action, c_rl->action);
+
+	return true;
+}
+
+static void test_trn_cli_update_rate_limit_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+	int update_rate_limit_1_ret_val = 0;
+
+	rpc_trn_rate_limit_t exp_vni_rl = {
+		.vni = 3,
+		.ip = 0,
+		.pps = 0,
+		.bps = 10000000000ULL,
+		.action = TRAN_RL_DROP,
+	};
+	rpc_trn_rate_limit_t exp_ep_rl = {
+		.vni = 3,
+		.ip = 0x0100000a,
+		.pps = 100000,
+		.bps = 0,
+		.action = TRAN_RL_MARK,
+	};
+
+	/* Test cases */
+	char *argv1[] = { "update-rate-limit", "-j", QUOTE({
+				"vni": 3,
+				"bps": 10000000000
+				}) };
+
+	char *argv2[] = { "update-rate-limit", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.1",
+				"pps": 100000,
+				"action": "mark"
+				}) };
+
+	char *argv3[] = { "update-rate-limit", "-j", QUOTE({
+				"vni": 3,
+				"ip": "10.0.0.1"
+				}) };
+
+	char *argv4[] = { "update-rate-limit", "-j", QUOTE({
+				"vni": 3,
+				"pps": 100000,
+				"action": "shape"
+				}) };
+
+	TEST_CASE("update_rate_limit succeed with VNI byte rate");
+	expect_function_call(__wrap_update_rate_limit_1);
+	will_return(__wrap_update_rate_limit_1, &update_rate_limit_1_ret_val);
+	expect_check(__wrap_update_rate_limit_1, argp, check_rate_limit_equal,
+		     &exp_vni_rl);
+	rc = trn_cli_update_rate_limit_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_rate_limit succeed with endpoint packet rate");
+	expect_function_call(__wrap_update_rate_limit_1);
+	will_return(__wrap_update_rate_limit_1, &update_rate_limit_1_ret_val);
+	expect_check(__wrap_update_rate_limit_1, argp, check_rate_limit_equal,
+		     &exp_ep_rl);
+	rc = trn_cli_update_rate_limit_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("update_rate_limit is not called without rates");
+	rc = trn_cli_update_rate_limit_subcmd(NULL, argc, argv3);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_rate_limit is not called with unknown action");
+	rc = trn_cli_update_rate_limit_subcmd(NULL, argc, argv4);
+	assert_int_equal(rc, -EINVAL);
+
+	TEST_CASE("update_rate_limit subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_update_rate_limit_1);
+	will_return(__wrap_update_rate_limit_1, NULL);
+	expect_any(__wrap_update_rate_limit_1, argp);
+	rc = trn_cli_update_rate_limit_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
+
+static int check_ct_filter_equal(const LargestIntegralType value,
+				 const LargestIntegralType check_value_data)
+{
+	rpc_trn_ct_filter_t *filter = (rpc_trn_ct_filter_t *)value;
+	rpc_trn_ct_filter_t *c_filter = (rpc_trn_ct_filter_t *)check_value_data;
+
+	assert_int_equal(filter->vni, c_filter->vni);
+	assert_int_equal(filter->all_vnis, c_filter->all_vnis);
+
+	return true;
+}
+
+static void test_trn_cli_dump_conntrack_subcmd(void **state)
+{
+	UNUSED(state);
+	int rc;
+	int argc = 3;
+
+	rpc_trn_ct_entry_t entries[] = {
+		{
+			.vni = 3,
+			.saddr = 0x0100000a,
+			.daddr = 0x0200000a,
+			.sport = 40000,
+			.dport = 80,
+			.protocol = IPPROTO_TCP,
+			.state = TRAN_CT_ESTABLISHED,
+			.idle = 2,
+		},
+	};
+	rpc_trn_ct_list_t dump_conntrack_1_ret_val = {
+		.total = 1,
+		.entries = { .entries_len = 1, .entries_val = entries },
+	};
+	rpc_trn_ct_filter_t exp_vni = { .vni = 3, .all_vnis = 0 };
+	rpc_trn_ct_filter_t exp_all = { .vni = 0, .all_vnis = 1 };
+
+	/* Test cases */
+	char *argv1[] = { "dump-conntrack", "-j", QUOTE({
+				"vni": 3
+				}) };
+
+	char *argv2[] = { "dump-conntrack", "-j", QUOTE({}) };
+
+	TEST_CASE("dump_conntrack succeed for a VNI");
+	expect_function_call(__wrap_dump_conntrack_1);
+	will_return(__wrap_dump_conntrack_1, &dump_conntrack_1_ret_val);
+	expect_check(__wrap_dump_conntrack_1, argp, check_ct_filter_equal,
+		     &exp_vni);
+	rc = trn_cli_dump_conntrack_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("dump_conntrack selects all VNIs without vni");
+	expect_function_call(__wrap_dump_conntrack_1);
+	will_return(__wrap_dump_conntrack_1, &dump_conntrack_1_ret_val);
+	expect_check(__wrap_dump_conntrack_1, argp, check_ct_filter_equal,
+		     &exp_all);
+	rc = trn_cli_dump_conntrack_subcmd(NULL, argc, argv2);
+	assert_int_equal(rc, 0);
+
+	TEST_CASE("dump_conntrack subcommand fails if rpc returns NULL");
+	expect_function_call(__wrap_dump_conntrack_1);
+	will_return(__wrap_dump_conntrack_1, NULL);
+	expect_any(__wrap_dump_conntrack_1, argp);
+	rc = trn_cli_dump_conntrack_subcmd(NULL, argc, argv1);
+	assert_int_equal(rc, -EINVAL);
+}
 
 int main()
 {
@@ -518,6 +2188,25 @@ int main()
 		cmocka_unit_test(test_trn_cli_unload_transit_subcmd),
 		cmocka_unit_test(test_trn_cli_get_ep_subcmd),
 		cmocka_unit_test(test_trn_cli_delete_ep_subcmd),
+		cmocka_unit_test(test_trn_cli_get_xsk_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_get_ep_misses_subcmd),
+		cmocka_unit_test(test_trn_cli_get_flow_cache_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_get_cpu_spread_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_get_xdp_mode_subcmd),
+		cmocka_unit_test(test_trn_cli_xdp_stage_subcmd),
+		cmocka_unit_test(test_trn_cli_get_xdp_stage_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_dft_subcmd),
+		cmocka_unit_test(test_trn_cli_chain_subcmd),
+		cmocka_unit_test(test_trn_cli_scaled_ep_subcmd),
+		cmocka_unit_test(test_trn_cli_get_scaled_ep_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_update_flood_list_subcmd),
+		cmocka_unit_test(test_trn_cli_get_flood_stats_subcmd),
+		cmocka_unit_test(test_trn_cli_eip_subcmd),
+		cmocka_unit_test(test_trn_cli_ep6_subcmd),
+		cmocka_unit_test(test_trn_cli_update_sg_rules_subcmd),
+		cmocka_unit_test(test_trn_cli_update_sg_identity_rules_subcmd),
+		cmocka_unit_test(test_trn_cli_update_rate_limit_subcmd),
+		cmocka_unit_test(test_trn_cli_dump_conntrack_subcmd),
 	};
 	return cmocka_run_group_tests(tests, NULL, NULL);
 }
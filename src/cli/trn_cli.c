@@ -34,11 +34,54 @@ static const struct cmd {
 	{ "load-transit-xdp", trn_cli_load_transit_subcmd },
 	{ "unload-transit-xdp", trn_cli_unload_transit_subcmd },
 	{ "update-droplet", trn_cli_update_droplet_subcmd },
+	{ "update-dft", trn_cli_update_dft_subcmd },
+	{ "get-dft", trn_cli_get_dft_subcmd },
+	{ "delete-dft", trn_cli_delete_dft_subcmd },
+	{ "update-chain", trn_cli_update_chain_subcmd },
+	{ "get-chain", trn_cli_get_chain_subcmd },
+	{ "delete-chain", trn_cli_delete_chain_subcmd },
+	{ "update-ftn", trn_cli_update_ftn_subcmd },
+	{ "get-ftn", trn_cli_get_ftn_subcmd },
+	{ "delete-ftn", trn_cli_delete_ftn_subcmd },
+	{ "update-scaled-ep", trn_cli_update_scaled_ep_subcmd },
+	{ "get-scaled-ep", trn_cli_get_scaled_ep_subcmd },
+	{ "delete-scaled-ep", trn_cli_delete_scaled_ep_subcmd },
+	{ "get-scaled-ep-stats", trn_cli_get_scaled_ep_stats_subcmd },
+	{ "update-flood-list", trn_cli_update_flood_list_subcmd },
+	{ "get-flood-list", trn_cli_get_flood_list_subcmd },
+	{ "delete-flood-list", trn_cli_delete_flood_list_subcmd },
+	{ "get-flood-stats", trn_cli_get_flood_stats_subcmd },
+	{ "update-eip", trn_cli_update_eip_subcmd },
+	{ "get-eip", trn_cli_get_eip_subcmd },
+	{ "delete-eip", trn_cli_delete_eip_subcmd },
+	{ "update-eip-gateway", trn_cli_update_eip_gateway_subcmd },
+	{ "get-eip-stats", trn_cli_get_eip_stats_subcmd },
+	{ "update-ep6", trn_cli_update_ep6_subcmd },
+	{ "get-ep6", trn_cli_get_ep6_subcmd },
+	{ "delete-ep6", trn_cli_delete_ep6_subcmd },
+	{ "update-sg-rules", trn_cli_update_sg_rules_subcmd },
+	{ "delete-sg-rules", trn_cli_delete_sg_rules_subcmd },
+	{ "update-sg-identity-rules", trn_cli_update_sg_identity_rules_subcmd },
+	{ "delete-sg-identity-rule", trn_cli_delete_sg_identity_rule_subcmd },
+	{ "update-rate-limit", trn_cli_update_rate_limit_subcmd },
+	{ "delete-rate-limit", trn_cli_delete_rate_limit_subcmd },
+	{ "get-rate-limit-stats", trn_cli_get_rate_limit_stats_subcmd },
+	{ "dump-conntrack", trn_cli_dump_conntrack_subcmd },
+	{ "flush-conntrack", trn_cli_flush_conntrack_subcmd },
 	{ "update-ep", trn_cli_update_ep_subcmd },
 	{ "get-ep", trn_cli_get_ep_subcmd },
 	{ "delete-ep", trn_cli_delete_ep_subcmd },
+	{ "get-ep-misses", trn_cli_get_ep_misses_subcmd },
 	{ "load-ebpf-prog", trn_cli_load_ebpf_prog_subcmd },
 	{ "unload-ebpf-prog", trn_cli_unload_ebpf_prog_subcmd },
+	{ "get-xsk-stats", trn_cli_get_xsk_stats_subcmd },
+	{ "get-upcall-stats", trn_cli_get_upcall_stats_subcmd },
+	{ "get-flow-cache-stats", trn_cli_get_flow_cache_stats_subcmd },
+	{ "get-cpu-spread-stats", trn_cli_get_cpu_spread_stats_subcmd },
+	{ "get-xdp-mode", trn_cli_get_xdp_mode_subcmd },
+	{ "insert-xdp-stage", trn_cli_insert_xdp_stage_subcmd },
+	{ "remove-xdp-stage", trn_cli_remove_xdp_stage_subcmd },
+	{ "get-xdp-stage-stats", trn_cli_get_xdp_stage_stats_subcmd },
 	{ 0 },
 };
 
@@ -68,19 +68,90 @@ int trn_cli_parse_json_number_mac(const cJSON *jsonobj, const char *const key,
 int trn_cli_parse_json_number_u32(const cJSON *jsonobj, const char *const key,
 	unsigned int *buf);
 int trn_cli_parse_json_str_ip(const cJSON *jsonobj, const char *const key, unsigned int *buf);
+int trn_cli_parse_json_str_ip6(const cJSON *jsonobj, const char *const key, unsigned int *buf);
 int trn_cli_parse_json_str_mac(const cJSON *jsonobj, const char *const key, unsigned char *buf);
 int trn_cli_parse_arion_key(const cJSON *jsonobj,
 			   struct rpc_trn_arion_key_t *arion_key);
+int trn_cli_parse_ep_key(const cJSON *jsonobj, rpc_endpoint_key_t *epk);
+int trn_cli_parse_vni_key(const cJSON *jsonobj, rpc_trn_vni_key_t *key);
+int trn_cli_read_vni_key(int argc, char *argv[], rpc_trn_vni_key_t *key);
+int trn_cli_parse_xdp_mode(const cJSON *jsonobj, const char *const key,
+			   uint32_t *mode);
 
 int trn_cli_update_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_delete_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_get_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_ep_misses_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_load_transit_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_unload_transit_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_update_droplet_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_dft_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_dft_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_dft_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_chain_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_chain_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_chain_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_ftn_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_ftn_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_ftn_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_scaled_ep_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_flood_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_eip_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_eip_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_eip_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_eip_gateway_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_eip_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_ep6_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_ep6_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_ep6_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_sg_rules_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_sg_rules_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_update_sg_identity_rules_subcmd(CLIENT *clnt, int argc,
+					    char *argv[]);
+int trn_cli_delete_sg_identity_rule_subcmd(CLIENT *clnt, int argc,
+					   char *argv[]);
+int trn_cli_update_rate_limit_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_delete_rate_limit_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_rate_limit_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_dump_conntrack_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_flush_conntrack_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_xsk_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_upcall_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_flow_cache_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_cpu_spread_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_xdp_mode_subcmd(CLIENT *clnt, int argc, char *argv[]);
 
 int trn_cli_load_ebpf_prog_subcmd(CLIENT *clnt, int argc, char *argv[]);
 int trn_cli_unload_ebpf_prog_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_insert_xdp_stage_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_remove_xdp_stage_subcmd(CLIENT *clnt, int argc, char *argv[]);
+int trn_cli_get_xdp_stage_stats_subcmd(CLIENT *clnt, int argc, char *argv[]);
 
 void dump_droplet(rpc_trn_droplet_t *droplet);
+void dump_dft(rpc_trn_dft_t *dft);
+void dump_chain(rpc_trn_chain_t *chain);
+void dump_ftn(rpc_trn_ftn_t *ftn);
+void dump_scaled_ep(rpc_trn_scaled_ep_t *sep);
+void dump_scaled_ep_stats(rpc_trn_scaled_ep_stats_t *stats);
+void dump_flood_list(rpc_trn_flood_list_t *fl);
+void dump_flood_stats(rpc_trn_flood_stats_t *stats);
+void dump_eip(rpc_trn_eip_t *eip);
+void dump_eip_stats(rpc_trn_eip_stats_t *stats);
+void dump_rate_limit(rpc_trn_rate_limit_t *rl);
+void dump_rate_limit_stats(rpc_trn_rate_limit_stats_t *stats);
+void dump_ep6(rpc_trn_endpoint6_t *ep);
+void dump_conntrack(rpc_trn_ct_list_t *cts);
 void dump_ep(trn_ep_t *ep);
+void dump_ep_misses(rpc_trn_ep_miss_list_t *misses);
+void dump_xsk_stats(char *itf, rpc_trn_xsk_stats_t *stats);
+void dump_upcall_stats(rpc_trn_upcall_stats_t *stats);
+void dump_flow_cache_stats(rpc_trn_flow_cache_stats_t *stats);
+void dump_cpu_spread_stats(rpc_trn_cpu_spread_stats_list_t *stats);
+void dump_xdp_mode(char *itf, rpc_trn_xdp_mode_t *mode);
+void dump_xdp_stage_stats(rpc_trn_xdp_stage_stats_list_t *stats);
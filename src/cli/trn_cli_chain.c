@@ -0,0 +1,306 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_chain.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to chains and FTNs
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+/* Ids are sent by mgmt as strings, numbers are taken as well */
+static int trn_cli_parse_id(const cJSON *jsonobj, const char *const key,
+			    unsigned int *id)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
+
+	if (item == NULL) {
+		print_err("Error: Missing %s\n", key);
+		return -EINVAL;
+	} else if (cJSON_IsString(item)) {
+		*id = atoi(item->valuestring);
+	} else if (cJSON_IsNumber(item)) {
+		*id = (unsigned int)item->valuedouble;
+	} else {
+		print_err("Error: Invalid %s type\n", key);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_chain(const cJSON *jsonobj, struct rpc_trn_chain_t *chain)
+{
+	if (trn_cli_parse_id(jsonobj, "id", &chain->id)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_id(jsonobj, "tail_ftn", &chain->tail_ftn)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_ftn(const cJSON *jsonobj, struct rpc_trn_ftn_t *ftn)
+{
+	if (trn_cli_parse_id(jsonobj, "id", &ftn->id)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_id(jsonobj, "ftn_position", &ftn->position)) {
+		return -EINVAL;
+	} else if (ftn->position > TRAN_FTN_TYPE_TAIL) {
+		print_err("Error: ftn_position should be 0 (head) to %d (tail)\n",
+			  TRAN_FTN_TYPE_TAIL);
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "ip", &ftn->ip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "mac", ftn->mac)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "next_ip", &ftn->next_ip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "next_mac", ftn->next_mac)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* get/delete of chains and FTNs share the key parsing and rpc checks */
+static int trn_cli_read_arion_key(int argc, char *argv[],
+				  rpc_trn_arion_key_t *key)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int err = trn_cli_parse_arion_key(json_str, key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing key.\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int trn_cli_check_rc(int *rc, const char *rpc)
+{
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: %s.\n", rpc);
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_update_chain_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_trn_chain_t chain;
+
+	int err = trn_cli_parse_chain(json_str, &chain);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing chain config.\n");
+		return -EINVAL;
+	}
+
+	if (trn_cli_check_rc(update_chain_1(&chain, clnt), "update_chain_1")) {
+		return -EINVAL;
+	}
+
+	dump_chain(&chain);
+	print_msg("update_chain_1 successfully updated chain %d.\n", chain.id);
+	return 0;
+}
+
+int trn_cli_get_chain_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_arion_key_t key;
+	rpc_trn_chain_t *chain;
+
+	if (trn_cli_read_arion_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	chain = get_chain_1(&key, clnt);
+	if (chain == NULL) {
+		print_err("RPC Error: client call failed: get_chain_1.\n");
+		return -EINVAL;
+	}
+
+	dump_chain(chain);
+	return 0;
+}
+
+int trn_cli_delete_chain_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_arion_key_t key;
+
+	if (trn_cli_read_arion_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_check_rc(delete_chain_1(&key, clnt), "delete_chain_1")) {
+		return -EINVAL;
+	}
+
+	print_msg("delete_chain_1 successfully deleted chain %d.\n", key.id);
+	return 0;
+}
+
+int trn_cli_update_ftn_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_trn_ftn_t ftn;
+
+	int err = trn_cli_parse_ftn(json_str, &ftn);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing FTN config.\n");
+		return -EINVAL;
+	}
+
+	if (trn_cli_check_rc(update_ftn_1(&ftn, clnt), "update_ftn_1")) {
+		return -EINVAL;
+	}
+
+	dump_ftn(&ftn);
+	print_msg("update_ftn_1 successfully updated FTN %d.\n", ftn.id);
+	return 0;
+}
+
+int trn_cli_get_ftn_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_arion_key_t key;
+	rpc_trn_ftn_t *ftn;
+
+	if (trn_cli_read_arion_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	ftn = get_ftn_1(&key, clnt);
+	if (ftn == NULL) {
+		print_err("RPC Error: client call failed: get_ftn_1.\n");
+		return -EINVAL;
+	}
+
+	dump_ftn(ftn);
+	return 0;
+}
+
+int trn_cli_delete_ftn_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_arion_key_t key;
+
+	if (trn_cli_read_arion_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_check_rc(delete_ftn_1(&key, clnt), "delete_ftn_1")) {
+		return -EINVAL;
+	}
+
+	print_msg("delete_ftn_1 successfully deleted FTN %d.\n", key.id);
+	return 0;
+}
+
+void dump_chain(struct rpc_trn_chain_t *chain)
+{
+	print_msg("Chain: %d\n", chain->id);
+	print_msg("Tail FTN: %d\n", chain->tail_ftn);
+}
+
+void dump_ftn(struct rpc_trn_ftn_t *ftn)
+{
+	static const char *positions[] = {
+		[TRAN_FTN_TYPE_HEAD] = "head",
+		[TRAN_FTN_TYPE_MIDDLE] = "middle",
+		[TRAN_FTN_TYPE_TAIL] = "tail",
+	};
+
+	print_msg("FTN: %d\n", ftn->id);
+	print_msg("Position: %s\n", ftn->position <= TRAN_FTN_TYPE_TAIL ?
+		  positions[ftn->position] : "unknown");
+	print_msg("IP: 0x%08x MAC: %02x:%02x:%02x:%02x:%02x:%02x\n", ftn->ip,
+		  ftn->mac[0], ftn->mac[1], ftn->mac[2], ftn->mac[3],
+		  ftn->mac[4], ftn->mac[5]);
+	print_msg("Next IP: 0x%08x MAC: %02x:%02x:%02x:%02x:%02x:%02x\n",
+		  ftn->next_ip, ftn->next_mac[0], ftn->next_mac[1],
+		  ftn->next_mac[2], ftn->next_mac[3], ftn->next_mac[4],
+		  ftn->next_mac[5]);
+}
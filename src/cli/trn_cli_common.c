@@ -149,6 +149,23 @@ int trn_cli_parse_json_str_ip(const cJSON *jsonobj, const char *const key, unsig
 	return 0;
 }
 
+int trn_cli_parse_json_str_ip6(const cJSON *jsonobj, const char *const key, unsigned int *buf)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
+
+	if (item == NULL) {
+		print_err("Missing %s\n", key);
+		return -EINVAL;
+	} else if (!cJSON_IsString(item)) {
+		print_err("Invalid ip type, should be string\n");
+		return -EINVAL;
+	} else if (inet_pton(AF_INET6, item->valuestring, buf) <= 0) {
+		print_err("Failed to convert ipv6 %s", item->valuestring);
+		return -EINVAL;
+	}
+	return 0;
+}
+
 int trn_cli_parse_json_str_mac(const cJSON *jsonobj, const char *const key, unsigned char *buf)
 {
 	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
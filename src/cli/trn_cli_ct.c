@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_ct.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to connection tracking
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+/* Connections of all VNIs are selected if vni is missing */
+static int trn_cli_parse_ct_filter(const cJSON *jsonobj,
+				   struct rpc_trn_ct_filter_t *filter)
+{
+	filter->vni = 0;
+	filter->all_vnis = cJSON_GetObjectItem(jsonobj, "vni") == NULL;
+
+	if (!filter->all_vnis &&
+	    trn_cli_parse_json_number_u32(jsonobj, "vni", &filter->vni)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int trn_cli_read_ct_filter(int argc, char *argv[],
+				  rpc_trn_ct_filter_t *filter)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int err = trn_cli_parse_ct_filter(json_str, filter);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing connection filter.\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_dump_conntrack_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_ct_filter_t filter;
+	rpc_trn_ct_list_t *cts;
+
+	if (trn_cli_read_ct_filter(argc, argv, &filter)) {
+		return -EINVAL;
+	}
+
+	cts = dump_conntrack_1(&filter, clnt);
+	if (cts == NULL) {
+		print_err("RPC Error: client call failed: dump_conntrack_1.\n");
+		return -EINVAL;
+	}
+
+	dump_conntrack(cts);
+	return 0;
+}
+
+int trn_cli_flush_conntrack_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_ct_filter_t filter;
+	int *rc;
+	char rpc[] = "flush_conntrack_1";
+
+	if (trn_cli_read_ct_filter(argc, argv, &filter)) {
+		return -EINVAL;
+	}
+
+	rc = flush_conntrack_1(&filter, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: flush_conntrack_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	if (filter.all_vnis) {
+		print_msg("flush_conntrack_1 successfully flushed all connections.\n");
+	} else {
+		print_msg("flush_conntrack_1 successfully flushed connections of VNI %d.\n",
+			  filter.vni);
+	}
+	return 0;
+}
+
+void dump_conntrack(struct rpc_trn_ct_list_t *cts)
+{
+	static const char *states[] = {
+		[TRAN_CT_NEW] = "new",
+		[TRAN_CT_ESTABLISHED] = "established",
+		[TRAN_CT_CLOSING] = "closing",
+	};
+	char saddr[INET_ADDRSTRLEN], daddr[INET_ADDRSTRLEN];
+	unsigned int i;
+
+	for (i = 0; i < cts->entries.entries_len; i++) {
+		rpc_trn_ct_entry_t *ct = &cts->entries.entries_val[i];
+
+		inet_ntop(AF_INET, &ct->saddr, saddr, sizeof(saddr));
+		inet_ntop(AF_INET, &ct->daddr, daddr, sizeof(daddr));
+		print_msg("VNI: %d proto: %d %s:%d -> %s:%d %s idle: %ds\n",
+			  ct->vni, ct->protocol, saddr, ct->sport, daddr,
+			  ct->dport, ct->state <= TRAN_CT_CLOSING ?
+			  states[ct->state] : "unknown", ct->idle);
+	}
+	print_msg("Connections: %d of %d\n", cts->entries.entries_len,
+		  cts->total);
+}
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_dft.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to DFTs
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+/* Parse cJSON into struct, table entries are chain ids as number or string */
+int trn_cli_parse_dft(const cJSON *jsonobj, struct rpc_trn_dft_t *dft)
+{
+	rpc_trn_arion_key_t key;
+	cJSON *table = cJSON_GetObjectItem(jsonobj, "table");
+	cJSON *entry;
+	int i = 0;
+
+	if (trn_cli_parse_arion_key(jsonobj, &key)) {
+		return -EINVAL;
+	}
+	dft->id = key.id;
+
+	if (table == NULL) {
+		print_err("Error: Missing table\n");
+		return -EINVAL;
+	} else if (!cJSON_IsArray(table)) {
+		print_err("Error: table should be array type\n");
+		return -EINVAL;
+	} else if (cJSON_GetArraySize(table) == 0 ||
+		   cJSON_GetArraySize(table) > TRAN_MAX_DFT_TABLE_SIZE) {
+		print_err("Error: table size should be 1 to %d\n",
+			  TRAN_MAX_DFT_TABLE_SIZE);
+		return -EINVAL;
+	}
+
+	cJSON_ArrayForEach(entry, table) {
+		if (cJSON_IsNumber(entry)) {
+			dft->table.table_val[i] = (unsigned int)entry->valuedouble;
+		} else if (cJSON_IsString(entry)) {
+			dft->table.table_val[i] = atoi(entry->valuestring);
+		} else {
+			print_err("Error: table entry %d is not a chain id\n", i);
+			return -EINVAL;
+		}
+		i++;
+	}
+	dft->table.table_len = i;
+
+	return 0;
+}
+
+int trn_cli_update_dft_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_dft_t dft;
+	char rpc[] = "update_dft_1";
+
+	dft.table.table_val = malloc(TRAN_MAX_DFT_TABLE_SIZE *
+				     sizeof(*dft.table.table_val));
+	if (dft.table.table_val == NULL) {
+		cJSON_Delete(json_str);
+		print_err("Error: out of memory for DFT table.\n");
+		return -ENOMEM;
+	}
+
+	int err = trn_cli_parse_dft(json_str, &dft);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		free(dft.table.table_val);
+		print_err("Error: parsing DFT config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_dft_1(&dft, clnt);
+	free(dft.table.table_val);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_dft_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("update_dft_1 successfully updated DFT %d with %d entries.\n",
+		  dft.id, dft.table.table_len);
+	return 0;
+}
+
+int trn_cli_get_dft_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_trn_arion_key_t key;
+	rpc_trn_dft_t *dft;
+
+	int err = trn_cli_parse_arion_key(json_str, &key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing DFT key.\n");
+		return -EINVAL;
+	}
+
+	dft = get_dft_1(&key, clnt);
+	if (dft == NULL) {
+		print_err("RPC Error: client call failed: get_dft_1.\n");
+		return -EINVAL;
+	}
+
+	dump_dft(dft);
+
+	return 0;
+}
+
+int trn_cli_delete_dft_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_arion_key_t key;
+	char rpc[] = "delete_dft_1";
+
+	int err = trn_cli_parse_arion_key(json_str, &key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing DFT key.\n");
+		return -EINVAL;
+	}
+
+	rc = delete_dft_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_dft_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_dft_1 successfully deleted DFT %d.\n", key.id);
+
+	return 0;
+}
+
+void dump_dft(struct rpc_trn_dft_t *dft)
+{
+	unsigned int i;
+
+	print_msg("DFT: %d\n", dft->id);
+	print_msg("Table size: %d\n", dft->table.table_len);
+	print_msg("Table: [");
+	for (i = 0; i < dft->table.table_len; i++) {
+		print_msg("%s%d", i ? ", " : "", dft->table.table_val[i]);
+	}
+	print_msg("]\n");
+}
@@ -50,6 +50,55 @@ int trn_cli_parse_droplet(const cJSON *jsonobj, struct rpc_trn_droplet_t *drople
 		i++;
 	}
 
+	/* Optional, derive outer UDP source port from the inner flow */
+	cJSON *sport_hash = cJSON_GetObjectItem(jsonobj, "sport_hash");
+	droplet->options = 0;
+	if (sport_hash != NULL) {
+		__u32 enable;
+
+		if (trn_cli_parse_json_number_u32(jsonobj, "sport_hash", &enable)) {
+			return -EINVAL;
+		}
+		if (enable) {
+			droplet->options |= TRAN_ITF_OPT_SPORT_HASH;
+		}
+	}
+
+	/* Optional, carry source host hint in overlay header, not a trailer */
+	cJSON *hint_hdr = cJSON_GetObjectItem(jsonobj, "hint_hdr");
+	if (hint_hdr != NULL) {
+		__u32 enable;
+
+		if (trn_cli_parse_json_number_u32(jsonobj, "hint_hdr", &enable)) {
+			return -EINVAL;
+		}
+		if (enable) {
+			droplet->options |= TRAN_ITF_OPT_HINT_HDR;
+		}
+	}
+
+	/* Optional, DFT that flows missing an endpoint are spread over */
+	droplet->dft_id = TRAN_UNUSED_DFT_ID;
+	if (cJSON_GetObjectItem(jsonobj, "dft") != NULL) {
+		if (trn_cli_parse_json_number_u32(jsonobj, "dft",
+						  &droplet->dft_id)) {
+			return -EINVAL;
+		}
+		if (droplet->dft_id >= TRAN_MAX_DFT) {
+			print_err("Error: dft over limit %d\n", TRAN_MAX_DFT);
+			return -EINVAL;
+		}
+	}
+
+	/* Optional, FTN of a chain the droplet serves */
+	droplet->ftn_id = TRAN_UNUSED_FTN_ID;
+	if (cJSON_GetObjectItem(jsonobj, "ftn") != NULL) {
+		if (trn_cli_parse_json_number_u32(jsonobj, "ftn",
+						  &droplet->ftn_id)) {
+			return -EINVAL;
+		}
+	}
+
 	return 0;
 }
 
@@ -119,4 +168,14 @@ void dump_droplet(struct rpc_trn_droplet_t *droplet)
 			droplet->entrances[i].mac[5]);
 	}
 	print_msg("]\n");
+	print_msg("sport_hash: %s\n",
+		droplet->options & TRAN_ITF_OPT_SPORT_HASH ? "on" : "off");
+	print_msg("hint_hdr: %s\n",
+		droplet->options & TRAN_ITF_OPT_HINT_HDR ? "on" : "off");
+	if (droplet->dft_id != TRAN_UNUSED_DFT_ID) {
+		print_msg("dft: %d\n", droplet->dft_id);
+	}
+	if (droplet->ftn_id != TRAN_UNUSED_FTN_ID) {
+		print_msg("ftn: %d\n", droplet->ftn_id);
+	}
 }
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_eip.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to elastic IPs of gateway endpoints
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+int trn_cli_parse_eip(const cJSON *jsonobj, struct rpc_trn_eip_t *eip)
+{
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &eip->vni)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "ip", &eip->ip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "eip", &eip->eip)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_eip_gw(const cJSON *jsonobj, struct rpc_trn_eip_gw_t *gw)
+{
+	if (trn_cli_parse_json_string(jsonobj, "interface", gw->interface)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_xdp_mode(jsonobj, "xdp_mode", &gw->xdp_mode)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "mac", gw->mac)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "gw_mac", gw->gw_mac)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "tunnel_ip", &gw->tunnel_ip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "tunnel_mac", gw->tunnel_mac)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* get/delete of elastic IPs are keyed by their endpoint */
+static int trn_cli_read_eip_key(int argc, char *argv[], rpc_endpoint_key_t *key)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int err = trn_cli_parse_ep_key(json_str, key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing gateway endpoint key.\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_update_eip_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_eip_t eip;
+	char rpc[] = "update_eip_1";
+
+	int err = trn_cli_parse_eip(json_str, &eip);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing elastic IP config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_eip_1(&eip, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_eip_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	dump_eip(&eip);
+	print_msg("update_eip_1 successfully updated elastic IP 0x%08x.\n",
+		  eip.eip);
+	return 0;
+}
+
+int trn_cli_get_eip_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_endpoint_key_t key;
+	rpc_trn_eip_t *eip;
+
+	if (trn_cli_read_eip_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	eip = get_eip_1(&key, clnt);
+	if (eip == NULL) {
+		print_err("RPC Error: client call failed: get_eip_1.\n");
+		return -EINVAL;
+	}
+
+	dump_eip(eip);
+	return 0;
+}
+
+int trn_cli_delete_eip_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_endpoint_key_t key;
+	int *rc;
+	char rpc[] = "delete_eip_1";
+
+	if (trn_cli_read_eip_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	rc = delete_eip_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_eip_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_eip_1 successfully deleted elastic IP of 0x%08x.\n",
+		  key.ip);
+	return 0;
+}
+
+int trn_cli_update_eip_gateway_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	char itf[TRAN_MAX_ITF_SIZE];
+	rpc_trn_eip_gw_t gw = { .interface = itf };
+	char rpc[] = "update_eip_gateway_1";
+
+	int err = trn_cli_parse_eip_gw(json_str, &gw);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing elastic IP gateway config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_eip_gateway_1(&gw, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_eip_gateway_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("update_eip_gateway_1 successfully attached elastic IP gateway %s.\n",
+		  gw.interface);
+	return 0;
+}
+
+int trn_cli_get_eip_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_eip_stats_t *stats;
+	char *dummy = NULL;
+
+	stats = get_eip_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_eip_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_eip_stats(stats);
+	print_msg("get_eip_stats_1 successfully queried elastic IP stats.\n");
+	return 0;
+}
+
+void dump_eip(rpc_trn_eip_t *eip)
+{
+	print_msg("VNI: %d\n", eip->vni);
+	print_msg("IP: 0x%x\n", eip->ip);
+	print_msg("EIP: 0x%x\n", eip->eip);
+}
+
+void dump_eip_stats(rpc_trn_eip_stats_t *stats)
+{
+	print_msg("snat packets: %lu\n", (unsigned long)stats->snat_pkts);
+	print_msg("dnat packets: %lu\n", (unsigned long)stats->dnat_pkts);
+	print_msg("dropped: %lu\n", (unsigned long)stats->dropped);
+}
@@ -94,6 +94,19 @@ int trn_cli_parse_ep(const cJSON *jsonobj, rpc_trn_endpoint_batch_t *batch)
 			goto cleanup;
 		}
 
+		/* Optional security identity of identity based policy */
+		item->xdp_ep.val.identity = 0;
+		if (cJSON_GetObjectItem(ep, "identity") != NULL) {
+			unsigned int identity;
+
+			if (trn_cli_parse_json_number_u32(ep, "identity", &identity) ||
+			    identity > 0xffff) {
+				print_err("Error: identity should be 0 to 65535\n");
+				goto cleanup;
+			}
+			item->xdp_ep.val.identity = identity;
+		}
+
 		item++;
 		i++;
 	}
@@ -249,6 +262,38 @@ int trn_cli_delete_ep_subcmd(CLIENT *clnt, int argc, char *argv[])
 	return 0;
 }
 
+int trn_cli_get_ep_misses_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_ep_miss_list_t *misses;
+	char *dummy = NULL;
+
+	misses = get_ep_misses_1((void *)&dummy, clnt);
+	if (misses == NULL) {
+		print_err("RPC Error: client call failed: get_ep_misses_1.\n");
+		return -EINVAL;
+	}
+
+	dump_ep_misses(misses);
+	return 0;
+}
+
+void dump_ep_misses(rpc_trn_ep_miss_list_t *misses)
+{
+	char ip[INET_ADDRSTRLEN];
+	unsigned int i;
+
+	for (i = 0; i < misses->misses.misses_len; i++) {
+		rpc_trn_ep_miss_t *m = &misses->misses.misses_val[i];
+
+		inet_ntop(AF_INET, &m->ip, ip, sizeof(ip));
+		print_msg("VNI: %d IP: %s packets: %d\n", m->vni, ip,
+			  m->packets);
+	}
+	print_msg("Misses: %d\n", misses->misses.misses_len);
+}
+
 void dump_ep(trn_ep_t *ep)
 {
 	int i;
@@ -262,4 +307,5 @@ void dump_ep(trn_ep_t *ep)
 	print_msg("Host MAC: %02x:%02x:%02x:%02x:%02x:%02x\n",
 		ep->xdp_ep.val.hmac[0],ep->xdp_ep.val.hmac[1],ep->xdp_ep.val.hmac[2],
 		ep->xdp_ep.val.hmac[3],ep->xdp_ep.val.hmac[4],ep->xdp_ep.val.hmac[5]);
+	print_msg("Identity: %d\n", ep->xdp_ep.val.identity);
 }
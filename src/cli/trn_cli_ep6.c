@@ -0,0 +1,198 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_ep6.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to IPv6 endpoints
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+int trn_cli_parse_ep6_key(const cJSON *jsonobj, rpc_endpoint6_key_t *key)
+{
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &key->vni)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip6(jsonobj, "ip", key->ip)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_ep6(const cJSON *jsonobj, struct rpc_trn_endpoint6_t *ep)
+{
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &ep->vni)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip6(jsonobj, "ip", ep->ip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "hip", &ep->hip)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "mac", ep->mac)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_mac(jsonobj, "hmac", ep->hmac)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* get/delete of IPv6 endpoints share the key parsing */
+static int trn_cli_read_ep6_key(int argc, char *argv[],
+				rpc_endpoint6_key_t *key)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int err = trn_cli_parse_ep6_key(json_str, key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing IPv6 endpoint key.\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_update_ep6_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_endpoint6_t ep;
+	char rpc[] = "update_ep6_1";
+
+	int err = trn_cli_parse_ep6(json_str, &ep);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing IPv6 endpoint config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_ep6_1(&ep, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_ep6_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	dump_ep6(&ep);
+	print_msg("update_ep6_1 successfully updated IPv6 endpoint.\n");
+	return 0;
+}
+
+int trn_cli_get_ep6_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_endpoint6_key_t key;
+	rpc_trn_endpoint6_t *ep;
+
+	if (trn_cli_read_ep6_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	ep = get_ep6_1(&key, clnt);
+	if (ep == NULL) {
+		print_err("RPC Error: client call failed: get_ep6_1.\n");
+		return -EINVAL;
+	}
+
+	dump_ep6(ep);
+	return 0;
+}
+
+int trn_cli_delete_ep6_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_endpoint6_key_t key;
+	int *rc;
+	char rpc[] = "delete_ep6_1";
+
+	if (trn_cli_read_ep6_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	rc = delete_ep6_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_ep6_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_ep6_1 successfully deleted IPv6 endpoint.\n");
+	return 0;
+}
+
+void dump_ep6(struct rpc_trn_endpoint6_t *ep)
+{
+	char ip[INET6_ADDRSTRLEN];
+
+	inet_ntop(AF_INET6, ep->ip, ip, sizeof(ip));
+	print_msg("VNI: %d IP: %s\n", ep->vni, ip);
+	print_msg("MAC: %02x:%02x:%02x:%02x:%02x:%02x\n", ep->mac[0],
+		  ep->mac[1], ep->mac[2], ep->mac[3], ep->mac[4], ep->mac[5]);
+	print_msg("Host IP: 0x%08x MAC: %02x:%02x:%02x:%02x:%02x:%02x\n",
+		  ep->hip, ep->hmac[0], ep->hmac[1], ep->hmac[2], ep->hmac[3],
+		  ep->hmac[4], ep->hmac[5]);
+}
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_flood.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to BUM flood lists
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+int trn_cli_parse_vni_key(const cJSON *jsonobj, rpc_trn_vni_key_t *key)
+{
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &key->vni)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_flood_list(const cJSON *jsonobj,
+			     struct rpc_trn_flood_list_t *fl)
+{
+	cJSON *hosts = cJSON_GetObjectItem(jsonobj, "hosts");
+	cJSON *host;
+	int i = 0;
+
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &fl->vni)) {
+		return -EINVAL;
+	}
+
+	/* Optional replication cap, all hosts get a copy if missing */
+	fl->cap = 0;
+	if (cJSON_GetObjectItem(jsonobj, "cap") != NULL &&
+	    trn_cli_parse_json_number_u32(jsonobj, "cap", &fl->cap)) {
+		return -EINVAL;
+	}
+
+	if (hosts == NULL) {
+		print_err("Error: Missing hosts\n");
+		return -EINVAL;
+	} else if (!cJSON_IsArray(hosts)) {
+		print_err("Error: hosts should be array type\n");
+		return -EINVAL;
+	} else if (cJSON_GetArraySize(hosts) == 0 ||
+		   cJSON_GetArraySize(hosts) > TRAN_MAX_FLOOD) {
+		print_err("Error: hosts size should be 1 to %d\n",
+			  TRAN_MAX_FLOOD);
+		return -EINVAL;
+	}
+
+	cJSON_ArrayForEach(host, hosts) {
+		if (trn_cli_parse_json_str_ip(host, "ip",
+					      &fl->hosts.hosts_val[i].ip) ||
+		    trn_cli_parse_json_str_mac(host, "mac",
+					       fl->hosts.hosts_val[i].mac)) {
+			print_err("Error: hosts entry %d is not a host\n", i);
+			return -EINVAL;
+		}
+		i++;
+	}
+	fl->hosts.hosts_len = i;
+
+	return 0;
+}
+
+/* get/delete of per-VNI objects share the key parsing */
+int trn_cli_read_vni_key(int argc, char *argv[], rpc_trn_vni_key_t *key)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int err = trn_cli_parse_vni_key(json_str, key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing vni.\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_update_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_flood_list_t fl;
+	rpc_addr_t hosts[TRAN_MAX_FLOOD];
+	char rpc[] = "update_flood_list_1";
+
+	fl.hosts.hosts_val = hosts;
+
+	int err = trn_cli_parse_flood_list(json_str, &fl);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing flood list config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_flood_list_1(&fl, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_flood_list_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	dump_flood_list(&fl);
+	print_msg("update_flood_list_1 successfully updated flood list %d.\n",
+		  fl.vni);
+	return 0;
+}
+
+int trn_cli_get_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_vni_key_t key;
+	rpc_trn_flood_list_t *fl;
+
+	if (trn_cli_read_vni_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	fl = get_flood_list_1(&key, clnt);
+	if (fl == NULL) {
+		print_err("RPC Error: client call failed: get_flood_list_1.\n");
+		return -EINVAL;
+	}
+
+	dump_flood_list(fl);
+	return 0;
+}
+
+int trn_cli_delete_flood_list_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_vni_key_t key;
+	int *rc;
+	char rpc[] = "delete_flood_list_1";
+
+	if (trn_cli_read_vni_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	rc = delete_flood_list_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_flood_list_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_flood_list_1 successfully deleted flood list %d.\n",
+		  key.vni);
+	return 0;
+}
+
+int trn_cli_get_flood_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_vni_key_t key;
+	rpc_trn_flood_stats_t *stats;
+
+	if (trn_cli_read_vni_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	stats = get_flood_stats_1(&key, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_flood_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_flood_stats(stats);
+	print_msg("get_flood_stats_1 successfully queried flood stats of %d.\n",
+		  key.vni);
+	return 0;
+}
+
+void dump_flood_list(rpc_trn_flood_list_t *fl)
+{
+	unsigned int i;
+
+	print_msg("VNI: %d\n", fl->vni);
+	print_msg("Cap: %d\n", fl->cap);
+	print_msg("Hosts: %d\n", fl->hosts.hosts_len);
+	for (i = 0; i < fl->hosts.hosts_len; i++) {
+		rpc_addr_t *host = &fl->hosts.hosts_val[i];
+
+		print_msg("IP: 0x%08x MAC: %02x:%02x:%02x:%02x:%02x:%02x\n",
+			  host->ip, host->mac[0], host->mac[1], host->mac[2],
+			  host->mac[3], host->mac[4], host->mac[5]);
+	}
+}
+
+void dump_flood_stats(rpc_trn_flood_stats_t *stats)
+{
+	print_msg("frames: %lu\n", (unsigned long)stats->frames);
+	print_msg("copies: %lu\n", (unsigned long)stats->copies);
+	print_msg("capped: %lu\n", (unsigned long)stats->capped);
+	print_msg("dropped: %lu\n", (unsigned long)stats->dropped);
+	print_msg("rejected: %lu\n", (unsigned long)stats->rejected);
+}
@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_rate_limit.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to VNI and endpoint rate limits
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+/* The policer of the VNI is selected if ip is missing */
+static int trn_cli_parse_rate_limit_key(const cJSON *jsonobj,
+					rpc_endpoint_key_t *key)
+{
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &key->vni)) {
+		return -EINVAL;
+	}
+
+	key->ip = 0;
+	if (cJSON_GetObjectItem(jsonobj, "ip") != NULL &&
+	    trn_cli_parse_json_str_ip(jsonobj, "ip", &key->ip)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Optional rate of the host, unlimited if missing. Transitd shares it
+ * among the CPUs policing the key, so it is an average, not a per
+ * packet ceiling.
+ */
+static int trn_cli_parse_rate(const cJSON *jsonobj, const char *const key,
+			      uint64_t *rate)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
+
+	*rate = 0;
+	if (item == NULL) {
+		return 0;
+	} else if (!cJSON_IsNumber(item) || item->valuedouble < 0) {
+		print_err("Error: %s should be a positive number\n", key);
+		return -EINVAL;
+	}
+	*rate = (uint64_t)item->valuedouble;
+
+	return 0;
+}
+
+int trn_cli_parse_rate_limit(const cJSON *jsonobj,
+			     struct rpc_trn_rate_limit_t *rl)
+{
+	cJSON *action = cJSON_GetObjectItem(jsonobj, "action");
+	rpc_endpoint_key_t key;
+
+	if (trn_cli_parse_rate_limit_key(jsonobj, &key)) {
+		return -EINVAL;
+	}
+	rl->vni = key.vni;
+	rl->ip = key.ip;
+
+	if (trn_cli_parse_rate(jsonobj, "pps", &rl->pps) ||
+	    trn_cli_parse_rate(jsonobj, "bps", &rl->bps)) {
+		return -EINVAL;
+	} else if (!rl->pps && !rl->bps) {
+		print_err("Error: Missing pps or bps\n");
+		return -EINVAL;
+	}
+
+	rl->action = TRAN_RL_DROP;
+	if (action == NULL) {
+		return 0;
+	} else if (!cJSON_IsString(action)) {
+		print_err("Error: Invalid action type\n");
+		return -EINVAL;
+	} else if (!strcmp(action->valuestring, "mark")) {
+		rl->action = TRAN_RL_MARK;
+	} else if (strcmp(action->valuestring, "drop")) {
+		print_err("Error: action should be drop or mark\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_update_rate_limit_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_rate_limit_t rl;
+	char rpc[] = "update_rate_limit_1";
+
+	int err = trn_cli_parse_rate_limit(json_str, &rl);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing rate limit config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_rate_limit_1(&rl, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_rate_limit_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	dump_rate_limit(&rl);
+	print_msg("update_rate_limit_1 successfully updated rate limit of VNI %d.\n",
+		  rl.vni);
+	return 0;
+}
+
+int trn_cli_delete_rate_limit_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_endpoint_key_t key;
+	char rpc[] = "delete_rate_limit_1";
+
+	int err = trn_cli_parse_rate_limit_key(json_str, &key);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing rate limit key.\n");
+		return -EINVAL;
+	}
+
+	rc = delete_rate_limit_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_rate_limit_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_rate_limit_1 successfully deleted rate limit of VNI %d ip 0x%08x.\n",
+		  key.vni, key.ip);
+	return 0;
+}
+
+int trn_cli_get_rate_limit_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_vni_key_t key;
+	rpc_trn_rate_limit_stats_t *stats;
+
+	if (trn_cli_read_vni_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	stats = get_rate_limit_stats_1(&key, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_rate_limit_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_rate_limit_stats(stats);
+	print_msg("get_rate_limit_stats_1 successfully queried rate limit stats of %d.\n",
+		  key.vni);
+	return 0;
+}
+
+void dump_rate_limit(rpc_trn_rate_limit_t *rl)
+{
+	print_msg("VNI: %d\n", rl->vni);
+	print_msg("IP: 0x%08x\n", rl->ip);
+	print_msg("pps: %lu\n", (unsigned long)rl->pps);
+	print_msg("bps: %lu\n", (unsigned long)rl->bps);
+	print_msg("Action: %s\n", rl->action == TRAN_RL_MARK ? "mark" : "drop");
+}
+
+void dump_rate_limit_stats(rpc_trn_rate_limit_stats_t *stats)
+{
+	print_msg("marked: %lu\n", (unsigned long)stats->marked);
+	print_msg("dropped: %lu\n", (unsigned long)stats->dropped);
+	print_msg("dropped_bytes: %lu\n", (unsigned long)stats->dropped_bytes);
+}
@@ -0,0 +1,255 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_scaled_ep.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to scaled endpoints
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+int trn_cli_parse_scaled_ep(const cJSON *jsonobj,
+			    struct rpc_trn_scaled_ep_t *sep)
+{
+	cJSON *remotes = cJSON_GetObjectItem(jsonobj, "remote_ips");
+	cJSON *remote;
+	unsigned int dsr;
+	int i = 0;
+
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &sep->vni)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_json_str_ip(jsonobj, "ip", &sep->ip)) {
+		return -EINVAL;
+	}
+
+	/* Optional direct server return, replies bypass transit */
+	sep->flags = 0;
+	if (cJSON_GetObjectItem(jsonobj, "dsr") != NULL) {
+		if (trn_cli_parse_json_number_u32(jsonobj, "dsr", &dsr)) {
+			return -EINVAL;
+		}
+		if (dsr) {
+			sep->flags |= TRAN_SCALED_EP_DSR;
+		}
+	}
+
+	if (remotes == NULL) {
+		print_err("Error: Missing remote_ips\n");
+		return -EINVAL;
+	} else if (!cJSON_IsArray(remotes)) {
+		print_err("Error: remote_ips should be array type\n");
+		return -EINVAL;
+	} else if (cJSON_GetArraySize(remotes) == 0 ||
+		   cJSON_GetArraySize(remotes) > TRAN_MAX_REMOTES) {
+		print_err("Error: remote_ips size should be 1 to %d\n",
+			  TRAN_MAX_REMOTES);
+		return -EINVAL;
+	}
+
+	cJSON_ArrayForEach(remote, remotes) {
+		if (!cJSON_IsString(remote) ||
+		    inet_pton(AF_INET, remote->valuestring,
+			      &sep->remote_ips.remote_ips_val[i]) <= 0) {
+			print_err("Error: remote_ips entry %d is not an ip\n", i);
+			return -EINVAL;
+		}
+		i++;
+	}
+	sep->remote_ips.remote_ips_len = i;
+
+	return 0;
+}
+
+int trn_cli_update_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_scaled_ep_t sep;
+	uint32_t remote_ips[TRAN_MAX_REMOTES];
+	char rpc[] = "update_scaled_ep_1";
+
+	sep.remote_ips.remote_ips_val = remote_ips;
+
+	int err = trn_cli_parse_scaled_ep(json_str, &sep);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing scaled endpoint config.\n");
+		return -EINVAL;
+	}
+
+	rc = update_scaled_ep_1(&sep, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_scaled_ep_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	dump_scaled_ep(&sep);
+	print_msg("update_scaled_ep_1 successfully updated scaled endpoint 0x%08x.\n",
+		  sep.ip);
+	return 0;
+}
+
+int trn_cli_get_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_endpoint_key_t epkey;
+	rpc_trn_scaled_ep_t *sep;
+
+	int err = trn_cli_parse_ep_key(json_str, &epkey);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing scaled endpoint key.\n");
+		return -EINVAL;
+	}
+
+	sep = get_scaled_ep_1(&epkey, clnt);
+	if (sep == NULL) {
+		print_err("RPC Error: client call failed: get_scaled_ep_1.\n");
+		return -EINVAL;
+	}
+
+	dump_scaled_ep(sep);
+
+	return 0;
+}
+
+int trn_cli_delete_scaled_ep_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_endpoint_key_t epkey;
+	char rpc[] = "delete_scaled_ep_1";
+
+	int err = trn_cli_parse_ep_key(json_str, &epkey);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing scaled endpoint key.\n");
+		return -EINVAL;
+	}
+
+	rc = delete_scaled_ep_1(&epkey, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_scaled_ep_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_scaled_ep_1 successfully deleted scaled endpoint 0x%08x.\n",
+		  epkey.ip);
+
+	return 0;
+}
+
+void dump_scaled_ep(struct rpc_trn_scaled_ep_t *sep)
+{
+	unsigned int i;
+
+	print_msg("VNI: %d\n", sep->vni);
+	print_msg("IP: 0x%x\n", sep->ip);
+	print_msg("DSR: %s\n", sep->flags & TRAN_SCALED_EP_DSR ? "on" : "off");
+	print_msg("Backends: [");
+	for (i = 0; i < sep->remote_ips.remote_ips_len; i++) {
+		print_msg("%s0x%x", i ? ", " : "",
+			  sep->remote_ips.remote_ips_val[i]);
+	}
+	print_msg("]\n");
+}
+
+int trn_cli_get_scaled_ep_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_scaled_ep_stats_t *stats;
+	char *dummy = NULL;
+
+	stats = get_scaled_ep_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_scaled_ep_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_scaled_ep_stats(stats);
+	print_msg("get_scaled_ep_stats_1 successfully queried scaled endpoint stats.\n");
+	return 0;
+}
+
+void dump_scaled_ep_stats(rpc_trn_scaled_ep_stats_t *stats)
+{
+	print_msg("dsr flows: %lu\n", (unsigned long)stats->dsr_flows);
+	print_msg("dsr bytes: %lu\n", (unsigned long)stats->dsr_bytes);
+}
@@ -0,0 +1,452 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_cli_sg.c
+ * @author Wei Yue           (@w-yue)
+ *
+ * @brief CLI subcommands related to security group rules
+ *
+ * @copyright Copyright (c) 2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_cli.h"
+
+static int trn_cli_parse_sg_direction(const cJSON *jsonobj, uint32_t *dir)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, "direction");
+
+	if (item == NULL || !cJSON_IsString(item)) {
+		print_err("Error: Missing or invalid direction\n");
+		return -EINVAL;
+	} else if (!strcmp(item->valuestring, "egress")) {
+		*dir = TRAN_SG_EGRESS;
+	} else if (!strcmp(item->valuestring, "ingress")) {
+		*dir = TRAN_SG_INGRESS;
+	} else {
+		print_err("Error: direction should be egress or ingress\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* Protocols are given by name or number, any if missing */
+static int trn_cli_parse_sg_protocol(const cJSON *jsonobj, uint32_t *proto)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, "protocol");
+
+	*proto = TRAN_SG_PROTO_ANY;
+	if (item == NULL) {
+		return 0;
+	} else if (cJSON_IsNumber(item) && item->valuedouble >= 0 &&
+		   item->valuedouble <= 0xff) {
+		*proto = (uint32_t)item->valuedouble;
+	} else if (!cJSON_IsString(item)) {
+		print_err("Error: Invalid protocol type\n");
+		return -EINVAL;
+	} else if (!strcmp(item->valuestring, "tcp")) {
+		*proto = IPPROTO_TCP;
+	} else if (!strcmp(item->valuestring, "udp")) {
+		*proto = IPPROTO_UDP;
+	} else if (!strcmp(item->valuestring, "icmp")) {
+		*proto = IPPROTO_ICMP;
+	} else if (strcmp(item->valuestring, "any")) {
+		print_err("Error: Unknown protocol %s\n", item->valuestring);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int trn_cli_parse_sg_cidr(const cJSON *jsonobj,
+				 struct rpc_trn_sg_rule_t *rule)
+{
+	cJSON *item = cJSON_GetObjectItem(jsonobj, "cidr");
+	char ip[INET_ADDRSTRLEN + 3];    // with /len
+	char *len;
+
+	if (item == NULL || !cJSON_IsString(item)) {
+		print_err("Error: Missing or invalid cidr\n");
+		return -EINVAL;
+	}
+
+	snprintf(ip, sizeof(ip), "%s", item->valuestring);
+	len = strchr(ip, '/');
+	rule->prefixlen = 32;
+	if (len) {
+		*len++ = '\0';
+		rule->prefixlen = atoi(len);
+	}
+
+	if (inet_pton(AF_INET, ip, &rule->cidr) <= 0 || rule->prefixlen > 32) {
+		print_err("Error: Failed to convert cidr %s\n",
+			  item->valuestring);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int trn_cli_parse_sg_port(const cJSON *jsonobj, const char *const key,
+				 uint16_t *port, uint16_t dflt)
+{
+	unsigned int val;
+
+	*port = dflt;
+	if (cJSON_GetObjectItem(jsonobj, key) == NULL) {
+		return 0;
+	}
+
+	if (trn_cli_parse_json_number_u32(jsonobj, key, &val)) {
+		return -EINVAL;
+	} else if (val > 0xffff) {
+		print_err("Error: %s should be 0 to 65535\n", key);
+		return -EINVAL;
+	}
+	*port = val;
+
+	return 0;
+}
+
+int trn_cli_parse_sg_rule(const cJSON *jsonobj, struct rpc_trn_sg_rule_t *rule)
+{
+	if (trn_cli_parse_sg_direction(jsonobj, &rule->direction)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_sg_protocol(jsonobj, &rule->protocol)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_sg_cidr(jsonobj, rule)) {
+		return -EINVAL;
+	}
+
+	/* Ports default to all of them */
+	if (trn_cli_parse_sg_port(jsonobj, "port_min", &rule->port_min, 0) ||
+	    trn_cli_parse_sg_port(jsonobj, "port_max", &rule->port_max, 0xffff)) {
+		return -EINVAL;
+	}
+
+	if (rule->port_min > rule->port_max) {
+		print_err("Error: port_min is over port_max\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_sg_rules(const cJSON *jsonobj,
+			   struct rpc_trn_sg_rules_t *sg)
+{
+	cJSON *rules = cJSON_GetObjectItem(jsonobj, "rules");
+	cJSON *append = cJSON_GetObjectItem(jsonobj, "append");
+	cJSON *rule;
+	int i = 0;
+
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &sg->vni)) {
+		return -EINVAL;
+	}
+
+	/* Rules replace the ones set before unless appended */
+	sg->append = append != NULL && cJSON_IsTrue(append);
+
+	if (rules == NULL) {
+		print_err("Error: Missing rules\n");
+		return -EINVAL;
+	} else if (!cJSON_IsArray(rules)) {
+		print_err("Error: rules should be array type\n");
+		return -EINVAL;
+	} else if (cJSON_GetArraySize(rules) > TRAN_MAX_SG_RULES_BATCH) {
+		print_err("Error: rules size should be up to %d\n",
+			  TRAN_MAX_SG_RULES_BATCH);
+		return -EINVAL;
+	}
+
+	cJSON_ArrayForEach(rule, rules) {
+		if (trn_cli_parse_sg_rule(rule, &sg->rules.rules_val[i])) {
+			print_err("Error: rules entry %d is not a rule\n", i);
+			return -EINVAL;
+		}
+		i++;
+	}
+	sg->rules.rules_len = i;
+
+	return 0;
+}
+
+static int trn_cli_parse_sg_identity(const cJSON *jsonobj,
+				     const char *const key, uint16_t *id)
+{
+	unsigned int val;
+
+	if (trn_cli_parse_json_number_u32(jsonobj, key, &val)) {
+		return -EINVAL;
+	} else if (val == 0 || val > 0xffff) {
+		print_err("Error: %s should be 1 to 65535\n", key);
+		return -EINVAL;
+	}
+	*id = val;
+
+	return 0;
+}
+
+/* Verdicts are allow or deny, allow if missing */
+int trn_cli_parse_sg_identity_rule(const cJSON *jsonobj,
+				   struct rpc_trn_sg_identity_rule_t *rule)
+{
+	cJSON *verdict = cJSON_GetObjectItem(jsonobj, "verdict");
+
+	if (trn_cli_parse_json_number_u32(jsonobj, "vni", &rule->vni)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_sg_identity(jsonobj, "src_id", &rule->src_id) ||
+	    trn_cli_parse_sg_identity(jsonobj, "dst_id", &rule->dst_id)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_sg_protocol(jsonobj, &rule->protocol)) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_sg_port(jsonobj, "port", &rule->port, 0)) {
+		return -EINVAL;
+	}
+
+	rule->verdict = TRAN_SG_ALLOW;
+	if (verdict == NULL) {
+		return 0;
+	} else if (!cJSON_IsString(verdict)) {
+		print_err("Error: Invalid verdict type\n");
+		return -EINVAL;
+	} else if (!strcmp(verdict->valuestring, "deny")) {
+		rule->verdict = TRAN_SG_DENY;
+	} else if (strcmp(verdict->valuestring, "allow")) {
+		print_err("Error: verdict should be allow or deny\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+int trn_cli_parse_sg_identity_rules(const cJSON *jsonobj,
+				    struct rpc_trn_sg_identity_rules_t *sg)
+{
+	cJSON *rules = cJSON_GetObjectItem(jsonobj, "rules");
+	cJSON *rule;
+	int i = 0;
+
+	if (rules == NULL) {
+		print_err("Error: Missing rules\n");
+		return -EINVAL;
+	} else if (!cJSON_IsArray(rules)) {
+		print_err("Error: rules should be array type\n");
+		return -EINVAL;
+	} else if (cJSON_GetArraySize(rules) > TRAN_MAX_SG_RULES_BATCH) {
+		print_err("Error: rules size should be up to %d\n",
+			  TRAN_MAX_SG_RULES_BATCH);
+		return -EINVAL;
+	}
+
+	cJSON_ArrayForEach(rule, rules) {
+		if (trn_cli_parse_sg_identity_rule(rule,
+						   &sg->rules.rules_val[i])) {
+			print_err("Error: rules entry %d is not a rule\n", i);
+			return -EINVAL;
+		}
+		i++;
+	}
+	sg->rules.rules_len = i;
+
+	return 0;
+}
+
+int trn_cli_update_sg_rules_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_sg_rules_t sg;
+	rpc_trn_sg_rule_t rules[TRAN_MAX_SG_RULES_BATCH];
+	char rpc[] = "update_sg_rules_1";
+
+	sg.rules.rules_val = rules;
+
+	int err = trn_cli_parse_sg_rules(json_str, &sg);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing security group rules.\n");
+		return -EINVAL;
+	}
+
+	rc = update_sg_rules_1(&sg, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_sg_rules_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("update_sg_rules_1 successfully %s %d rules of VNI %d.\n",
+		  sg.append ? "appended" : "set", sg.rules.rules_len, sg.vni);
+	return 0;
+}
+
+int trn_cli_delete_sg_rules_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	rpc_trn_vni_key_t key;
+	int *rc;
+	char rpc[] = "delete_sg_rules_1";
+
+	if (trn_cli_read_vni_key(argc, argv, &key)) {
+		return -EINVAL;
+	}
+
+	rc = delete_sg_rules_1(&key, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_sg_rules_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_sg_rules_1 successfully deleted rules of VNI %d.\n",
+		  key.vni);
+	return 0;
+}
+
+int trn_cli_update_sg_identity_rules_subcmd(CLIENT *clnt, int argc,
+					    char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_sg_identity_rules_t sg;
+	rpc_trn_sg_identity_rule_t rules[TRAN_MAX_SG_RULES_BATCH];
+	char rpc[] = "update_sg_identity_rules_1";
+
+	sg.rules.rules_val = rules;
+
+	int err = trn_cli_parse_sg_identity_rules(json_str, &sg);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing identity policy rules.\n");
+		return -EINVAL;
+	}
+
+	rc = update_sg_identity_rules_1(&sg, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: update_sg_identity_rules_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("update_sg_identity_rules_1 successfully set %d rules.\n",
+		  sg.rules.rules_len);
+	return 0;
+}
+
+int trn_cli_delete_sg_identity_rule_subcmd(CLIENT *clnt, int argc,
+					   char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	rpc_trn_sg_identity_rule_t rule;
+	char rpc[] = "delete_sg_identity_rule_1";
+
+	int err = trn_cli_parse_sg_identity_rule(json_str, &rule);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing identity policy rule.\n");
+		return -EINVAL;
+	}
+
+	rc = delete_sg_identity_rule_1(&rule, clnt);
+	if (rc == (int *)NULL) {
+		print_err("RPC Error: client call failed: delete_sg_identity_rule_1.\n");
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err(
+			"Error: %s fatal daemon error, see transitd logs for details.\n",
+			rpc);
+		return -EINVAL;
+	}
+
+	print_msg("delete_sg_identity_rule_1 successfully deleted rule %d to %d of VNI %d.\n",
+		  rule.src_id, rule.dst_id, rule.vni);
+	return 0;
+}
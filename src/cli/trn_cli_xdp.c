@@ -23,32 +23,44 @@
  */
 #include "trn_cli.h"
 
-int trn_cli_parse_ebpf_prog(const cJSON *jsonobj, rpc_trn_ebpf_prog_t *prog)
+static const char *verdict_names[TRAN_MAX_PROG] = {
+	[TRAN_TX_PROG] = "xdp_tx",
+	[TRAN_PASS_PROG] = "xdp_pass",
+	[TRAN_REDIRECT_PROG] = "xdp_redirect",
+	[TRAN_DROP_PROG] = "xdp_drop",
+};
+
+/* Parse the verdict a program or stage pipeline is for */
+static int trn_cli_parse_verdict(const cJSON *jsonobj, const char *const key,
+				 uint32_t *prog_idx)
 {
-	cJSON *name = cJSON_GetObjectItem(jsonobj, "name");
+	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
 
-	if (name == NULL) {
-		print_err("Missing name for ebpf program to load.\n");
+	if (item == NULL) {
+		print_err("Missing %s\n", key);
 		return -EINVAL;
-	} else if (!cJSON_IsString(name)) {
-		print_err("Invalid name type, should be string\n");
+	} else if (!cJSON_IsString(item)) {
+		print_err("Invalid %s type, should be string\n", key);
 		return -EINVAL;
-	} else {
-		const char *name_str = name->valuestring;
-		if (strcmp(name_str, "xdp_tx") == 0) {
-			prog->prog_idx = TRAN_TX_PROG;
-		} else if (strcmp(name_str, "xdp_pass") == 0) {
-			prog->prog_idx = TRAN_PASS_PROG;
-		} else if (strcmp(name_str, "xdp_redirect") == 0) {
-			prog->prog_idx = TRAN_REDIRECT_PROG;
-		} else if (strcmp(name_str, "xdp_drop") == 0) {
-			prog->prog_idx = TRAN_DROP_PROG;
-		} else {
-			print_err("Unsupported eBPF program %s.\n", name_str);
-			return -EINVAL;
+	}
+
+	for (uint32_t i = TRAN_TX_PROG; i < TRAN_MAX_PROG; i++) {
+		if (strcmp(item->valuestring, verdict_names[i]) == 0) {
+			*prog_idx = i;
+			return 0;
 		}
 	}
 
+	print_err("Unsupported eBPF program %s.\n", item->valuestring);
+	return -EINVAL;
+}
+
+int trn_cli_parse_ebpf_prog(const cJSON *jsonobj, rpc_trn_ebpf_prog_t *prog)
+{
+	if (trn_cli_parse_verdict(jsonobj, "name", &prog->prog_idx)) {
+		return -EINVAL;
+	}
+
 	if (trn_cli_parse_json_number_u32(jsonobj,
 		"debug_mode", &prog->debug_mode)) {
 		return -EINVAL;
@@ -57,6 +69,64 @@ int trn_cli_parse_ebpf_prog(const cJSON *jsonobj, rpc_trn_ebpf_prog_t *prog)
 	return 0;
 }
 
+static const char *xdp_mode_names[TRAN_XDP_MODE_MAX] = {
+	[TRAN_XDP_MODE_AUTO] = "auto",
+	[TRAN_XDP_MODE_NATIVE] = "native",
+	[TRAN_XDP_MODE_GENERIC] = "generic",
+};
+
+/* Parse optional XDP attach mode, auto if absent */
+int trn_cli_parse_xdp_mode(const cJSON *jsonobj, const char *const key,
+			   uint32_t *mode)
+{
+	char buf[TRAN_MAX_ITF_SIZE];
+	cJSON *item = cJSON_GetObjectItem(jsonobj, key);
+
+	*mode = TRAN_XDP_MODE_AUTO;
+	if (item == NULL) {
+		return 0;
+	}
+
+	if (!cJSON_IsString(item) ||
+	    strlen(item->valuestring) >= sizeof(buf)) {
+		print_err("Invalid %s, should be auto, native or generic\n", key);
+		return -EINVAL;
+	}
+	strcpy(buf, item->valuestring);
+
+	for (uint32_t i = 0; i < TRAN_XDP_MODE_MAX; i++) {
+		if (strcmp(buf, xdp_mode_names[i]) == 0) {
+			*mode = i;
+			return 0;
+		}
+	}
+
+	print_err("Unsupported XDP mode %s.\n", buf);
+	return -EINVAL;
+}
+
+/* Parse optional on/off switch of a TRAN_XDP_FEAT_* feature */
+static int trn_cli_parse_xdp_feature(const cJSON *jsonobj, const char *const key,
+				     uint32_t feature, uint32_t *features)
+{
+	__u32 enable;
+
+	if (cJSON_GetObjectItem(jsonobj, key) == NULL) {
+		return 0;
+	}
+
+	if (trn_cli_parse_json_number_u32(jsonobj, key, &enable)) {
+		return -EINVAL;
+	}
+
+	if (enable) {
+		*features |= feature;
+	} else {
+		*features &= ~feature;
+	}
+	return 0;
+}
+
 int trn_cli_parse_xdp(const cJSON *jsonobj, rpc_trn_xdp_intf_t *xdp_intf)
 {
 	int tmp;
@@ -87,6 +157,95 @@ int trn_cli_parse_xdp(const cJSON *jsonobj, rpc_trn_xdp_intf_t *xdp_intf)
 		}
 	}
 
+	if (trn_cli_parse_xdp_mode(jsonobj, "xdp_mode_tenant",
+		&xdp_intf->xdp_modes[TRAN_ITF_MAP_TENANT])) {
+		return -EINVAL;
+	}
+
+	if (trn_cli_parse_xdp_mode(jsonobj, "xdp_mode_zgc",
+		&xdp_intf->xdp_modes[TRAN_ITF_MAP_ZGC])) {
+		return -EINVAL;
+	}
+
+	/*
+	 * RX spreading over worker CPUs is optional. Spread packets skip the
+	 * xdp stage pipeline and xdpcap. Packets toward unknown endpoints are
+	 * not spread, misses of spread packets are counted as missed in
+	 * get-cpu-spread-stats and go to the AF_XDP slow path of queue 0.
+	 */
+	cJSON *spread_cpus = cJSON_GetObjectItem(jsonobj, "spread_cpus");
+	cJSON *cpu;
+	xdp_intf->spread_cpus.spread_cpus_len = 0;
+	if (spread_cpus != NULL) {
+		if (!cJSON_IsArray(spread_cpus)) {
+			print_err("Error: spread_cpus should be array type\n");
+			return -EINVAL;
+		} else if (cJSON_GetArraySize(spread_cpus) > TRAN_MAX_SPREAD_CPUS) {
+			print_err("Error: spread_cpus over limit %d\n",
+				  TRAN_MAX_SPREAD_CPUS);
+			return -EINVAL;
+		}
+
+		cJSON_ArrayForEach(cpu, spread_cpus) {
+			if (!cJSON_IsNumber(cpu) || cpu->valueint < 0 ||
+			    cpu->valueint >= TRAN_MAX_CPUS) {
+				print_err("Error: invalid cpu in spread_cpus\n");
+				return -EINVAL;
+			}
+			xdp_intf->spread_cpus.spread_cpus_val
+				[xdp_intf->spread_cpus.spread_cpus_len++] =
+				cpu->valueint;
+		}
+	}
+
+	cJSON *cpumap_qsize = cJSON_GetObjectItem(jsonobj, "cpumap_qsize");
+	if (cpumap_qsize == NULL) {
+		xdp_intf->cpumap_qsize = TRAN_DEFAULT_CPUMAP_QSIZE;
+	} else if (trn_cli_parse_json_number_u32(jsonobj,
+		"cpumap_qsize", &xdp_intf->cpumap_qsize)) {
+		return -EINVAL;
+	}
+
+	/*
+	 * Optional upcall budgets of the miss guard, transitd defaults if 0.
+	 * upcall_host_pps applies to each CPU the misses of a source host
+	 * land on, so a host spread over n CPUs may get n times as many
+	 * upcalls. upcall_vni_pps is of the whole host, split over CPUs.
+	 */
+	xdp_intf->upcall_host_pps = 0;
+	xdp_intf->upcall_vni_pps = 0;
+	if ((cJSON_GetObjectItem(jsonobj, "upcall_host_pps") != NULL &&
+	     trn_cli_parse_json_number_u32(jsonobj, "upcall_host_pps",
+					   &xdp_intf->upcall_host_pps)) ||
+	    (cJSON_GetObjectItem(jsonobj, "upcall_vni_pps") != NULL &&
+	     trn_cli_parse_json_number_u32(jsonobj, "upcall_vni_pps",
+					   &xdp_intf->upcall_vni_pps))) {
+		return -EINVAL;
+	}
+
+	/* Features compiled in every object, enabled at load time */
+	xdp_intf->features = TRAN_XDP_FEAT_DEFAULT;
+	if (trn_cli_parse_xdp_feature(jsonobj, "sg_support",
+		TRAN_XDP_FEAT_SG, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "conn_track",
+		TRAN_XDP_FEAT_CONNTRACK, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "append_tail",
+		TRAN_XDP_FEAT_APPEND_TAIL, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "scaled_ep",
+		TRAN_XDP_FEAT_SCALED_EP, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "bum_flood",
+		TRAN_XDP_FEAT_BUM, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "eip",
+		TRAN_XDP_FEAT_EIP, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "identity_policy",
+		TRAN_XDP_FEAT_IDENTITY, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "rate_limit",
+		TRAN_XDP_FEAT_RATE_LIMIT, &xdp_intf->features) ||
+	    trn_cli_parse_xdp_feature(jsonobj, "miss_guard",
+		TRAN_XDP_FEAT_MISS_GUARD, &xdp_intf->features)) {
+		return -EINVAL;
+	}
+
 	return 0;
 }
 
@@ -210,9 +369,11 @@ int trn_cli_load_transit_subcmd(CLIENT *clnt, int argc, char *argv[])
 	int *rc;
 	char itf_tenant[TRAN_MAX_ITF_SIZE];
 	char itf_zgc[TRAN_MAX_ITF_SIZE];
+	uint32_t spread_cpus[TRAN_MAX_SPREAD_CPUS];
 	rpc_trn_xdp_intf_t xdp_intf = {
 		.interfaces[TRAN_ITF_MAP_TENANT] = itf_tenant,
 		.interfaces[TRAN_ITF_MAP_ZGC] = itf_zgc,
+		.spread_cpus.spread_cpus_val = spread_cpus,
 	};
 	char rpc[] = "load_transit_xdp_1";
 
@@ -263,9 +424,11 @@ int trn_cli_unload_transit_subcmd(CLIENT *clnt, int argc, char *argv[])
 	int *rc;
 	char itf_tenant[TRAN_MAX_ITF_SIZE];
 	char itf_zgc[TRAN_MAX_ITF_SIZE];
+	uint32_t spread_cpus[TRAN_MAX_SPREAD_CPUS];
 	rpc_trn_xdp_intf_t xdp_intf = {
 		.interfaces[TRAN_ITF_MAP_TENANT] = itf_tenant,
 		.interfaces[TRAN_ITF_MAP_ZGC] = itf_zgc,
+		.spread_cpus.spread_cpus_val = spread_cpus,
 	};
 	char rpc[] = "unload_transit_xdp_1";
 
@@ -291,3 +454,338 @@ int trn_cli_unload_transit_subcmd(CLIENT *clnt, int argc, char *argv[])
 	printf("unload_transit_xdp_1 successfully unloaded transit xdp.\n");
 	return 0;
 }
+
+int trn_cli_get_xsk_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_trn_xsk_stats_t *stats;
+	char itf_name[TRAN_MAX_ITF_SIZE];
+	rpc_intf_name itf = itf_name;
+
+	int err = trn_cli_parse_json_string(json_str, "interface", itf_name);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing interface name.\n");
+		return -EINVAL;
+	}
+
+	stats = get_xsk_stats_1(&itf, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_xsk_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_xsk_stats(itf_name, stats);
+	print_msg("get_xsk_stats_1 successfully queried slow path stats.\n");
+	return 0;
+}
+
+void dump_xsk_stats(char *itf, rpc_trn_xsk_stats_t *stats)
+{
+	unsigned int i;
+
+	print_msg("Interface: %s\n", itf);
+	print_msg("Num of queues: %d\n", stats->queues.queues_len);
+	for (i = 0; i < stats->queues.queues_len; i++) {
+		rpc_trn_xsk_queue_stats_t *q = &stats->queues.queues_val[i];
+
+		print_msg("queue %d: upcalls %lu resolved %lu unresolved %lu "
+			  "parked %lu reinjected %lu tx_errors %lu\n",
+			  q->queue_id, (unsigned long)q->upcalls,
+			  (unsigned long)q->resolved,
+			  (unsigned long)q->unresolved,
+			  (unsigned long)q->parked,
+			  (unsigned long)q->reinjected,
+			  (unsigned long)q->tx_errors);
+	}
+}
+
+int trn_cli_get_upcall_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_upcall_stats_t *stats;
+	char *dummy = NULL;
+
+	stats = get_upcall_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_upcall_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_upcall_stats(stats);
+	print_msg("get_upcall_stats_1 successfully queried upcall stats.\n");
+	return 0;
+}
+
+void dump_upcall_stats(rpc_trn_upcall_stats_t *stats)
+{
+	print_msg("admitted: %lu\n", (unsigned long)stats->admitted);
+	print_msg("negative: %lu\n", (unsigned long)stats->negative);
+	print_msg("throttled_host: %lu\n", (unsigned long)stats->throttled_host);
+	print_msg("throttled_vni: %lu\n", (unsigned long)stats->throttled_vni);
+}
+
+int trn_cli_get_flow_cache_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_flow_cache_stats_t *stats;
+	char *dummy = NULL;
+
+	stats = get_flow_cache_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_flow_cache_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_flow_cache_stats(stats);
+	print_msg("get_flow_cache_stats_1 successfully queried flow cache stats.\n");
+	return 0;
+}
+
+void dump_flow_cache_stats(rpc_trn_flow_cache_stats_t *stats)
+{
+	__u64 lookups = stats->hit + stats->miss;
+
+	print_msg("hit: %lu\n", (unsigned long)stats->hit);
+	print_msg("miss: %lu\n", (unsigned long)stats->miss);
+	print_msg("evict: %lu\n", (unsigned long)stats->evict);
+	print_msg("insert: %lu\n", (unsigned long)stats->insert);
+	print_msg("hit ratio: %.2f%%\n",
+		  lookups ? 100.0 * stats->hit / lookups : 0.0);
+}
+
+int trn_cli_get_cpu_spread_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_cpu_spread_stats_list_t *stats;
+	char *dummy = NULL;
+
+	stats = get_cpu_spread_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_cpu_spread_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_cpu_spread_stats(stats);
+	print_msg("get_cpu_spread_stats_1 successfully queried cpu spread stats.\n");
+	return 0;
+}
+
+void dump_cpu_spread_stats(rpc_trn_cpu_spread_stats_list_t *stats)
+{
+	unsigned int i;
+
+	print_msg("Num of cpus: %d\n", stats->cpus.cpus_len);
+	for (i = 0; i < stats->cpus.cpus_len; i++) {
+		rpc_trn_cpu_spread_stats_t *c = &stats->cpus.cpus_val[i];
+
+		print_msg("cpu %d: redirected %lu processed %lu missed %lu\n",
+			  c->cpu, (unsigned long)c->redirected,
+			  (unsigned long)c->processed,
+			  (unsigned long)c->missed);
+	}
+}
+
+int trn_cli_get_xdp_mode_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	rpc_trn_xdp_mode_t *mode;
+	char itf_name[TRAN_MAX_ITF_SIZE];
+	rpc_intf_name itf = itf_name;
+
+	int err = trn_cli_parse_json_string(json_str, "interface", itf_name);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing interface name.\n");
+		return -EINVAL;
+	}
+
+	mode = get_xdp_mode_1(&itf, clnt);
+	if (mode == NULL) {
+		print_err("Error: call failed: get_xdp_mode_1.\n");
+		return -EINVAL;
+	}
+
+	dump_xdp_mode(itf_name, mode);
+	print_msg("get_xdp_mode_1 successfully queried XDP mode.\n");
+	return 0;
+}
+
+void dump_xdp_mode(char *itf, rpc_trn_xdp_mode_t *mode)
+{
+	print_msg("Interface: %s\n", itf);
+	print_msg("XDP mode: %s\n", mode->mode < TRAN_XDP_MODE_MAX ?
+		  xdp_mode_names[mode->mode] : "unknown");
+	print_msg("XDP prog id: %d\n", mode->prog_id);
+}
+
+/* Parse a pipeline stage, path and position are only needed to insert */
+static int trn_cli_parse_xdp_stage(const cJSON *jsonobj,
+				   rpc_trn_xdp_stage_t *stage,
+				   int insert)
+{
+	cJSON *name = cJSON_GetObjectItem(jsonobj, "name");
+	cJSON *path = cJSON_GetObjectItem(jsonobj, "path");
+
+	if (name == NULL || !cJSON_IsString(name) ||
+	    strlen(name->valuestring) >= TRAN_MAX_STAGE_NAME) {
+		print_err("Missing or invalid stage name\n");
+		return -EINVAL;
+	}
+	strcpy(stage->name, name->valuestring);
+
+	if (trn_cli_parse_verdict(jsonobj, "verdict", &stage->prog_idx)) {
+		return -EINVAL;
+	}
+
+	stage->position = TRAN_MAX_STAGES;
+	if (!insert) {
+		stage->path[0] = '\0';
+		return 0;
+	}
+
+	if (path == NULL || !cJSON_IsString(path) ||
+	    strlen(path->valuestring) >= TRAN_MAX_PATH_SIZE) {
+		print_err("Missing or invalid stage object path\n");
+		return -EINVAL;
+	}
+	strcpy(stage->path, path->valuestring);
+
+	if (cJSON_GetObjectItem(jsonobj, "position") != NULL &&
+	    trn_cli_parse_json_number_u32(jsonobj, "position",
+					  &stage->position)) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int trn_cli_xdp_stage_subcmd(CLIENT *clnt, int argc, char *argv[],
+				    int insert)
+{
+	ketopt_t om = KETOPT_INIT;
+	struct cli_conf_data_t conf;
+	cJSON *json_str = NULL;
+
+	if (trn_cli_read_conf_str(&om, argc, argv, &conf)) {
+		return -EINVAL;
+	}
+
+	char *buf = conf.conf_str;
+	json_str = trn_cli_parse_json(buf);
+
+	if (json_str == NULL) {
+		return -EINVAL;
+	}
+
+	int *rc;
+	char name[TRAN_MAX_STAGE_NAME];
+	char path[TRAN_MAX_PATH_SIZE];
+	rpc_trn_xdp_stage_t stage = {
+		.name = name,
+		.path = path,
+	};
+	char *rpc = insert ? "insert_xdp_stage_1" : "remove_xdp_stage_1";
+
+	int err = trn_cli_parse_xdp_stage(json_str, &stage, insert);
+	cJSON_Delete(json_str);
+
+	if (err != 0) {
+		print_err("Error: parsing XDP stage config.\n");
+		return -EINVAL;
+	}
+
+	rc = insert ? insert_xdp_stage_1(&stage, clnt) :
+		      remove_xdp_stage_1(&stage, clnt);
+	if (rc == (int *)NULL) {
+		print_err("Error: call failed: %s.\n", rpc);
+		return -EINVAL;
+	}
+
+	if (*rc != 0) {
+		print_err("Error: %s fatal error, see transitd logs for details.\n",
+			  rpc);
+		return -EINVAL;
+	}
+
+	print_msg("%s successfully %s stage %s.\n", rpc,
+		  insert ? "inserted" : "removed", name);
+	return 0;
+}
+
+int trn_cli_insert_xdp_stage_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	return trn_cli_xdp_stage_subcmd(clnt, argc, argv, 1);
+}
+
+int trn_cli_remove_xdp_stage_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	return trn_cli_xdp_stage_subcmd(clnt, argc, argv, 0);
+}
+
+int trn_cli_get_xdp_stage_stats_subcmd(CLIENT *clnt, int argc, char *argv[])
+{
+	UNUSED(argc);
+	UNUSED(argv);
+	rpc_trn_xdp_stage_stats_list_t *stats;
+	char *dummy = NULL;
+
+	stats = get_xdp_stage_stats_1((void *)&dummy, clnt);
+	if (stats == NULL) {
+		print_err("Error: call failed: get_xdp_stage_stats_1.\n");
+		return -EINVAL;
+	}
+
+	dump_xdp_stage_stats(stats);
+	print_msg("get_xdp_stage_stats_1 successfully queried stage stats.\n");
+	return 0;
+}
+
+void dump_xdp_stage_stats(rpc_trn_xdp_stage_stats_list_t *stats)
+{
+	unsigned int i;
+
+	print_msg("Num of stages: %d\n", stats->stages.stages_len);
+	for (i = 0; i < stats->stages.stages_len; i++) {
+		rpc_trn_xdp_stage_stats_t *st = &stats->stages.stages_val[i];
+
+		print_msg("%s[%d] %s: runs %lu avg %lu ns\n",
+			  st->prog_idx < TRAN_MAX_PROG && verdict_names[st->prog_idx] ?
+			  verdict_names[st->prog_idx] : "unknown",
+			  st->position, st->name, (unsigned long)st->runs,
+			  st->runs ? (unsigned long)(st->run_ns / st->runs) : 0);
+	}
+}
@@ -42,6 +42,8 @@ static struct test_bpf_map_t maps[] = {
 	{.name="hosted_eps_if"},
 	{.name="if_config_map"},
 	{.name="interfaces_map"},
+	{.name="sg_identity_map"},
+	{.name="flow_gen_map"},
 #if turnOn
 	{.name="oam_queue_map"},
 	{.name="fwd_flow_cache"},
@@ -52,6 +54,11 @@ static struct test_bpf_map_t maps[] = {
 	{.name="xdpcap_hook"},
 };
 
+/* flow_gen_map gets its own fd, the mocks keep its generations */
+#define TEST_FLOW_GEN_FD 2
+
+static __u32 test_flow_gen[TRAN_FLOW_GEN_SLOTS];
+
 int __wrap_trn_transit_map_get_fd(char *map)
 {
 	UNUSED(map);
@@ -121,21 +128,24 @@ int __wrap_setrlimit(int resource, const struct rlimit *rlim)
 	return 0;
 }
 
-int __wrap_bpf_map_update_elem(void *map, void *key, void *value,
+int __wrap_bpf_map_update_elem(int fd, void *key, void *value,
 			       unsigned long long flags)
 {
-	UNUSED(map);
-	UNUSED(key);
-	UNUSED(value);
 	UNUSED(flags);
 	function_called();
+	if (fd == TEST_FLOW_GEN_FD)
+		test_flow_gen[*(__u32 *)key] = *(__u32 *)value;
 	return 0;
 }
 
-int __wrap_bpf_map_lookup_elem(void *map, void *key, void *value)
+int __wrap_bpf_map_lookup_elem(int fd, void *key, void *value)
 {
-	UNUSED(map);
-	UNUSED(key);
+	if (fd == TEST_FLOW_GEN_FD) {
+		function_called();
+		*(__u32 *)value = test_flow_gen[*(__u32 *)key];
+		return 0;
+	}
+
 	endpoint_t *endpoint = mock_ptr_type(endpoint_t *);
 	struct ftn_t *ftn = mock_ptr_type(struct ftn_t *);
 	struct chain_t *chain = mock_ptr_type(struct chain_t *);
@@ -221,7 +231,8 @@ struct bpf_map *__wrap_bpf_map__next(struct bpf_map *map,
 
 int __wrap_bpf_map__fd(struct bpf_map *map)
 {
-	UNUSED(map);
+	if (!strcmp(((struct test_bpf_map_t *)map)->name, "flow_gen_map"))
+		return TEST_FLOW_GEN_FD;
 	return 1;
 }
 
@@ -368,8 +379,8 @@ static void do_lo_xdp_load(void)
 	xdp_intf.debug_mode = 1;
 
 	int *rc;
-	/* Expect map update for jmp_table + interfaces_map */
-	expect_function_calls(__wrap_bpf_map_update_elem, TRAN_MAX_PROG + 1);
+	/* Expect map update for stage_cfg_map + interfaces_map */
+	expect_function_calls(__wrap_bpf_map_update_elem, 2);
 	rc = load_transit_xdp_1_svc(&xdp_intf, NULL);
 	assert_int_equal(*rc, 0);
 }
@@ -406,10 +417,16 @@ static void test_update_ep_1_svc(void **state)
 		.rpc_trn_endpoint_batch_t_val = &ep1.rpc_ep,
 	};
 
+	__u32 gen = test_flow_gen[TRAN_FLOW_GEN_SLOT(123)];
+
+	/* Endpoint update, then the flow generation of its VNI */
 	int *rc;
-	expect_function_calls(__wrap_bpf_map_update_elem, 1);
+	expect_function_call(__wrap_bpf_map_update_elem);
+	expect_function_call(__wrap_bpf_map_lookup_elem);
+	expect_function_call(__wrap_bpf_map_update_elem);
 	rc = update_ep_1_svc(&epb, NULL);
 	assert_int_equal(*rc, 0);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(123)], gen + 1);
 }
 
 static void test_get_ep_1_svc(void **state)
@@ -480,6 +497,7 @@ static void test_delete_ep_1_svc(void **state)
 	memcpy(ep_val.mac, mac, sizeof(mac));
 
 	int *rc;
+	__u32 gen = test_flow_gen[TRAN_FLOW_GEN_SLOT(123)];
 
 	/* Test delete_ep_1 with valid ep_key */
 	will_return(__wrap_bpf_map_lookup_elem, &ep_val);
@@ -489,8 +507,11 @@ static void test_delete_ep_1_svc(void **state)
 	will_return(__wrap_bpf_map_delete_elem, TRUE);
 	expect_function_call(__wrap_bpf_map_lookup_elem);
 	expect_function_call(__wrap_bpf_map_delete_elem);
+	expect_function_call(__wrap_bpf_map_lookup_elem);
+	expect_function_call(__wrap_bpf_map_update_elem);
 	rc = delete_ep_1_svc(&ep_key, NULL);
 	assert_int_equal(*rc, 0);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(123)], gen + 1);
 
 	/* Test delete_ep_1 with invalid ep_key */
 	will_return(__wrap_bpf_map_lookup_elem, &ep_val);
@@ -502,6 +523,70 @@ static void test_delete_ep_1_svc(void **state)
 	expect_function_call(__wrap_bpf_map_delete_elem);
 	rc = delete_ep_1_svc(&ep_key, NULL);
 	assert_int_equal(*rc, RPC_TRN_ERROR);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(123)], gen + 1);
+}
+
+static void test_flow_cache_invalidate(void **state)
+{
+	UNUSED(state);
+
+	sg_identity_key_t key = {
+		.vni = 123,
+		.src_id = 1,
+		.dst_id = 2,
+		.port = 80,
+		.protocol = IPPROTO_TCP,
+	};
+	__u32 gen = test_flow_gen[TRAN_FLOW_GEN_SLOT(123)];
+	__u32 other = test_flow_gen[TRAN_FLOW_GEN_SLOT(124)];
+
+	/* A policy update drops the cached verdicts of its VNI only */
+	expect_function_call(__wrap_bpf_map_update_elem);
+	expect_function_call(__wrap_bpf_map_lookup_elem);
+	expect_function_call(__wrap_bpf_map_update_elem);
+	assert_int_equal(trn_update_sg_identity_rule(&key, TRAN_SG_DENY), 0);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(123)], gen + 1);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(124)], other);
+
+	expect_function_call(__wrap_bpf_map_lookup_elem);
+	expect_function_call(__wrap_bpf_map_update_elem);
+	assert_int_equal(trn_flow_cache_invalidate(124), 0);
+	assert_int_equal(test_flow_gen[TRAN_FLOW_GEN_SLOT(124)], other + 1);
+}
+
+static void test_trn_sg_compile(void **state)
+{
+	UNUSED(state);
+
+	trn_sg_rule_t rules[] = {
+		/* 10.0.0.0/8 tcp 80-443 and 8000-9000 merge into one entry */
+		{ .cidr = 0x0000000a, .prefixlen = 8, .protocol = IPPROTO_TCP,
+		  .port_min = 80, .port_max = 443 },
+		{ .cidr = 0x0000000a, .prefixlen = 8, .protocol = IPPROTO_TCP,
+		  .port_min = 8000, .port_max = 9000 },
+		{ .cidr = 0x0101a8c0, .prefixlen = 32,
+		  .direction = TRAN_SG_INGRESS },
+	};
+	trn_sg_rule_t bad = { .prefixlen = 33 };
+	trn_sg_table_t tbl;
+
+	assert_int_equal(trn_sg_compile(7, rules, 3, &tbl), 0);
+	assert_int_equal(tbl.nentries, 2);
+	assert_int_equal(tbl.nports, 1);
+	assert_int_equal(tbl.vni.prefixes[TRAN_SG_EGRESS], 1ULL << 8);
+	assert_int_equal(tbl.vni.any_prefixes[TRAN_SG_INGRESS], 1ULL << 32);
+	assert_int_equal(tbl.entries[0].ranges, 0x3);
+
+	/* [0, 80) [80, 444) [444, 8000) [8000, 9001) [9001, 65535] */
+	assert_int_equal(tbl.ports[0].nintervals, 5);
+	assert_int_equal(tbl.ports[0].start[1], 80);
+	assert_int_equal(tbl.ports[0].ranges[1], 0x1);
+	assert_int_equal(tbl.ports[0].start[3], 8000);
+	assert_int_equal(tbl.ports[0].ranges[3], 0x2);
+	assert_int_equal(tbl.ports[0].ranges[4], 0);
+	trn_sg_table_free(&tbl);
+
+	assert_int_equal(trn_sg_compile(7, &bad, 1, &tbl), 1);
 }
 
 /**
@@ -531,7 +616,9 @@ int main()
 	const struct CMUnitTest tests[] = {
 		cmocka_unit_test(test_update_ep_1_svc),
 		cmocka_unit_test(test_delete_ep_1_svc),
-		cmocka_unit_test(test_get_ep_1_svc)
+		cmocka_unit_test(test_get_ep_1_svc),
+		cmocka_unit_test(test_trn_sg_compile),
+		cmocka_unit_test(test_flow_cache_invalidate)
 	};
 
 	int result = cmocka_run_group_tests(tests, groupSetup, groupTeardown);
@@ -33,6 +33,7 @@
 #include <memory.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <syslog.h>
 #include <search.h>
 #include <stdlib.h>
@@ -141,6 +142,29 @@ int *update_droplet_1_svc(rpc_trn_droplet_t *droplet, struct svc_req *rqstp)
 		goto error;
 	}
 
+	if (droplet->num_entrances > TRAN_MAX_ZGC_ENTRANCES) {
+		TRN_LOG_ERROR("Droplet %s has %d entrances, limit is %d",
+			      droplet->interface, droplet->num_entrances,
+			      TRAN_MAX_ZGC_ENTRANCES);
+		result = RPC_TRN_ERROR;
+		goto error;
+	}
+
+	/* Entrances are keyed by MAC, a duplicate would shadow the other */
+	for (unsigned int i = 0; i < droplet->num_entrances; i++) {
+		for (unsigned int j = 0; j < i; j++) {
+			if (!memcmp(droplet->entrances[i].mac,
+				    droplet->entrances[j].mac,
+				    sizeof(droplet->entrances[i].mac))) {
+				TRN_LOG_ERROR("Droplet %s has duplicate entrance "
+					      "MAC at %d and %d",
+					      droplet->interface, j, i);
+				result = RPC_TRN_ERROR;
+				goto error;
+			}
+		}
+	}
+
 	for (unsigned int i = 0; i < droplet->num_entrances; i++) {
 		itf.entrances[i].ip = droplet->entrances[i].ip;
 		memcpy(itf.entrances[i].mac, droplet->entrances[i].mac,
@@ -148,6 +172,9 @@ int *update_droplet_1_svc(rpc_trn_droplet_t *droplet, struct svc_req *rqstp)
 		itf.entrances[i].announced = 0;
 	}
 	itf.num_entrances = droplet->num_entrances;
+	itf.options = droplet->options;
+	itf.dft_id = droplet->dft_id;
+	itf.ftn_id = droplet->ftn_id;
 	itf.iface_index = eth->iface_index;
 	itf.ibo_port = eth->ibo_port;
 	itf.role = eth->role;
@@ -165,14 +192,207 @@ error:
 	return &result;
 }
 
+rpc_trn_xsk_stats_t *get_xsk_stats_1_svc(rpc_intf_name *argp,
+					  struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_xsk_stats_t result;
+	static rpc_trn_xsk_queue_stats_t queues[TRAN_MAX_XSK_QUEUES];
+	trn_xsk_stats_t stats[TRAN_MAX_XSK_QUEUES];
+	__u32 num_queues = 0;
+	trn_iface_t *eth;
+
+	TRN_LOG_DEBUG("get_xsk_stats_1 interface: %s", *argp);
+
+	eth = trn_get_itf_context(*argp);
+	if (!eth) {
+		TRN_LOG_ERROR("Failed to get interface context %s", *argp);
+		goto error;
+	}
+
+	if (trn_xsk_get_stats(eth->iface_index, &num_queues, stats)) {
+		TRN_LOG_ERROR("Cannot get AF_XDP slow path stats of %s", *argp);
+		goto error;
+	}
+
+	for (__u32 i = 0; i < num_queues; i++) {
+		queues[i].queue_id = i;
+		queues[i].upcalls = stats[i].upcalls;
+		queues[i].resolved = stats[i].resolved;
+		queues[i].unresolved = stats[i].unresolved;
+		queues[i].parked = stats[i].parked;
+		queues[i].reinjected = stats[i].reinjected;
+		queues[i].tx_errors = stats[i].tx_errors;
+	}
+	result.queues.queues_len = num_queues;
+	result.queues.queues_val = queues;
+
+	return &result;
+
+error:
+	return NULL;
+}
+
+rpc_trn_ep_miss_list_t *get_ep_misses_1_svc(void *argp, struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_ep_miss_list_t result;
+	static rpc_trn_ep_miss_t entries[TRAN_MAX_EP_MISSES];
+	trn_xsk_miss_t misses[TRAN_MAX_EP_MISSES];
+	__u32 n = 0;
+
+	TRN_LOG_DEBUG("get_ep_misses_1");
+
+	trn_xsk_get_misses(misses, &n);
+
+	for (__u32 i = 0; i < n; i++) {
+		entries[i].vni = misses[i].key.vni;
+		entries[i].ip = misses[i].key.ip;
+		entries[i].packets = misses[i].packets;
+	}
+	result.misses.misses_len = n;
+	result.misses.misses_val = entries;
+
+	return &result;
+}
+
+rpc_trn_flow_cache_stats_t *get_flow_cache_stats_1_svc(void *argp,
+							struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_flow_cache_stats_t result;
+	flow_cache_stats_t stats;
+
+	TRN_LOG_DEBUG("get_flow_cache_stats_1");
+
+	if (trn_get_flow_cache_stats(&stats)) {
+		TRN_LOG_ERROR("Cannot get flow cache stats");
+		goto error;
+	}
+
+	result.hit = stats.hit;
+	result.miss = stats.miss;
+	result.evict = stats.evict;
+	result.insert = stats.insert;
+
+	return &result;
+
+error:
+	return NULL;
+}
+
+rpc_trn_upcall_stats_t *get_upcall_stats_1_svc(void *argp,
+						struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_upcall_stats_t result;
+	upcall_stats_t stats;
+
+	TRN_LOG_DEBUG("get_upcall_stats_1");
+
+	if (trn_get_upcall_stats(&stats)) {
+		TRN_LOG_ERROR("Cannot get upcall stats");
+		return NULL;
+	}
+
+	result.admitted = stats.admitted;
+	result.negative = stats.negative;
+	result.throttled_host = stats.throttled_host;
+	result.throttled_vni = stats.throttled_vni;
+
+	return &result;
+}
+
+rpc_trn_cpu_spread_stats_list_t *get_cpu_spread_stats_1_svc(void *argp,
+							     struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_cpu_spread_stats_list_t result;
+	static rpc_trn_cpu_spread_stats_t cpus[TRAN_MAX_CPUS];
+	cpu_spread_stats_t stats[TRAN_MAX_CPUS];
+	__u32 num_cpus = 0, n = 0;
+
+	TRN_LOG_DEBUG("get_cpu_spread_stats_1");
+
+	if (trn_get_cpu_spread_stats(&num_cpus, stats)) {
+		TRN_LOG_ERROR("Cannot get cpu spread stats");
+		goto error;
+	}
+
+	for (__u32 i = 0; i < num_cpus; i++) {
+		if (!stats[i].redirected && !stats[i].processed)
+			continue;
+		cpus[n].cpu = i;
+		cpus[n].redirected = stats[i].redirected;
+		cpus[n].processed = stats[i].processed;
+		cpus[n].missed = stats[i].missed;
+		n++;
+	}
+	result.cpus.cpus_len = n;
+	result.cpus.cpus_val = cpus;
+
+	return &result;
+
+error:
+	return NULL;
+}
+
+rpc_trn_xdp_mode_t *get_xdp_mode_1_svc(rpc_intf_name *argp,
+					struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_xdp_mode_t result;
+	trn_iface_t *eth;
+
+	TRN_LOG_DEBUG("get_xdp_mode_1 interface: %s", *argp);
+
+	eth = trn_get_itf_context(*argp);
+	if (!eth) {
+		TRN_LOG_ERROR("Failed to get interface context %s", *argp);
+		goto error;
+	}
+
+	if (trn_get_xdp_mode(eth->iface_index, &result.mode, &result.prog_id)) {
+		TRN_LOG_ERROR("Cannot get XDP mode of %s", *argp);
+		goto error;
+	}
+
+	return &result;
+
+error:
+	return NULL;
+}
+
 /* RPC backend to load transit XDP and attach to interfaces */
 int *load_transit_xdp_1_svc(rpc_trn_xdp_intf_t *xdp_intf, struct svc_req *rqstp)
 {
 	UNUSED(rqstp);
 	static int result;
 	bool debug = xdp_intf->debug_mode == 0? false:true;
+	trn_xdp_load_cfg_t cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	if (xdp_intf->spread_cpus.spread_cpus_len > TRAN_MAX_SPREAD_CPUS) {
+		TRN_LOG_ERROR("Too many RX spreading cpus %d",
+			      xdp_intf->spread_cpus.spread_cpus_len);
+		result = RPC_TRN_ERROR;
+		return &result;
+	}
+	cfg.num_spread_cpus = xdp_intf->spread_cpus.spread_cpus_len;
+	memcpy(cfg.spread_cpus, xdp_intf->spread_cpus.spread_cpus_val,
+	       cfg.num_spread_cpus * sizeof(cfg.spread_cpus[0]));
+	cfg.cpumap_qsize = xdp_intf->cpumap_qsize;
+	memcpy(cfg.xdp_modes, xdp_intf->xdp_modes, sizeof(cfg.xdp_modes));
+	cfg.features = xdp_intf->features;
+	cfg.upcall_host_pps = xdp_intf->upcall_host_pps;
+	cfg.upcall_vni_pps = xdp_intf->upcall_vni_pps;
 
-	if (trn_transit_xdp_load(xdp_intf->interfaces, xdp_intf->ibo_port, debug)) {
+	if (trn_transit_xdp_load(xdp_intf->interfaces, xdp_intf->ibo_port, debug,
+				 &cfg)) {
 		TRN_LOG_ERROR("Failed to load transit XDP");
 		result = RPC_TRN_FATAL;
 	} else {
@@ -235,3 +455,960 @@ int *unload_transit_xdp_ebpf_1_svc(rpc_trn_ebpf_prog_t *argp,
 
 	return &result;
 }
+
+int *insert_xdp_stage_1_svc(rpc_trn_xdp_stage_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("insert_xdp_stage_1 stage: %s, pipeline: %d, position: %d",
+		      argp->name, argp->prog_idx, argp->position);
+
+	rc = trn_transit_stage_insert(argp->prog_idx, argp->position,
+				      argp->name, argp->path);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to insert XDP stage %s", argp->name);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *remove_xdp_stage_1_svc(rpc_trn_xdp_stage_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("remove_xdp_stage_1 stage: %s, pipeline: %d",
+		      argp->name, argp->prog_idx);
+
+	rc = trn_transit_stage_remove(argp->prog_idx, argp->name);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to remove XDP stage %s", argp->name);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_xdp_stage_stats_list_t *get_xdp_stage_stats_1_svc(void *argp,
+							   struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_xdp_stage_stats_list_t result;
+	static rpc_trn_xdp_stage_stats_t stages[TRAN_MAX_STAGE_SLOTS];
+	static char names[TRAN_MAX_STAGE_SLOTS][TRAN_MAX_STAGE_NAME];
+	stage_stats_t stats;
+	__u32 prog_idx, pos, n = 0;
+
+	TRN_LOG_DEBUG("get_xdp_stage_stats_1");
+
+	for (prog_idx = TRAN_TX_PROG; prog_idx < TRAN_MAX_PROG; prog_idx++) {
+		for (pos = 0; pos < TRAN_MAX_STAGES; pos++) {
+			if (trn_get_stage_stats(prog_idx, pos, names[n], &stats))
+				break;
+			stages[n].name = names[n];
+			stages[n].prog_idx = prog_idx;
+			stages[n].position = pos;
+			stages[n].runs = stats.runs;
+			stages[n].run_ns = stats.run_ns;
+			n++;
+		}
+	}
+	result.stages.stages_len = n;
+	result.stages.stages_val = stages;
+
+	return &result;
+}
+
+int *update_dft_1_svc(rpc_trn_dft_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("update_dft_1 dft: %d, table_len: %d",
+		      argp->id, argp->table.table_len);
+
+	rc = trn_update_dft(argp->id, argp->table.table_len,
+			    argp->table.table_val);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update DFT %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_dft_1_svc(rpc_trn_arion_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_dft_1 dft: %d", argp->id);
+
+	rc = trn_delete_dft(argp->id);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete DFT %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_dft_t *get_dft_1_svc(rpc_trn_arion_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_dft_t result;
+	static __u32 table[TRAN_MAX_DFT_TABLE_SIZE];
+	__u32 table_len;
+
+	TRN_LOG_DEBUG("get_dft_1 dft: %d", argp->id);
+
+	if (trn_get_dft(argp->id, &table_len, table)) {
+		TRN_LOG_ERROR("Cannot find DFT %d from XDP map", argp->id);
+		return NULL;
+	}
+
+	result.id = argp->id;
+	result.table.table_len = table_len;
+	result.table.table_val = table;
+
+	return &result;
+}
+
+int *update_chain_1_svc(rpc_trn_chain_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	struct chain_t chain;
+	int rc;
+
+	TRN_LOG_DEBUG("update_chain_1 chain: %d, tail_ftn: %d",
+		      argp->id, argp->tail_ftn);
+
+	chain.tail_ftn = argp->tail_ftn;
+	rc = trn_update_chain(argp->id, &chain);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update chain %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_chain_1_svc(rpc_trn_arion_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_chain_1 chain: %d", argp->id);
+
+	rc = trn_delete_chain(argp->id);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete chain %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_chain_t *get_chain_1_svc(rpc_trn_arion_key_t *argp,
+				 struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_chain_t result;
+	struct chain_t chain;
+
+	TRN_LOG_DEBUG("get_chain_1 chain: %d", argp->id);
+
+	if (trn_get_chain(argp->id, &chain)) {
+		TRN_LOG_ERROR("Cannot find chain %d from XDP map", argp->id);
+		return NULL;
+	}
+
+	result.id = argp->id;
+	result.tail_ftn = chain.tail_ftn;
+
+	return &result;
+}
+
+int *update_ftn_1_svc(rpc_trn_ftn_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	struct ftn_t ftn;
+	int rc;
+
+	TRN_LOG_DEBUG("update_ftn_1 ftn: %d, position: %d, next_ip: 0x%x",
+		      argp->id, argp->position, argp->next_ip);
+
+	ftn.position = argp->position;
+	ftn.ip = argp->ip;
+	ftn.next_ip = argp->next_ip;
+	memcpy(ftn.mac, argp->mac, sizeof(ftn.mac));
+	memcpy(ftn.next_mac, argp->next_mac, sizeof(ftn.next_mac));
+	rc = trn_update_ftn(argp->id, &ftn);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update FTN %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_ftn_1_svc(rpc_trn_arion_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_ftn_1 ftn: %d", argp->id);
+
+	rc = trn_delete_ftn(argp->id);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete FTN %d", argp->id);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_ftn_t *get_ftn_1_svc(rpc_trn_arion_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_ftn_t result;
+	struct ftn_t ftn;
+
+	TRN_LOG_DEBUG("get_ftn_1 ftn: %d", argp->id);
+
+	if (trn_get_ftn(argp->id, &ftn)) {
+		TRN_LOG_ERROR("Cannot find FTN %d from XDP map", argp->id);
+		return NULL;
+	}
+
+	result.id = argp->id;
+	result.position = ftn.position;
+	result.ip = ftn.ip;
+	result.next_ip = ftn.next_ip;
+	memcpy(result.mac, ftn.mac, sizeof(ftn.mac));
+	memcpy(result.next_mac, ftn.next_mac, sizeof(ftn.next_mac));
+
+	return &result;
+}
+
+int *update_scaled_ep_1_svc(rpc_trn_scaled_ep_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	endpoint_key_t epkey;
+	struct scaled_ep_t sep;
+	int rc;
+
+	TRN_LOG_DEBUG("update_scaled_ep_1 vni: %d, ip: 0x%x, backends: %d",
+		      argp->vni, argp->ip, argp->remote_ips.remote_ips_len);
+
+	if (argp->remote_ips.remote_ips_len > TRAN_MAX_REMOTES) {
+		TRN_LOG_ERROR("Too many backends of scaled ep %d - 0x%x",
+			      argp->vni, argp->ip);
+		result = RPC_TRN_ERROR;
+		return &result;
+	}
+
+	epkey.vni = argp->vni;
+	epkey.ip = argp->ip;
+	memset(&sep, 0, sizeof(sep));
+	sep.nremotes = argp->remote_ips.remote_ips_len;
+	sep.flags = argp->flags;
+	memcpy(sep.remote_ips, argp->remote_ips.remote_ips_val,
+	       sep.nremotes * sizeof(sep.remote_ips[0]));
+	rc = trn_update_scaled_ep(&epkey, &sep);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update scaled ep %d - 0x%x", argp->vni,
+			      argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_scaled_ep_1_svc(rpc_endpoint_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_scaled_ep_1 vni: %d, ip: 0x%x", argp->vni,
+		      argp->ip);
+
+	rc = trn_delete_scaled_ep((endpoint_key_t *)argp);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete scaled ep %d - 0x%x", argp->vni,
+			      argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_scaled_ep_t *get_scaled_ep_1_svc(rpc_endpoint_key_t *argp,
+					 struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_scaled_ep_t result;
+	static __u32 remote_ips[TRAN_MAX_REMOTES];
+	struct scaled_ep_t sep;
+
+	TRN_LOG_DEBUG("get_scaled_ep_1 vni: %d, ip: 0x%x", argp->vni,
+		      argp->ip);
+
+	if (trn_get_scaled_ep((endpoint_key_t *)argp, &sep)) {
+		TRN_LOG_ERROR("Cannot find scaled ep %d - 0x%x from XDP map",
+			      argp->vni, argp->ip);
+		return NULL;
+	}
+
+	result.vni = argp->vni;
+	result.ip = argp->ip;
+	result.flags = sep.flags;
+	memcpy(remote_ips, sep.remote_ips, sizeof(remote_ips));
+	result.remote_ips.remote_ips_len = sep.nremotes;
+	result.remote_ips.remote_ips_val = remote_ips;
+
+	return &result;
+}
+
+rpc_trn_scaled_ep_stats_t *get_scaled_ep_stats_1_svc(void *argp,
+						     struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_scaled_ep_stats_t result;
+	scaled_ep_stats_t stats;
+
+	TRN_LOG_DEBUG("get_scaled_ep_stats_1");
+
+	if (trn_get_scaled_ep_stats(&stats)) {
+		TRN_LOG_ERROR("Cannot get scaled ep stats");
+		return NULL;
+	}
+
+	result.dsr_flows = stats.dsr_flows;
+	result.dsr_bytes = stats.dsr_bytes;
+
+	return &result;
+}
+
+int *update_flood_list_1_svc(rpc_trn_flood_list_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	struct flood_list_t fl;
+	int rc;
+
+	TRN_LOG_DEBUG("update_flood_list_1 vni: %d, cap: %d, hosts: %d",
+		      argp->vni, argp->cap, argp->hosts.hosts_len);
+
+	if (argp->hosts.hosts_len > TRAN_MAX_FLOOD) {
+		TRN_LOG_ERROR("Too many hosts in flood list %d", argp->vni);
+		result = RPC_TRN_ERROR;
+		return &result;
+	}
+
+	memset(&fl, 0, sizeof(fl));
+	fl.nhosts = argp->hosts.hosts_len;
+	fl.cap = argp->cap;
+	for (unsigned int i = 0; i < fl.nhosts; i++) {
+		fl.hosts[i].ip = argp->hosts.hosts_val[i].ip;
+		memcpy(fl.hosts[i].mac, argp->hosts.hosts_val[i].mac,
+		       sizeof(fl.hosts[i].mac));
+	}
+	rc = trn_update_flood_list(argp->vni, &fl);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update flood list %d", argp->vni);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_flood_list_1_svc(rpc_trn_vni_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_flood_list_1 vni: %d", argp->vni);
+
+	rc = trn_delete_flood_list(argp->vni);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete flood list %d", argp->vni);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_flood_list_t *get_flood_list_1_svc(rpc_trn_vni_key_t *argp,
+					   struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_flood_list_t result;
+	static rpc_addr_t hosts[TRAN_MAX_FLOOD];
+	struct flood_list_t fl;
+
+	TRN_LOG_DEBUG("get_flood_list_1 vni: %d", argp->vni);
+
+	if (trn_get_flood_list(argp->vni, &fl)) {
+		TRN_LOG_ERROR("Cannot find flood list %d from XDP map",
+			      argp->vni);
+		return NULL;
+	}
+
+	for (unsigned int i = 0; i < fl.nhosts && i < TRAN_MAX_FLOOD; i++) {
+		hosts[i].ip = fl.hosts[i].ip;
+		memcpy(hosts[i].mac, fl.hosts[i].mac, sizeof(hosts[i].mac));
+	}
+	result.vni = argp->vni;
+	result.cap = fl.cap;
+	result.hosts.hosts_len = fl.nhosts;
+	result.hosts.hosts_val = hosts;
+
+	return &result;
+}
+
+rpc_trn_flood_stats_t *get_flood_stats_1_svc(rpc_trn_vni_key_t *argp,
+					     struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_flood_stats_t result;
+	flood_stats_t stats;
+
+	TRN_LOG_DEBUG("get_flood_stats_1 vni: %d", argp->vni);
+
+	if (trn_get_flood_stats(argp->vni, &stats)) {
+		TRN_LOG_ERROR("Cannot get flood stats of %d", argp->vni);
+		return NULL;
+	}
+
+	result.frames = stats.frames;
+	result.copies = stats.copies;
+	result.capped = stats.capped;
+	result.dropped = stats.dropped;
+	result.rejected = stats.rejected;
+
+	return &result;
+}
+
+int *update_eip_1_svc(rpc_trn_eip_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	endpoint_key_t epkey;
+	int rc;
+
+	TRN_LOG_DEBUG("update_eip_1 vni: %d, ip: 0x%x, eip: 0x%x", argp->vni,
+		      argp->ip, argp->eip);
+
+	epkey.vni = argp->vni;
+	epkey.ip = argp->ip;
+	rc = trn_update_eip(&epkey, argp->eip);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update elastic IP of %d - 0x%x",
+			      argp->vni, argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_eip_1_svc(rpc_endpoint_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_eip_1 vni: %d, ip: 0x%x", argp->vni, argp->ip);
+
+	rc = trn_delete_eip((endpoint_key_t *)argp);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete elastic IP of %d - 0x%x",
+			      argp->vni, argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_eip_t *get_eip_1_svc(rpc_endpoint_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_eip_t result;
+
+	TRN_LOG_DEBUG("get_eip_1 vni: %d, ip: 0x%x", argp->vni, argp->ip);
+
+	if (trn_get_eip((endpoint_key_t *)argp, &result.eip)) {
+		TRN_LOG_ERROR("Cannot find elastic IP of %d - 0x%x from XDP map",
+			      argp->vni, argp->ip);
+		return NULL;
+	}
+
+	result.vni = argp->vni;
+	result.ip = argp->ip;
+
+	return &result;
+}
+
+int *update_eip_gateway_1_svc(rpc_trn_eip_gw_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	struct eip_gw_t gw;
+	int rc;
+
+	TRN_LOG_DEBUG("update_eip_gateway_1 interface: %s, tunnel ip: 0x%x",
+		      argp->interface, argp->tunnel_ip);
+
+	memset(&gw, 0, sizeof(gw));
+	gw.tunnel_ip = argp->tunnel_ip;
+	memcpy(gw.mac, argp->mac, sizeof(gw.mac));
+	memcpy(gw.gw_mac, argp->gw_mac, sizeof(gw.gw_mac));
+	memcpy(gw.tunnel_mac, argp->tunnel_mac, sizeof(gw.tunnel_mac));
+	rc = trn_update_eip_gw(argp->interface, &gw, argp->xdp_mode);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update elastic IP gateway %s",
+			      argp->interface);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_eip_stats_t *get_eip_stats_1_svc(void *argp, struct svc_req *rqstp)
+{
+	UNUSED(argp);
+	UNUSED(rqstp);
+	static rpc_trn_eip_stats_t result;
+	eip_stats_t stats;
+
+	TRN_LOG_DEBUG("get_eip_stats_1");
+
+	if (trn_get_eip_stats(&stats)) {
+		TRN_LOG_ERROR("Cannot get elastic IP stats");
+		return NULL;
+	}
+
+	result.snat_pkts = stats.snat_pkts;
+	result.dnat_pkts = stats.dnat_pkts;
+	result.dropped = stats.dropped;
+
+	return &result;
+}
+
+int *update_ep6_1_svc(rpc_trn_endpoint6_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	char ip[INET6_ADDRSTRLEN];
+	endpoint_key6_t epkey;
+	endpoint_t ep;
+	int rc;
+
+	inet_ntop(AF_INET6, argp->ip, ip, sizeof(ip));
+	TRN_LOG_DEBUG("update_ep6_1 vni: %d, ip: %s, hip: 0x%x", argp->vni, ip,
+		      argp->hip);
+
+	epkey.vni = argp->vni;
+	memcpy(epkey.ip, argp->ip, sizeof(epkey.ip));
+	memset(&ep, 0, sizeof(ep));
+	ep.hip = argp->hip;
+	memcpy(ep.mac, argp->mac, sizeof(ep.mac));
+	memcpy(ep.hmac, argp->hmac, sizeof(ep.hmac));
+	rc = trn_update_endpoint6(&epkey, &ep);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update IPv6 endpoint %d - %s",
+			      argp->vni, ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_ep6_1_svc(rpc_endpoint6_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	char ip[INET6_ADDRSTRLEN];
+	endpoint_key6_t epkey;
+	int rc;
+
+	inet_ntop(AF_INET6, argp->ip, ip, sizeof(ip));
+	TRN_LOG_DEBUG("delete_ep6_1 vni: %d, ip: %s", argp->vni, ip);
+
+	epkey.vni = argp->vni;
+	memcpy(epkey.ip, argp->ip, sizeof(epkey.ip));
+	rc = trn_delete_endpoint6(&epkey);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete IPv6 endpoint %d - %s",
+			      argp->vni, ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_endpoint6_t *get_ep6_1_svc(rpc_endpoint6_key_t *argp,
+				   struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_endpoint6_t result;
+	char ip[INET6_ADDRSTRLEN];
+	endpoint_key6_t epkey;
+	endpoint_t ep;
+
+	inet_ntop(AF_INET6, argp->ip, ip, sizeof(ip));
+	TRN_LOG_DEBUG("get_ep6_1 vni: %d, ip: %s", argp->vni, ip);
+
+	epkey.vni = argp->vni;
+	memcpy(epkey.ip, argp->ip, sizeof(epkey.ip));
+	if (trn_get_endpoint6(&epkey, &ep)) {
+		TRN_LOG_ERROR("Cannot find IPv6 endpoint %d - %s from XDP map",
+			      argp->vni, ip);
+		return NULL;
+	}
+
+	result.vni = argp->vni;
+	memcpy(result.ip, argp->ip, sizeof(result.ip));
+	result.hip = ep.hip;
+	memcpy(result.mac, ep.mac, sizeof(result.mac));
+	memcpy(result.hmac, ep.hmac, sizeof(result.hmac));
+
+	return &result;
+}
+
+int *update_sg_rules_1_svc(rpc_trn_sg_rules_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	static trn_sg_rule_t rules[TRAN_MAX_SG_RULES_BATCH];
+	u_int i;
+	int rc;
+
+	TRN_LOG_DEBUG("update_sg_rules_1 vni: %d, rules: %d, append: %d",
+		      argp->vni, argp->rules.rules_len, argp->append);
+
+	for (i = 0; i < argp->rules.rules_len; i++) {
+		rpc_trn_sg_rule_t *r = &argp->rules.rules_val[i];
+
+		rules[i].cidr = r->cidr;
+		rules[i].prefixlen = r->prefixlen;
+		rules[i].direction = r->direction;
+		rules[i].protocol = r->protocol;
+		rules[i].rsvd = 0;
+		rules[i].port_min = r->port_min;
+		rules[i].port_max = r->port_max;
+
+		if (r->prefixlen > 32 || r->direction >= TRAN_SG_DIRS ||
+		    r->protocol > 0xff) {
+			TRN_LOG_ERROR("Invalid security group rule %d of VNI %d",
+				      i, argp->vni);
+			result = RPC_TRN_ERROR;
+			return &result;
+		}
+	}
+
+	rc = trn_update_sg_rules(argp->vni, rules, argp->rules.rules_len,
+				 argp->append);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update security group rules of VNI %d",
+			      argp->vni);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_sg_rules_1_svc(rpc_trn_vni_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_sg_rules_1 vni: %d", argp->vni);
+
+	rc = trn_delete_sg_rules(argp->vni);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete security group rules of VNI %d",
+			      argp->vni);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+static int trn_sg_identity_key(rpc_trn_sg_identity_rule_t *r,
+			       sg_identity_key_t *key)
+{
+	if (r->protocol > 0xff) {
+		return 1;
+	}
+
+	key->vni = r->vni;
+	key->src_id = r->src_id;
+	key->dst_id = r->dst_id;
+	key->port = r->port;
+	key->protocol = r->protocol;
+	key->rsvd = 0;
+	return 0;
+}
+
+int *update_sg_identity_rules_1_svc(rpc_trn_sg_identity_rules_t *argp,
+				    struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	sg_identity_key_t key;
+	u_int i;
+
+	TRN_LOG_DEBUG("update_sg_identity_rules_1 rules: %d",
+		      argp->rules.rules_len);
+
+	result = 0;
+	for (i = 0; i < argp->rules.rules_len; i++) {
+		rpc_trn_sg_identity_rule_t *r = &argp->rules.rules_val[i];
+
+		if (trn_sg_identity_key(r, &key) || r->verdict > TRAN_SG_ALLOW) {
+			TRN_LOG_ERROR("Invalid identity policy rule %d of VNI %d",
+				      i, r->vni);
+			result = RPC_TRN_ERROR;
+			break;
+		}
+
+		if (trn_update_sg_identity_rule(&key, r->verdict)) {
+			TRN_LOG_ERROR("Failed to update identity policy %d to %d of VNI %d",
+				      r->src_id, r->dst_id, r->vni);
+			result = RPC_TRN_ERROR;
+			break;
+		}
+	}
+
+	return &result;
+}
+
+int *delete_sg_identity_rule_1_svc(rpc_trn_sg_identity_rule_t *argp,
+				   struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	sg_identity_key_t key;
+
+	TRN_LOG_DEBUG("delete_sg_identity_rule_1 vni: %d, %d to %d",
+		      argp->vni, argp->src_id, argp->dst_id);
+
+	if (trn_sg_identity_key(argp, &key) ||
+	    trn_delete_sg_identity_rule(&key)) {
+		TRN_LOG_ERROR("Failed to delete identity policy %d to %d of VNI %d",
+			      argp->src_id, argp->dst_id, argp->vni);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_ct_list_t *dump_conntrack_1_svc(rpc_trn_ct_filter_t *argp,
+					struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_ct_list_t result;
+	static rpc_trn_ct_entry_t entries[TRAN_MAX_CT_DUMP];
+	trn_ct_entry_t cts[TRAN_MAX_CT_DUMP];
+	__u32 n = 0;
+
+	TRN_LOG_DEBUG("dump_conntrack_1 vni: %d all: %d", argp->vni,
+		      argp->all_vnis);
+
+	if (trn_dump_conntrack(argp->vni, argp->all_vnis, cts, &n,
+			       &result.total)) {
+		TRN_LOG_ERROR("Cannot dump tracked connections");
+		goto error;
+	}
+
+	for (__u32 i = 0; i < n; i++) {
+		entries[i].vni = cts[i].vni;
+		entries[i].saddr = cts[i].tuple.saddr;
+		entries[i].daddr = cts[i].tuple.daddr;
+		entries[i].sport = ntohs(cts[i].tuple.sport);
+		entries[i].dport = ntohs(cts[i].tuple.dport);
+		entries[i].protocol = cts[i].tuple.protocol;
+		entries[i].state = cts[i].state;
+		entries[i].idle = cts[i].idle;
+	}
+	result.entries.entries_len = n;
+	result.entries.entries_val = entries;
+
+	return &result;
+
+error:
+	return NULL;
+}
+
+int *flush_conntrack_1_svc(rpc_trn_ct_filter_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("flush_conntrack_1 vni: %d all: %d", argp->vni,
+		      argp->all_vnis);
+
+	rc = trn_flush_conntrack(argp->vni, argp->all_vnis);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to flush tracked connections");
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *update_rate_limit_1_svc(rpc_trn_rate_limit_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	endpoint_key_t epkey;
+	int rc;
+
+	TRN_LOG_DEBUG("update_rate_limit_1 vni: %d, ip: 0x%x, pps: %lu, "
+		      "bps: %lu, action: %d", argp->vni, argp->ip,
+		      (unsigned long)argp->pps, (unsigned long)argp->bps,
+		      argp->action);
+
+	if (argp->action > TRAN_RL_MARK) {
+		TRN_LOG_ERROR("Invalid rate limit action %d", argp->action);
+		result = RPC_TRN_ERROR;
+		return &result;
+	}
+
+	epkey.vni = argp->vni;
+	epkey.ip = argp->ip;
+	rc = trn_update_rate_limit(&epkey, argp->pps, argp->bps, argp->action);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to update rate limit of %d - 0x%x",
+			      argp->vni, argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+int *delete_rate_limit_1_svc(rpc_endpoint_key_t *argp, struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static int result;
+	int rc;
+
+	TRN_LOG_DEBUG("delete_rate_limit_1 vni: %d, ip: 0x%x", argp->vni,
+		      argp->ip);
+
+	rc = trn_delete_rate_limit((endpoint_key_t *)argp);
+
+	if (rc != 0) {
+		TRN_LOG_ERROR("Failed to delete rate limit of %d - 0x%x",
+			      argp->vni, argp->ip);
+		result = RPC_TRN_ERROR;
+	} else {
+		result = 0;
+	}
+
+	return &result;
+}
+
+rpc_trn_rate_limit_stats_t *get_rate_limit_stats_1_svc(rpc_trn_vni_key_t *argp,
+						       struct svc_req *rqstp)
+{
+	UNUSED(rqstp);
+	static rpc_trn_rate_limit_stats_t result;
+	rate_limit_stats_t stats;
+
+	TRN_LOG_DEBUG("get_rate_limit_stats_1 vni: %d", argp->vni);
+
+	if (trn_get_rate_limit_stats(argp->vni, &stats)) {
+		TRN_LOG_ERROR("Cannot get rate limit stats of %d", argp->vni);
+		return NULL;
+	}
+
+	result.marked = stats.marked;
+	result.dropped = stats.dropped;
+	result.dropped_bytes = stats.dropped_bytes;
+
+	return &result;
+}
@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_transit_sg_usr.c
+ *
+ * @brief Security group rule compiler of transit daemon.
+ *
+ * Transit XDP classifies a packet by probing one hash table per remote
+ * prefix length in use by the VNI (tuple space search), so its cost
+ * depends on the number of distinct prefix lengths, not of rules. The
+ * destination port is first mapped to the port ranges it falls in by a
+ * binary search over the intervals the ranges split the port space in,
+ * a rule entry then matches if it allows one of them.
+ *
+ * Tables come in two generations. A change of a VNI's rules recompiles
+ * all of them into the generation not in use, flips the VNI over to it
+ * with a single sg_vni_map update and then removes the previous one, so
+ * packets never see a partially applied rule set.
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include "trn_transitd.h"
+
+/* Rules of a VNI and the tables compiled from them installed in XDP */
+typedef struct trn_sg_node {
+	__u32 vni;
+	__u32 nrules;
+	trn_sg_rule_t *rules;
+	trn_sg_table_t tbl;
+	struct trn_sg_node *next;
+} trn_sg_node_t;
+
+static trn_sg_node_t *sg_db[TRN_SG_DB_BUCKETS];
+
+static trn_sg_node_t **trn_sg_db_find(__u32 vni)
+{
+	trn_sg_node_t **node = &sg_db[vni & (TRN_SG_DB_BUCKETS - 1)];
+
+	while (*node && (*node)->vni != vni)
+		node = &(*node)->next;
+
+	return node;
+}
+
+static int trn_sg_entry_cmp(const void *a, const void *b)
+{
+	return memcmp(&((const trn_sg_entry_t *)a)->key,
+		      &((const trn_sg_entry_t *)b)->key, sizeof(sg_rule_key_t));
+}
+
+static int trn_sg_u32_cmp(const void *a, const void *b)
+{
+	__u32 x = *(const __u32 *)a, y = *(const __u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* Port table of a direction and protocol, TRN_SG_PORT_TABLES if portless */
+static __u32 trn_sg_port_table(__u8 direction, __u8 protocol)
+{
+	if (protocol == IPPROTO_TCP)
+		return direction * 2;
+	if (protocol == IPPROTO_UDP)
+		return direction * 2 + 1;
+	return TRN_SG_PORT_TABLES;
+}
+
+static __u32 trn_sg_mask(__u8 prefixlen)
+{
+	return prefixlen ? htonl(~0U << (32 - prefixlen)) : 0;
+}
+
+/* Split the port space at range boundaries, tag intervals with ranges */
+static void trn_sg_compile_ports(__u16 *lo, __u16 *hi, __u32 nranges,
+				 struct sg_ports_t *ports)
+{
+	__u32 bounds[2 * TRAN_MAX_SG_PORT_RANGES + 1];
+	__u32 i, j, k, n = 0;
+
+	bounds[n++] = 0;
+	for (i = 0; i < nranges; i++) {
+		bounds[n++] = lo[i];
+		if (hi[i] < 0xffff)
+			bounds[n++] = hi[i] + 1;
+	}
+	qsort(bounds, n, sizeof(bounds[0]), trn_sg_u32_cmp);
+
+	memset(ports, 0, sizeof(*ports));
+	for (i = 0; i < n; i++) {
+		if (i && bounds[i] == bounds[i - 1])
+			continue;
+
+		j = ports->nintervals++;
+		ports->start[j] = bounds[i];
+		for (k = 0; k < nranges; k++) {
+			if (lo[k] <= bounds[i] && bounds[i] <= hi[k])
+				ports->ranges[j] |= 1ULL << k;
+		}
+	}
+}
+
+int trn_sg_compile(__u32 vni, trn_sg_rule_t *rules, __u32 nrules,
+		   trn_sg_table_t *tbl)
+{
+	static const __u8 protos[] = { IPPROTO_TCP, IPPROTO_UDP };
+	__u16 lo[TRN_SG_PORT_TABLES][TRAN_MAX_SG_PORT_RANGES];
+	__u16 hi[TRN_SG_PORT_TABLES][TRAN_MAX_SG_PORT_RANGES];
+	__u32 nranges[TRN_SG_PORT_TABLES] = { 0 };
+	trn_sg_entry_t *e;
+	__u32 i, j, t, n;
+
+	memset(tbl, 0, sizeof(*tbl));
+	tbl->entries = calloc(nrules ? nrules : 1, sizeof(*tbl->entries));
+	if (!tbl->entries) {
+		TRN_LOG_ERROR("Failed to allocate security group tables of VNI %d",
+			      vni);
+		return 1;
+	}
+
+	for (i = 0; i < nrules; i++) {
+		trn_sg_rule_t *r = &rules[i];
+		__u64 bit = 1;
+
+		if (r->direction >= TRAN_SG_DIRS || r->prefixlen > 32 ||
+		    r->port_min > r->port_max) {
+			TRN_LOG_ERROR("Invalid security group rule %d of VNI %d",
+				      i, vni);
+			goto error;
+		}
+
+		t = trn_sg_port_table(r->direction, r->protocol);
+		if (t < TRN_SG_PORT_TABLES) {
+			for (j = 0; j < nranges[t]; j++) {
+				if (lo[t][j] == r->port_min &&
+				    hi[t][j] == r->port_max)
+					break;
+			}
+
+			if (j == TRAN_MAX_SG_PORT_RANGES) {
+				TRN_LOG_ERROR("VNI %d has over %d port ranges of protocol %d",
+					      vni, TRAN_MAX_SG_PORT_RANGES,
+					      r->protocol);
+				goto error;
+			} else if (j == nranges[t]) {
+				lo[t][j] = r->port_min;
+				hi[t][j] = r->port_max;
+				nranges[t]++;
+			}
+			bit = 1ULL << j;
+		}
+
+		e = &tbl->entries[i];
+		e->key.vni = vni;
+		e->key.remote_ip = r->cidr & trn_sg_mask(r->prefixlen);
+		e->key.prefixlen = r->prefixlen;
+		e->key.direction = r->direction;
+		e->key.protocol = r->protocol;
+		e->ranges = bit;
+
+		if (r->protocol == TRAN_SG_PROTO_ANY)
+			tbl->vni.any_prefixes[r->direction] |= 1ULL << r->prefixlen;
+		else
+			tbl->vni.prefixes[r->direction] |= 1ULL << r->prefixlen;
+	}
+
+	/* Rules sharing a remote prefix become one entry */
+	qsort(tbl->entries, nrules, sizeof(*tbl->entries), trn_sg_entry_cmp);
+	for (i = 0, n = 0; i < nrules; i++) {
+		if (n && !trn_sg_entry_cmp(&tbl->entries[n - 1], &tbl->entries[i]))
+			tbl->entries[n - 1].ranges |= tbl->entries[i].ranges;
+		else
+			tbl->entries[n++] = tbl->entries[i];
+	}
+	tbl->nentries = n;
+
+	for (t = 0; t < TRN_SG_PORT_TABLES; t++) {
+		if (!nranges[t])
+			continue;
+
+		tbl->port_keys[tbl->nports].vni = vni;
+		tbl->port_keys[tbl->nports].direction = t / 2;
+		tbl->port_keys[tbl->nports].protocol = protos[t % 2];
+		trn_sg_compile_ports(lo[t], hi[t], nranges[t],
+				     &tbl->ports[tbl->nports]);
+		tbl->nports++;
+	}
+
+	return 0;
+
+error:
+	trn_sg_table_free(tbl);
+	return 1;
+}
+
+void trn_sg_table_free(trn_sg_table_t *tbl)
+{
+	free(tbl->entries);
+	tbl->entries = NULL;
+	tbl->nentries = 0;
+	tbl->nports = 0;
+}
+
+static void trn_sg_uninstall(trn_sg_maps_t *maps, trn_sg_table_t *tbl)
+{
+	__u32 i;
+
+	for (i = 0; i < tbl->nentries; i++)
+		bpf_map_delete_elem(maps->rules_fd, &tbl->entries[i].key);
+
+	for (i = 0; i < tbl->nports; i++)
+		bpf_map_delete_elem(maps->ports_fd, &tbl->port_keys[i]);
+}
+
+static int trn_sg_install(trn_sg_maps_t *maps, trn_sg_table_t *tbl, __u8 gen)
+{
+	__u32 i;
+	int err;
+
+	tbl->vni.gen = gen;
+
+	for (i = 0; i < tbl->nports; i++) {
+		tbl->port_keys[i].gen = gen;
+		err = bpf_map_update_elem(maps->ports_fd, &tbl->port_keys[i],
+					  &tbl->ports[i], 0);
+		if (err) {
+			TRN_LOG_ERROR("Store security group ports failed (err:%d).",
+				      err);
+			goto error;
+		}
+	}
+
+	for (i = 0; i < tbl->nentries; i++) {
+		tbl->entries[i].key.gen = gen;
+		err = bpf_map_update_elem(maps->rules_fd, &tbl->entries[i].key,
+					  &tbl->entries[i].ranges, 0);
+		if (err) {
+			TRN_LOG_ERROR("Store security group rule failed (err:%d).",
+				      err);
+			goto error;
+		}
+	}
+
+	return 0;
+
+error:
+	trn_sg_uninstall(maps, tbl);
+	return 1;
+}
+
+/*
+ * Set the rules of a VNI, or add to them if append. An empty rule set
+ * denies all traffic of the VNI, unlike a VNI without one.
+ */
+int trn_sg_update(trn_sg_maps_t *maps, __u32 vni, trn_sg_rule_t *rules,
+		  __u32 nrules, bool append)
+{
+	trn_sg_node_t **slot = trn_sg_db_find(vni);
+	trn_sg_node_t *node = *slot;
+	__u32 nold = (append && node) ? node->nrules : 0;
+	trn_sg_rule_t *all;
+	trn_sg_table_t tbl;
+
+	if (nold + nrules > TRAN_MAX_SG_RULES) {
+		TRN_LOG_ERROR("VNI %d has over %d security group rules", vni,
+			      TRAN_MAX_SG_RULES);
+		return 1;
+	}
+
+	all = malloc((nold + nrules) * sizeof(*all) + 1);
+	if (!all) {
+		TRN_LOG_ERROR("Failed to allocate security group rules of VNI %d",
+			      vni);
+		return 1;
+	}
+	if (nold)
+		memcpy(all, node->rules, nold * sizeof(*all));
+	memcpy(all + nold, rules, nrules * sizeof(*all));
+
+	if (!node) {
+		node = calloc(1, sizeof(*node));
+		if (!node) {
+			TRN_LOG_ERROR("Failed to allocate security group of VNI %d",
+				      vni);
+			goto error;
+		}
+		node->vni = vni;
+	}
+
+	if (trn_sg_compile(vni, all, nold + nrules, &tbl))
+		goto error;
+
+	if (trn_sg_install(maps, &tbl, *slot ? !node->tbl.vni.gen : 0))
+		goto error_free;
+
+	/* Flip the VNI over to the new generation */
+	if (bpf_map_update_elem(maps->vni_fd, &vni, &tbl.vni, 0)) {
+		TRN_LOG_ERROR("Store security group of VNI %d failed.", vni);
+		trn_sg_uninstall(maps, &tbl);
+		goto error_free;
+	}
+
+	if (*slot) {
+		trn_sg_uninstall(maps, &node->tbl);
+		trn_sg_table_free(&node->tbl);
+		free(node->rules);
+	} else {
+		*slot = node;
+	}
+
+	node->rules = all;
+	node->nrules = nold + nrules;
+	node->tbl = tbl;
+	return 0;
+
+error_free:
+	trn_sg_table_free(&tbl);
+error:
+	if (node && !*slot)
+		free(node);
+	free(all);
+	return 1;
+}
+
+/* Remove all rules of a VNI, its traffic is no longer classified */
+int trn_sg_delete(trn_sg_maps_t *maps, __u32 vni)
+{
+	trn_sg_node_t **slot = trn_sg_db_find(vni);
+	trn_sg_node_t *node = *slot;
+	int err;
+
+	if (!node) {
+		TRN_LOG_ERROR("VNI %d has no security group rules", vni);
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(maps->vni_fd, &vni);
+	if (err) {
+		TRN_LOG_ERROR("Deleting security group of VNI %d failed (err:%d).",
+			      vni, err);
+		return 1;
+	}
+
+	trn_sg_uninstall(maps, &node->tbl);
+	trn_sg_table_free(&node->tbl);
+	free(node->rules);
+	*slot = node->next;
+	free(node);
+	return 0;
+}
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_transit_sg_usr.h
+ *
+ * @brief Security group rule compiler of transit daemon. Rules of a VNI
+ * are compiled into the tuple-space classifier tables of transit XDP.
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#pragma once
+
+#include <linux/types.h>
+#include <stdbool.h>
+
+#include "trn_datamodel.h"
+
+/* Bucket count of the table of VNIs with rules */
+#define TRN_SG_DB_BUCKETS 1024
+
+/* Port tables of a VNI, one per direction for TCP and UDP */
+#define TRN_SG_PORT_TABLES (TRAN_SG_DIRS * 2)
+
+/*
+ * A security group rule, traffic it matches is allowed. cidr is the
+ * remote side in network byte order, ports are the destination ports
+ * of TCP and UDP and are ignored for other protocols.
+ */
+typedef struct {
+	__u32 cidr;
+	__u8 prefixlen;
+	__u8 direction;      // TRAN_SG_EGRESS or TRAN_SG_INGRESS
+	__u8 protocol;       // TRAN_SG_PROTO_ANY matches all
+	__u8 rsvd;
+	__u16 port_min;
+	__u16 port_max;
+} trn_sg_rule_t;
+
+typedef struct {
+	sg_rule_key_t key;
+	__u64 ranges;
+} trn_sg_entry_t;
+
+/* Classifier tables compiled from the rules of a VNI */
+typedef struct {
+	struct sg_vni_t vni;
+	__u32 nentries;
+	trn_sg_entry_t *entries;
+	__u32 nports;
+	sg_ports_key_t port_keys[TRN_SG_PORT_TABLES];
+	struct sg_ports_t ports[TRN_SG_PORT_TABLES];
+} trn_sg_table_t;
+
+typedef struct {
+	int vni_fd;
+	int rules_fd;
+	int ports_fd;
+} trn_sg_maps_t;
+
+int trn_sg_compile(__u32 vni, trn_sg_rule_t *rules, __u32 nrules,
+		   trn_sg_table_t *tbl);
+void trn_sg_table_free(trn_sg_table_t *tbl);
+
+int trn_sg_update(trn_sg_maps_t *maps, __u32 vni, trn_sg_rule_t *rules,
+		  __u32 nrules, bool append);
+int trn_sg_delete(trn_sg_maps_t *maps, __u32 vni);
@@ -25,6 +25,7 @@
 
 #include <stdio.h>
 #include <time.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
@@ -53,6 +54,25 @@ static trn_xdp_prog_t trn_prog_dbg_tbl[TRAN_MAX_PROG] = {
 	{TRAN_DROP_PROG, "/trn_xdp/trn_transit_drop_proc_xdp_ebpf_debug.o"},
 };
 
+/* Transit XDP objects specialized per interface role, by trn_xdp_role_t */
+static trn_xdp_prog_t trn_role_prog_tbl[XDP_ROLE_MAX] = {
+	{XDP_FWD, "/trn_xdp/trn_transit_xdp_fwd_ebpf.o"},
+	{XDP_FTN, "/trn_xdp/trn_transit_xdp_ftn_ebpf.o"},
+};
+
+static trn_xdp_prog_t trn_role_prog_dbg_tbl[XDP_ROLE_MAX] = {
+	{XDP_FWD, "/trn_xdp/trn_transit_xdp_fwd_ebpf_debug.o"},
+	{XDP_FTN, "/trn_xdp/trn_transit_xdp_ftn_ebpf_debug.o"},
+};
+
+/* Stage names of the built-in verdict programs of trn_prog_tbl */
+static const char *trn_stage_builtin_names[TRAN_MAX_PROG] = {
+	[TRAN_TX_PROG] = "xdp_tx",
+	[TRAN_PASS_PROG] = "xdp_pass",
+	[TRAN_REDIRECT_PROG] = "xdp_redirect",
+	[TRAN_DROP_PROG] = "xdp_drop",
+};
+
 static trn_xdp_itf_def_t trn_xdp_itf_def[TRAN_ITF_MAP_MAX] = {
 	{TRAN_ITF_MAP_TENANT, XDP_FWD, XDP_TUNNEL_VXLAN},
 	{TRAN_ITF_MAP_ZGC, XDP_FTN, XDP_TUNNEL_GENEVE},
@@ -60,21 +80,62 @@ static trn_xdp_itf_def_t trn_xdp_itf_def[TRAN_ITF_MAP_MAX] = {
 
 static char * pin_path = "/sys/fs/bpf";
 
+/* Name of the CPUMAP stage in transit XDP object */
+#define TRN_CPUMAP_PROG_NAME "_transit_cpumap"
+
+/* Name prefix of the DEVMAP egress programs rewriting BUM copies */
+#define TRN_FLOOD_PROG_NAME "_transit_flood_"
+
+/* Name of the program of the external interface of gateway endpoints */
+#define TRN_EIP_PROG_NAME "_transit_eip"
+
 /* Make sure to keep in-sync with XDP programs, order doesn't matter */
 static trn_xdp_map_t trn_xdp_bpfmaps[] = {
 	{"jmp_table", true, -1, NULL},
 	{"endpoints_map", true, -1, NULL},
+	{"endpoints6_map", true, -1, NULL},
 	{"if_config_map", true, -1, NULL},
+	{"entrances_map", true, -1, NULL},
 	{"interfaces_map", true, -1, NULL},
-#if connTrack
 	{"contrack_map", true, -1, NULL},
-#endif
-#if sgSupport
-	{"sg_cidr_map", true, -1, NULL},
-	{"security_group_map", true, -1, NULL},
-	{"port_range_map", true, -1, NULL},
-#endif
+	{"sg_vni_map", true, -1, NULL},
+	{"sg_rules_map", true, -1, NULL},
+	{"sg_ports_map", true, -1, NULL},
+	{"sg_identity_map", true, -1, NULL},
     {"xsks_map", true, -1,NULL},
+	{"flow_cache_map", true, -1, NULL},
+	{"flow_gen_map", true, -1, NULL},
+	{"flow_cache_stats_map", true, -1, NULL},
+	{"dfts_map", true, -1, NULL},
+	{"dft_tables_map", true, -1, NULL},
+	{"chains_map", true, -1, NULL},
+	{"ftns_map", true, -1, NULL},
+	{"scaled_eps_map", true, -1, NULL},
+	{"scaled_fwd_map", true, -1, NULL},
+	{"scaled_rev_map", true, -1, NULL},
+	{"scaled_ep_stats_map", true, -1, NULL},
+	{"flood_lists_map", true, -1, NULL},
+	{"flood_stats_map", true, -1, NULL},
+	{"flood_devmaps_map", true, -1, NULL},
+	{"eip_map", true, -1, NULL},
+	{"eip_rev_map", true, -1, NULL},
+	{"eip_gw_map", true, -1, NULL},
+	{"eip_devmap", true, -1, NULL},
+	{"eip_stats_map", true, -1, NULL},
+	{"rate_limits_map", true, -1, NULL},
+	{"ep_bloom_map", true, -1, NULL},
+	{"miss_neg_map", true, -1, NULL},
+	{"upcall_cfg_map", true, -1, NULL},
+	{"upcall_buckets_map", true, -1, NULL},
+	{"upcall_stats_map", true, -1, NULL},
+	{"rate_buckets_map", true, -1, NULL},
+	{"rate_limit_stats_map", true, -1, NULL},
+	{"cpu_map", true, -1, NULL},
+	{"cpus_available", true, -1, NULL},
+	{"cpu_spread_cfg_map", true, -1, NULL},
+	{"cpu_spread_stats_map", true, -1, NULL},
+	{"stage_cfg_map", true, -1, NULL},
+	{"stage_stats_map", true, -1, NULL},
 #if turnOn
 	{"hosted_eps_if", true, -1, NULL},
 	{"oam_queue_map", true, -1, NULL},
@@ -88,6 +149,10 @@ static trn_xdp_map_t trn_xdp_bpfmaps[] = {
 
 static user_metadata_t *md = NULL;
 
+/* Inner map templates of map-in-maps, only needed while loading */
+static int dft_inner_fd = -1;
+static int flood_inner_fd = -1;
+
 static trn_xdp_map_t * trn_transit_map_get(char *map_name)
 {
 	int num_maps = sizeof(trn_xdp_bpfmaps) / sizeof(trn_xdp_bpfmaps[0]);
@@ -125,6 +190,143 @@ static void trn_transit_map_hash_destroy(void)
 {
 }
 
+/* bpfmaps only used by an optional feature, shrunk when it's disabled */
+static struct {
+	char *name;
+	__u32 feature;
+} trn_xdp_feature_maps[] = {
+	{"contrack_map", TRAN_XDP_FEAT_CONNTRACK},
+	{"sg_vni_map", TRAN_XDP_FEAT_SG},
+	{"sg_rules_map", TRAN_XDP_FEAT_SG},
+	{"sg_ports_map", TRAN_XDP_FEAT_SG},
+	{"sg_identity_map", TRAN_XDP_FEAT_IDENTITY},
+	{"scaled_eps_map", TRAN_XDP_FEAT_SCALED_EP},
+	{"scaled_fwd_map", TRAN_XDP_FEAT_SCALED_EP},
+	{"scaled_rev_map", TRAN_XDP_FEAT_SCALED_EP},
+	{"scaled_ep_stats_map", TRAN_XDP_FEAT_SCALED_EP},
+	{"flood_lists_map", TRAN_XDP_FEAT_BUM},
+	{"flood_stats_map", TRAN_XDP_FEAT_BUM},
+	{"flood_devmaps_map", TRAN_XDP_FEAT_BUM},
+	{"eip_map", TRAN_XDP_FEAT_EIP},
+	{"eip_rev_map", TRAN_XDP_FEAT_EIP},
+	{"eip_stats_map", TRAN_XDP_FEAT_EIP},
+	{"rate_limits_map", TRAN_XDP_FEAT_RATE_LIMIT},
+	{"rate_buckets_map", TRAN_XDP_FEAT_RATE_LIMIT},
+	{"rate_limit_stats_map", TRAN_XDP_FEAT_RATE_LIMIT},
+	{"ep_bloom_map", TRAN_XDP_FEAT_MISS_GUARD},
+	{"miss_neg_map", TRAN_XDP_FEAT_MISS_GUARD},
+	{"upcall_buckets_map", TRAN_XDP_FEAT_MISS_GUARD},
+	{"upcall_stats_map", TRAN_XDP_FEAT_MISS_GUARD},
+};
+
+static bool trn_transit_map_disabled(const char *map_name)
+{
+	for (size_t i = 0; i < sizeof(trn_xdp_feature_maps) /
+		     sizeof(trn_xdp_feature_maps[0]); i++) {
+		if (!strcmp(map_name, trn_xdp_feature_maps[i].name)) {
+			return !(md->cfg.features & trn_xdp_feature_maps[i].feature);
+		}
+	}
+	return false;
+}
+
+/*
+ * Write the load time TRAN_XDP_FEAT_* into trn_features, the only
+ * variable in .rodata of XDP objects. libbpf rejects a size mismatch.
+ */
+static int trn_transit_set_features(struct bpf_map *map)
+{
+	const char *map_name = bpf_map__name(map);
+	size_t len = strlen(map_name);
+
+	if (len < strlen(".rodata") ||
+	    strcmp(map_name + len - strlen(".rodata"), ".rodata")) {
+		return 0;
+	}
+
+	if (bpf_map__set_initial_value(map, &md->cfg.features,
+				       sizeof(md->cfg.features))) {
+		TRN_LOG_ERROR("Failed to set XDP features in %s.\n", map_name);
+		return 1;
+	}
+	TRN_LOG_INFO("XDP features 0x%x set in %s.\n", md->cfg.features,
+		     map_name);
+	return 0;
+}
+
+/*
+ * Probe once whether the kernel accepts multi-buffer (frags aware) XDP
+ * programs. Without it native XDP refuses to attach on jumbo MTU.
+ */
+static bool trn_xdp_frags_supported(void)
+{
+	static int supported = -1;
+	struct bpf_insn insns[] = {
+		/* r0 = XDP_PASS; exit */
+		{ .code = BPF_ALU64 | BPF_MOV | BPF_K, .dst_reg = BPF_REG_0,
+		  .imm = XDP_PASS },
+		{ .code = BPF_JMP | BPF_EXIT },
+	};
+	LIBBPF_OPTS(bpf_prog_load_opts, opts,
+		.prog_flags = BPF_F_XDP_HAS_FRAGS,
+	);
+	int fd;
+
+	if (supported >= 0) {
+		return supported;
+	}
+
+	fd = bpf_prog_load(BPF_PROG_TYPE_XDP, NULL, "GPL", insns,
+			   sizeof(insns) / sizeof(insns[0]), &opts);
+	supported = fd >= 0;
+	if (fd >= 0) {
+		close(fd);
+	}
+
+	TRN_LOG_INFO("XDP multi-buffer %ssupported", supported ? "" : "not ");
+	return supported;
+}
+
+/*
+ * Per-DFT array of chain ids. BPF_F_INNER_MAP lets arrays of any size
+ * share dft_tables_map.
+ */
+static int trn_dft_table_create(__u32 table_len)
+{
+	LIBBPF_OPTS(bpf_map_create_opts, opts,
+		.map_flags = BPF_F_INNER_MAP,
+	);
+
+	return bpf_map_create(BPF_MAP_TYPE_ARRAY, NULL, sizeof(__u32),
+			      sizeof(__u32), table_len, &opts);
+}
+
+/* Devmap of the hosts a VNI floods to, one slot per host */
+static int trn_flood_devmap_create(void)
+{
+	return bpf_map_create(BPF_MAP_TYPE_DEVMAP, NULL, sizeof(__u32),
+			      sizeof(struct bpf_devmap_val), TRAN_MAX_FLOOD,
+			      NULL);
+}
+
+/*
+ * Devmap slot served by a flood egress program, _transit_flood_<hi>_<lo>
+ * serves slot hi * 8 + lo. Returns -1 for other programs.
+ */
+static int trn_flood_prog_slot(const char *name)
+{
+	unsigned int hi, lo;
+	char end;
+
+	if (strncmp(name, TRN_FLOOD_PROG_NAME, strlen(TRN_FLOOD_PROG_NAME)) ||
+	    sscanf(name + strlen(TRN_FLOOD_PROG_NAME), "%u_%u%c",
+		   &hi, &lo, &end) != 2 ||
+	    lo >= 8 || hi * 8 + lo >= TRAN_MAX_FLOOD) {
+		return -1;
+	}
+	return hi * 8 + lo;
+}
+
 /*
  * Setup bpfmap to use shared map if it was pinned   
  * Must be invoked before load to take effect
@@ -151,6 +353,38 @@ static int trn_transit_xdp_pre_load(trn_prog_t *prog, int prog_idx)
 	bpf_object__for_each_program(bpf_prog, obj) {
 		bpf_program__set_type(bpf_prog, BPF_PROG_TYPE_XDP);
 		bpf_program__set_ifindex(bpf_prog, 0);
+
+		/* Main and tail-called programs must agree on frags */
+		if (trn_xdp_frags_supported()) {
+			bpf_program__set_flags(bpf_prog,
+				bpf_program__flags(bpf_prog) | BPF_F_XDP_HAS_FRAGS);
+		}
+
+		/* CPUMAP stage is only needed when RX spreading is on */
+		if (!strcmp(bpf_program__name(bpf_prog), TRN_CPUMAP_PROG_NAME)) {
+			bpf_program__set_expected_attach_type(bpf_prog,
+				BPF_XDP_CPUMAP);
+			bpf_program__set_autoload(bpf_prog,
+				md->cfg.num_spread_cpus > 0);
+			continue;
+		}
+
+		/* Flood egress programs are only needed for BUM replication */
+		if (trn_flood_prog_slot(bpf_program__name(bpf_prog)) >= 0) {
+			bpf_program__set_expected_attach_type(bpf_prog,
+				BPF_XDP_DEVMAP);
+			bpf_program__set_autoload(bpf_prog,
+				!!(md->cfg.features & TRAN_XDP_FEAT_BUM));
+			continue;
+		}
+
+		/* External interface program is only needed for elastic IPs */
+		if (!strcmp(bpf_program__name(bpf_prog), TRN_EIP_PROG_NAME)) {
+			bpf_program__set_autoload(bpf_prog,
+				!!(md->cfg.features & TRAN_XDP_FEAT_EIP));
+			continue;
+		}
+
 		if (!first_prog) {
 			first_prog = bpf_prog;
 		}
@@ -168,6 +402,38 @@ static int trn_transit_xdp_pre_load(trn_prog_t *prog, int prog_idx)
 
 		bpf_map__set_ifindex(map, 0);
 
+		if (trn_transit_set_features(map)) {
+			return 1;
+		}
+
+		if (trn_transit_map_disabled(map_name)) {
+			bpf_map__set_max_entries(map, 1);
+		}
+
+		if (!strcmp(map_name, "dft_tables_map")) {
+			if (dft_inner_fd < 0) {
+				dft_inner_fd = trn_dft_table_create(1);
+			}
+			if (dft_inner_fd < 0 ||
+			    bpf_map__set_inner_map_fd(map, dft_inner_fd)) {
+				TRN_LOG_ERROR("Failed to set inner map of %s.\n",
+					map_name);
+				return 1;
+			}
+		}
+
+		if (!strcmp(map_name, "flood_devmaps_map")) {
+			if (flood_inner_fd < 0) {
+				flood_inner_fd = trn_flood_devmap_create();
+			}
+			if (flood_inner_fd < 0 ||
+			    bpf_map__set_inner_map_fd(map, flood_inner_fd)) {
+				TRN_LOG_ERROR("Failed to set inner map of %s.\n",
+					map_name);
+				return 1;
+			}
+		}
+
 		trn_xdp_map_t *xdpmap = trn_transit_map_get(map_name);
 
 		if (!xdpmap) {
@@ -204,11 +470,11 @@ static int trn_transit_xdp_pre_load(trn_prog_t *prog, int prog_idx)
 static int trn_transit_xdp_post_load(trn_prog_t *prog, int prog_idx)
 {
 	char buf[TRAN_MAX_PATH_SIZE];
-	struct bpf_program *first_prog;
+	struct bpf_program *bpf_prog, *first_prog = NULL;
 	struct bpf_object *obj;
 	struct bpf_map *map;
 	char *map_name, *pinfile;
-	int len, fd;
+	int len, fd, slot;
 
 	if (!prog || !prog->obj) {
 		TRN_LOG_ERROR("Invalid input.\n");
@@ -216,8 +482,26 @@ static int trn_transit_xdp_post_load(trn_prog_t *prog, int prog_idx)
 	}
 
 	obj = prog->obj;
+	prog->cpumap_prog_fd = -1;
+	for (slot = 0; slot < TRAN_MAX_FLOOD; slot++) {
+		prog->flood_prog_fds[slot] = -1;
+	}
+	prog->eip_prog_fd = -1;
+
+	bpf_object__for_each_program(bpf_prog, obj) {
+		slot = trn_flood_prog_slot(bpf_program__name(bpf_prog));
+		if (!strcmp(bpf_program__name(bpf_prog), TRN_CPUMAP_PROG_NAME)) {
+			prog->cpumap_prog_fd = bpf_program__fd(bpf_prog);
+		} else if (slot >= 0) {
+			prog->flood_prog_fds[slot] = bpf_program__fd(bpf_prog);
+		} else if (!strcmp(bpf_program__name(bpf_prog),
+				   TRN_EIP_PROG_NAME)) {
+			prog->eip_prog_fd = bpf_program__fd(bpf_prog);
+		} else if (!first_prog) {
+			first_prog = bpf_prog;
+		}
+	}
 
-	first_prog = bpf_object__next_program(obj, NULL);
 	if (!first_prog) {
 		TRN_LOG_ERROR("Failed to find XDP program in object file: %s\n",
 				bpf_object__name(obj));
@@ -225,6 +509,15 @@ static int trn_transit_xdp_post_load(trn_prog_t *prog, int prog_idx)
 	}
 	prog->prog_fd = bpf_program__fd(first_prog);
 
+	if (dft_inner_fd >= 0) {
+		close(dft_inner_fd);
+		dft_inner_fd = -1;
+	}
+	if (flood_inner_fd >= 0) {
+		close(flood_inner_fd);
+		flood_inner_fd = -1;
+	}
+
 	TRN_LOG_INFO("trn_transit_xdp_post_load\n");
 
 	bpf_object__for_each_map(map, obj) {
@@ -276,6 +569,149 @@ static int trn_transit_xdp_post_load(trn_prog_t *prog, int prog_idx)
 	return 0;
 }
 
+/*
+ * Upcall budgets are of the whole host, every CPU polices its share with
+ * its own buckets like rate limits do.
+ */
+static int trn_transit_upcall_initialize(void)
+{
+	upcall_cfg_t cfg;
+	int fd, err, num_cpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("upcall_cfg_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get upcall_cfg_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	/*
+	 * Misses of a source host mostly land on one CPU, its budget is
+	 * given whole to each CPU. Those of a VNI spread over all of them.
+	 */
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.host_pps = md->cfg.upcall_host_pps;
+	cfg.vni_pps = (md->cfg.upcall_vni_pps + num_cpus - 1) / num_cpus;
+	cfg.gen = 1;
+
+	err = bpf_map_update_elem(fd, &key, &cfg, 0);
+	if (err) {
+		TRN_LOG_ERROR("Failed to update upcall_cfg_map (err:%d).", err);
+		return 1;
+	}
+
+	TRN_LOG_INFO("Upcall budgets %d pps per host and CPU, %d pps per VNI",
+		     md->cfg.upcall_host_pps, md->cfg.upcall_vni_pps);
+	return 0;
+}
+
+/*
+ * Populate cpu_map with the worker CPUs of RX spreading, every CPU runs
+ * the CPUMAP stage of the first transit object since all objects share
+ * the same bpfmaps.
+ */
+static int trn_transit_cpu_spread_initialize(void)
+{
+	trn_xdp_load_cfg_t *cfg = &md->cfg;
+	cpu_spread_cfg_t spread_cfg = { .num_cpus = 0 };
+	int map_fd, avail_fd, cfg_fd, num_cpus, err;
+	__u32 idx, key = 0;
+
+	map_fd = trn_transit_map_get_fd("cpu_map");
+	avail_fd = trn_transit_map_get_fd("cpus_available");
+	cfg_fd = trn_transit_map_get_fd("cpu_spread_cfg_map");
+	if (map_fd < 0 || avail_fd < 0 || cfg_fd < 0) {
+		TRN_LOG_ERROR("Failed to get RX spreading bpfmap fds");
+		return 1;
+	}
+
+	if (cfg->num_spread_cpus) {
+		struct bpf_cpumap_val val = {
+			.qsize = cfg->cpumap_qsize,
+			.bpf_prog.fd = md->objs[0].xdp.cpumap_prog_fd,
+		};
+
+		if (val.bpf_prog.fd < 0) {
+			TRN_LOG_ERROR("CPUMAP stage of transit XDP not loaded");
+			return 1;
+		}
+
+		num_cpus = libbpf_num_possible_cpus();
+		if (num_cpus <= 0) {
+			TRN_LOG_ERROR("Failed to get number of possible cpus");
+			return 1;
+		}
+
+		for (idx = 0; idx < cfg->num_spread_cpus; idx++) {
+			__u32 cpu = cfg->spread_cpus[idx];
+
+			if (cpu >= TRAN_MAX_CPUS || cpu >= (__u32)num_cpus) {
+				TRN_LOG_ERROR("Invalid RX spreading cpu %d", cpu);
+				return 1;
+			}
+
+			err = bpf_map_update_elem(map_fd, &cpu, &val, 0);
+			if (err) {
+				TRN_LOG_ERROR("Failed to add cpu %d to cpu_map (err:%d).",
+					cpu, err);
+				return 1;
+			}
+
+			err = bpf_map_update_elem(avail_fd, &idx, &cpu, 0);
+			if (err) {
+				TRN_LOG_ERROR("Failed to update cpus_available (err:%d).",
+					err);
+				return 1;
+			}
+		}
+		spread_cfg.num_cpus = cfg->num_spread_cpus;
+		TRN_LOG_INFO("RX spreading over %d cpus, qsize %d",
+			cfg->num_spread_cpus, cfg->cpumap_qsize);
+	}
+
+	/* Written last so XDP never picks a CPU missing in cpu_map */
+	err = bpf_map_update_elem(cfg_fd, &key, &spread_cfg, 0);
+	if (err) {
+		TRN_LOG_ERROR("Failed to update cpu_spread_cfg_map (err:%d).", err);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Flag verdicts with stages in stage_cfg_map, others skip the tail call */
+static int trn_update_stage_mask(void)
+{
+	__u32 key = 0, mask = 0, prog_idx;
+	int fd, err;
+
+	for (prog_idx = TRAN_TX_PROG; prog_idx < TRAN_MAX_PROG; prog_idx++) {
+		if (md->num_stages[prog_idx]) {
+			mask |= 1 << prog_idx;
+		}
+	}
+
+	fd = trn_transit_map_get_fd("stage_cfg_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get stage_cfg_map fd");
+		return 1;
+	}
+
+	err = bpf_map_update_elem(fd, &key, &mask, 0);
+	if (err) {
+		TRN_LOG_ERROR("Failed to update stage mask 0x%x (err:%d).",
+			mask, err);
+		return 1;
+	}
+	return 0;
+}
+
 /*
  * Pin bpfmap for sharing if it was not pinned  
  * Must be invoked AFTER load
@@ -291,20 +727,10 @@ static int trn_transit_xdp_map_initialize(void)
 
 	TRN_LOG_INFO("trn_transit_xdp_map_initialize\n");
 
-	/* Initialize jmp_table */
-	fd = trn_transit_map_get_fd("jmp_table");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get jmp_table fd");
+	/* No stage pipelines until programs are inserted */
+	if (trn_update_stage_mask()) {
 		return 1;
 	}
-	for (idx = TRAN_TRANSIT_PROG + 1; idx < TRAN_MAX_PROG; idx++) {
-		err = bpf_map_update_elem(fd, &idx, &md->ebpf_progs[idx].prog_fd, 0);
-		if (err) {
-			TRN_LOG_ERROR("Failed to add prog %d to jmp table (err:%d).",
-				idx, err);
-			return 1;
-		}
-	}
 
 	/* Initialize interfaces_map for redirect */
 	fd = trn_transit_map_get_fd("interfaces_map");
@@ -322,15 +748,26 @@ static int trn_transit_xdp_map_initialize(void)
 		}
 	}
 
+	if (trn_transit_cpu_spread_initialize()) {
+		TRN_LOG_ERROR("Failed to initialize RX spreading");
+		return 1;
+	}
+
+	if ((md->cfg.features & TRAN_XDP_FEAT_MISS_GUARD) &&
+	    trn_transit_upcall_initialize()) {
+		TRN_LOG_ERROR("Failed to initialize upcall budgets");
+		return 1;
+	}
+
 	/* Don't initialize if_config_map untill droplets created */
 	// Should initial with all zero config map to avoid garbage data lookup
 	return 0;
 }
 
-static int trn_prog_load(trn_prog_t *prog, int prog_idx)
+static int trn_prog_load_file(trn_prog_t *prog, int prog_idx, char *path)
 {
 	struct bpf_object_open_attr open_attr = {
-		.file = md->prog_tbl[prog_idx].prog_path,
+		.file = path,
 		.prog_type = BPF_PROG_TYPE_XDP
 	};
 
@@ -381,384 +818,1781 @@ cleanup:
 	return 1;
 }
 
-#if sgSupport
-int trn_update_sg_cidr_get_ctx(void)
+/*
+ * Path of the transit XDP object for an interface role. Falls back to
+ * the generic object, which serves all roles, if the specialized one is
+ * not installed.
+ */
+static char *trn_transit_prog_path(int role)
 {
-	int fd;
+	char *path = md->role_prog_tbl[role].prog_path;
 
-	fd = trn_transit_map_get_fd("sg_cidr_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get sg_cidr_map fd");
+	if (access(path, R_OK)) {
+		TRN_LOG_WARN("Missing %s, using generic transit XDP object", path);
+		path = md->prog_tbl[TRAN_TRANSIT_PROG].prog_path;
 	}
+	return path;
+}
 
-	return fd;
+static int trn_sg_get_maps(trn_sg_maps_t *maps)
+{
+	maps->vni_fd = trn_transit_map_get_fd("sg_vni_map");
+	maps->rules_fd = trn_transit_map_get_fd("sg_rules_map");
+	maps->ports_fd = trn_transit_map_get_fd("sg_ports_map");
+	if (maps->vni_fd < 0 || maps->rules_fd < 0 || maps->ports_fd < 0) {
+		TRN_LOG_ERROR("Failed to get security group map fds");
+		return 1;
+	}
+	return 0;
 }
 
-int trn_update_sg_cidr(int fd, sg_cidr_key_t *sgkey, sg_cidr_t *sg)
+int trn_update_sg_rules(__u32 vni, trn_sg_rule_t *rules, __u32 nrules,
+			bool append)
 {
-	int err;
+	trn_sg_maps_t maps;
 
-	if (fd < 0) {
-		TRN_LOG_ERROR("Invalid sg_cidr_map fd");
+	if (trn_sg_get_maps(&maps))
 		return 1;
-	}
 
-	err = bpf_map_update_elem(fd, sgkey, sg, 0);
-	if (err) {
-		TRN_LOG_ERROR("Store sg_cidr mapping failed (err:%d).", err);
+	if (trn_sg_update(&maps, vni, rules, nrules, append))
 		return 1;
-	}
+
+	trn_flow_cache_invalidate(vni);
+
+	return 0;
+}
+
+int trn_delete_sg_rules(__u32 vni)
+{
+	trn_sg_maps_t maps;
+
+	if (trn_sg_get_maps(&maps))
+		return 1;
+
+	if (trn_sg_delete(&maps, vni))
+		return 1;
+
+	trn_flow_cache_invalidate(vni);
 
 	return 0;
 }
 
-int trn_get_sg_cidr(sg_cidr_key_t *epkey, sg_cidr_t *ep)
+int trn_update_sg_identity_rule(sg_identity_key_t *key, __u32 verdict)
 {
 	int fd, err;
 
-	fd = trn_transit_map_get_fd("sg_cidr_map");
+	fd = trn_transit_map_get_fd("sg_identity_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get sg_cidr_map fd");
+		TRN_LOG_ERROR("Failed to get sg_identity_map fd");
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, epkey, ep);
+	err = bpf_map_update_elem(fd, key, &verdict, 0);
 	if (err) {
-		TRN_LOG_ERROR("Querying sg_cidr mapping failed (err:%d).",
+		TRN_LOG_ERROR("Store identity policy verdict failed (err:%d).",
 			      err);
 		return 1;
 	}
+
+	trn_flow_cache_invalidate(key->vni);
+
 	return 0;
 }
 
-int trn_delete_sg_cidr(sg_cidr_key_t *epkey)
+int trn_delete_sg_identity_rule(sg_identity_key_t *key)
 {
-	sg_cidr_t ep;
 	int fd, err;
 
-	fd = trn_transit_map_get_fd("sg_cidr_map");
+	fd = trn_transit_map_get_fd("sg_identity_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get sg_cidr_map fd");
+		TRN_LOG_ERROR("Failed to get sg_identity_map fd");
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, epkey, &ep);
-
+	err = bpf_map_delete_elem(fd, key);
 	if (err) {
-		TRN_LOG_ERROR("Querying sg_cidr for delete failed (err:%d).",
+		TRN_LOG_ERROR("Deleting identity policy verdict failed (err:%d).",
 			      err);
 		return 1;
 	}
 
-	err = bpf_map_delete_elem(fd, epkey);
-	if (err) {
-		TRN_LOG_ERROR("Deleting sg_cidr mapping failed (err:%d).",
-			      err);
-		return 1;
-	}
+	trn_flow_cache_invalidate(key->vni);
 
 	return 0;
 }
-// security_group
-int trn_update_sg_get_ctx(void)
+
+int trn_update_endpoints_get_ctx(void)
 {
 	int fd;
 
-	fd = trn_transit_map_get_fd("security_group_map");
+	fd = trn_transit_map_get_fd("endpoints_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get security_group_map fd");
+		TRN_LOG_ERROR("Failed to get endpoints_map fd");
 	}
 
 	return fd;
 }
 
-int trn_update_sg(int fd, security_group_key_t *sgkey, security_group_t *sg)
+/*
+ * Precompute the outer IPv4 checksum change of redirecting a packet to
+ * ep->hip (RFC 1624). The transit's own address moves from daddr to
+ * saddr and cancels out, leaving the new daddr and the ttl decrement;
+ * XDP only adds the complement of the old saddr per packet.
+ */
+void trn_set_endpoint_csum_delta(endpoint_t *ep)
+{
+	__u32 csum;
+
+	csum = (ep->hip & 0xffff) + (ep->hip >> 16) +
+	       (__u16)~htons(0x0100);
+	csum = (csum & 0xffff) + (csum >> 16);
+	csum = (csum & 0xffff) + (csum >> 16);
+
+	ep->csum_delta = csum;
+}
+
+/*
+ * Bloom filters can't forget, keys of deleted endpoints stay and only
+ * cost their misses the endpoints_map probe again.
+ */
+int trn_endpoint_bloom_add(endpoint_key_t *epkey)
 {
-	int err;
+	int fd, err;
+
+	if (!md || !(md->cfg.features & TRAN_XDP_FEAT_MISS_GUARD)) {
+		return 0;
+	}
 
+	fd = trn_transit_map_get_fd("ep_bloom_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Invalid security_group_map fd");
+		TRN_LOG_ERROR("Failed to get ep_bloom_map fd");
 		return 1;
 	}
 
-	err = bpf_map_update_elem(fd, sgkey, sg, 0);
+	err = bpf_map_update_elem(fd, NULL, epkey, BPF_ANY);
 	if (err) {
-		TRN_LOG_ERROR("Store sg_cidr mapping failed (err:%d).", err);
+		TRN_LOG_ERROR("Store endpoint %d - 0x%x in bloom filter failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
 		return 1;
 	}
 
 	return 0;
 }
 
-int trn_get_sg(security_group_key_t *sgkey, security_group_t *sg)
+/* Misses of a key the slow path couldn't resolve skip it for a while */
+int trn_miss_neg_cache_add(endpoint_key_t *epkey)
 {
+	struct timespec now;
+	__u64 expiry;
 	int fd, err;
 
-	fd = trn_transit_map_get_fd("security_group_map");
+	if (!md || !(md->cfg.features & TRAN_XDP_FEAT_MISS_GUARD)) {
+		return 0;
+	}
+
+	fd = trn_transit_map_get_fd("miss_neg_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get security_group_map fd");
+		TRN_LOG_ERROR("Failed to get miss_neg_map fd");
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, sgkey, sg);
+	/* Same clock as bpf_ktime_get_ns */
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	expiry = (__u64)now.tv_sec * 1000000000ULL + now.tv_nsec +
+		 TRAN_MISS_NEG_TTL_NS;
+
+	err = bpf_map_update_elem(fd, epkey, &expiry, BPF_ANY);
 	if (err) {
-		TRN_LOG_ERROR("Querying sg_cidr mapping failed (err:%d).",
-			      err);
+		TRN_LOG_ERROR("Store negative cache entry %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
 		return 1;
 	}
+
 	return 0;
 }
 
-int trn_delete_sg(security_group_key_t *sgkey)
+int trn_update_endpoint(int fd, endpoint_key_t *epkey, endpoint_t *ep)
 {
-	security_group_t sg;
-	int fd, err;
+	int err;
 
-	fd = trn_transit_map_get_fd("security_group_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get security_group_map fd");
+		TRN_LOG_ERROR("Invalid endpoints_map fd");
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, sgkey, &sg);
+	trn_set_endpoint_csum_delta(ep);
 
+	err = bpf_map_update_elem(fd, epkey, ep, 0);
 	if (err) {
-		TRN_LOG_ERROR("Querying security_group for delete failed (err:%d).",
-			      err);
+		TRN_LOG_ERROR("Store endpoint mapping failed (err:%d).", err);
 		return 1;
 	}
 
-	err = bpf_map_delete_elem(fd, sgkey);
-	if (err) {
-		TRN_LOG_ERROR("Deleting security_group mapping failed (err:%d).",
-			      err);
-		return 1;
+	/* Keep slow path able to re-install it after LRU/flush eviction */
+	if (trn_xsk_ep_db_update(epkey, ep)) {
+		TRN_LOG_WARN("Store endpoint for slow path failed.");
 	}
 
+	if (trn_endpoint_bloom_add(epkey)) {
+		TRN_LOG_WARN("Store endpoint in miss filter failed.");
+	}
+
+	trn_flow_cache_invalidate(epkey->vni);
+
 	return 0;
 }
 
-//port_range_map
-int trn_update_port_range_get_ctx(void)
+int trn_get_endpoint(endpoint_key_t *epkey, endpoint_t *ep)
 {
-	int fd;
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("endpoints_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get endpoints_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, ep);
+	if (err) {
+		TRN_LOG_ERROR("Querying endpoint mapping failed (err:%d).",
+			      err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_endpoint(endpoint_key_t *epkey)
+{
+	endpoint_t ep;
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("endpoints_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get endpoints_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, &ep);
+
+	if (err) {
+		TRN_LOG_ERROR("Querying endpoint for delete failed (err:%d).",
+			      err);
+		return 1;
+	}
+
+	trn_xsk_ep_db_delete(epkey);
+
+	err = bpf_map_delete_elem(fd, epkey);
+	if (err) {
+		TRN_LOG_ERROR("Deleting endpoint mapping failed (err:%d).",
+			      err);
+		return 1;
+	}
+
+	trn_flow_cache_invalidate(epkey->vni);
+
+	return 0;
+}
+
+/*
+ * IPv6 endpoints are resolved in XDP only, the slow path and the flow
+ * cache are IPv4 so there is nothing else to keep in sync.
+ */
+int trn_update_endpoint6(endpoint_key6_t *epkey, endpoint_t *ep)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("endpoints6_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get endpoints6_map fd");
+		return 1;
+	}
+
+	trn_set_endpoint_csum_delta(ep);
+
+	err = bpf_map_update_elem(fd, epkey, ep, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store IPv6 endpoint mapping failed (err:%d).",
+			      err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_endpoint6(endpoint_key6_t *epkey, endpoint_t *ep)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("endpoints6_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get endpoints6_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, ep);
+	if (err) {
+		TRN_LOG_ERROR("Querying IPv6 endpoint mapping failed (err:%d).",
+			      err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_endpoint6(endpoint_key6_t *epkey)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("endpoints6_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get endpoints6_map fd");
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(fd, epkey);
+	if (err) {
+		TRN_LOG_ERROR("Deleting IPv6 endpoint mapping failed (err:%d).",
+			      err);
+		return 1;
+	}
+	return 0;
+}
+
+/* Stale cached flows of VNIs sharing the generation slot of vni */
+int trn_flow_cache_invalidate(__u32 vni)
+{
+	__u32 slot = TRAN_FLOW_GEN_SLOT(vni);
+	__u32 gen = 0;
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("flow_gen_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flow_gen_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, &slot, &gen);
+	if (err) {
+		TRN_LOG_ERROR("Querying flow generation failed (err:%d).", err);
+		return 1;
+	}
+
+	gen++;
+	err = bpf_map_update_elem(fd, &slot, &gen, 0);
+	if (err) {
+		TRN_LOG_ERROR("Bumping flow generation failed (err:%d).", err);
+		return 1;
+	}
+
+	return 0;
+}
+
+int trn_get_flow_cache_stats(flow_cache_stats_t *stats)
+{
+	int fd, err, num_cpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("flow_cache_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flow_cache_stats_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	flow_cache_stats_t percpu[num_cpus];
+
+	err = bpf_map_lookup_elem(fd, &key, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying flow cache stats failed (err:%d).", err);
+		return 1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < num_cpus; i++) {
+		stats->hit += percpu[i].hit;
+		stats->miss += percpu[i].miss;
+		stats->evict += percpu[i].evict;
+		stats->insert += percpu[i].insert;
+	}
+
+	return 0;
+}
+
+typedef int (*trn_ct_visit_t)(contrack_key_t *key, contrack_t *ct,
+			      __u64 now, void *arg);
+
+/*
+ * Visit the tracked connections of vni, or of all VNIs, with now in
+ * bpf_ktime_get_ns time. Connections visit returns 1 for are deleted,
+ * after the key following them is read.
+ */
+static int trn_ct_walk(__u32 vni, bool all_vnis, trn_ct_visit_t visit,
+		       void *arg)
+{
+	contrack_key_t key, next;
+	struct timespec ts;
+	contrack_t ct;
+	__u64 now;
+	int fd, more;
+
+	if (!md || !md->ready ||
+	    !(md->cfg.features & TRAN_XDP_FEAT_CONNTRACK)) {
+		TRN_LOG_ERROR("Connection tracking not enabled");
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("contrack_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get contrack_map fd");
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+	more = !bpf_map_get_next_key(fd, NULL, &key);
+	while (more) {
+		more = !bpf_map_get_next_key(fd, &key, &next);
+
+		if ((all_vnis || key.vni == vni) &&
+		    !bpf_map_lookup_elem(fd, &key, &ct) &&
+		    visit(&key, &ct, now, arg)) {
+			bpf_map_delete_elem(fd, &key);
+		}
+		key = next;
+	}
+
+	return 0;
+}
+
+static int trn_ct_stale(contrack_key_t *key, contrack_t *ct, __u64 now,
+			void *arg)
+{
+	__u64 timeout = TRAN_CT_TIMEOUT(key->tuple.protocol, ct->state) *
+			1000000000ULL;
+	__u32 *swept = arg;
+
+	if (now <= ct->last_seen + timeout)
+		return 0;
+
+	(*swept)++;
+	return 1;
+}
+
+static int trn_ct_flush(contrack_key_t *key, contrack_t *ct, __u64 now,
+			void *arg)
+{
+	UNUSED(key);
+	UNUSED(ct);
+	UNUSED(now);
+	UNUSED(arg);
+	return 1;
+}
+
+struct trn_ct_dump_t {
+	trn_ct_entry_t *entries;
+	__u32 max;
+	__u32 n;
+	__u32 total;
+};
+
+static int trn_ct_dump(contrack_key_t *key, contrack_t *ct, __u64 now,
+		       void *arg)
+{
+	struct trn_ct_dump_t *dump = arg;
+	trn_ct_entry_t *e;
+
+	if (dump->total++ >= dump->max)
+		return 0;
+
+	e = &dump->entries[dump->n++];
+	e->vni = key->vni;
+	e->tuple = key->tuple;
+	if (ct->orig) {
+		e->tuple.saddr = key->tuple.daddr;
+		e->tuple.daddr = key->tuple.saddr;
+		e->tuple.sport = key->tuple.dport;
+		e->tuple.dport = key->tuple.sport;
+	}
+	e->state = ct->state;
+	e->idle = now > ct->last_seen ?
+		(now - ct->last_seen) / 1000000000ULL : 0;
+
+	return 0;
+}
+
+/* Tracked connections of vni, entries holds up to TRAN_MAX_CT_DUMP */
+int trn_dump_conntrack(__u32 vni, bool all_vnis, trn_ct_entry_t *entries,
+		       __u32 *nentries, __u32 *total)
+{
+	struct trn_ct_dump_t dump = {
+		.entries = entries,
+		.max = TRAN_MAX_CT_DUMP,
+	};
+
+	if (trn_ct_walk(vni, all_vnis, trn_ct_dump, &dump)) {
+		return 1;
+	}
+
+	*nentries = dump.n;
+	*total = dump.total;
+	return 0;
+}
+
+/*
+ * Forget the tracked connections of vni, their next packets are
+ * classified by the security groups again.
+ */
+int trn_flush_conntrack(__u32 vni, bool all_vnis)
+{
+	return trn_ct_walk(vni, all_vnis, trn_ct_flush, NULL);
+}
+
+/*
+ * Delete connections idle past the timeout of their state. XDP ignores
+ * them already, this frees their entries before LRU eviction has to.
+ */
+void trn_sweep_conntrack(void)
+{
+	__u32 swept = 0;
+
+	if (!md || !md->ready ||
+	    !(md->cfg.features & TRAN_XDP_FEAT_CONNTRACK)) {
+		return;
+	}
+
+	if (!trn_ct_walk(0, true, trn_ct_stale, &swept) && swept) {
+		TRN_LOG_DEBUG("Swept %d stale tracked connections", swept);
+	}
+}
+
+/* Per CPU RX spreading counters, stats holds up to TRAN_MAX_CPUS entries */
+int trn_get_cpu_spread_stats(__u32 *num_cpus, cpu_spread_stats_t *stats)
+{
+	int fd, err, ncpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("cpu_spread_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get cpu_spread_stats_map fd");
+		return 1;
+	}
+
+	ncpus = libbpf_num_possible_cpus();
+	if (ncpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	cpu_spread_stats_t percpu[ncpus];
+
+	err = bpf_map_lookup_elem(fd, &key, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying cpu spread stats failed (err:%d).", err);
+		return 1;
+	}
+
+	*num_cpus = ncpus < TRAN_MAX_CPUS ? ncpus : TRAN_MAX_CPUS;
+	memcpy(stats, percpu, *num_cpus * sizeof(*stats));
+	return 0;
+}
+
+/*
+ * Program the Maglev table of a DFT. Tables over TRAN_MAX_MAGLEV_TABLE_SIZE
+ * go to a new array map in dft_tables_map, which is swapped in before the
+ * length in dfts_map so the XDP lookup never indexes past its table.
+ */
+int trn_update_dft(__u32 dft_id, __u32 table_len, const __u32 *table)
+{
+	static struct dft_t dft;
+	int fd, tables_fd, inner_fd, err = 0;
+
+	if (dft_id >= TRAN_MAX_DFT || !table_len ||
+	    table_len > TRAN_MAX_DFT_TABLE_SIZE) {
+		TRN_LOG_ERROR("Invalid DFT %d with table of %d entries",
+			      dft_id, table_len);
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("dfts_map");
+	tables_fd = trn_transit_map_get_fd("dft_tables_map");
+	if (fd < 0 || tables_fd < 0) {
+		TRN_LOG_ERROR("Failed to get DFT map fds");
+		return 1;
+	}
+
+	memset(&dft, 0, sizeof(dft));
+	dft.table_len = table_len;
+
+	if (table_len <= TRAN_MAX_MAGLEV_TABLE_SIZE) {
+		memcpy(dft.table, table, table_len * sizeof(*table));
+	} else {
+		inner_fd = trn_dft_table_create(table_len);
+		if (inner_fd < 0) {
+			TRN_LOG_ERROR("Failed to create table of DFT %d (err:%d).",
+				      dft_id, inner_fd);
+			return 1;
+		}
+
+		for (__u32 i = 0; i < table_len; i++) {
+			err = bpf_map_update_elem(inner_fd, &i, &table[i], 0);
+			if (err) {
+				break;
+			}
+		}
+		if (!err) {
+			err = bpf_map_update_elem(tables_fd, &dft_id,
+						  &inner_fd, 0);
+		}
+		close(inner_fd);
+
+		if (err) {
+			TRN_LOG_ERROR("Store table of DFT %d failed (err:%d).",
+				      dft_id, err);
+			return 1;
+		}
+	}
+
+	err = bpf_map_update_elem(fd, &dft_id, &dft, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store DFT %d failed (err:%d).", dft_id, err);
+		return 1;
+	}
+
+	if (table_len <= TRAN_MAX_MAGLEV_TABLE_SIZE) {
+		bpf_map_delete_elem(tables_fd, &dft_id);
+	}
+
+	return 0;
+}
+
+/* Read back a DFT table, table holds up to TRAN_MAX_DFT_TABLE_SIZE */
+int trn_get_dft(__u32 dft_id, __u32 *table_len, __u32 *table)
+{
+	static struct dft_t dft;
+	int fd, tables_fd, inner_fd, err = 0;
+	__u32 inner_id;
+
+	fd = trn_transit_map_get_fd("dfts_map");
+	tables_fd = trn_transit_map_get_fd("dft_tables_map");
+	if (fd < 0 || tables_fd < 0) {
+		TRN_LOG_ERROR("Failed to get DFT map fds");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, &dft_id, &dft);
+	if (err || !dft.table_len) {
+		TRN_LOG_ERROR("DFT %d not found", dft_id);
+		return 1;
+	}
+
+	*table_len = dft.table_len;
+	if (dft.table_len <= TRAN_MAX_MAGLEV_TABLE_SIZE) {
+		memcpy(table, dft.table, dft.table_len * sizeof(*table));
+		return 0;
+	}
+
+	/* Map-in-map lookup from user space yields the inner map id */
+	if (bpf_map_lookup_elem(tables_fd, &dft_id, &inner_id)) {
+		TRN_LOG_ERROR("Table of DFT %d not found", dft_id);
+		return 1;
+	}
+
+	inner_fd = bpf_map_get_fd_by_id(inner_id);
+	if (inner_fd < 0) {
+		TRN_LOG_ERROR("Failed to open table of DFT %d", dft_id);
+		return 1;
+	}
+
+	for (__u32 i = 0; i < dft.table_len; i++) {
+		err = bpf_map_lookup_elem(inner_fd, &i, &table[i]);
+		if (err) {
+			break;
+		}
+	}
+	close(inner_fd);
+
+	if (err) {
+		TRN_LOG_ERROR("Querying table of DFT %d failed (err:%d).",
+			      dft_id, err);
+		return 1;
+	}
+
+	return 0;
+}
+
+int trn_delete_dft(__u32 dft_id)
+{
+	static struct dft_t dft;
+	int fd, tables_fd, err;
+
+	fd = trn_transit_map_get_fd("dfts_map");
+	tables_fd = trn_transit_map_get_fd("dft_tables_map");
+	if (fd < 0 || tables_fd < 0) {
+		TRN_LOG_ERROR("Failed to get DFT map fds");
+		return 1;
+	}
+
+	/* Array entries stay, an empty table disables the DFT */
+	memset(&dft, 0, sizeof(dft));
+	err = bpf_map_update_elem(fd, &dft_id, &dft, 0);
+	if (err) {
+		TRN_LOG_ERROR("Delete DFT %d failed (err:%d).", dft_id, err);
+		return 1;
+	}
+
+	bpf_map_delete_elem(tables_fd, &dft_id);
+	return 0;
+}
+
+int trn_update_chain(__u32 chain_id, struct chain_t *chain)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("chains_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get chains_map fd");
+		return 1;
+	}
+
+	err = bpf_map_update_elem(fd, &chain_id, chain, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store chain %d failed (err:%d).", chain_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_chain(__u32 chain_id, struct chain_t *chain)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("chains_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get chains_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, &chain_id, chain);
+	if (err) {
+		TRN_LOG_ERROR("Querying chain %d failed (err:%d).", chain_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_chain(__u32 chain_id)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("chains_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get chains_map fd");
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(fd, &chain_id);
+	if (err) {
+		TRN_LOG_ERROR("Delete chain %d failed (err:%d).", chain_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_update_ftn(__u32 ftn_id, struct ftn_t *ftn)
+{
+	int fd, err;
+
+	if (ftn->position > TRAN_FTN_TYPE_TAIL) {
+		TRN_LOG_ERROR("Invalid position %d of FTN %d", ftn->position,
+			      ftn_id);
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("ftns_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get ftns_map fd");
+		return 1;
+	}
+
+	err = bpf_map_update_elem(fd, &ftn_id, ftn, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store FTN %d failed (err:%d).", ftn_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_ftn(__u32 ftn_id, struct ftn_t *ftn)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("ftns_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get ftns_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, &ftn_id, ftn);
+	if (err) {
+		TRN_LOG_ERROR("Querying FTN %d failed (err:%d).", ftn_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_ftn(__u32 ftn_id)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("ftns_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get ftns_map fd");
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(fd, &ftn_id);
+	if (err) {
+		TRN_LOG_ERROR("Delete FTN %d failed (err:%d).", ftn_id, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_update_scaled_ep(endpoint_key_t *epkey, struct scaled_ep_t *sep)
+{
+	int fd, err;
+
+	if (!sep->nremotes || sep->nremotes > TRAN_MAX_REMOTES) {
+		TRN_LOG_ERROR("Invalid number of backends %d of scaled ep %d - 0x%x",
+			      sep->nremotes, epkey->vni, epkey->ip);
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("scaled_eps_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get scaled_eps_map fd");
+		return 1;
+	}
+
+	/* Established flows keep their backend in scaled_fwd_map */
+	err = bpf_map_update_elem(fd, epkey, sep, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store scaled ep %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_scaled_ep(endpoint_key_t *epkey, struct scaled_ep_t *sep)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("scaled_eps_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get scaled_eps_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, sep);
+	if (err) {
+		TRN_LOG_ERROR("Querying scaled ep %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_scaled_ep(endpoint_key_t *epkey)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("scaled_eps_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get scaled_eps_map fd");
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(fd, epkey);
+	if (err) {
+		TRN_LOG_ERROR("Delete scaled ep %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_scaled_ep_stats(scaled_ep_stats_t *stats)
+{
+	int fd, err, num_cpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("scaled_ep_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get scaled_ep_stats_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	scaled_ep_stats_t percpu[num_cpus];
+
+	err = bpf_map_lookup_elem(fd, &key, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying scaled ep stats failed (err:%d).", err);
+		return 1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < num_cpus; i++) {
+		stats->dsr_flows += percpu[i].dsr_flows;
+		stats->dsr_bytes += percpu[i].dsr_bytes;
+	}
+
+	return 0;
+}
+
+/*
+ * XDP broadcasts a BUM frame to every slot of the devmap of its VNI, so
+ * the devmap gets exactly one slot per host under the cap. Each slot is
+ * the tenant interface running the flood egress program of that slot,
+ * which sends its copy to the host of the same index.
+ * The devmap is built aside and swapped in whole.
+ */
+static int trn_update_flood_devmap(__u32 vni, __u32 nslots)
+{
+	trn_prog_t *xdp = &md->objs[TRAN_ITF_MAP_TENANT].xdp;
+	struct bpf_devmap_val val = {
+		.ifindex = md->objs[TRAN_ITF_MAP_TENANT].eth.iface_index,
+	};
+	int fd, inner_fd, err = 0;
+
+	for (__u32 i = 0; i < nslots; i++) {
+		if (xdp->flood_prog_fds[i] < 0) {
+			TRN_LOG_ERROR("Flood egress program %d of transit XDP not loaded",
+				      i);
+			return 1;
+		}
+	}
+
+	fd = trn_transit_map_get_fd("flood_devmaps_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flood_devmaps_map fd");
+		return 1;
+	}
+
+	inner_fd = trn_flood_devmap_create();
+	if (inner_fd < 0) {
+		TRN_LOG_ERROR("Failed to create devmap of flood list %d (err:%d).",
+			      vni, inner_fd);
+		return 1;
+	}
+
+	for (__u32 i = 0; i < nslots; i++) {
+		val.bpf_prog.fd = xdp->flood_prog_fds[i];
+		err = bpf_map_update_elem(inner_fd, &i, &val, 0);
+		if (err) {
+			break;
+		}
+	}
+	if (!err) {
+		err = bpf_map_update_elem(fd, &vni, &inner_fd, 0);
+	}
+	close(inner_fd);
+
+	if (err) {
+		TRN_LOG_ERROR("Store devmap of flood list %d failed (err:%d).",
+			      vni, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_update_flood_list(__u32 vni, struct flood_list_t *fl)
+{
+	__u32 nslots = fl->nhosts;
+	int fd, err;
+
+	if (!fl->nhosts || fl->nhosts > TRAN_MAX_FLOOD) {
+		TRN_LOG_ERROR("Invalid number of hosts %d of flood list %d",
+			      fl->nhosts, vni);
+		return 1;
+	}
+
+	if (fl->cap && fl->cap < nslots) {
+		nslots = fl->cap;
+	}
+
+	/* Slots first, or XDP would drop copies of the new hosts */
+	if (trn_update_flood_devmap(vni, nslots)) {
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("flood_lists_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flood_lists_map fd");
+		return 1;
+	}
+
+	err = bpf_map_update_elem(fd, &vni, fl, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store flood list %d failed (err:%d).", vni, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_flood_list(__u32 vni, struct flood_list_t *fl)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("flood_lists_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flood_lists_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, &vni, fl);
+	if (err) {
+		TRN_LOG_ERROR("Querying flood list %d failed (err:%d).", vni, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_flood_list(__u32 vni)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("flood_lists_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get flood_lists_map fd");
+		return 1;
+	}
+
+	err = bpf_map_delete_elem(fd, &vni);
+	if (err) {
+		TRN_LOG_ERROR("Delete flood list %d failed (err:%d).", vni, err);
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("flood_devmaps_map");
+	if (fd >= 0) {
+		bpf_map_delete_elem(fd, &vni);
+	}
+	return 0;
+}
+
+int trn_get_flood_stats(__u32 vni, flood_stats_t *stats)
+{
+	int fd, err, num_cpus;
 
-	fd = trn_transit_map_get_fd("port_range_map");
+	fd = trn_transit_map_get_fd("flood_stats_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get port_range_map fd");
+		TRN_LOG_ERROR("Failed to get flood_stats_map fd");
+		return 1;
 	}
 
-	return fd;
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	flood_stats_t percpu[num_cpus];
+
+	err = bpf_map_lookup_elem(fd, &vni, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying flood stats of %d failed (err:%d).",
+			      vni, err);
+		return 1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < num_cpus; i++) {
+		stats->frames += percpu[i].frames;
+		stats->copies += percpu[i].copies;
+		stats->capped += percpu[i].capped;
+		stats->dropped += percpu[i].dropped;
+		stats->rejected += percpu[i].rejected;
+	}
+
+	return 0;
 }
 
-int trn_update_port_range(int fd, port_range_key_t *prkey, port_range_t *pr)
+/* Elastic IPs are 1:1, an address can't be taken from another endpoint */
+int trn_update_eip(endpoint_key_t *epkey, __u32 eip)
 {
-	int err;
+	endpoint_key_t owner;
+	__u32 old_eip;
+	int fd, rev_fd, err;
+
+	fd = trn_transit_map_get_fd("eip_map");
+	rev_fd = trn_transit_map_get_fd("eip_rev_map");
+	if (fd < 0 || rev_fd < 0) {
+		TRN_LOG_ERROR("Failed to get elastic IP bpfmap fds");
+		return 1;
+	}
+
+	if (!bpf_map_lookup_elem(rev_fd, &eip, &owner) &&
+	    (owner.vni != epkey->vni || owner.ip != epkey->ip)) {
+		TRN_LOG_ERROR("Elastic IP 0x%x already mapped to %d - 0x%x",
+			      eip, owner.vni, owner.ip);
+		return 1;
+	}
+
+	/* Reverse first, replies may arrive once egress is NATed */
+	err = bpf_map_update_elem(rev_fd, &eip, epkey, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store elastic IP 0x%x failed (err:%d).", eip, err);
+		return 1;
+	}
+
+	if (!bpf_map_lookup_elem(fd, epkey, &old_eip) && old_eip != eip) {
+		bpf_map_delete_elem(rev_fd, &old_eip);
+	}
+
+	err = bpf_map_update_elem(fd, epkey, &eip, 0);
+	if (err) {
+		TRN_LOG_ERROR("Store elastic IP of %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_get_eip(endpoint_key_t *epkey, __u32 *eip)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("eip_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get eip_map fd");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, eip);
+	if (err) {
+		TRN_LOG_ERROR("Querying elastic IP of %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+	return 0;
+}
+
+int trn_delete_eip(endpoint_key_t *epkey)
+{
+	int fd, rev_fd, err;
+	__u32 eip;
+
+	fd = trn_transit_map_get_fd("eip_map");
+	rev_fd = trn_transit_map_get_fd("eip_rev_map");
+	if (fd < 0 || rev_fd < 0) {
+		TRN_LOG_ERROR("Failed to get elastic IP bpfmap fds");
+		return 1;
+	}
+
+	err = bpf_map_lookup_elem(fd, epkey, &eip);
+	if (!err) {
+		err = bpf_map_delete_elem(fd, epkey);
+	}
+	if (err) {
+		TRN_LOG_ERROR("Delete elastic IP of %d - 0x%x failed (err:%d).",
+			      epkey->vni, epkey->ip, err);
+		return 1;
+	}
+
+	bpf_map_delete_elem(rev_fd, &eip);
+	return 0;
+}
+
+int trn_get_eip_stats(eip_stats_t *stats)
+{
+	int fd, err, num_cpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("eip_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get eip_stats_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	eip_stats_t percpu[num_cpus];
+
+	err = bpf_map_lookup_elem(fd, &key, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying elastic IP stats failed (err:%d).", err);
+		return 1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < num_cpus; i++) {
+		stats->snat_pkts += percpu[i].snat_pkts;
+		stats->dnat_pkts += percpu[i].dnat_pkts;
+		stats->dropped += percpu[i].dropped;
+	}
+
+	return 0;
+}
+
+/* Serializes policer updates of RPCs with trn_share_rate_limits */
+static pthread_mutex_t rate_limits_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Number of CPUs whose bucket of policer key was refilled within the last
+ * TRAN_RL_SHARE_NS, 0 if none was.
+ */
+static int trn_rate_limit_cpus(endpoint_key_t *key, int num_cpus)
+{
+	rate_bucket_t buckets[num_cpus];
+	struct timespec ts;
+	__u64 now;
+	int fd, cpus = 0;
+
+	fd = trn_transit_map_get_fd("rate_buckets_map");
+	if (fd < 0 || bpf_map_lookup_elem(fd, key, buckets)) {
+		return 0;
+	}
+
+	/* Same clock as bpf_ktime_get_ns */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = (__u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+
+	for (int i = 0; i < num_cpus; i++) {
+		if (buckets[i].refill_ns &&
+		    buckets[i].refill_ns + TRAN_RL_SHARE_NS > now) {
+			cpus++;
+		}
+	}
+	return cpus;
+}
+
+static void trn_rate_limit_share(struct rate_limit_t *rl, int cpus)
+{
+	rl->pps = (rl->host_pps + cpus - 1) / cpus;
+	rl->bps = (rl->host_bps + cpus - 1) / cpus;
+}
+
+/*
+ * A source host mostly lands on few CPUs, so the host rates are shared
+ * by the CPUs that police the key rather than all of them. New policers
+ * without traffic yet start with shares of all possible CPUs.
+ */
+int trn_update_rate_limit(endpoint_key_t *key, __u64 pps, __u64 bps,
+			  __u8 action)
+{
+	static __u32 gen = 0;
+	struct rate_limit_t rl;
+	int fd, err, num_cpus, cpus;
+
+	fd = trn_transit_map_get_fd("rate_limits_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get rate_limits_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	pthread_mutex_lock(&rate_limits_lock);
+
+	/* Buckets of a CPU start zeroed, gen 0 is never valid */
+	if (++gen == 0)
+		gen = 1;
+
+	cpus = trn_rate_limit_cpus(key, num_cpus);
+	if (!cpus) {
+		cpus = num_cpus;
+	}
+
+	memset(&rl, 0, sizeof(rl));
+	rl.host_pps = pps;
+	rl.host_bps = bps;
+	rl.gen = gen;
+	rl.action = action;
+	trn_rate_limit_share(&rl, cpus);
+
+	err = bpf_map_update_elem(fd, key, &rl, 0);
+	pthread_mutex_unlock(&rate_limits_lock);
+	if (err) {
+		TRN_LOG_ERROR("Store rate limit of %d - 0x%x failed (err:%d).",
+			      key->vni, key->ip, err);
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Resize the per CPU shares of policers to the CPUs that policed them in
+ * the last TRAN_RL_SHARE_NS. Idle policers keep their shares. Buckets
+ * keep their tokens, so while traffic moves to more CPUs the host rates
+ * may be exceeded until the next call.
+ */
+void trn_share_rate_limits(void)
+{
+	endpoint_key_t key, next;
+	struct rate_limit_t rl;
+	int fd, num_cpus, cpus;
+	void *prev = NULL;
+	__u64 pps, bps;
 
+	if (!md || !md->ready ||
+	    !(md->cfg.features & TRAN_XDP_FEAT_RATE_LIMIT)) {
+		return;
+	}
+
+	fd = trn_transit_map_get_fd("rate_limits_map");
+	num_cpus = libbpf_num_possible_cpus();
+	if (fd < 0 || num_cpus <= 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&rate_limits_lock);
+	while (!bpf_map_get_next_key(fd, prev, &next)) {
+		key = next;
+		prev = &key;
+
+		cpus = trn_rate_limit_cpus(&key, num_cpus);
+		if (!cpus || bpf_map_lookup_elem(fd, &key, &rl)) {
+			continue;
+		}
+
+		pps = rl.pps;
+		bps = rl.bps;
+		trn_rate_limit_share(&rl, cpus);
+		if (rl.pps == pps && rl.bps == bps) {
+			continue;
+		}
+
+		if (bpf_map_update_elem(fd, &key, &rl, BPF_EXIST)) {
+			TRN_LOG_DEBUG("Policer of %d - 0x%x went away",
+				      key.vni, key.ip);
+		}
+	}
+	pthread_mutex_unlock(&rate_limits_lock);
+}
+
+int trn_delete_rate_limit(endpoint_key_t *key)
+{
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("rate_limits_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get rate_limits_map fd");
+		return 1;
+	}
+
+	pthread_mutex_lock(&rate_limits_lock);
+	err = bpf_map_delete_elem(fd, key);
+	pthread_mutex_unlock(&rate_limits_lock);
+	if (err) {
+		TRN_LOG_ERROR("Delete rate limit of %d - 0x%x failed (err:%d).",
+			      key->vni, key->ip, err);
+		return 1;
+	}
+
+	return 0;
+}
+
+int trn_get_rate_limit_stats(__u32 vni, rate_limit_stats_t *stats)
+{
+	int fd, err, num_cpus;
+
+	fd = trn_transit_map_get_fd("rate_limit_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get rate_limit_stats_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	rate_limit_stats_t percpu[num_cpus];
+
+	/* A VNI has no counters until one of its packets is policed */
+	memset(stats, 0, sizeof(*stats));
+	err = bpf_map_lookup_elem(fd, &vni, percpu);
+	if (err) {
+		if (errno == ENOENT)
+			return 0;
+		TRN_LOG_ERROR("Querying rate limit stats of %d failed (err:%d).",
+			      vni, err);
+		return 1;
+	}
+
+	for (int i = 0; i < num_cpus; i++) {
+		stats->marked += percpu[i].marked;
+		stats->dropped += percpu[i].dropped;
+		stats->dropped_bytes += percpu[i].dropped_bytes;
+	}
+
+	return 0;
+}
+
+int trn_get_upcall_stats(upcall_stats_t *stats)
+{
+	int fd, err, num_cpus;
+	__u32 key = 0;
+
+	fd = trn_transit_map_get_fd("upcall_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get upcall_stats_map fd");
+		return 1;
+	}
+
+	num_cpus = libbpf_num_possible_cpus();
+	if (num_cpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	upcall_stats_t percpu[num_cpus];
+
+	err = bpf_map_lookup_elem(fd, &key, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying upcall stats failed (err:%d).", err);
+		return 1;
+	}
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < num_cpus; i++) {
+		stats->admitted += percpu[i].admitted;
+		stats->negative += percpu[i].negative;
+		stats->throttled_host += percpu[i].throttled_host;
+		stats->throttled_vni += percpu[i].throttled_vni;
+	}
+
+	return 0;
+}
+
+trn_iface_t *trn_get_itf_context(char *interface)
+{
+	unsigned int iface_index;
+
+	if (!md) {
+		TRN_LOG_ERROR("Userspace XDP metadata not initialized");
+		return NULL;
+	}
+
+	iface_index = if_nametoindex(interface);
+	if (!iface_index) {
+		TRN_LOG_ERROR("if_nametoindex failed for %s", interface);
+		return NULL;
+	}
+
+	for (int idx = 0; idx < TRAN_ITF_MAP_MAX; idx++) {
+		if (md->objs[idx].eth.iface_index == iface_index) {
+			return &md->objs[idx].eth;
+		}
+	}
+
+	TRN_LOG_ERROR("Interface %s is not used for Transit XDP", interface);
+	return NULL;
+}
+
+static void trn_set_entrance_key(entrance_key_t *entkey, __u32 iface_index,
+				 __u8 *mac)
+{
+	memset(entkey, 0, sizeof(*entkey));
+	entkey->iface_index = iface_index;
+	memcpy(entkey->mac, mac, sizeof(entkey->mac));
+}
+
+/* Sync entrances_map with the entrances of an interface config */
+static int trn_update_itf_entrances(struct tunnel_iface_t *old_itf,
+				    struct tunnel_iface_t *itf)
+{
+	entrance_key_t entkey;
+	entrance_t ent;
+	__u32 i, j;
+	int fd, err;
+
+	fd = trn_transit_map_get_fd("entrances_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get entrances_map fd");
+		return 1;
+	}
+
+	if (itf->num_entrances > TRAN_MAX_ZGC_ENTRANCES) {
+		TRN_LOG_ERROR("Too many entrances %d on interface %d",
+			      itf->num_entrances, itf->iface_index);
+		return 1;
+	}
+
+	for (i = 0; i < itf->num_entrances; i++) {
+		trn_set_entrance_key(&entkey, itf->iface_index,
+				     itf->entrances[i].mac);
+		memset(&ent, 0, sizeof(ent));
+		ent.ip = itf->entrances[i].ip;
+		ent.idx = i;
+
+		err = bpf_map_update_elem(fd, &entkey, &ent, 0);
+		if (err) {
+			TRN_LOG_ERROR("Failed to update entrances_map: %d (err:%d).",
+				itf->iface_index, err);
+			return 1;
+		}
+	}
+
+	/* Remove entrances no longer announced, after new ones are in place */
+	for (i = 0; i < old_itf->num_entrances && i < TRAN_MAX_ZGC_ENTRANCES; i++) {
+		bool found = false;
+
+		for (j = 0; j < itf->num_entrances; j++) {
+			if (!memcmp(old_itf->entrances[i].mac, itf->entrances[j].mac,
+				    sizeof(itf->entrances[j].mac))) {
+				found = true;
+				break;
+			}
+		}
+		if (found)
+			continue;
+
+		trn_set_entrance_key(&entkey, itf->iface_index,
+				     old_itf->entrances[i].mac);
+		bpf_map_delete_elem(fd, &entkey);
+	}
+
+	return 0;
+}
+
+int trn_update_itf_config(struct tunnel_iface_t *itf)
+{
+	struct tunnel_iface_t old_itf;
+
+	/* VXLAN hints take the GBP bytes carrying the security identity */
+	if (itf->role != XDP_FTN && (itf->options & TRAN_ITF_OPT_HINT_HDR) &&
+	    md && (md->cfg.features & TRAN_XDP_FEAT_IDENTITY)) {
+		TRN_LOG_ERROR("Header hints can't be used with identity policy "
+			      "on VXLAN interface %d", itf->iface_index);
+		return 1;
+	}
+
+	int	fd = trn_transit_map_get_fd("if_config_map");
 	if (fd < 0) {
-		TRN_LOG_ERROR("Invalid port_range_map fd");
+		TRN_LOG_ERROR("Failed to get if_config_map fd");
 		return 1;
 	}
 
-	err = bpf_map_update_elem(fd, prkey, pr, 0);
-	if (err) {
-		TRN_LOG_ERROR("Store port_range mapping failed (err:%d).", err);
-		return 1;
+	if (bpf_map_lookup_elem(fd, &itf->iface_index, &old_itf)) {
+		memset(&old_itf, 0, sizeof(old_itf));
 	}
 
-	return 0;
-}
-
-int trn_get_port_range(port_range_key_t *prkey, port_range_t *pr)
-{
-	int fd, err;
-
-	fd = trn_transit_map_get_fd("port_range_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get port_range_map fd");
+	if (trn_update_itf_entrances(&old_itf, itf)) {
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, prkey, pr);
+	int err = bpf_map_update_elem(fd, &itf->iface_index, itf, 0);
 	if (err) {
-		TRN_LOG_ERROR("Querying port_range mapping failed (err:%d).",
-			      err);
+		TRN_LOG_ERROR("Failed to update if_config_map: %d (err:%d).",
+			itf->iface_index, err);
 		return 1;
 	}
+
 	return 0;
 }
 
-int trn_delete_port_range(port_range_key_t *prkey)
+/*
+ * Attach transit XDP to the interface in the requested mode. Auto mode
+ * probes the driver by trying native attach first and falls back to
+ * generic XDP if the driver refuses it.
+ */
+static int trn_transit_xdp_attach(trn_xdp_object_t *obj, __u32 mode)
 {
-	port_range_t pr;
-	int fd, err;
+	__u32 flags;
+	int err;
 
-	fd = trn_transit_map_get_fd("port_range_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get port_range_map fd");
+	switch (mode) {
+	case TRAN_XDP_MODE_NATIVE:
+	case TRAN_XDP_MODE_AUTO:
+		flags = XDP_FLAGS_DRV_MODE;
+		break;
+	case TRAN_XDP_MODE_GENERIC:
+		flags = XDP_FLAGS_SKB_MODE;
+		break;
+	default:
+		TRN_LOG_ERROR("Invalid XDP mode %d", mode);
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, prkey, &pr);
-
-	if (err) {
-		TRN_LOG_ERROR("Querying port_range for delete failed (err:%d).",
-			      err);
-		return 1;
+	err = bpf_xdp_attach(obj->eth.iface_index, obj->xdp.prog_fd, flags, NULL);
+	if (err < 0 && mode == TRAN_XDP_MODE_AUTO) {
+		TRN_LOG_WARN("Native XDP not supported on ifindex %d (err:%d), "
+			     "falling back to generic XDP",
+			     obj->eth.iface_index, err);
+		flags = XDP_FLAGS_SKB_MODE;
+		err = bpf_xdp_attach(obj->eth.iface_index, obj->xdp.prog_fd,
+				     flags, NULL);
 	}
 
-	err = bpf_map_delete_elem(fd, prkey);
-	if (err) {
-		TRN_LOG_ERROR("Deleting port_range mapping failed (err:%d).",
-			      err);
+	if (err < 0) {
+		TRN_LOG_ERROR("Failed to attach XDP on ifindex %d in %s mode (err:%d)",
+			      obj->eth.iface_index,
+			      flags == XDP_FLAGS_DRV_MODE ? "native" : "generic", err);
 		return 1;
 	}
 
+	obj->xdp_flags = flags;
+	TRN_LOG_INFO("Attached transit XDP on ifindex %d in %s mode",
+		     obj->eth.iface_index,
+		     flags == XDP_FLAGS_DRV_MODE ? "native" : "generic");
 	return 0;
 }
-#endif
 
-int trn_update_endpoints_get_ctx(void)
+int trn_get_xdp_mode(__u32 iface_index, __u32 *mode, __u32 *prog_id)
 {
-	int fd;
+	if (!md || !md->ready) {
+		TRN_LOG_ERROR("Transit XDP not loaded");
+		return 1;
+	}
 
-	fd = trn_transit_map_get_fd("endpoints_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get endpoints_map fd");
+	for (int i = 0; i < TRAN_ITF_MAP_MAX; i++) {
+		if (md->objs[i].eth.iface_index != iface_index)
+			continue;
+
+		*mode = (md->objs[i].xdp_flags & XDP_FLAGS_DRV_MODE) ?
+			TRAN_XDP_MODE_NATIVE : TRAN_XDP_MODE_GENERIC;
+		*prog_id = md->objs[i].xdp.prog_id;
+		return 0;
 	}
 
-	return fd;
+	TRN_LOG_ERROR("Transit XDP not attached to ifindex %d", iface_index);
+	return 1;
 }
 
-int trn_update_endpoint(int fd, endpoint_key_t *epkey, endpoint_t *ep)
+static void trn_eip_gw_detach(void)
 {
-	int err;
-
-	if (fd < 0) {
-		TRN_LOG_ERROR("Invalid endpoints_map fd");
-		return 1;
-	}
+	trn_xdp_object_t *ext = &md->eip_gw;
 
-	err = bpf_map_update_elem(fd, epkey, ep, 0);
-	if (err) {
-		TRN_LOG_ERROR("Store endpoint mapping failed (err:%d).", err);
-		return 1;
+	if (!ext->eth.iface_index) {
+		return;
 	}
 
-	return 0;
+	bpf_xdp_attach(ext->eth.iface_index, -1, ext->xdp_flags, NULL);
+	TRN_LOG_INFO("Detached elastic IP XDP from ifindex %d",
+		     ext->eth.iface_index);
+	ext->eth.iface_index = 0;
 }
 
-int trn_get_endpoint(endpoint_key_t *epkey, endpoint_t *ep)
+/*
+ * Send gateway endpoints out of interface and attach the elastic IP
+ * program of the tenant object to it for the way back. A previous
+ * external interface is detached first.
+ */
+int trn_update_eip_gw(char *interface, struct eip_gw_t *gw, __u32 mode)
 {
-	int fd, err;
+	trn_xdp_object_t *ext;
+	int gw_fd, dev_fd, err;
+	__u32 key = 0;
 
-	fd = trn_transit_map_get_fd("endpoints_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get endpoints_map fd");
+	if (!md || !md->ready) {
+		TRN_LOG_ERROR("Transit XDP not loaded");
 		return 1;
 	}
+	ext = &md->eip_gw;
 
-	err = bpf_map_lookup_elem(fd, epkey, ep);
-	if (err) {
-		TRN_LOG_ERROR("Querying endpoint mapping failed (err:%d).",
-			      err);
+	if (mode >= TRAN_XDP_MODE_MAX) {
+		TRN_LOG_ERROR("Invalid XDP mode %d for %s", mode, interface);
 		return 1;
 	}
-	return 0;
-}
 
-int trn_remove_prog(unsigned int prog_idx)
-{
-	int fd = trn_transit_map_get_fd("jmp_table");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get jmp_table fd");
+	gw->ifindex = if_nametoindex(interface);
+	if (!gw->ifindex) {
+		TRN_LOG_ERROR("if_nametoindex failed for %s", interface);
 		return 1;
 	}
 
-	int err;
-	err = bpf_map_delete_elem(fd, &prog_idx);
-	if (err) {
-		TRN_LOG_ERROR("Error add prog to trn jmp table (err:%d).", err);
+	ext->xdp.prog_fd = md->objs[TRAN_ITF_MAP_TENANT].xdp.eip_prog_fd;
+	if (ext->xdp.prog_fd < 0) {
+		TRN_LOG_ERROR("Elastic IP program of transit XDP not loaded");
+		return 1;
 	}
-	bpf_object__close(md->ebpf_progs[prog_idx].obj);
-	return 0;
-}
-
-int trn_delete_endpoint(endpoint_key_t *epkey)
-{
-	endpoint_t ep;
-	int fd, err;
 
-	fd = trn_transit_map_get_fd("endpoints_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get endpoints_map fd");
+	gw_fd = trn_transit_map_get_fd("eip_gw_map");
+	dev_fd = trn_transit_map_get_fd("eip_devmap");
+	if (gw_fd < 0 || dev_fd < 0) {
+		TRN_LOG_ERROR("Failed to get elastic IP gateway bpfmap fds");
 		return 1;
 	}
 
-	err = bpf_map_lookup_elem(fd, epkey, &ep);
-
+	err = bpf_map_update_elem(dev_fd, &key, &gw->ifindex, 0);
 	if (err) {
-		TRN_LOG_ERROR("Querying endpoint for delete failed (err:%d).",
-			      err);
+		TRN_LOG_ERROR("Failed to update eip_devmap with %s (err:%d).",
+			      interface, err);
 		return 1;
 	}
 
-	err = bpf_map_delete_elem(fd, epkey);
+	err = bpf_map_update_elem(gw_fd, &key, gw, 0);
 	if (err) {
-		TRN_LOG_ERROR("Deleting endpoint mapping failed (err:%d).",
-			      err);
+		TRN_LOG_ERROR("Failed to update eip_gw_map (err:%d).", err);
 		return 1;
 	}
 
+	trn_eip_gw_detach();
+	ext->eth.iface_index = gw->ifindex;
+	if (trn_transit_xdp_attach(ext, mode)) {
+		ext->eth.iface_index = 0;
+		return 1;
+	}
 	return 0;
 }
 
-trn_iface_t *trn_get_itf_context(char *interface)
+/* Serve endpoint misses of each attached interface with AF_XDP */
+static void trn_transit_xsk_start(void)
 {
-	unsigned int iface_index;
-
-	if (!md) {
-		TRN_LOG_ERROR("Userspace XDP metadata not initialized");
-		return NULL;
-	}
-
-	iface_index = if_nametoindex(interface);
-	if (!iface_index) {
-		TRN_LOG_ERROR("if_nametoindex failed for %s", interface);
-		return NULL;
-	}
+	int xsks_fd = trn_transit_map_get_fd("xsks_map");
+	int ep_fd = trn_transit_map_get_fd("endpoints_map");
+	int itf_fd = trn_transit_map_get_fd("if_config_map");
 
-	for (int idx = 0; idx < TRAN_ITF_MAP_MAX; idx++) {
-		if (md->objs[idx].eth.iface_index == iface_index) {
-			return &md->objs[idx].eth;
+	for (int i = 0; i < TRAN_ITF_MAP_MAX; i++) {
+		trn_iface_t *eth = &md->objs[i].eth;
+		__u16 bind_flags = (md->objs[i].xdp_flags & XDP_FLAGS_SKB_MODE) ?
+			XDP_COPY : 0;
+		bool dup = false;
+
+		/* An rx queue can only be bound once */
+		for (int j = 0; j < i; j++) {
+			if (md->objs[j].eth.iface_index == eth->iface_index)
+				dup = true;
 		}
-	}
-
-	TRN_LOG_ERROR("Interface %s is not used for Transit XDP", interface);
-	return NULL;
-}
-
-int trn_update_itf_config(struct tunnel_iface_t *itf)
-{
-	int	fd = trn_transit_map_get_fd("if_config_map");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get if_config_map fd");
-		return 1;
-	}
+		if (dup)
+			continue;
 
-	int err = bpf_map_update_elem(fd, &itf->iface_index, itf, 0);
-	if (err) {
-		TRN_LOG_ERROR("Failed to update if_config_map: %d (err:%d).",
-			itf->iface_index, err);
-		return 1;
+		if (trn_xsk_start(eth->role, eth->iface_index, xsks_fd, ep_fd,
+				  itf_fd, md->cfg.features, bind_flags)) {
+			TRN_LOG_WARN("AF_XDP slow path not available on ifindex %d, "
+				     "endpoint misses will be dropped",
+				     eth->iface_index);
+		}
 	}
-
-	return 0;
 }
 
 /* Initialize Transit XDP Basic Objects */
 // parameters: 
-int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug)
+int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug,
+			 trn_xdp_load_cfg_t *cfg)
 {
 	int i;
 	struct rlimit r = { RLIM_INFINITY, RLIM_INFINITY };
@@ -790,10 +2624,33 @@ int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug)
 
 	memset(md, 0, sizeof(user_metadata_t));
 
-	// try XDP_FLAGS_DRV_MODE?  --wyue
-	//md->xdp_flags = debug? XDP_FLAGS_SKB_MODE:XDP_FLAGS_DRV_MODE;
-	md->xdp_flags = XDP_FLAGS_SKB_MODE;
 	md->prog_tbl = debug?trn_prog_dbg_tbl:trn_prog_tbl;
+	md->role_prog_tbl = debug?trn_role_prog_dbg_tbl:trn_role_prog_tbl;
+	if (cfg) {
+		md->cfg = *cfg;
+	} else {
+		md->cfg.features = TRAN_XDP_FEAT_DEFAULT;
+	}
+	if (md->cfg.num_spread_cpus > TRAN_MAX_SPREAD_CPUS) {
+		TRN_LOG_ERROR("Too many RX spreading cpus %d", md->cfg.num_spread_cpus);
+		goto cleanup;
+	}
+	if (!md->cfg.cpumap_qsize) {
+		md->cfg.cpumap_qsize = TRAN_DEFAULT_CPUMAP_QSIZE;
+	}
+	if (!md->cfg.upcall_host_pps) {
+		md->cfg.upcall_host_pps = TRAN_DEFAULT_UPCALL_HOST_PPS;
+	}
+	if (!md->cfg.upcall_vni_pps) {
+		md->cfg.upcall_vni_pps = TRAN_DEFAULT_UPCALL_VNI_PPS;
+	}
+	for (i = 0; i < TRAN_ITF_MAP_MAX; i++) {
+		if (md->cfg.xdp_modes[i] >= TRAN_XDP_MODE_MAX) {
+			TRN_LOG_ERROR("Invalid XDP mode %d for %s",
+				md->cfg.xdp_modes[i], interfaces[i]);
+			goto cleanup;
+		}
+	}
 
 	/* Step 1: Load Transit XDP object for interfaces attachment */
 	for (i = 0; i < TRAN_ITF_MAP_MAX; i++) {
@@ -811,22 +2668,19 @@ int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug)
 		snprintf(prog->pcapfile, sizeof(prog->pcapfile),
 			"/sys/fs/bpf/transit_xdp_pcap_%s", interfaces[i]);
 
-		/* Load transit XDP main program */
-		if (trn_prog_load(prog, TRAN_TRANSIT_PROG)) {
+		/* Load transit XDP main program specialized for the role */
+		if (trn_prog_load_file(prog, TRAN_TRANSIT_PROG,
+				       trn_transit_prog_path(eth->role))) {
 			TRN_LOG_ERROR("Loading transit XDP program %d failed\n", TRAN_TRANSIT_PROG);
 			goto cleanup;
 		}
 	}
 
-	/* Step 2: Load Transit XDP sidecar eBPF program objects */
-	for (i = TRAN_TRANSIT_PROG + 1; i < TRAN_MAX_PROG; i++) {
-		prog = &md->ebpf_progs[i];
-		if (trn_prog_load(prog, i)) {
-			TRN_LOG_ERROR("Loading transit XDP program %d failed\n", i);
-			goto cleanup;
-		}
-	}
-	
+	/*
+	 * Verdict stage pipelines start empty, so verdicts cost no tail
+	 * call. Stages, built-in ones included, are inserted on demand.
+	 */
+
 	/* Initialize bpfmaps before attach to interfaces */
 	if (trn_transit_xdp_map_initialize()) {
 		TRN_LOG_ERROR("Failed to initialize bpfmaps before attach\n");
@@ -841,10 +2695,9 @@ int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug)
 		memset(&info, 0, info_len);
 
 		/* Attach main transit XDP program to interface */
-		if (bpf_xdp_attach(md->objs[i].eth.iface_index,
-			md->objs[i].xdp.prog_fd, md->xdp_flags, NULL) < 0) {
-			TRN_LOG_ERROR("Failed to attach XDP program %s to %s - %s\n",
-				md->prog_tbl[TRAN_TRANSIT_PROG].prog_path, interfaces[i], strerror(errno));
+		if (trn_transit_xdp_attach(&md->objs[i], md->cfg.xdp_modes[i])) {
+			TRN_LOG_ERROR("Failed to attach XDP program %s to %s\n",
+				bpf_object__name(md->objs[i].xdp.obj), interfaces[i]);
 			goto cleanup;
 		}
 
@@ -858,6 +2711,8 @@ int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug)
 		TRN_LOG_INFO("Successfully loaded transit XDP on interface %s", interfaces[i]);
 	}
 
+	trn_transit_xsk_start();
+
 	md->ready = TRUE;
 	return 0;
 
@@ -879,17 +2734,26 @@ int trn_transit_xdp_unload(char **interfaces)
 		return 0;
 	}
 
+	/* Step 0: Stop slow path before its sockets lose the program */
+	for (i = 0; i < XDP_ROLE_MAX; i++) {
+		trn_xsk_stop(i);
+	}
+
 	/* Step 1: Detatch XDP program from interfaces before releasing bpfmaps */
+	trn_eip_gw_detach();
+
 	for (i = 0; i < TRAN_ITF_MAP_MAX; i++) {
 		__u32 link_prog_id = 0;
 
-		if (bpf_xdp_query_id(md->objs[i].eth.iface_index, md->xdp_flags, &link_prog_id)) {
+		__u32 xdp_flags = md->objs[i].xdp_flags;
+
+		if (bpf_xdp_query_id(md->objs[i].eth.iface_index, xdp_flags, &link_prog_id)) {
 			TRN_LOG_ERROR("Failed to get XDP prog_id from %s", interfaces[i]);
 			return 1;
 		}
 
 		if (md->objs[i].xdp.prog_id == link_prog_id) {
-			bpf_xdp_attach(md->objs[i].eth.iface_index, -1, md->xdp_flags, NULL);
+			bpf_xdp_attach(md->objs[i].eth.iface_index, -1, xdp_flags, NULL);
 		} else if (!link_prog_id) {
 			TRN_LOG_WARN("couldn't find a prog id on %s\n", interfaces[i]);
 		} else {
@@ -897,9 +2761,9 @@ int trn_transit_xdp_unload(char **interfaces)
 		}
 
 		if ( bpf_xdp_attach(md->objs[i].eth.iface_index,
-			md->objs[i].xdp.prog_fd, md->xdp_flags, NULL) < 0) {
+			md->objs[i].xdp.prog_fd, xdp_flags, NULL) < 0) {
 			TRN_LOG_ERROR("Failed to attach XDP program %s to %s - %s\n",
-				md->prog_tbl[TRAN_TRANSIT_PROG].prog_path, interfaces[i], strerror(errno));
+				bpf_object__name(md->objs[i].xdp.obj), interfaces[i], strerror(errno));
 			return 1;
 		}
 	}
@@ -925,9 +2789,9 @@ int trn_transit_xdp_unload(char **interfaces)
 	trn_transit_map_hash_destroy();
 
 	/* Step 3: Close bpfobjs */
-	for (i = 1; i < TRAN_MAX_PROG; i++) {
-		if (!IS_ERR_OR_NULL(md->ebpf_progs[i].obj)) {
-			bpf_object__close(md->ebpf_progs[i].obj);
+	for (i = TRAN_TX_PROG; i < TRAN_MAX_PROG; i++) {
+		for (__u32 pos = 0; pos < md->num_stages[i]; pos++) {
+			bpf_object__close(md->stages[i][pos].prog.obj);
 		}
 	}
 	for (i = 0; i < TRAN_ITF_MAP_MAX; i++) {
@@ -941,9 +2805,6 @@ int trn_transit_xdp_unload(char **interfaces)
 
 int trn_transit_ebpf_load(int prog_idx)
 {
-	trn_prog_t *prog;
-	int err, fd;
-
 	TRN_LOG_INFO("Start loading eBPF program %d.", prog_idx);
 
 	if (!md) {
@@ -956,35 +2817,164 @@ int trn_transit_ebpf_load(int prog_idx)
 		return 1;
 	}
 
-	prog = &md->ebpf_progs[prog_idx];
+	/* Built-in verdict programs end their pipeline */
+	return trn_transit_stage_insert(prog_idx, TRAN_MAX_STAGES,
+					trn_stage_builtin_names[prog_idx],
+					md->prog_tbl[prog_idx].prog_path);
+}
+
+int trn_transit_ebpf_unload(int prog_idx)
+{
+	TRN_LOG_INFO("Start unloading eBPF program %d.", prog_idx);
+
+	if (prog_idx <= TRAN_TRANSIT_PROG || prog_idx >= TRAN_MAX_PROG) {
+		TRN_LOG_ERROR("Invalid program index");
+		return 1;
+	}
+
+	return trn_transit_stage_remove(prog_idx,
+					trn_stage_builtin_names[prog_idx]);
+}
+
+static int trn_stage_find(__u32 prog_idx, const char *name)
+{
+	for (__u32 pos = 0; pos < md->num_stages[prog_idx]; pos++) {
+		if (!strcmp(md->stages[prog_idx][pos].name, name)) {
+			return pos;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Point the jmp_table slot of stage pos at stage. Its counters move
+ * along from slot of stage from, or start over if from is negative.
+ */
+static int trn_stage_install(__u32 prog_idx, __u32 pos, trn_stage_t *stage,
+			     int from)
+{
+	__u32 slot = TRAN_STAGE_SLOT(prog_idx, pos), from_slot;
+	int jmp_fd, stats_fd, ncpus, err;
 
-	/* Load eBPF program */
-	if (trn_prog_load(prog, prog_idx)) {
-		TRN_LOG_ERROR("Loading transit XDP program %d failed\n", prog_idx);
+	jmp_fd = trn_transit_map_get_fd("jmp_table");
+	stats_fd = trn_transit_map_get_fd("stage_stats_map");
+	if (jmp_fd < 0 || stats_fd < 0) {
+		TRN_LOG_ERROR("Failed to get stage pipeline bpfmap fds");
 		return 1;
 	}
 
-	/* Add eBPF program to junp_table */
-	fd = trn_transit_map_get_fd("jmp_table");
-	if (fd < 0) {
-		TRN_LOG_ERROR("Failed to get jmp_table fd");
+	ncpus = libbpf_num_possible_cpus();
+	if (ncpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
 		return 1;
 	}
-	err = bpf_map_update_elem(fd, &prog_idx, &md->ebpf_progs[prog_idx].prog_fd, 0);
+
+	stage_stats_t percpu[ncpus];
+
+	memset(percpu, 0, sizeof(percpu));
+	if (from >= 0) {
+		from_slot = TRAN_STAGE_SLOT(prog_idx, from);
+		if (bpf_map_lookup_elem(stats_fd, &from_slot, percpu)) {
+			TRN_LOG_WARN("Failed to carry counters of stage %s.",
+				     stage->name);
+		}
+	}
+	if (bpf_map_update_elem(stats_fd, &slot, percpu, 0)) {
+		TRN_LOG_WARN("Failed to reset counters of stage %s.",
+			     stage->name);
+	}
+
+	err = bpf_map_update_elem(jmp_fd, &slot, &stage->prog.prog_fd, 0);
 	if (err) {
-		TRN_LOG_ERROR("Failed to add prog %d to jmp table (err:%d).",
-			prog_idx, err);
+		TRN_LOG_ERROR("Failed to add stage %s to jmp table slot %d (err:%d).",
+			stage->name, slot, err);
 		return 1;
 	}
-
 	return 0;
 }
 
-int trn_transit_ebpf_unload(int prog_idx)
+/*
+ * Load the stage program at path and insert it before stage pos of the
+ * verdict pipeline prog_idx, appended if pos is past the end. Following
+ * stages shift up from the back, so a frame in flight may run a stage
+ * twice but never skips one.
+ */
+int trn_transit_stage_insert(__u32 prog_idx, __u32 pos, const char *name,
+			     char *path)
 {
-	int err, fd;
+	trn_stage_t *stages, stage;
+	__u32 i, n;
 
-	TRN_LOG_INFO("Start unloading eBPF program %d.", prog_idx);
+	TRN_LOG_INFO("Start inserting stage %s at %d of pipeline %d.",
+		     name, pos, prog_idx);
+
+	if (!md) {
+		TRN_LOG_ERROR("Userspace XDP metadata not initialized");
+		return 1;
+	}
+
+	if (prog_idx <= TRAN_TRANSIT_PROG || prog_idx >= TRAN_MAX_PROG) {
+		TRN_LOG_ERROR("Invalid program index");
+		return 1;
+	}
+
+	if (!name[0] || strlen(name) >= TRAN_MAX_STAGE_NAME) {
+		TRN_LOG_ERROR("Invalid stage name");
+		return 1;
+	}
+
+	stages = md->stages[prog_idx];
+	n = md->num_stages[prog_idx];
+	if (n >= TRAN_MAX_STAGES) {
+		TRN_LOG_ERROR("Pipeline %d is full", prog_idx);
+		return 1;
+	}
+
+	if (trn_stage_find(prog_idx, name) >= 0) {
+		TRN_LOG_ERROR("Stage %s already in pipeline %d", name, prog_idx);
+		return 1;
+	}
+
+	memset(&stage, 0, sizeof(stage));
+	strcpy(stage.name, name);
+	if (trn_prog_load_file(&stage.prog, prog_idx, path)) {
+		TRN_LOG_ERROR("Loading stage %s from %s failed", name, path);
+		return 1;
+	}
+
+	if (pos > n) {
+		pos = n;
+	}
+
+	for (i = n; i > pos; i--) {
+		if (trn_stage_install(prog_idx, i, &stages[i - 1], i - 1)) {
+			goto error;
+		}
+		stages[i] = stages[i - 1];
+	}
+
+	if (trn_stage_install(prog_idx, pos, &stage, -1)) {
+		goto error;
+	}
+	stages[pos] = stage;
+	md->num_stages[prog_idx] = n + 1;
+
+	return trn_update_stage_mask();
+
+error:
+	TRN_LOG_ERROR("Failed to insert stage %s in pipeline %d", name, prog_idx);
+	bpf_object__close(stage.prog.obj);
+	return 1;
+}
+
+/* Remove a stage, the pipeline is skipped once its last stage is gone */
+int trn_transit_stage_remove(__u32 prog_idx, const char *name)
+{
+	trn_stage_t *stages, stage;
+	__u32 i, n, slot;
+	int pos, fd;
+
+	TRN_LOG_INFO("Start removing stage %s of pipeline %d.", name, prog_idx);
 
 	if (!md) {
 		TRN_LOG_ERROR("Userspace XDP metadata not initialized");
@@ -996,22 +2986,82 @@ int trn_transit_ebpf_unload(int prog_idx)
 		return 1;
 	}
 
+	pos = trn_stage_find(prog_idx, name);
+	if (pos < 0) {
+		TRN_LOG_ERROR("Stage %s not in pipeline %d", name, prog_idx);
+		return 1;
+	}
+
 	fd = trn_transit_map_get_fd("jmp_table");
 	if (fd < 0) {
 		TRN_LOG_ERROR("Failed to get jmp_table fd");
 		return 1;
 	}
-	err = bpf_map_delete_elem(fd, &prog_idx);
-	if (err) {
-		TRN_LOG_ERROR("Error removing prog %d from jmp table (err:%d).",
-			prog_idx, err);
+
+	stages = md->stages[prog_idx];
+	n = md->num_stages[prog_idx];
+	stage = stages[pos];
+
+	for (i = pos; i + 1 < n; i++) {
+		if (trn_stage_install(prog_idx, i, &stages[i + 1], i + 1)) {
+			return 1;
+		}
+		stages[i] = stages[i + 1];
+	}
+
+	md->num_stages[prog_idx] = n - 1;
+	if (trn_update_stage_mask()) {
+		TRN_LOG_WARN("Pipeline %d still flagged after removing %s",
+			     prog_idx, name);
+	}
+
+	slot = TRAN_STAGE_SLOT(prog_idx, n - 1);
+	if (bpf_map_delete_elem(fd, &slot)) {
+		TRN_LOG_ERROR("Error removing jmp table slot %d.", slot);
+	}
+
+	bpf_object__close(stage.prog.obj);
+	return 0;
+}
+
+/* Counters of stage pos of a verdict pipeline summed over all CPUs */
+int trn_get_stage_stats(__u32 prog_idx, __u32 pos, char *name,
+			stage_stats_t *stats)
+{
+	__u32 slot = TRAN_STAGE_SLOT(prog_idx, pos);
+	int fd, err, ncpus;
+
+	if (!md || prog_idx <= TRAN_TRANSIT_PROG || prog_idx >= TRAN_MAX_PROG ||
+	    pos >= md->num_stages[prog_idx]) {
+		return 1;
+	}
+
+	fd = trn_transit_map_get_fd("stage_stats_map");
+	if (fd < 0) {
+		TRN_LOG_ERROR("Failed to get stage_stats_map fd");
+		return 1;
 	}
 
-	bpf_object__close(md->ebpf_progs[prog_idx].obj);
+	ncpus = libbpf_num_possible_cpus();
+	if (ncpus <= 0) {
+		TRN_LOG_ERROR("Failed to get number of possible cpus");
+		return 1;
+	}
+
+	stage_stats_t percpu[ncpus];
+
+	err = bpf_map_lookup_elem(fd, &slot, percpu);
+	if (err) {
+		TRN_LOG_ERROR("Querying stage stats failed (err:%d).", err);
+		return 1;
+	}
 
-	md->ebpf_progs[prog_idx].obj = NULL;
-	close(md->ebpf_progs[prog_idx].prog_fd);
-	md->ebpf_progs[prog_idx].prog_fd = -1;
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < ncpus; i++) {
+		stats->runs += percpu[i].runs;
+		stats->run_ns += percpu[i].run_ns;
+	}
+	strcpy(name, md->stages[prog_idx][pos].name);
 	return 0;
 }
 
@@ -50,8 +50,9 @@
 
 #include "extern/cJSON.h"
 
+#include "trn_transit_sg_usr.h"
+
 #define turnOn 0
-#define sgSupport 1
 
 typedef struct {
 	int prog_id;          // definition in trn_xdp_prog_id_t
@@ -67,11 +68,39 @@ typedef struct {
 
 typedef struct {
 	int prog_fd;
+	int cpumap_prog_fd;   // second stage of RX spreading, -1 if not loaded
+	int flood_prog_fds[TRAN_MAX_FLOOD]; // BUM copy egress per devmap slot
+	int eip_prog_fd;      // external side of elastic IPs, -1 if not loaded
 	__u32 prog_id;
 	struct bpf_object *obj;
 	char pcapfile[TRAN_MAX_PATH_SIZE];
 } trn_prog_t;
 
+/* A program in the stage pipeline of a verdict */
+typedef struct {
+	char name[TRAN_MAX_STAGE_NAME];
+	trn_prog_t prog;
+} trn_stage_t;
+
+/* Tracked connection, tuple from the side that opened it */
+typedef struct {
+	__u32 vni;
+	struct ipv4_tuple_t tuple;
+	__u8 state;        // TRAN_CT_*
+	__u32 idle;        // seconds since the last packet
+} trn_ct_entry_t;
+
+/* Optional knobs of load-transit-xdp */
+typedef struct {
+	__u32 num_spread_cpus;                     // 0 disables RX spreading
+	__u32 spread_cpus[TRAN_MAX_SPREAD_CPUS];   // worker CPUs of cpu_map
+	__u32 cpumap_qsize;                        // per CPU cpumap queue size
+	__u32 xdp_modes[TRAN_ITF_MAP_MAX];         // trn_xdp_mode_t per interface
+	__u32 features;                            // bitmask of TRAN_XDP_FEAT_*
+	__u32 upcall_host_pps;                     // upcall budget of a source host per CPU
+	__u32 upcall_vni_pps;                      // upcall budget of a VNI
+} trn_xdp_load_cfg_t;
+
 typedef struct {
 	__u32 ip;
 	__u32 iface_index;
@@ -84,52 +113,102 @@ typedef struct {
 typedef struct {
 	trn_iface_t eth;
 	trn_prog_t xdp;
+	__u32 xdp_flags;   // attach flags of the XDP mode in effect
 } trn_xdp_object_t;
 
 typedef struct {
 	bool ready;
-	__u32 xdp_flags;
+	trn_xdp_load_cfg_t cfg;
 	trn_xdp_object_t objs[TRAN_ITF_MAP_MAX];
+	trn_xdp_object_t eip_gw;   // external interface, attached if iface_index
 
 	trn_xdp_prog_t *prog_tbl;
+	trn_xdp_prog_t *role_prog_tbl;   // transit objects by trn_xdp_role_t
 
 	/*
-	 * Array of sidecar programs transit XDP main program can jump to
-	 * to perform additional functionality.
+	 * Stage pipelines transit XDP main program runs per verdict, by
+	 * trn_xdp_prog_id_t, in jmp_table order.
 	 */
-	trn_prog_t ebpf_progs[TRAN_MAX_PROG];
+	trn_stage_t stages[TRAN_MAX_PROG][TRAN_MAX_STAGES];
+	__u32 num_stages[TRAN_MAX_PROG];
 } user_metadata_t;
 
 trn_iface_t *trn_get_itf_context(char *interface);
 int trn_update_itf_config(struct tunnel_iface_t *itf);
 
 int trn_update_endpoints_get_ctx(void);
+void trn_set_endpoint_csum_delta(endpoint_t *ep);
 int trn_update_endpoint(int fd, endpoint_key_t *epkey, endpoint_t *ep);
 int trn_get_endpoint(endpoint_key_t *epkey, endpoint_t *ep);
 int trn_delete_endpoint(endpoint_key_t *epkey);
-
-#if sgSupport
-int trn_update_sg_cidr_get_ctx(void);
-int trn_update_sg_cidr(int fd, sg_cidr_key_t *sgkey, sg_cidr_t *sg);
-int trn_get_sg_cidr(sg_cidr_key_t *sgkey, sg_cidr_t *sg);
-int trn_delete_sg_cidr(sg_cidr_key_t *sgkey);
-
-int trn_update_sg_get_ctx(void);
-int trn_update_sg(int fd, security_group_key_t *sgkey, security_group_t *sg);
-int trn_get_sg(security_group_key_t *sgkey, security_group_t *sg);
-int trn_delete_sg(security_group_key_t *sgkey);
-
-int trn_update_port_range_get_ctx(void);
-int trn_update_port_range(int fd, port_range_key_t *prkey, port_range_t *pr);
-int trn_get_port_range(port_range_key_t *prkey, port_range_t *pr);
-int trn_delete_port_range(port_range_key_t *prkey);
-#endif
-
-int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug);
+int trn_update_endpoint6(endpoint_key6_t *epkey, endpoint_t *ep);
+int trn_get_endpoint6(endpoint_key6_t *epkey, endpoint_t *ep);
+int trn_delete_endpoint6(endpoint_key6_t *epkey);
+
+int trn_flow_cache_invalidate(__u32 vni);
+int trn_get_flow_cache_stats(flow_cache_stats_t *stats);
+
+int trn_dump_conntrack(__u32 vni, bool all_vnis, trn_ct_entry_t *entries,
+		       __u32 *nentries, __u32 *total);
+int trn_flush_conntrack(__u32 vni, bool all_vnis);
+void trn_sweep_conntrack(void);
+
+int trn_get_cpu_spread_stats(__u32 *num_cpus, cpu_spread_stats_t *stats);
+
+int trn_update_dft(__u32 dft_id, __u32 table_len, const __u32 *table);
+int trn_get_dft(__u32 dft_id, __u32 *table_len, __u32 *table);
+int trn_delete_dft(__u32 dft_id);
+
+int trn_update_chain(__u32 chain_id, struct chain_t *chain);
+int trn_get_chain(__u32 chain_id, struct chain_t *chain);
+int trn_delete_chain(__u32 chain_id);
+
+int trn_update_ftn(__u32 ftn_id, struct ftn_t *ftn);
+int trn_get_ftn(__u32 ftn_id, struct ftn_t *ftn);
+int trn_delete_ftn(__u32 ftn_id);
+
+int trn_update_scaled_ep(endpoint_key_t *epkey, struct scaled_ep_t *sep);
+int trn_get_scaled_ep(endpoint_key_t *epkey, struct scaled_ep_t *sep);
+int trn_delete_scaled_ep(endpoint_key_t *epkey);
+int trn_get_scaled_ep_stats(scaled_ep_stats_t *stats);
+int trn_update_flood_list(__u32 vni, struct flood_list_t *fl);
+int trn_get_flood_list(__u32 vni, struct flood_list_t *fl);
+int trn_delete_flood_list(__u32 vni);
+int trn_get_flood_stats(__u32 vni, flood_stats_t *stats);
+int trn_update_eip(endpoint_key_t *epkey, __u32 eip);
+int trn_get_eip(endpoint_key_t *epkey, __u32 *eip);
+int trn_delete_eip(endpoint_key_t *epkey);
+int trn_get_eip_stats(eip_stats_t *stats);
+int trn_update_eip_gw(char *interface, struct eip_gw_t *gw, __u32 mode);
+int trn_update_rate_limit(endpoint_key_t *key, __u64 pps, __u64 bps,
+			  __u8 action);
+int trn_delete_rate_limit(endpoint_key_t *key);
+void trn_share_rate_limits(void);
+int trn_get_rate_limit_stats(__u32 vni, rate_limit_stats_t *stats);
+int trn_endpoint_bloom_add(endpoint_key_t *epkey);
+int trn_miss_neg_cache_add(endpoint_key_t *epkey);
+int trn_get_upcall_stats(upcall_stats_t *stats);
+
+int trn_get_xdp_mode(__u32 iface_index, __u32 *mode, __u32 *prog_id);
+
+int trn_update_sg_rules(__u32 vni, trn_sg_rule_t *rules, __u32 nrules,
+			bool append);
+int trn_delete_sg_rules(__u32 vni);
+int trn_update_sg_identity_rule(sg_identity_key_t *key, __u32 verdict);
+int trn_delete_sg_identity_rule(sg_identity_key_t *key);
+
+int trn_transit_xdp_load(char **interfaces, unsigned short ibo_port, bool debug,
+			 trn_xdp_load_cfg_t *cfg);
 int trn_transit_xdp_unload(char **interfaces);
 int trn_transit_ebpf_load(int prog_idx);
 int trn_transit_ebpf_unload(int prog_idx);
 
+int trn_transit_stage_insert(__u32 prog_idx, __u32 pos, const char *name,
+			     char *path);
+int trn_transit_stage_remove(__u32 prog_idx, const char *name);
+int trn_get_stage_stats(__u32 prog_idx, __u32 pos, char *name,
+			stage_stats_t *stats);
+
 #if turnOn
 int trn_transit_dp_assistant(void);
 #endif
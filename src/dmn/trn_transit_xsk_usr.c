@@ -0,0 +1,1194 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_transit_xsk_usr.c
+ *
+ * @brief AF_XDP slow path of transit daemon.
+ *
+ * Transit XDP redirects packets it can not resolve an endpoint for
+ * (EP_NOT_FOUND) into xsks_map. For every rx queue of an interface
+ * we bind one AF_XDP socket backed by its own UMEM and serve it from
+ * a dedicated worker thread. The worker resolves the missing endpoint,
+ * installs it into endpoints_map so the flow stays on the fast path
+ * from then on, performs the same rewrite transit XDP would have done,
+ * and transmits the frame back out of the queue it arrived on, like an
+ * XDP_TX verdict, without copying it out of the UMEM.
+ *
+ * Endpoints transitd has not been told about are reported to the
+ * control plane, which polls them with get-ep-misses and answers with
+ * update-ep. Their frames stay parked in the UMEM until the answer
+ * arrives or TRN_XSK_PARK_TIMEOUT_MS passes.
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#define _GNU_SOURCE
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <net/if_arp.h>
+#include <linux/ethtool.h>
+#include <linux/sockios.h>
+
+#include "trn_transitd.h"
+#include "extern/jhash.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+#define TRN_XSK_POLL_TIMEOUT_MS 100
+#define TRN_XSK_VXLAN_PORT 4789
+#define TRN_XSK_GENEVE_PORT 6081
+#define TRN_XSK_OVERLAY_HDR_LEN 8
+
+/*
+ * Source host hint in the overlay header, as transit XDP writes it: the
+ * Geneve RTS option (struct trn_gnv_rts_opt) leads the options, VXLAN
+ * flags the reserved bit 0x40, clears GBP and takes the host IP in the
+ * reserved bytes 1-3 and 7.
+ */
+#define TRN_XSK_GNV_RTS_OPT_TYPE 0x48
+#define TRN_XSK_GNV_RTS_TYPE_OFF 10
+#define TRN_XSK_GNV_RTS_HOST_OFF 13
+#define TRN_XSK_GNV_RTS_LEN 24
+#define TRN_XSK_VXLAN_HINT_FLAG 0x40
+#define TRN_XSK_VXLAN_GBP_FLAG 0x80
+
+/* Producer/consumer ring shared with kernel */
+struct trn_xsk_ring {
+	__u32 cached_prod;
+	__u32 cached_cons;
+	__u32 mask;
+	__u32 size;
+	__u32 *producer;
+	__u32 *consumer;
+	__u32 *flags;
+	void *ring;
+	void *map;
+	size_t map_size;
+};
+
+struct trn_xsk_engine;
+
+typedef struct {
+	__u64 addr;
+	__u32 len;
+	__u64 deadline_ns;
+} trn_xsk_parked_t;
+
+typedef struct {
+	struct trn_xsk_engine *engine;
+	__u32 queue_id;
+	int fd;
+	bool need_wakeup;
+
+	void *umem_area;
+	size_t umem_size;
+
+	struct trn_xsk_ring fq;
+	struct trn_xsk_ring cq;
+	struct trn_xsk_ring rx;
+	struct trn_xsk_ring tx;
+
+	/* Frames owned by userspace, neither in fill ring nor in flight */
+	__u64 free_frames[TRN_XSK_NUM_FRAMES];
+	__u32 num_free;
+	__u32 outstanding_tx;
+
+	/* Frames waiting for the control plane, retried on ep_db changes */
+	trn_xsk_parked_t parked[TRN_XSK_MAX_PARKED];
+	__u32 num_parked;
+	__u32 parked_gen;
+
+	pthread_t thread;
+	bool thread_started;
+
+	trn_xsk_stats_t stats;
+} trn_xsk_queue_t;
+
+typedef struct trn_xsk_engine {
+	int itf_key;
+	__u32 iface_index;
+	int xsks_fd;
+	int endpoints_fd;
+	int if_config_fd;
+	__u32 features;     // TRAN_XDP_FEAT_* transit XDP was loaded with
+	bool running;
+	__u32 num_queues;
+	trn_xsk_queue_t *queues[TRAN_MAX_XSK_QUEUES];
+} trn_xsk_engine_t;
+
+typedef struct trn_xsk_ep_node {
+	endpoint_key_t key;
+	endpoint_t ep;
+	struct trn_xsk_ep_node *next;
+} trn_xsk_ep_node_t;
+
+static trn_xsk_engine_t *xsk_engines[XDP_ROLE_MAX];
+
+static trn_xsk_ep_node_t **ep_db = NULL;
+static __u32 ep_db_gen = 0;
+static pthread_mutex_t ep_db_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Unresolved misses since the control plane last drained them */
+static trn_xsk_miss_t ep_misses[TRAN_MAX_EP_MISSES];
+static __u32 num_ep_misses = 0;
+static pthread_mutex_t ep_misses_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline __u32 trn_xsk_ep_db_hash(endpoint_key_t *epkey)
+{
+	__u32 h = epkey->vni * 0x9e3779b1 ^ epkey->ip;
+
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	return h & (TRN_XSK_EP_DB_BUCKETS - 1);
+}
+
+int trn_xsk_ep_db_update(endpoint_key_t *epkey, endpoint_t *ep)
+{
+	trn_xsk_ep_node_t *node;
+	__u32 b = trn_xsk_ep_db_hash(epkey);
+	int rc = 0;
+
+	pthread_mutex_lock(&ep_db_lock);
+
+	if (!ep_db) {
+		ep_db = calloc(TRN_XSK_EP_DB_BUCKETS, sizeof(*ep_db));
+		if (!ep_db) {
+			TRN_LOG_ERROR("Failed to allocate slow path endpoint table");
+			rc = 1;
+			goto out;
+		}
+	}
+
+	for (node = ep_db[b]; node; node = node->next) {
+		if (node->key.vni == epkey->vni && node->key.ip == epkey->ip) {
+			node->ep = *ep;
+			goto out;
+		}
+	}
+
+	node = malloc(sizeof(*node));
+	if (!node) {
+		TRN_LOG_ERROR("Failed to allocate slow path endpoint entry");
+		rc = 1;
+		goto out;
+	}
+	node->key = *epkey;
+	node->ep = *ep;
+	node->next = ep_db[b];
+	ep_db[b] = node;
+
+out:
+	/* Tell the workers parked frames may be resolvable now */
+	if (!rc)
+		__atomic_add_fetch(&ep_db_gen, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&ep_db_lock);
+	return rc;
+}
+
+int trn_xsk_ep_db_lookup(endpoint_key_t *epkey, endpoint_t *ep)
+{
+	trn_xsk_ep_node_t *node;
+	__u32 b = trn_xsk_ep_db_hash(epkey);
+	int rc = 1;
+
+	pthread_mutex_lock(&ep_db_lock);
+
+	for (node = ep_db ? ep_db[b] : NULL; node; node = node->next) {
+		if (node->key.vni == epkey->vni && node->key.ip == epkey->ip) {
+			*ep = node->ep;
+			rc = 0;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&ep_db_lock);
+	return rc;
+}
+
+int trn_xsk_ep_db_delete(endpoint_key_t *epkey)
+{
+	trn_xsk_ep_node_t **pnode, *node;
+	__u32 b = trn_xsk_ep_db_hash(epkey);
+	int rc = 1;
+
+	pthread_mutex_lock(&ep_db_lock);
+
+	for (pnode = ep_db ? &ep_db[b] : NULL; pnode && *pnode;
+	     pnode = &(*pnode)->next) {
+		node = *pnode;
+		if (node->key.vni == epkey->vni && node->key.ip == epkey->ip) {
+			*pnode = node->next;
+			free(node);
+			rc = 0;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&ep_db_lock);
+	return rc;
+}
+
+static void trn_xsk_report_miss(endpoint_key_t *epkey)
+{
+	__u32 i;
+
+	pthread_mutex_lock(&ep_misses_lock);
+
+	for (i = 0; i < num_ep_misses; i++) {
+		if (ep_misses[i].key.vni == epkey->vni &&
+		    ep_misses[i].key.ip == epkey->ip) {
+			ep_misses[i].packets++;
+			goto out;
+		}
+	}
+
+	/* Full until drained, the key is reported again on a later miss */
+	if (num_ep_misses < TRAN_MAX_EP_MISSES) {
+		ep_misses[num_ep_misses].key = *epkey;
+		ep_misses[num_ep_misses].packets = 1;
+		num_ep_misses++;
+	}
+
+out:
+	pthread_mutex_unlock(&ep_misses_lock);
+}
+
+void trn_xsk_get_misses(trn_xsk_miss_t *misses, __u32 *n)
+{
+	pthread_mutex_lock(&ep_misses_lock);
+	memcpy(misses, ep_misses, num_ep_misses * sizeof(*misses));
+	*n = num_ep_misses;
+	num_ep_misses = 0;
+	pthread_mutex_unlock(&ep_misses_lock);
+}
+
+static __u64 trn_xsk_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (__u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static __u32 trn_xsk_prod_reserve(struct trn_xsk_ring *r, __u32 nb)
+{
+	__u32 free_entries = r->cached_cons - r->cached_prod;
+
+	if (free_entries < nb) {
+		r->cached_cons = __atomic_load_n(r->consumer, __ATOMIC_ACQUIRE) +
+				 r->size;
+		free_entries = r->cached_cons - r->cached_prod;
+	}
+
+	return free_entries < nb ? free_entries : nb;
+}
+
+static void trn_xsk_prod_submit(struct trn_xsk_ring *r, __u32 nb)
+{
+	r->cached_prod += nb;
+	__atomic_store_n(r->producer, r->cached_prod, __ATOMIC_RELEASE);
+}
+
+static __u32 trn_xsk_cons_peek(struct trn_xsk_ring *r, __u32 nb)
+{
+	__u32 entries = r->cached_prod - r->cached_cons;
+
+	if (entries == 0) {
+		r->cached_prod = __atomic_load_n(r->producer, __ATOMIC_ACQUIRE);
+		entries = r->cached_prod - r->cached_cons;
+	}
+
+	return entries < nb ? entries : nb;
+}
+
+static void trn_xsk_cons_release(struct trn_xsk_ring *r, __u32 nb)
+{
+	r->cached_cons += nb;
+	__atomic_store_n(r->consumer, r->cached_cons, __ATOMIC_RELEASE);
+}
+
+static inline __u64 *trn_xsk_addr_ring(struct trn_xsk_ring *r, __u32 idx)
+{
+	return &((__u64 *)r->ring)[idx & r->mask];
+}
+
+static inline struct xdp_desc *trn_xsk_desc_ring(struct trn_xsk_ring *r,
+						 __u32 idx)
+{
+	return &((struct xdp_desc *)r->ring)[idx & r->mask];
+}
+
+static int trn_xsk_map_ring(int fd, struct trn_xsk_ring *r,
+			    struct xdp_ring_offset *off, size_t desc_size,
+			    off_t pgoff, bool producer)
+{
+	r->map_size = off->desc + TRN_XSK_RING_SIZE * desc_size;
+	r->map = mmap(NULL, r->map_size, PROT_READ | PROT_WRITE,
+		      MAP_SHARED | MAP_POPULATE, fd, pgoff);
+	if (r->map == MAP_FAILED) {
+		r->map = NULL;
+		return 1;
+	}
+
+	r->producer = (__u32 *)((char *)r->map + off->producer);
+	r->consumer = (__u32 *)((char *)r->map + off->consumer);
+	r->flags = (__u32 *)((char *)r->map + off->flags);
+	r->ring = (char *)r->map + off->desc;
+	r->mask = TRN_XSK_RING_SIZE - 1;
+	r->size = TRN_XSK_RING_SIZE;
+
+	r->cached_prod = *r->producer;
+	r->cached_cons = *r->consumer;
+	/* Producer rings track free slots against consumer + size */
+	if (producer)
+		r->cached_cons += r->size;
+
+	return 0;
+}
+
+static void trn_xsk_unmap_ring(struct trn_xsk_ring *r)
+{
+	if (r->map) {
+		munmap(r->map, r->map_size);
+		r->map = NULL;
+	}
+}
+
+static void trn_xsk_free_frame(trn_xsk_queue_t *q, __u64 addr)
+{
+	/* Frames are recycled by chunk base, rx addr may carry headroom */
+	q->free_frames[q->num_free++] = addr & ~((__u64)TRN_XSK_FRAME_SIZE - 1);
+}
+
+static void trn_xsk_refill(trn_xsk_queue_t *q)
+{
+	__u32 i, nb;
+
+	nb = trn_xsk_prod_reserve(&q->fq, q->num_free);
+	for (i = 0; i < nb; i++) {
+		*trn_xsk_addr_ring(&q->fq, q->fq.cached_prod + i) =
+			q->free_frames[--q->num_free];
+	}
+
+	if (nb)
+		trn_xsk_prod_submit(&q->fq, nb);
+}
+
+static void trn_xsk_kick_tx(trn_xsk_queue_t *q)
+{
+	if (q->need_wakeup &&
+	    !(__atomic_load_n(q->tx.flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP))
+		return;
+
+	if (sendto(q->fd, NULL, 0, MSG_DONTWAIT, NULL, 0) < 0 &&
+	    errno != EAGAIN && errno != EBUSY && errno != ENOBUFS &&
+	    errno != ENETDOWN) {
+		TRN_LOG_WARN("AF_XDP tx kick failed on queue %d: %s",
+			     q->queue_id, strerror(errno));
+	}
+}
+
+static void trn_xsk_complete_tx(trn_xsk_queue_t *q)
+{
+	__u32 i, nb;
+
+	if (!q->outstanding_tx)
+		return;
+
+	trn_xsk_kick_tx(q);
+
+	nb = trn_xsk_cons_peek(&q->cq, TRN_XSK_BATCH_SIZE);
+	for (i = 0; i < nb; i++) {
+		trn_xsk_free_frame(q, *trn_xsk_addr_ring(&q->cq,
+							 q->cq.cached_cons + i));
+	}
+
+	if (nb) {
+		trn_xsk_cons_release(&q->cq, nb);
+		q->outstanding_tx -= nb;
+	}
+}
+
+static __u16 trn_xsk_ip_csum(struct iphdr *ip)
+{
+	__u16 *p = (__u16 *)ip;
+	__u32 csum = 0;
+
+	ip->check = 0;
+	for (unsigned int i = 0; i < ip->ihl * 2; i++)
+		csum += p[i];
+
+	while (csum >> 16)
+		csum = (csum & 0xffff) + (csum >> 16);
+
+	return ~csum;
+}
+
+/* Mirror of trn_process_inner_arp response, valid request verified by caller */
+static void trn_xsk_arp_reply(struct ethhdr *eth, struct iphdr *ip,
+			      struct ethhdr *inner_eth, __u8 *arp, endpoint_t *ep)
+{
+	struct arphdr *arph = (struct arphdr *)arp;
+	__u8 *sha = arp + sizeof(*arph);
+	__u8 *sip = sha + ETH_ALEN;
+	__u8 *tha = sip + sizeof(__u32);
+	__u8 *tip = tha + ETH_ALEN;
+	__u8 tmp_ip[sizeof(__u32)];
+	__u8 tmp_mac[ETH_ALEN];
+
+	arph->ar_op = htons(ARPOP_REPLY);
+	memcpy(tha, sha, ETH_ALEN);
+	memcpy(sha, ep->mac, ETH_ALEN);
+
+	memcpy(tmp_ip, sip, sizeof(tmp_ip));
+	memcpy(sip, tip, sizeof(tmp_ip));
+	memcpy(tip, tmp_ip, sizeof(tmp_ip));
+
+	memcpy(inner_eth->h_dest, inner_eth->h_source, ETH_ALEN);
+	memcpy(inner_eth->h_source, ep->mac, ETH_ALEN);
+
+	/* Keep overlay header, swap outer IP and MAC */
+	__u32 tmp = ip->saddr;
+	ip->saddr = ip->daddr;
+	ip->daddr = tmp;
+	ip->ttl--;
+	ip->check = trn_xsk_ip_csum(ip);
+
+	memcpy(tmp_mac, eth->h_dest, ETH_ALEN);
+	memcpy(eth->h_dest, eth->h_source, ETH_ALEN);
+	memcpy(eth->h_source, tmp_mac, ETH_ALEN);
+}
+
+/* Overlay frame parsed by trn_xsk_process_pkt */
+typedef struct {
+	__u8 *end;
+	struct ethhdr *eth;
+	struct iphdr *ip;
+	struct udphdr *udp;
+	__u8 *ovl;
+	__u32 ovl_len;
+	bool geneve;
+	struct ethhdr *inner_eth;
+	struct iphdr *inner_ip;
+	__u32 vni;
+} trn_xsk_pkt_t;
+
+/* Mirror of trn_update_l4_csum and trn_update_l4_csum_port */
+static __u16 trn_xsk_csum_replace(__u16 check, __u32 from, __u32 to)
+{
+	__u64 csum = (__u16)~check;
+
+	csum += (__u16)~from + (__u16)~(from >> 16) + (to & 0xffff) +
+		(to >> 16);
+	while (csum >> 16)
+		csum = (csum & 0xffff) + (csum >> 16);
+
+	return ~csum;
+}
+
+/* Mirror of trn_get_inner_packet_hash */
+static __u32 trn_xsk_inner_hash(trn_xsk_pkt_t *p)
+{
+	struct iphdr *inner_ip = p->inner_ip;
+	__u16 *ports = (__u16 *)((__u8 *)inner_ip + sizeof(*inner_ip));
+	__u32 l4 = 0;
+
+	if ((inner_ip->protocol == IPPROTO_TCP ||
+	     inner_ip->protocol == IPPROTO_UDP) &&
+	    (__u8 *)(ports + 2) <= p->end)
+		l4 = (__u32)ports[0] << 16 | ports[1];
+
+	return jhash_3words(inner_ip->saddr, inner_ip->daddr,
+			    l4 ^ inner_ip->protocol, JHASH_INITVAL);
+}
+
+/* Mirror of trn_set_hint_hdr */
+static void trn_xsk_set_hint_hdr(trn_xsk_pkt_t *p, __be32 hip)
+{
+	__u8 *ip = (__u8 *)&hip;
+
+	if (p->geneve) {
+		if (p->ovl_len < TRN_XSK_GNV_RTS_LEN)
+			return;
+		p->ovl[TRN_XSK_GNV_RTS_TYPE_OFF] = TRN_XSK_GNV_RTS_OPT_TYPE;
+		memcpy(p->ovl + TRN_XSK_GNV_RTS_HOST_OFF, &hip, sizeof(hip));
+		memcpy(p->ovl + TRN_XSK_GNV_RTS_HOST_OFF + sizeof(hip),
+		       p->eth->h_source, ETH_ALEN);
+	} else {
+		p->ovl[0] |= TRN_XSK_VXLAN_HINT_FLAG;
+		p->ovl[0] &= ~TRN_XSK_VXLAN_GBP_FLAG;
+		p->ovl[1] = ip[0];
+		p->ovl[2] = ip[1];
+		p->ovl[3] = ip[2];
+		p->ovl[7] = ip[3];
+	}
+
+	p->udp->check = 0;
+}
+
+/*
+ * Mirror of the forwarding rewrite of trn_process_inner_ip, so the first
+ * packets of a flow leave exactly like those the fast path forwards:
+ * outer IP from the endpoint's checksum delta, source port from the
+ * inner flow and the UDP checksum updated per droplet options, and the
+ * source host hint in the overlay header or in the trailer transit XDP
+ * made room for. Returns 1 if the frame shall be dropped.
+ */
+static int trn_xsk_ip_forward(trn_xsk_engine_t *engine, trn_xsk_pkt_t *p,
+			      __u32 options, endpoint_t *ep)
+{
+	struct iphdr *ip = p->ip;
+	struct udphdr *udp = p->udp;
+	__be32 old_saddr = ip->saddr, old_daddr = ip->daddr, tip = 0;
+	__be16 old_sport = udp->source;
+	bool hint;
+	__u64 csum;
+
+	memcpy(p->inner_eth->h_dest, ep->mac, ETH_ALEN);
+
+	hint = (engine->features & TRAN_XDP_FEAT_APPEND_TAIL) &&
+	       p->inner_ip->protocol != IPPROTO_ICMP;
+	if (hint)
+		tip = ip->saddr;
+
+	/* trn_redirect_ip_csum, or a full sum if no delta was computed */
+	ip->ttl--;
+	if (ep->csum_delta) {
+		csum = (__u16)~ip->check + (__u16)~(ip->saddr & 0xffff) +
+		       (__u16)~(ip->saddr >> 16) + ep->csum_delta;
+		while (csum >> 16)
+			csum = (csum & 0xffff) + (csum >> 16);
+		ip->saddr = ip->daddr;
+		ip->daddr = ep->hip;
+		ip->check = ~csum;
+	} else {
+		ip->saddr = ip->daddr;
+		ip->daddr = ep->hip;
+		ip->check = trn_xsk_ip_csum(ip);
+	}
+
+	if (options & TRAN_ITF_OPT_SPORT_HASH) {
+		udp->source = htons(TRAN_UDP_SPORT_MIN |
+				    (trn_xsk_inner_hash(p) & TRAN_UDP_SPORT_MASK));
+	}
+
+	if (udp->check) {
+		__u16 check = udp->check;
+
+		check = trn_xsk_csum_replace(check, old_saddr, ip->saddr);
+		check = trn_xsk_csum_replace(check, old_daddr, ip->daddr);
+		check = trn_xsk_csum_replace(check, old_sport, udp->source);
+		udp->check = check ? check : 0xffff;
+	}
+
+	memcpy(p->eth->h_source, p->eth->h_dest, ETH_ALEN);
+	memcpy(p->eth->h_dest, ep->hmac, ETH_ALEN);
+
+	if (hint && (options & TRAN_ITF_OPT_HINT_HDR)) {
+		trn_xsk_set_hint_hdr(p, tip);
+	} else if (hint) {
+		struct xdp_hints_src h_src;
+		__u8 *tail = (__u8 *)p->eth + sizeof(struct ethhdr) +
+			     ntohs(ip->tot_len);
+
+		/* Transit XDP grew the frame unless it had no tailroom */
+		if (tail + sizeof(h_src) <= p->end) {
+			h_src.flags = TRAN_HINTS_SRC_FLAGS;
+			h_src.vni = p->vni;
+			h_src.saddr = tip;
+			memcpy(h_src.h_source, p->eth->h_source, ETH_ALEN);
+			memcpy(tail, &h_src, sizeof(h_src));
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * Resolve the endpoint a redirected packet missed and rewrite the packet
+ * in place for re-injection, options are those of the droplet. Returns 0
+ * if the frame shall be transmitted, -ENOENT with epkey set if the
+ * endpoint is unknown, the frame is left untouched then.
+ */
+static int trn_xsk_process_pkt(trn_xsk_queue_t *q, __u8 *data, __u32 len,
+			       __u32 options, endpoint_key_t *epkey)
+{
+	trn_xsk_pkt_t p = { .end = data + len };
+	struct arphdr *arph = NULL;
+	endpoint_t ep;
+	__u8 *tip;
+
+	p.eth = (struct ethhdr *)data;
+	p.ip = (struct iphdr *)(p.eth + 1);
+	if ((__u8 *)(p.ip + 1) > p.end || p.eth->h_proto != htons(ETH_P_IP) ||
+	    p.ip->protocol != IPPROTO_UDP || p.ip->ihl < 5 || !p.ip->ttl)
+		return 1;
+
+	p.udp = (struct udphdr *)((__u8 *)p.ip + p.ip->ihl * 4);
+	p.ovl = (__u8 *)(p.udp + 1);
+	if (p.ovl + TRN_XSK_OVERLAY_HDR_LEN > p.end)
+		return 1;
+
+	if (p.udp->dest == htons(TRN_XSK_VXLAN_PORT)) {
+		p.ovl_len = TRN_XSK_OVERLAY_HDR_LEN;
+	} else if (p.udp->dest == htons(TRN_XSK_GENEVE_PORT)) {
+		p.ovl_len = TRN_XSK_OVERLAY_HDR_LEN + (p.ovl[0] & 0x3f) * 4;
+		p.geneve = true;
+	} else {
+		return 1;
+	}
+
+	/* VNI sits at the same offset in VxLAN and Geneve headers */
+	p.vni = (p.ovl[4] << 16) | (p.ovl[5] << 8) | p.ovl[6];
+	epkey->vni = p.vni;
+
+	p.inner_eth = (struct ethhdr *)(p.ovl + p.ovl_len);
+	if ((__u8 *)(p.inner_eth + 1) > p.end)
+		return 1;
+
+	if (p.inner_eth->h_proto == htons(ETH_P_ARP)) {
+		arph = (struct arphdr *)(p.inner_eth + 1);
+		tip = (__u8 *)(arph + 1) + 2 * ETH_ALEN + sizeof(__u32);
+		if (tip + sizeof(__u32) > p.end ||
+		    arph->ar_op != htons(ARPOP_REQUEST))
+			return 1;
+		memcpy(&epkey->ip, tip, sizeof(epkey->ip));
+	} else if (p.inner_eth->h_proto == htons(ETH_P_IP)) {
+		p.inner_ip = (struct iphdr *)(p.inner_eth + 1);
+		if ((__u8 *)(p.inner_ip + 1) > p.end)
+			return 1;
+		epkey->ip = p.inner_ip->daddr;
+	} else {
+		return 1;
+	}
+
+	if (trn_xsk_ep_db_lookup(epkey, &ep))
+		return -ENOENT;
+
+	/* Install it so following packets stay on the fast path */
+	trn_set_endpoint_csum_delta(&ep);
+	if (bpf_map_update_elem(q->engine->endpoints_fd, epkey, &ep, BPF_ANY)) {
+		TRN_LOG_WARN("Slow path failed to install endpoint %d 0x%08x: %s",
+			     epkey->vni, epkey->ip, strerror(errno));
+	}
+	trn_endpoint_bloom_add(epkey);
+	q->stats.resolved++;
+
+	if (arph) {
+		trn_xsk_arp_reply(p.eth, p.ip, p.inner_eth, (__u8 *)arph, &ep);
+		return 0;
+	}
+
+	return trn_xsk_ip_forward(q->engine, &p, options, &ep);
+}
+
+/* TRAN_ITF_OPT_* of the droplet served, read once per batch */
+static __u32 trn_xsk_itf_options(trn_xsk_engine_t *engine)
+{
+	struct tunnel_iface_t itf;
+
+	if (bpf_map_lookup_elem(engine->if_config_fd, &engine->iface_index,
+				&itf))
+		return 0;
+
+	return itf.options;
+}
+
+static void trn_xsk_tx(trn_xsk_queue_t *q, struct xdp_desc *descs, __u32 ntx)
+{
+	__u32 i, nb;
+
+	if (!ntx)
+		return;
+
+	nb = trn_xsk_prod_reserve(&q->tx, ntx);
+	for (i = 0; i < nb; i++)
+		*trn_xsk_desc_ring(&q->tx, q->tx.cached_prod + i) = descs[i];
+	trn_xsk_prod_submit(&q->tx, nb);
+	q->outstanding_tx += nb;
+	q->stats.reinjected += nb;
+
+	/* TX ring full, give the rest back */
+	for (i = nb; i < ntx; i++) {
+		trn_xsk_free_frame(q, descs[i].addr);
+		q->stats.tx_errors++;
+	}
+
+	trn_xsk_kick_tx(q);
+}
+
+/* Hold the frame of an unknown endpoint until the control plane answers */
+static bool trn_xsk_park(trn_xsk_queue_t *q, struct xdp_desc *desc)
+{
+	trn_xsk_parked_t *p;
+
+	if (q->num_parked == TRN_XSK_MAX_PARKED)
+		return false;
+
+	if (!q->num_parked)
+		q->parked_gen = __atomic_load_n(&ep_db_gen, __ATOMIC_ACQUIRE);
+
+	p = &q->parked[q->num_parked++];
+	p->addr = desc->addr;
+	p->len = desc->len;
+	p->deadline_ns = trn_xsk_now_ns() +
+			 TRN_XSK_PARK_TIMEOUT_MS * 1000000ULL;
+	q->stats.parked++;
+	return true;
+}
+
+static void trn_xsk_miss(trn_xsk_queue_t *q, struct xdp_desc *desc,
+			 endpoint_key_t *epkey)
+{
+	trn_xsk_report_miss(epkey);
+	trn_miss_neg_cache_add(epkey);
+
+	if (!trn_xsk_park(q, desc)) {
+		q->stats.unresolved++;
+		trn_xsk_free_frame(q, desc->addr);
+	}
+}
+
+/*
+ * Re-run parked frames once update-ep changed the endpoint table, frames
+ * still unknown at their deadline are dropped.
+ */
+static void trn_xsk_retry_parked(trn_xsk_queue_t *q)
+{
+	struct xdp_desc tx_descs[TRN_XSK_MAX_PARKED];
+	endpoint_key_t epkey;
+	__u32 i, n = 0, ntx = 0, gen, options = 0;
+	__u64 now;
+	bool changed;
+
+	if (!q->num_parked)
+		return;
+
+	gen = __atomic_load_n(&ep_db_gen, __ATOMIC_ACQUIRE);
+	changed = gen != q->parked_gen;
+	q->parked_gen = gen;
+	now = trn_xsk_now_ns();
+	if (changed)
+		options = trn_xsk_itf_options(q->engine);
+
+	for (i = 0; i < q->num_parked; i++) {
+		trn_xsk_parked_t *p = &q->parked[i];
+		int rc = -ENOENT;
+
+		if (changed) {
+			rc = trn_xsk_process_pkt(q, (__u8 *)q->umem_area + p->addr,
+						 p->len, options, &epkey);
+		}
+
+		if (!rc) {
+			tx_descs[ntx].addr = p->addr;
+			tx_descs[ntx].len = p->len;
+			tx_descs[ntx].options = 0;
+			ntx++;
+		} else if (rc == -ENOENT && now < p->deadline_ns) {
+			q->parked[n++] = *p;
+		} else {
+			q->stats.unresolved++;
+			trn_xsk_free_frame(q, p->addr);
+		}
+	}
+	q->num_parked = n;
+
+	trn_xsk_tx(q, tx_descs, ntx);
+}
+
+static void trn_xsk_rx_batch(trn_xsk_queue_t *q)
+{
+	struct xdp_desc tx_descs[TRN_XSK_BATCH_SIZE];
+	endpoint_key_t epkey;
+	__u32 i, rcvd, ntx = 0, options;
+	int rc;
+
+	rcvd = trn_xsk_cons_peek(&q->rx, TRN_XSK_BATCH_SIZE);
+	if (!rcvd)
+		return;
+
+	options = trn_xsk_itf_options(q->engine);
+
+	for (i = 0; i < rcvd; i++) {
+		struct xdp_desc *desc =
+			trn_xsk_desc_ring(&q->rx, q->rx.cached_cons + i);
+		__u8 *data = (__u8 *)q->umem_area + desc->addr;
+
+		q->stats.upcalls++;
+
+		rc = trn_xsk_process_pkt(q, data, desc->len, options, &epkey);
+		if (rc == -ENOENT) {
+			trn_xsk_miss(q, desc, &epkey);
+			continue;
+		} else if (rc) {
+			trn_xsk_free_frame(q, desc->addr);
+			continue;
+		}
+		tx_descs[ntx].addr = desc->addr;
+		tx_descs[ntx].len = desc->len;
+		tx_descs[ntx].options = 0;
+		ntx++;
+	}
+
+	trn_xsk_cons_release(&q->rx, rcvd);
+
+	trn_xsk_tx(q, tx_descs, ntx);
+	trn_xsk_refill(q);
+}
+
+static void *trn_xsk_worker(void *arg)
+{
+	trn_xsk_queue_t *q = arg;
+	struct pollfd pfd = {
+		.fd = q->fd,
+		.events = POLLIN,
+	};
+
+	TRN_LOG_INFO("AF_XDP slow path worker running on ifindex %d queue %d",
+		     q->engine->iface_index, q->queue_id);
+
+	while (__atomic_load_n(&q->engine->running, __ATOMIC_ACQUIRE)) {
+		trn_xsk_complete_tx(q);
+		trn_xsk_retry_parked(q);
+		trn_xsk_refill(q);
+
+		if (poll(&pfd, 1, TRN_XSK_POLL_TIMEOUT_MS) <= 0)
+			continue;
+
+		trn_xsk_rx_batch(q);
+	}
+
+	return NULL;
+}
+
+static void trn_xsk_queue_destroy(trn_xsk_queue_t *q)
+{
+	if (!q)
+		return;
+
+	trn_xsk_unmap_ring(&q->rx);
+	trn_xsk_unmap_ring(&q->tx);
+	trn_xsk_unmap_ring(&q->fq);
+	trn_xsk_unmap_ring(&q->cq);
+
+	if (q->fd >= 0)
+		close(q->fd);
+
+	if (q->umem_area)
+		munmap(q->umem_area, q->umem_size);
+
+	free(q);
+}
+
+static trn_xsk_queue_t *trn_xsk_queue_create(trn_xsk_engine_t *engine,
+					     __u32 queue_id, __u16 bind_flags)
+{
+	struct xdp_mmap_offsets off;
+	struct xdp_umem_reg mr;
+	struct sockaddr_xdp sxdp;
+	socklen_t optlen = sizeof(off);
+	int ring_size = TRN_XSK_RING_SIZE;
+	trn_xsk_queue_t *q;
+
+	q = calloc(1, sizeof(*q));
+	if (!q) {
+		TRN_LOG_ERROR("Failed to allocate AF_XDP queue %d", queue_id);
+		return NULL;
+	}
+	q->engine = engine;
+	q->queue_id = queue_id;
+	q->fd = -1;
+
+	/* UMEM on hugepages to keep TLB misses off the slow path */
+	q->umem_size = (size_t)TRN_XSK_NUM_FRAMES * TRN_XSK_FRAME_SIZE;
+	q->umem_area = mmap(NULL, q->umem_size, PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (q->umem_area == MAP_FAILED) {
+		TRN_LOG_INFO("No hugepages for AF_XDP UMEM of queue %d, "
+			     "falling back to regular pages", queue_id);
+		q->umem_area = mmap(NULL, q->umem_size, PROT_READ | PROT_WRITE,
+				    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (q->umem_area == MAP_FAILED) {
+			q->umem_area = NULL;
+			TRN_LOG_ERROR("Failed to allocate AF_XDP UMEM: %s",
+				      strerror(errno));
+			goto cleanup;
+		}
+	}
+
+	q->fd = socket(AF_XDP, SOCK_RAW, 0);
+	if (q->fd < 0) {
+		TRN_LOG_ERROR("Failed to create AF_XDP socket: %s",
+			      strerror(errno));
+		goto cleanup;
+	}
+
+	memset(&mr, 0, sizeof(mr));
+	mr.addr = (__u64)(uintptr_t)q->umem_area;
+	mr.len = q->umem_size;
+	mr.chunk_size = TRN_XSK_FRAME_SIZE;
+	mr.headroom = 0;
+	if (setsockopt(q->fd, SOL_XDP, XDP_UMEM_REG, &mr, sizeof(mr))) {
+		TRN_LOG_ERROR("Failed to register AF_XDP UMEM: %s",
+			      strerror(errno));
+		goto cleanup;
+	}
+
+	if (setsockopt(q->fd, SOL_XDP, XDP_UMEM_FILL_RING, &ring_size,
+		       sizeof(ring_size)) ||
+	    setsockopt(q->fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &ring_size,
+		       sizeof(ring_size)) ||
+	    setsockopt(q->fd, SOL_XDP, XDP_RX_RING, &ring_size,
+		       sizeof(ring_size)) ||
+	    setsockopt(q->fd, SOL_XDP, XDP_TX_RING, &ring_size,
+		       sizeof(ring_size))) {
+		TRN_LOG_ERROR("Failed to size AF_XDP rings: %s",
+			      strerror(errno));
+		goto cleanup;
+	}
+
+	if (getsockopt(q->fd, SOL_XDP, XDP_MMAP_OFFSETS, &off, &optlen)) {
+		TRN_LOG_ERROR("Failed to get AF_XDP ring offsets: %s",
+			      strerror(errno));
+		goto cleanup;
+	}
+
+	if (trn_xsk_map_ring(q->fd, &q->fq, &off.fr, sizeof(__u64),
+			     XDP_UMEM_PGOFF_FILL_RING, true) ||
+	    trn_xsk_map_ring(q->fd, &q->cq, &off.cr, sizeof(__u64),
+			     XDP_UMEM_PGOFF_COMPLETION_RING, false) ||
+	    trn_xsk_map_ring(q->fd, &q->rx, &off.rx, sizeof(struct xdp_desc),
+			     XDP_PGOFF_RX_RING, false) ||
+	    trn_xsk_map_ring(q->fd, &q->tx, &off.tx, sizeof(struct xdp_desc),
+			     XDP_PGOFF_TX_RING, true)) {
+		TRN_LOG_ERROR("Failed to mmap AF_XDP rings: %s",
+			      strerror(errno));
+		goto cleanup;
+	}
+
+	for (__u32 i = 0; i < TRN_XSK_NUM_FRAMES; i++)
+		q->free_frames[q->num_free++] = (__u64)i * TRN_XSK_FRAME_SIZE;
+	trn_xsk_refill(q);
+
+	memset(&sxdp, 0, sizeof(sxdp));
+	sxdp.sxdp_family = AF_XDP;
+	sxdp.sxdp_ifindex = engine->iface_index;
+	sxdp.sxdp_queue_id = queue_id;
+	sxdp.sxdp_flags = bind_flags | XDP_USE_NEED_WAKEUP;
+	q->need_wakeup = true;
+
+	if (bind(q->fd, (struct sockaddr *)&sxdp, sizeof(sxdp))) {
+		/* Older kernels don't know about need_wakeup */
+		sxdp.sxdp_flags = bind_flags;
+		q->need_wakeup = false;
+		if (bind(q->fd, (struct sockaddr *)&sxdp, sizeof(sxdp))) {
+			TRN_LOG_ERROR("Failed to bind AF_XDP socket to ifindex %d "
+				      "queue %d: %s", engine->iface_index,
+				      queue_id, strerror(errno));
+			goto cleanup;
+		}
+	}
+
+	return q;
+
+cleanup:
+	trn_xsk_queue_destroy(q);
+	return NULL;
+}
+
+static __u32 trn_xsk_get_num_queues(__u32 iface_index)
+{
+	struct ethtool_channels ch;
+	struct ifreq ifr;
+	__u32 num_queues = 1;
+	int fd;
+
+	memset(&ifr, 0, sizeof(ifr));
+	if (!if_indextoname(iface_index, ifr.ifr_name))
+		return num_queues;
+
+	memset(&ch, 0, sizeof(ch));
+	ch.cmd = ETHTOOL_GCHANNELS;
+	ifr.ifr_data = (void *)&ch;
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		return num_queues;
+
+	if (!ioctl(fd, SIOCETHTOOL, &ifr)) {
+		num_queues = ch.combined_count > ch.rx_count ?
+			ch.combined_count : ch.rx_count;
+	}
+	close(fd);
+
+	if (!num_queues)
+		num_queues = 1;
+	if (num_queues > TRAN_MAX_XSK_QUEUES) {
+		TRN_LOG_WARN("ifindex %d has %d queues, slow path serves first %d",
+			     iface_index, num_queues, TRAN_MAX_XSK_QUEUES);
+		num_queues = TRAN_MAX_XSK_QUEUES;
+	}
+
+	return num_queues;
+}
+
+void trn_xsk_stop(int itf_key)
+{
+	trn_xsk_engine_t *engine;
+	__u32 i;
+	int key;
+
+	if (itf_key < 0 || itf_key >= XDP_ROLE_MAX || !xsk_engines[itf_key])
+		return;
+
+	engine = xsk_engines[itf_key];
+	__atomic_store_n(&engine->running, false, __ATOMIC_RELEASE);
+
+	for (i = 0; i < engine->num_queues; i++) {
+		trn_xsk_queue_t *q = engine->queues[i];
+
+		if (!q)
+			continue;
+
+		if (q->thread_started)
+			pthread_join(q->thread, NULL);
+
+		key = TRAN_XSK_MAP_KEY(itf_key, i);
+		bpf_map_delete_elem(engine->xsks_fd, &key);
+
+		trn_xsk_queue_destroy(q);
+		engine->queues[i] = NULL;
+	}
+
+	TRN_LOG_INFO("AF_XDP slow path stopped on ifindex %d",
+		     engine->iface_index);
+
+	free(engine);
+	xsk_engines[itf_key] = NULL;
+}
+
+int trn_xsk_start(int itf_key, __u32 iface_index, int xsks_fd,
+		  int endpoints_fd, int if_config_fd, __u32 features,
+		  __u16 bind_flags)
+{
+	trn_xsk_engine_t *engine;
+	__u32 i, num_queues;
+	int key, rc;
+
+	if (itf_key < 0 || itf_key >= XDP_ROLE_MAX) {
+		TRN_LOG_ERROR("Invalid slow path interface key %d", itf_key);
+		return 1;
+	}
+
+	if (xsks_fd < 0 || endpoints_fd < 0 || if_config_fd < 0) {
+		TRN_LOG_ERROR("Invalid xsks_map, endpoints_map or if_config_map fd");
+		return 1;
+	}
+
+	/* xsks_map is keyed by role, one interface of a role is served */
+	if (xsk_engines[itf_key]) {
+		if (xsk_engines[itf_key]->iface_index == iface_index)
+			return 0;
+		TRN_LOG_ERROR("AF_XDP slow path of role %d already serves "
+			      "ifindex %d, ifindex %d can't be served",
+			      itf_key, xsk_engines[itf_key]->iface_index,
+			      iface_index);
+		return 1;
+	}
+
+	engine = calloc(1, sizeof(*engine));
+	if (!engine) {
+		TRN_LOG_ERROR("Failed to allocate AF_XDP slow path");
+		return 1;
+	}
+	engine->itf_key = itf_key;
+	engine->iface_index = iface_index;
+	engine->xsks_fd = xsks_fd;
+	engine->endpoints_fd = endpoints_fd;
+	engine->if_config_fd = if_config_fd;
+	engine->features = features;
+	engine->running = true;
+	xsk_engines[itf_key] = engine;
+
+	num_queues = trn_xsk_get_num_queues(iface_index);
+
+	for (i = 0; i < num_queues; i++) {
+		trn_xsk_queue_t *q = trn_xsk_queue_create(engine, i, bind_flags);
+
+		if (!q)
+			break;
+
+		engine->queues[i] = q;
+		engine->num_queues = i + 1;
+
+		key = TRAN_XSK_MAP_KEY(itf_key, i);
+		if (bpf_map_update_elem(xsks_fd, &key, &q->fd, 0)) {
+			TRN_LOG_ERROR("Failed to add AF_XDP socket of queue %d "
+				      "to xsks_map: %s", i, strerror(errno));
+			break;
+		}
+
+		rc = pthread_create(&q->thread, NULL, trn_xsk_worker, q);
+		if (rc) {
+			TRN_LOG_ERROR("Failed to create AF_XDP worker of queue %d, "
+				      "rc: %d", i, rc);
+			bpf_map_delete_elem(xsks_fd, &key);
+			break;
+		}
+		q->thread_started = true;
+	}
+
+	if (i < num_queues) {
+		/* All or nothing, a missing queue silently drops its misses */
+		trn_xsk_stop(itf_key);
+		return 1;
+	}
+
+	TRN_LOG_INFO("AF_XDP slow path started on ifindex %d with %d queues",
+		     iface_index, num_queues);
+	return 0;
+}
+
+int trn_xsk_get_stats(__u32 iface_index, __u32 *num_queues,
+		      trn_xsk_stats_t *stats)
+{
+	for (int k = 0; k < XDP_ROLE_MAX; k++) {
+		trn_xsk_engine_t *engine = xsk_engines[k];
+
+		if (!engine || engine->iface_index != iface_index)
+			continue;
+
+		for (__u32 i = 0; i < engine->num_queues; i++)
+			stats[i] = engine->queues[i]->stats;
+
+		*num_queues = engine->num_queues;
+		return 0;
+	}
+
+	TRN_LOG_ERROR("AF_XDP slow path not running on ifindex %d", iface_index);
+	return 1;
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_transit_xsk_usr.h
+ *
+ * @brief AF_XDP slow path of transit daemon. Packets missing
+ * endpoints_map are redirected by transit XDP to xsks_map, resolved
+ * here or by the control plane, and re-injected back onto the same queue.
+ *
+ * @copyright Copyright (c) 2022-2023 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#pragma once
+
+#include <linux/types.h>
+#include <linux/if_xdp.h>
+#include <stdbool.h>
+
+#include "trn_datamodel.h"
+
+/* UMEM geometry of one rx queue, frames are carved out of hugepages */
+#define TRN_XSK_FRAME_SIZE 4096
+#define TRN_XSK_NUM_FRAMES 1024
+#define TRN_XSK_RING_SIZE 512
+#define TRN_XSK_BATCH_SIZE 64
+
+/* Frames of a queue held while the control plane resolves their endpoint */
+#define TRN_XSK_MAX_PARKED 256
+#define TRN_XSK_PARK_TIMEOUT_MS 2000
+
+/* Bucket count of the endpoint table used to resolve misses */
+#define TRN_XSK_EP_DB_BUCKETS (64 * 1024)
+
+/* Per rx queue slow path counters */
+typedef struct {
+	__u64 upcalls;       // packets received from xsks_map
+	__u64 resolved;      // endpoints resolved and installed
+	__u64 unresolved;    // packets dropped for unknown endpoint
+	__u64 parked;        // packets held for the control plane to resolve
+	__u64 reinjected;    // packets transmitted back on the queue
+	__u64 tx_errors;     // packets failed to be transmitted
+} trn_xsk_stats_t;
+
+/* Endpoint missing in the endpoint table, reported to the control plane */
+typedef struct {
+	endpoint_key_t key;
+	__u32 packets;
+} trn_xsk_miss_t;
+
+int trn_xsk_ep_db_update(endpoint_key_t *epkey, endpoint_t *ep);
+int trn_xsk_ep_db_lookup(endpoint_key_t *epkey, endpoint_t *ep);
+int trn_xsk_ep_db_delete(endpoint_key_t *epkey);
+
+int trn_xsk_start(int itf_key, __u32 iface_index, int xsks_fd,
+		  int endpoints_fd, int if_config_fd, __u32 features,
+		  __u16 bind_flags);
+void trn_xsk_stop(int itf_key);
+int trn_xsk_get_stats(__u32 iface_index, __u32 *num_queues,
+		      trn_xsk_stats_t *stats);
+void trn_xsk_get_misses(trn_xsk_miss_t *misses, __u32 *n);
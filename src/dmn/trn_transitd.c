@@ -35,6 +35,7 @@
 #include <sys/mount.h>
 #include <signal.h>
 #include <pthread.h>
+#include <unistd.h>
 
 #include "trn_transitd.h"
 
@@ -109,6 +110,24 @@ void *entrance_rpc(void *arg)
 	pthread_exit(NULL);
 }
 
+/*
+ * thread entrance for aging of tracked connections and resizing of the
+ * per CPU shares of policers
+ */
+void *entrance_ct_sweep(void *arg)
+{
+	UNUSED(arg);
+
+	TRN_LOG_INFO("Connection tracking sweeper thread running");
+	for (;;) {
+		sleep(TRAN_CT_SWEEP_INTERVAL);
+		trn_sweep_conntrack();
+		trn_share_rate_limits();
+	}
+
+	pthread_exit(NULL);
+}
+
 #if turnOn
 /* thread entrance for datapath assistant */
 void *entrance_dpa(void *arg) {
@@ -124,7 +143,7 @@ void *entrance_dpa(void *arg) {
 int main()
 {
 	struct sigaction act;
-	pthread_t thr_rpc, thr_dpa;
+	pthread_t thr_rpc, thr_ct, thr_dpa;
 	int rc;
 
 	TRN_LOG_INIT(TRANSITLOGNAME);
@@ -142,6 +161,12 @@ int main()
 		exit(1);
     }
 
+	if ((rc = pthread_create(&thr_ct, NULL, entrance_ct_sweep, NULL))) {
+		TRN_LOG_ERROR("cannot create conntrack sweeper thread, rc: %d", rc);
+		printf("cannot create conntrack sweeper thread, rc: %d\n", rc);
+		exit(1);
+	}
+
 #if turnOn
 	if ((rc = pthread_create(&thr_dpa, NULL, entrance_dpa, NULL))) {
 		TRN_LOG_ERROR("cannot create datapath assistant thread, rc: %d", rc);
@@ -30,3 +30,5 @@
 #include "trn_rpc.h"
 #include "trn_log.h"
 #include "trn_transit_xdp_usr.h"
+#include "trn_transit_xsk_usr.h"
+#include "trn_transit_sg_usr.h"
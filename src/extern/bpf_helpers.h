@@ -193,6 +193,12 @@ static unsigned int (*bpf_set_hash)(void *ctx,
 static int (*bpf_skb_adjust_room)(void *ctx, __s32 len_diff, __u32 mode,
                                   unsigned long long flags) = (void *)
     BPF_FUNC_skb_adjust_room;
+static unsigned long long (*bpf_xdp_get_buff_len)(void *ctx) = (void *)
+    BPF_FUNC_xdp_get_buff_len;
+static int (*bpf_xdp_load_bytes)(void *ctx, __u32 offset, void *buf,
+                                 __u32 len) = (void *)BPF_FUNC_xdp_load_bytes;
+static int (*bpf_xdp_store_bytes)(void *ctx, __u32 offset, void *buf,
+                                  __u32 len) = (void *)BPF_FUNC_xdp_store_bytes;
 
 /* Scan the ARCH passed in from ARCH env variable (see Makefile) */
 #if defined(__TARGET_ARCH_x86)
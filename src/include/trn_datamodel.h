@@ -39,22 +39,35 @@
 #define TRAN_MAX_CLI_JSON_STR 10240
 
 #define TRAN_MAX_ZGC_ENTRANCES 128
-#define TRAN_MAX_EP_BATCH_SIZE 360
+#define TRAN_MAX_EP_BATCH_SIZE 256
 #define TRAN_DP_FLOW_TIMEOUT 30     // In seconds
 
 /* At most 10 chains, size has to be prime and 100x number of chains */
 #define TRAN_MAX_MAGLEV_TABLE_SIZE 10000
+/* Larger tables live in a per-DFT array map, see dft_t */
+#define TRAN_MAX_DFT_TABLE_SIZE (1 << 20)
+#define TRAN_MAX_DFT 16
+#define TRAN_UNUSED_DFT_ID TRAN_MAX_DFT
 #define TRAN_MAX_FTN 512
 #define TRAN_MAX_CHAIN 128
+#define TRAN_UNUSED_FTN_ID TRAN_MAX_FTN
 
 /* Set max total number of endpoints */
 #define TRAN_MAX_NEP 1024*1024*4
 /* Set max number of host IPs a (scaled) endpoint can be mapped to */
 #define TRAN_MAX_REMOTES 64
+#define TRAN_MAX_SCALED_EP 64*1024
 #define TRAN_MAX_ITF 128
 #define TRAN_MAX_VETH 2048
 #define TRAN_UNUSED_ITF_IDX -1
 
+/* Assume netdev has no more than 64 queues served by AF_XDP */
+#define TRAN_MAX_XSK_QUEUES 64
+/* xsks_map key of an rx queue on the interface of given role */
+#define TRAN_XSK_MAP_KEY(role, queue) ((role) * TRAN_MAX_XSK_QUEUES + (queue))
+/* Max unresolved endpoint misses held for the control plane */
+#define TRAN_MAX_EP_MISSES 1024
+
 #define TRAN_SUBSTRT_VNI 0
 
 #define TRAN_SUBSTRT_EP 0
@@ -62,23 +75,137 @@
 #define TRAN_SCALED_EP 2
 #define TRAN_GATEWAY_EP 3
 
+/* Flow cache size and number of VNI generation slots invalidating it */
+#define TRAN_MAX_FLOW_CACHE 1024*1024
+#define TRAN_FLOW_GEN_SLOTS 1024
+#define TRAN_FLOW_GEN_SLOT(vni) ((vni) & (TRAN_FLOW_GEN_SLOTS - 1))
+
+/* CPUMAP size and max number of worker CPUs RX can be spread to */
+#define TRAN_MAX_CPUS 256
+#define TRAN_MAX_SPREAD_CPUS 64
+#define TRAN_DEFAULT_CPUMAP_QSIZE 2048
+
+/* BUM replication: max copies of a frame and VNIs with a flood list */
+#define TRAN_MAX_FLOOD 64
+#define TRAN_MAX_FLOOD_VNI 16*1024
+
+/* Max number of elastic IPs of gateway endpoints */
+#define TRAN_MAX_EIP 64*1024
+
+/*
+ * Policers of VNIs and endpoints. Tokens are kept in 1/1000 units so a
+ * refill every ms adds the per second rate; buckets hold TRAN_RL_BURST_MS
+ * of it. Marked packets get the lower effort outer DSCP (CS1).
+ */
+#define TRAN_MAX_RATE_LIMITS 64*1024
+#define TRAN_RL_DROP 0
+#define TRAN_RL_MARK 1
+#define TRAN_RL_REFILL_NS 1000000ULL
+#define TRAN_RL_BURST_MS 10
+#define TRAN_RL_TOKEN 1000
+#define TRAN_RL_MARK_DSCP 8
+
+/* CPUs that policed a key within this window share its host rates */
+#define TRAN_RL_SHARE_NS (TRAN_CT_SWEEP_INTERVAL * 1000000000ULL)
+
+/*
+ * Slow path miss guard: default upcall budgets of a source host, in
+ * packets per second of each CPU, and of a VNI, of the whole host, and
+ * how long misses of a key the slow path could not resolve are dropped
+ * without upcall.
+ */
+#define TRAN_MAX_MISS_NEG 64*1024
+#define TRAN_MAX_UPCALL_BUCKETS 64*1024
+#define TRAN_DEFAULT_UPCALL_HOST_PPS 2000
+#define TRAN_DEFAULT_UPCALL_VNI_PPS 5000
+#define TRAN_MISS_NEG_TTL_NS 1000000000ULL
+#define TRAN_UPCALL_HOST_VNI 0xffffffff
+
+/* Per droplet options in tunnel_iface_t */
+#define TRAN_ITF_OPT_SPORT_HASH (1 << 0)  // outer UDP sport from inner flow
+#define TRAN_ITF_OPT_HINT_HDR   (1 << 1)  // source host hint in overlay header
+
+/* Outer UDP source ports are picked from the dynamic range, RFC 7348 */
+#define TRAN_UDP_SPORT_MIN 49152
+#define TRAN_UDP_SPORT_MASK 0x3fff
+
+/* Source host hint trailer, appended past the outer IP payload */
+#define TRAN_HINTS_SRC_FLAGS 0x5354
+struct xdp_hints_src {
+	__u16 flags;
+	__u32 vni;
+	__u32 saddr;
+	unsigned char h_source[6];
+} __attribute__((aligned(4))) __attribute__((packed));
+
 /* Size for OAM message queue bpfmap */
 #define TRAN_OAM_QUEUE_LEN 1024
 
 #define turnOn		0
 #define cnOn 		0
-#define sgSupport	1
-#define connTrack	0
-
-#if sgSupport
-#define TRAN_MAX_CIDRS 1024*1024
-#define TRAN_SG_STOP 1
-#define TRAN_SG_PASS 0
 
-#define SG_STATIC_PREFIX (sizeof(__be32) * 8)
-#define SG_PREFIX_LEN(PREFIX) (SG_STATIC_PREFIX + (PREFIX))
-#define SG_IPV4_PREFIX SG_PREFIX_LEN(32)
-#endif
+/*
+ * Transit XDP features selected at load time, transitd writes them to
+ * the trn_features constant so disabled code is removed by the verifier
+ */
+#define TRAN_XDP_FEAT_SG          (1 << 0)  // security group check
+#define TRAN_XDP_FEAT_CONNTRACK   (1 << 1)  // connection tracking
+#define TRAN_XDP_FEAT_APPEND_TAIL (1 << 2)  // source host hints to CN
+#define TRAN_XDP_FEAT_SCALED_EP   (1 << 3)  // scaled endpoint load balancing
+#define TRAN_XDP_FEAT_BUM         (1 << 4)  // tenant BUM replication
+#define TRAN_XDP_FEAT_EIP         (1 << 5)  // elastic IP NAT of gateway endpoints
+#define TRAN_XDP_FEAT_IDENTITY    (1 << 6)  // identity based security policy
+#define TRAN_XDP_FEAT_RATE_LIMIT  (1 << 7)  // per VNI and endpoint policers
+#define TRAN_XDP_FEAT_MISS_GUARD  (1 << 8)  // endpoint miss filtering and upcall budgets
+#define TRAN_XDP_FEAT_DEFAULT     TRAN_XDP_FEAT_SG
+
+/*
+ * Security group classifier compiled by transitd: rule entries of all
+ * VNIs per generation, VNIs with rules and distinct TCP/UDP port ranges
+ * of a VNI, direction and protocol. Ranges split the port space into at
+ * most TRAN_MAX_SG_INTERVALS intervals.
+ */
+#define TRAN_MAX_SG_RULES 256*1024
+#define TRAN_MAX_SG_VNI 16*1024
+#define TRAN_MAX_SG_PORT_RANGES 63
+#define TRAN_MAX_SG_INTERVALS 128
+#define TRAN_MAX_SG_RULES_BATCH 256
+#define TRAN_SG_EGRESS 0
+#define TRAN_SG_INGRESS 1
+#define TRAN_SG_DIRS 2
+#define TRAN_SG_PROTO_ANY 0
+
+/*
+ * Identity policy: verdicts between the security identities of the
+ * endpoints of a VNI, stamped in the overlay header by the source.
+ */
+#define TRAN_MAX_SG_IDENTITY_RULES 256*1024
+#define TRAN_SG_DENY 0
+#define TRAN_SG_ALLOW 1
+
+/*
+ * Connection tracking lets packets of connections opened through the
+ * security groups pass without classification. Entries idle longer than
+ * the timeout of their state (seconds) are stale, transitd sweeps them.
+ */
+#define TRAN_MAX_CT 1024*1024
+#define TRAN_MAX_CT_DUMP 128
+#define TRAN_CT_NEW 0             // no reply seen yet
+#define TRAN_CT_ESTABLISHED 1
+#define TRAN_CT_CLOSING 2         // TCP RST or FIN from both sides
+#define TRAN_CT_TIMEOUT_NEW 30
+#define TRAN_CT_TIMEOUT_CLOSING 10
+#define TRAN_CT_TIMEOUT_TCP 7200
+#define TRAN_CT_TIMEOUT_UDP 180
+#define TRAN_CT_TIMEOUT_ICMP 30
+#define TRAN_CT_SWEEP_INTERVAL 10
+
+#define TRAN_CT_TIMEOUT(protocol, state)                         \
+	((state) == TRAN_CT_NEW ? TRAN_CT_TIMEOUT_NEW :          \
+	 (state) == TRAN_CT_CLOSING ? TRAN_CT_TIMEOUT_CLOSING :  \
+	 (protocol) == IPPROTO_TCP ? TRAN_CT_TIMEOUT_TCP :       \
+	 (protocol) == IPPROTO_ICMP ? TRAN_CT_TIMEOUT_ICMP :     \
+	 TRAN_CT_TIMEOUT_UDP)
 
 /* XDP interface_map keys for packet redirect */
 enum trn_itf_ma_key_t {
@@ -90,7 +217,7 @@ TRAN_ITF_MAP_MAX
 /* Cache related const */
 #define TRAN_MAX_CACHE_SIZE 1000000
 
-/* XDP programs keys in transit XDP tailcall jump table */
+/* Transit XDP main program and the verdicts it runs stage pipelines for */
 enum trn_xdp_prog_id_t {
 	TRAN_TRANSIT_PROG = 0,
 	TRAN_TX_PROG,
@@ -100,6 +227,15 @@ enum trn_xdp_prog_id_t {
 	TRAN_MAX_PROG
 };
 
+/*
+ * Each verdict owns TRAN_MAX_STAGES consecutive jmp_table slots, run in
+ * order; stage_cfg_map flags (1 << trn_xdp_prog_id_t) verdicts having any.
+ */
+#define TRAN_MAX_STAGES 8
+#define TRAN_MAX_STAGE_NAME 32
+#define TRAN_STAGE_SLOT(prog, n) (((prog) - TRAN_TX_PROG) * TRAN_MAX_STAGES + (n))
+#define TRAN_MAX_STAGE_SLOTS TRAN_STAGE_SLOT(TRAN_MAX_PROG, 0)
+
 /* XDP programs roles pass along tail-called bpf programs */
 enum trn_xdp_role_t {
 	XDP_FWD = 0,
@@ -114,6 +250,14 @@ enum trn_ftn_type_t {
     TRAN_FTN_TYPE_TAIL
 };
 
+/* XDP attach mode requested for an interface */
+enum trn_xdp_mode_t {
+	TRAN_XDP_MODE_AUTO = 0,    // native if the driver supports it, else generic
+	TRAN_XDP_MODE_NATIVE,
+	TRAN_XDP_MODE_GENERIC,
+	TRAN_XDP_MODE_MAX
+};
+
 /* Tunnel Interface protocol */
 enum trn_xdp_tunnel_protocol_t {
 	XDP_TUNNEL_VXLAN = 0,
@@ -135,15 +279,22 @@ typedef struct {
 	int itf_protocol;   // from trn_xdp_tunnel_protocol_t
 } trn_xdp_itf_def_t;
 
+/*
+ * Maglev lookup table of a DFT, entries are chain ids. A table_len over
+ * TRAN_MAX_MAGLEV_TABLE_SIZE leaves table unused, the entries are then in
+ * the DFT's own array map of dft_tables_map.
+ */
 struct dft_t {
 	__u32 table_len;
 	__u32 table[TRAN_MAX_MAGLEV_TABLE_SIZE];
 } __attribute__((packed, aligned(4)));
 
+/* Flows of a chain are looked up at its tail FTN */
 struct chain_t {
 	__u32 tail_ftn;
 } __attribute__((packed, aligned(4)));
 
+/* Head and middle FTNs pass packets on to next_ip, the tail delivers */
 struct ftn_t {
 	__u8 position;
 	__u32 ip;
@@ -157,13 +308,55 @@ typedef struct {
 	__u32 ip;
 } __attribute__((packed, aligned(4))) endpoint_key_t;
 
+/*
+ * IPv6 endpoints share endpoint_t, ip is in network byte order. Security
+ * groups and identities are IPv4 only, IPv6 is forwarded to these only
+ * while neither TRAN_XDP_FEAT_SG nor TRAN_XDP_FEAT_IDENTITY is on.
+ */
+typedef struct {
+	__u32 vni;
+	__u32 ip[4];
+} __attribute__((packed, aligned(4))) endpoint_key6_t;
+
+/* scaled_ep_t flags */
+#define TRAN_SCALED_EP_DSR (1 << 0)  // backends reply to clients directly
+
+/*
+ * Backends of a scaled endpoint, keyed by its VIP. A flow picks one by
+ * rendezvous hashing, so a backend set change only moves flows of the
+ * removed backends.
+ */
+struct scaled_ep_t {
+	__u32 nremotes;
+	__u32 flags;
+	__u32 remote_ips[TRAN_MAX_REMOTES];
+} __attribute__((packed, aligned(4)));
+
+/*
+ * Backend a flow to a VIP is pinned to. For direct server return the
+ * client's last TCP ack is kept to account reply bytes bypassing transit.
+ */
+struct scaled_ep_flow_t {
+	__u32 rip;
+	__u32 ack;
+	__u8 dsr;
+	__u8 acked;         // ack is valid
+	__u16 rsvd;
+} __attribute__((packed, aligned(4)));
+
+/*
+ * csum_delta is the outer IPv4 checksum adjustment for redirecting a
+ * packet to hip, ttl decrement included. transitd fills it in on each
+ * update, zero means not precomputed.
+ */
 typedef struct {
 	__u32 hip;
 	unsigned char mac[6];
 	unsigned char hmac[6];
+	__u16 csum_delta;
+	__u16 identity;      // security identity, 0 if none
 } __attribute__((packed, aligned(4))) endpoint_t;
 
-#if connTrack
 struct ipv4_tuple_t {
 	__u32 saddr;
 	__u32 daddr;
@@ -183,53 +376,76 @@ typedef struct {
 	struct ipv4_tuple_t tuple;
 } __attribute__((packed)) contrack_key_t;
 
+/*
+ * Both directions of a connection share its entry, the tuple is ordered
+ * with the lower address (then port) as source. orig is the side that
+ * opened the connection, 0 for the tuple source.
+ */
 typedef struct {
-	__u32 hip;
-	unsigned char mac[6];
-	unsigned char hmac[6];
-} __attribute__((packed, aligned(4))) contrack_t;
-#endif
-
-#if sgSupport
-typedef struct {
-    __u32 prefixlen; /* up to 32 for AF_INET, 128 for AF_INET6*/
-    __u32 vni;
-    __u16 port;
-    __u8  direction;
-    __u8  protocol;
-    __u32 src_ip;
-    __u32 dst_ip;
-} __attribute__((packed, aligned(4))) sg_cidr_key_t;
-
-typedef struct {
-	__u32 sg_id;
-	__u8 action;
-} __attribute__((packed, aligned(4))) sg_cidr_t;
-
-typedef struct {
-    __u32 vni;
-    __u32 ip;
-    __u8  direction;
-} __attribute__((packed, aligned(4))) security_group_key_t;
-
+	__u64 last_seen;     // bpf_ktime_get_ns of the last packet
+	__u8 state;          // TRAN_CT_NEW, TRAN_CT_ESTABLISHED or TRAN_CT_CLOSING
+	__u8 orig;
+	__u8 fin;            // bit per side that sent a TCP FIN
+	__u8 rsvd[5];
+} __attribute__((packed, aligned(8))) contrack_t;
+
+/*
+ * Protocol TRAN_SG_PROTO_ANY and port 0 match any, the most specific
+ * verdict of a packet decides. The value is TRAN_SG_ALLOW or DENY.
+ */
 typedef struct {
-	__u32 sg_id;
-	__u8 action;
-} __attribute__((packed, aligned(4))) security_group_t;
+	__u32 vni;
+	__u16 src_id;
+	__u16 dst_id;
+	__u16 port;          // destination port, host byte order
+	__u8 protocol;
+	__u8 rsvd;
+} __attribute__((packed, aligned(4))) sg_identity_key_t;
 
+/*
+ * Rules of a VNI, direction and protocol with the same remote prefix
+ * are merged into one entry. The value is the mask of port ranges they
+ * allow, protocol agnostic and portless rules allow any (bit 0).
+ */
 typedef struct {
-    __u32 vni;
-    __u32 ip;
-    __u8  direction;
-} __attribute__((packed, aligned(4))) port_range_key_t;
+	__u32 vni;
+	__u32 remote_ip;     // masked to prefixlen
+	__u8 prefixlen;
+	__u8 direction;      // TRAN_SG_EGRESS or TRAN_SG_INGRESS
+	__u8 protocol;       // TRAN_SG_PROTO_ANY matches all
+	__u8 gen;
+} __attribute__((packed, aligned(4))) sg_rule_key_t;
 
 typedef struct {
-    __u16 port_min1;
-    __u16 port_max1;
-    __u16 port_min2;
-	__u16 port_max2;
-} __attribute__((packed, aligned(4))) port_range_t;
-#endif
+	__u32 vni;
+	__u8 direction;
+	__u8 protocol;       // IPPROTO_TCP or IPPROTO_UDP
+	__u8 gen;
+	__u8 rsvd;
+} __attribute__((packed, aligned(4))) sg_ports_key_t;
+
+/*
+ * Port classes of a VNI, direction and protocol: sorted interval starts
+ * (host byte order, start[0] is 0) and the port ranges each falls in.
+ */
+struct sg_ports_t {
+	__u32 nintervals;
+	__u16 start[TRAN_MAX_SG_INTERVALS];
+	__u64 ranges[TRAN_MAX_SG_INTERVALS];
+} __attribute__((packed, aligned(8)));
+
+/*
+ * Classifier of a VNI. Bit n of prefixes is set if rules of a protocol
+ * have remote prefix length n, of any_prefixes for protocol agnostic
+ * ones, so a packet only probes the prefix lengths in use. gen selects
+ * the table generation, transitd fills the other one and flips it.
+ */
+struct sg_vni_t {
+	__u64 prefixes[TRAN_SG_DIRS];
+	__u64 any_prefixes[TRAN_SG_DIRS];
+	__u8 gen;
+	__u8 rsvd[7];
+} __attribute__((packed, aligned(8)));
 
 typedef struct {
 	__u32 ip;   // IP used for ZGC access
@@ -237,6 +453,18 @@ typedef struct {
 	__u8 mac[6]; // MAC to be used for ZGC entrance
 } __attribute__((packed, aligned(4))) zgc_entrance_t;
 
+typedef struct {
+	__u32 iface_index;
+	__u8 mac[6];
+	__u16 pad;
+} __attribute__((packed, aligned(4))) entrance_key_t;
+
+typedef struct {
+	__u32 ip;    // IP of the entrance
+	__u16 idx;   // index into tunnel_iface_t entrances
+	__u16 pad;
+} __attribute__((packed, aligned(4))) entrance_t;
+
 /* Should call it overlay interface */
 struct tunnel_iface_t {
 	__u32 iface_index;
@@ -244,6 +472,9 @@ struct tunnel_iface_t {
 	__u8 protocol;     // value from trn_xdp_tunnel_protocol_t
 	__u8 role;         // value from trn_xdp_role_t
 	__u32 num_entrances;  // number of valid entries in entrances array
+	__u32 options;        // bitmask of TRAN_ITF_OPT_*
+	__u32 dft_id;         // DFT of flows missing an endpoint, or TRAN_UNUSED_DFT_ID
+	__u32 ftn_id;         // FTN served on the interface, or TRAN_UNUSED_FTN_ID
 	zgc_entrance_t entrances[TRAN_MAX_ZGC_ENTRANCES];
 } __attribute__((packed, aligned(4)));
 
@@ -256,6 +487,148 @@ typedef struct {
 	__u8 vni[3];
 } __attribute__((packed, aligned(4))) ipv4_flow_t;
 
+/* Cached verdict and rewrite result of a forwarded flow */
+typedef struct {
+	__u32 gen;         // flow_gen_map slot generation when cached
+	__u32 action;      // final verdict, XDP_TX or XDP_DROP
+	endpoint_t ep;     // rewrite target if XDP_TX
+} __attribute__((packed, aligned(4))) flow_cache_entry_t;
+
+/* Flow cache counters, one instance per CPU */
+typedef struct {
+	__u64 hit;
+	__u64 miss;
+	__u64 evict;       // entries dropped for stale generation
+	__u64 insert;
+} __attribute__((packed, aligned(8))) flow_cache_stats_t;
+
+/* Scaled endpoint counters, one instance per CPU */
+typedef struct {
+	__u64 dsr_flows;   // flows pinned in direct server return mode
+	__u64 dsr_bytes;   // TCP reply bytes acked by clients of DSR flows
+} __attribute__((packed, aligned(8))) scaled_ep_stats_t;
+
+/*
+ * Policer of a VNI (ip 0 in its endpoint_key_t) or of an endpoint. pps
+ * and bps are the share of each policing CPU of the host rates, 0 is
+ * unlimited. gen changes on every update so buckets restart full with
+ * the new rates, resizing shares keeps it.
+ */
+struct rate_limit_t {
+	__u64 pps;         // packets per second of each CPU
+	__u64 bps;         // bytes per second of each CPU
+	__u64 host_pps;    // packets per second of the host
+	__u64 host_bps;    // bytes per second of the host
+	__u32 gen;
+	__u8 action;       // TRAN_RL_DROP or TRAN_RL_MARK
+	__u8 rsvd[3];
+} __attribute__((packed, aligned(8)));
+
+/* Token bucket of a policer, one instance per CPU */
+typedef struct {
+	__u64 refill_ns;   // time of the last refill
+	__u64 pkt_tokens;
+	__u64 byte_tokens;
+	__u32 gen;         // rate_limit_t gen the bucket was filled for
+	__u32 rsvd;
+} __attribute__((packed, aligned(8))) rate_bucket_t;
+
+/* Policer counters of a VNI, one instance per CPU */
+typedef struct {
+	__u64 marked;      // out of profile packets sent marked
+	__u64 dropped;     // out of profile packets dropped
+	__u64 dropped_bytes;
+} __attribute__((packed, aligned(8))) rate_limit_stats_t;
+
+/*
+ * Upcall budget of a VNI (hip 0) or of a source host (vni is
+ * TRAN_UPCALL_HOST_VNI, not a valid VNI)
+ */
+typedef struct {
+	__u32 vni;
+	__u32 hip;
+} __attribute__((packed, aligned(4))) upcall_key_t;
+
+/* Upcall budgets in packets per second of each CPU */
+typedef struct {
+	__u64 host_pps;    // whole budget of a source host
+	__u64 vni_pps;     // share of the budget of a VNI
+	__u32 gen;
+	__u32 rsvd;
+} __attribute__((packed, aligned(8))) upcall_cfg_t;
+
+/* Endpoint miss counters, one instance per CPU */
+typedef struct {
+	__u64 admitted;        // misses sent to the slow path
+	__u64 negative;        // misses of keys the slow path couldn't resolve
+	__u64 throttled_host;  // misses over the budget of their source host
+	__u64 throttled_vni;   // misses over the budget of their VNI
+} __attribute__((packed, aligned(8))) upcall_stats_t;
+
+/* A host BUM frames of a VNI are replicated to */
+struct flood_host_t {
+	__u32 ip;
+	unsigned char mac[6];
+} __attribute__((packed));
+
+/*
+ * Flood list of a VNI. A BUM frame is copied to the first cap hosts,
+ * all of them if cap is 0, except the host it came from.
+ */
+struct flood_list_t {
+	__u32 nhosts;
+	__u32 cap;
+	struct flood_host_t hosts[TRAN_MAX_FLOOD];
+} __attribute__((packed, aligned(4)));
+
+/* BUM replication counters of a VNI, one instance per CPU */
+typedef struct {
+	__u64 frames;      // BUM frames received
+	__u64 copies;      // copies sent to hosts
+	__u64 capped;      // frames whose flood list was cut by the cap
+	__u64 dropped;     // frames of VNIs without flood list
+	__u64 rejected;    // Geneve frames, only VxLAN is flooded
+} __attribute__((packed, aligned(8))) flood_stats_t;
+
+/*
+ * External side of gateway endpoints. Packets leave decapsulated on
+ * ifindex from mac to the upstream router gw_mac; replies go back to
+ * the endpoint's host in VXLAN from tunnel_ip and tunnel_mac.
+ */
+struct eip_gw_t {
+	__u32 ifindex;
+	__u32 tunnel_ip;
+	unsigned char mac[6];
+	unsigned char gw_mac[6];
+	unsigned char tunnel_mac[6];
+	__u16 rsvd;
+} __attribute__((packed, aligned(4)));
+
+/* Elastic IP NAT counters, one instance per CPU */
+typedef struct {
+	__u64 snat_pkts;   // packets of gateway endpoints sent out
+	__u64 dnat_pkts;   // packets to elastic IPs sent to their endpoint
+	__u64 dropped;     // packets to elastic IPs denied, without endpoint or ttl
+} __attribute__((packed, aligned(8))) eip_stats_t;
+
+/* RX spreading config, disabled if num_cpus is 0 */
+typedef struct {
+	__u32 num_cpus;    // number of valid entries in cpus_available
+} cpu_spread_cfg_t;
+
+/* RX spreading counters, one instance per CPU */
+typedef struct {
+	__u64 redirected;  // packets this CPU received and redirected
+	__u64 processed;   // packets this CPU forwarded as worker
+	__u64 missed;      // endpoint misses this CPU upcalled as worker
+} __attribute__((packed, aligned(8))) cpu_spread_stats_t;
+
+/* Pipeline stage counters by jmp_table slot, one instance per CPU */
+typedef struct {
+	__u64 runs;
+	__u64 run_ns;      // time spent in the stage
+} __attribute__((packed, aligned(8))) stage_stats_t;
+
 struct remote_endpoint_t {
 	__u32 ip;
 	unsigned char mac[6];
@@ -22,6 +22,7 @@
 
 import logging
 import json
+import re
 from common.common import run_cmd
 from common.constants import KIND
 
@@ -48,8 +49,9 @@ class TrnRpc:
         self.trn_cli_get_ep = f'''{self.trn_cli} get-ep -j'''
         self.trn_cli_delete_dft = f'''{self.trn_cli} delete-dft -j'''
         self.trn_cli_delete_chain = f'''{self.trn_cli} delete-chain -j'''
-        self.trn_cli_delete_ftn = f'''{self.trn_cli} delete-ep -j'''
+        self.trn_cli_delete_ftn = f'''{self.trn_cli} delete-ftn -j'''
         self.trn_cli_delete_ep = f'''{self.trn_cli} delete-ep -j'''
+        self.trn_cli_get_ep_misses = f'''{self.trn_cli} get-ep-misses'''
         self.trn_cli_load_ebpf_prog = f'''{self.trn_cli} load-ebpf-prog -j'''
         self.trn_cli_unload_ebpf_prog = f'''{self.trn_cli} unload-ebpf-prog -j'''
 
@@ -255,3 +257,10 @@ class TrnRpc:
         logger.info(log_string)
         returncode, text = run_cmd(cmd)
         logger.info("returns {} {}".format(returncode, text))
+
+    def get_ep_misses(self):
+        """Endpoints transitd could not resolve as (vni, ip) tuples"""
+        cmd = f'''{self.trn_cli_get_ep_misses}'''
+        returncode, text = run_cmd(cmd)
+        return [(int(vni), ip) for vni, ip in
+                re.findall(r'VNI: (\d+) IP: ([\d.]+)', text)]
@@ -66,8 +66,9 @@ def create_app(script_info=None):
     from project.api.hosts import hosts_blueprint
     app.register_blueprint(hosts_blueprint)
 
-    from project.api.eps import eps_blueprint
+    from project.api.eps import eps_blueprint, eps_start_miss_poller
     app.register_blueprint(eps_blueprint)
+    eps_start_miss_poller(app)
     
     from project.api.default_setup import default_setup_blueprint
     app.register_blueprint(default_setup_blueprint)
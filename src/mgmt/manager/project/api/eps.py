@@ -6,18 +6,84 @@
 # Summary: EndPoint table for NBI API
 #
 import os
+import logging
+import threading
+import time
 
 from flask import (
     Blueprint, jsonify, request
 )
 
-from project.api.models import EP
+from project.api.models import EP, Port, Host
+from project.api.settings import node_ips, vnis
+from project.api.utils import ip_to_int, mac_to_int
 from project import db
+from common.rpc import TrnRpc
 
+# Make sure matching TRAN_MAX_EP_BATCH_SIZE in trn_datamodel.h
+EP_BATCH_MAX = 256
+# Keep well below TRN_XSK_PARK_TIMEOUT_MS in trn_transit_xsk_usr.h
+EP_MISS_POLL_INTERVAL = 0.5
+
+logger = logging.getLogger()
 
 eps_blueprint = Blueprint('eps', __name__)
 
 
+def eps_resolve_miss(vni, ip):
+    vpc_ids = [vpc_id for vpc_id, v in vnis.items() if int(v) == vni]
+    ep = EP.query.join(Port).filter(
+        EP.ip == ip, Port.vpc_id.in_(vpc_ids)).first()
+    if ep is None:
+        return None
+    port = Port.query.filter_by(port_id=ep.port_id).first()
+    if port is None:
+        return None
+    host = Host.query.filter_by(host_id=port.host_id).first()
+    if host is None:
+        return None
+    return {
+        "vni": vni,
+        "ip": ip_to_int(ip),
+        "hip": ip_to_int(host.ip_node),
+        "mac": mac_to_int(port.mac_port),
+        "hmac": mac_to_int(host.mac_node)
+    }
+
+
+def eps_answer_misses():
+    """Send each node the endpoints its slow path could not resolve"""
+    for node_ip in list(node_ips):
+        rpc = TrnRpc(node_ip)
+        eps = []
+        for vni, ip in rpc.get_ep_misses():
+            ep_rpc = eps_resolve_miss(vni, ip)
+            if ep_rpc is None:
+                logger.debug('Unknown endpoint {} {} missed on {}'.format(
+                    vni, ip, node_ip))
+                continue
+            eps.append(ep_rpc)
+        for i in range(0, len(eps), EP_BATCH_MAX):
+            eps_chunk = eps[i:i + EP_BATCH_MAX]
+            rpc.update_ep({'size': len(eps_chunk), 'eps': eps_chunk})
+        del rpc
+
+
+def eps_start_miss_poller(app):
+    def poll():
+        while True:
+            time.sleep(EP_MISS_POLL_INTERVAL)
+            with app.app_context():
+                try:
+                    eps_answer_misses()
+                except Exception as e:
+                    logger.error('Answering endpoint misses: {}'.format(e))
+                finally:
+                    db.session.remove()
+
+    threading.Thread(target=poll, daemon=True).start()
+
+
 @eps_blueprint.route('/eps', methods=['GET'])
 def all_eps():
     response_object = [ep.to_json() for ep in EP.query.all()]
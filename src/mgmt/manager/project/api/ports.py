@@ -23,7 +23,7 @@ from project import db
 from common.rpc import TrnRpc
 
 # Make sure matching TRAN_MAX_EP_BATCH_SIZE in trn_datamodel.h
-EP_BATCH_MAX = 360
+EP_BATCH_MAX = 256
 
 logger = logging.getLogger()
 
@@ -58,10 +58,12 @@ struct rpc_endpoint_t {
 	uint32_t hip;
 	uint8_t mac[6];
 	uint8_t hmac[6];
+	uint16_t csum_delta;
+	uint16_t rsvd;
 };
 */
 struct rpc_trn_endpoint_t {
-       uint64_t buf64[3];
+       uint64_t buf64[4];
 };
 
 /* endpoints batch, watch for 8k buffer limit over UDP */
@@ -72,6 +74,181 @@ struct rpc_trn_droplet_t {
        rpc_intf_name interface;
        uint32_t num_entrances;
        rpc_addr_t entrances[TRAN_MAX_ZGC_ENTRANCES];
+       uint32_t options;
+       uint32_t dft_id;
+       uint32_t ftn_id;
+};
+
+/* Defines a DFT, table is its Maglev lookup table of chain ids */
+struct rpc_trn_dft_t {
+       uint32_t id;
+       uint32_t table<TRAN_MAX_DFT_TABLE_SIZE>;
+};
+
+/* Defines a chain of FTNs */
+struct rpc_trn_chain_t {
+       uint32_t id;
+       uint32_t tail_ftn;
+};
+
+/* Defines an FTN and the next one in its chain */
+struct rpc_trn_ftn_t {
+       uint32_t id;
+       uint32_t position;        /* trn_ftn_type_t */
+       uint32_t ip;
+       uint8_t mac[6];
+       uint32_t next_ip;
+       uint8_t next_mac[6];
+};
+
+/* Defines a scaled endpoint, flows to ip are balanced over remote_ips */
+struct rpc_trn_scaled_ep_t {
+       uint32_t vni;
+       uint32_t ip;
+       uint32_t flags;           /* TRAN_SCALED_EP_* */
+       uint32_t remote_ips<TRAN_MAX_REMOTES>;
+};
+
+/* Scaled endpoint counters summed over all CPUs */
+struct rpc_trn_scaled_ep_stats_t {
+       uint64_t dsr_flows;
+       uint64_t dsr_bytes;
+};
+
+/* Key of per-VNI objects */
+struct rpc_trn_vni_key_t {
+       uint32_t vni;
+};
+
+/* Defines the flood list of a VNI, cap 0 copies to all hosts */
+struct rpc_trn_flood_list_t {
+       uint32_t vni;
+       uint32_t cap;
+       rpc_addr_t hosts<TRAN_MAX_FLOOD>;
+};
+
+/* BUM replication counters of a VNI summed over all CPUs */
+struct rpc_trn_flood_stats_t {
+       uint64_t frames;
+       uint64_t copies;
+       uint64_t capped;
+       uint64_t dropped;
+       uint64_t rejected;
+};
+
+/* Defines the elastic IP of a gateway endpoint */
+struct rpc_trn_eip_t {
+       uint32_t vni;
+       uint32_t ip;
+       uint32_t eip;
+};
+
+/* Defines the external interface of gateway endpoints */
+struct rpc_trn_eip_gw_t {
+       rpc_intf_name interface;
+       uint32_t xdp_mode;        /* trn_xdp_mode_t */
+       uint8_t mac[6];
+       uint8_t gw_mac[6];        /* upstream router */
+       uint32_t tunnel_ip;       /* VXLAN source toward endpoint hosts */
+       uint8_t tunnel_mac[6];
+};
+
+/* Elastic IP NAT counters summed over all CPUs */
+struct rpc_trn_eip_stats_t {
+       uint64_t snat_pkts;
+       uint64_t dnat_pkts;
+       uint64_t dropped;
+};
+
+/*
+ * Defines the policer of a VNI, or of its endpoint ip if not 0. Rates
+ * are of the host, 0 is unlimited. Each CPU policing the key enforces an
+ * equal share, resized every few seconds to the CPUs its traffic was
+ * seen on, so the rates hold on average: briefly exceeded while traffic
+ * spreads to more CPUs, undershot while it leaves some.
+ */
+struct rpc_trn_rate_limit_t {
+       uint32_t vni;
+       uint32_t ip;
+       uint64_t pps;
+       uint64_t bps;             /* bytes per second */
+       uint32_t action;          /* TRAN_RL_DROP or TRAN_RL_MARK */
+};
+
+/* Policer counters of a VNI summed over all CPUs */
+struct rpc_trn_rate_limit_stats_t {
+       uint64_t marked;
+       uint64_t dropped;
+       uint64_t dropped_bytes;
+};
+
+/* Defines an IPv6 endpoint, ip is in network byte order */
+struct rpc_endpoint6_key_t {
+       uint32_t vni;
+       uint32_t ip[4];
+};
+
+struct rpc_trn_endpoint6_t {
+       uint32_t vni;
+       uint32_t ip[4];
+       uint32_t hip;
+       uint8_t mac[6];
+       uint8_t hmac[6];
+};
+
+/* Defines a security group rule, ports apply to TCP and UDP only */
+struct rpc_trn_sg_rule_t {
+       uint32_t direction;       /* TRAN_SG_EGRESS or TRAN_SG_INGRESS */
+       uint32_t protocol;        /* TRAN_SG_PROTO_ANY for all */
+       uint32_t cidr;
+       uint32_t prefixlen;
+       uint16_t port_min;
+       uint16_t port_max;
+};
+
+/* Security group rules of a VNI, append adds to the rules already set */
+struct rpc_trn_sg_rules_t {
+       uint32_t vni;
+       uint32_t append;
+       rpc_trn_sg_rule_t rules<TRAN_MAX_SG_RULES_BATCH>;
+};
+
+/* Identity policy verdict, protocol TRAN_SG_PROTO_ANY and port 0 match any */
+struct rpc_trn_sg_identity_rule_t {
+       uint32_t vni;
+       uint16_t src_id;
+       uint16_t dst_id;
+       uint32_t protocol;
+       uint16_t port;
+       uint32_t verdict;         /* TRAN_SG_ALLOW or TRAN_SG_DENY */
+};
+
+struct rpc_trn_sg_identity_rules_t {
+       rpc_trn_sg_identity_rule_t rules<TRAN_MAX_SG_RULES_BATCH>;
+};
+
+/* Selects the tracked connections of a VNI, or of all VNIs */
+struct rpc_trn_ct_filter_t {
+       uint32_t vni;
+       uint32_t all_vnis;
+};
+
+/* A tracked connection, addresses and ports of the side that opened it */
+struct rpc_trn_ct_entry_t {
+       uint32_t vni;
+       uint32_t saddr;
+       uint32_t daddr;
+       uint16_t sport;
+       uint16_t dport;
+       uint32_t protocol;
+       uint32_t state;           /* TRAN_CT_* */
+       uint32_t idle;            /* seconds since the last packet */
+};
+
+/* Up to TRAN_MAX_CT_DUMP of the total selected connections */
+struct rpc_trn_ct_list_t {
+       uint32_t total;
+       rpc_trn_ct_entry_t entries<TRAN_MAX_CT_DUMP>;
 };
 
 /* Defines interfaces for xdp prog to attach/detatch */
@@ -79,6 +256,12 @@ struct rpc_trn_xdp_intf_t {
        rpc_intf_name interfaces[TRAN_ITF_MAP_MAX];
        uint16_t ibo_port;
        uint32_t debug_mode;
+       uint32_t spread_cpus<TRAN_MAX_SPREAD_CPUS>; /* no stages, misses dropped */
+       uint32_t cpumap_qsize;
+       uint32_t xdp_modes[TRAN_ITF_MAP_MAX];
+       uint32_t features;
+       uint32_t upcall_host_pps;  /* slow path budget of a source host on each CPU */
+       uint32_t upcall_vni_pps;   /* slow path budget of a VNI */
 };
 
 /* Defines an ebpf program at path to be loaded */
@@ -87,6 +270,91 @@ struct rpc_trn_ebpf_prog_t {
        uint32_t debug_mode;
 };
 
+/* Defines a stage program in the pipeline of a verdict */
+struct rpc_trn_xdp_stage_t {
+       string name<TRAN_MAX_STAGE_NAME>;
+       string path<TRAN_MAX_PATH_SIZE>;  /* object file, insert only */
+       uint32_t prog_idx;                /* verdict, trn_xdp_prog_id_t */
+       uint32_t position;                /* appended if past the end */
+};
+
+/* Counters of a pipeline stage */
+struct rpc_trn_xdp_stage_stats_t {
+       string name<TRAN_MAX_STAGE_NAME>;
+       uint32_t prog_idx;
+       uint32_t position;
+       uint64_t runs;
+       uint64_t run_ns;
+};
+
+/* Counters of all pipeline stages, in pipeline order */
+struct rpc_trn_xdp_stage_stats_list_t {
+       rpc_trn_xdp_stage_stats_t stages<TRAN_MAX_STAGE_SLOTS>;
+};
+
+/* AF_XDP slow path counters of one rx queue */
+struct rpc_trn_xsk_queue_stats_t {
+       uint32_t queue_id;
+       uint64_t upcalls;
+       uint64_t resolved;
+       uint64_t unresolved;
+       uint64_t parked;
+       uint64_t reinjected;
+       uint64_t tx_errors;
+};
+
+/* Endpoint transitd could not resolve, answered with update-ep */
+struct rpc_trn_ep_miss_t {
+       uint32_t vni;
+       uint32_t ip;
+       uint32_t packets;
+};
+
+/* Misses since the last query, drained on read */
+struct rpc_trn_ep_miss_list_t {
+       rpc_trn_ep_miss_t misses<TRAN_MAX_EP_MISSES>;
+};
+
+/* Endpoint miss counters summed over all CPUs */
+struct rpc_trn_upcall_stats_t {
+       uint64_t admitted;
+       uint64_t negative;
+       uint64_t throttled_host;
+       uint64_t throttled_vni;
+};
+
+/* AF_XDP slow path counters of an interface */
+struct rpc_trn_xsk_stats_t {
+       rpc_trn_xsk_queue_stats_t queues<TRAN_MAX_XSK_QUEUES>;
+};
+
+/* Flow cache counters summed over all CPUs */
+struct rpc_trn_flow_cache_stats_t {
+       uint64_t hit;
+       uint64_t miss;
+       uint64_t evict;
+       uint64_t insert;
+};
+
+/* RX spreading counters of one CPU */
+struct rpc_trn_cpu_spread_stats_t {
+       uint32_t cpu;
+       uint64_t redirected;
+       uint64_t processed;
+       uint64_t missed;
+};
+
+/* RX spreading counters of CPUs that saw traffic */
+struct rpc_trn_cpu_spread_stats_list_t {
+       rpc_trn_cpu_spread_stats_t cpus<TRAN_MAX_CPUS>;
+};
+
+/* XDP mode in effect on an interface */
+struct rpc_trn_xdp_mode_t {
+       uint32_t mode;
+       uint32_t prog_id;
+};
+
 /*----- Protocol. -----*/
 
 program RPC_TRANSIT_REMOTE_PROTOCOL {
@@ -102,6 +370,55 @@ program RPC_TRANSIT_REMOTE_PROTOCOL {
                 rpc_trn_endpoint_t GET_EP(rpc_endpoint_key_t) = 7;
                 
                 int UPDATE_DROPLET(rpc_trn_droplet_t) = 8;
+
+                rpc_trn_xsk_stats_t GET_XSK_STATS(rpc_intf_name) = 9;
+                rpc_trn_flow_cache_stats_t GET_FLOW_CACHE_STATS(void) = 10;
+                rpc_trn_cpu_spread_stats_list_t GET_CPU_SPREAD_STATS(void) = 11;
+                rpc_trn_xdp_mode_t GET_XDP_MODE(rpc_intf_name) = 12;
+
+                int INSERT_XDP_STAGE(rpc_trn_xdp_stage_t) = 13;
+                int REMOVE_XDP_STAGE(rpc_trn_xdp_stage_t) = 14;
+                rpc_trn_xdp_stage_stats_list_t GET_XDP_STAGE_STATS(void) = 15;
+
+                int UPDATE_DFT(rpc_trn_dft_t) = 16;
+                int DELETE_DFT(rpc_trn_arion_key_t) = 17;
+                rpc_trn_dft_t GET_DFT(rpc_trn_arion_key_t) = 18;
+
+                int UPDATE_CHAIN(rpc_trn_chain_t) = 19;
+                int DELETE_CHAIN(rpc_trn_arion_key_t) = 20;
+                rpc_trn_chain_t GET_CHAIN(rpc_trn_arion_key_t) = 21;
+
+                int UPDATE_FTN(rpc_trn_ftn_t) = 22;
+                int DELETE_FTN(rpc_trn_arion_key_t) = 23;
+                rpc_trn_ftn_t GET_FTN(rpc_trn_arion_key_t) = 24;
+
+                int UPDATE_SCALED_EP(rpc_trn_scaled_ep_t) = 25;
+                int DELETE_SCALED_EP(rpc_endpoint_key_t) = 26;
+                rpc_trn_scaled_ep_t GET_SCALED_EP(rpc_endpoint_key_t) = 27;
+                rpc_trn_scaled_ep_stats_t GET_SCALED_EP_STATS(void) = 28;
+                int UPDATE_FLOOD_LIST(rpc_trn_flood_list_t) = 29;
+                int DELETE_FLOOD_LIST(rpc_trn_vni_key_t) = 30;
+                rpc_trn_flood_list_t GET_FLOOD_LIST(rpc_trn_vni_key_t) = 31;
+                rpc_trn_flood_stats_t GET_FLOOD_STATS(rpc_trn_vni_key_t) = 32;
+                int UPDATE_EIP(rpc_trn_eip_t) = 33;
+                int DELETE_EIP(rpc_endpoint_key_t) = 34;
+                rpc_trn_eip_t GET_EIP(rpc_endpoint_key_t) = 35;
+                int UPDATE_EIP_GATEWAY(rpc_trn_eip_gw_t) = 36;
+                rpc_trn_eip_stats_t GET_EIP_STATS(void) = 37;
+                int UPDATE_EP6(rpc_trn_endpoint6_t) = 38;
+                int DELETE_EP6(rpc_endpoint6_key_t) = 39;
+                rpc_trn_endpoint6_t GET_EP6(rpc_endpoint6_key_t) = 40;
+                int UPDATE_SG_RULES(rpc_trn_sg_rules_t) = 41;
+                int DELETE_SG_RULES(rpc_trn_vni_key_t) = 42;
+                rpc_trn_ct_list_t DUMP_CONNTRACK(rpc_trn_ct_filter_t) = 43;
+                int FLUSH_CONNTRACK(rpc_trn_ct_filter_t) = 44;
+                int UPDATE_SG_IDENTITY_RULES(rpc_trn_sg_identity_rules_t) = 45;
+                int DELETE_SG_IDENTITY_RULE(rpc_trn_sg_identity_rule_t) = 46;
+                int UPDATE_RATE_LIMIT(rpc_trn_rate_limit_t) = 47;
+                int DELETE_RATE_LIMIT(rpc_endpoint_key_t) = 48;
+                rpc_trn_rate_limit_stats_t GET_RATE_LIMIT_STATS(rpc_trn_vni_key_t) = 49;
+                rpc_trn_upcall_stats_t GET_UPCALL_STATS(void) = 50;
+                rpc_trn_ep_miss_list_t GET_EP_MISSES(void) = 51;
           } = 1;
 
 } =  0x20009051;
@@ -27,7 +27,9 @@
 #pragma once
 
 #include <linux/bpf.h>
+#include <linux/icmpv6.h>
 #include <linux/ip.h>
+#include <linux/ipv6.h>
 #include <linux/udp.h>
 #include <linux/tcp.h>
 #include <stddef.h>
@@ -60,6 +62,21 @@
 #define TRN_GNV_OPT_CLASS 0x0111
 #define TRN_GNV_RTS_OPT_TYPE 0x48
 #define TRN_GNV_SCALED_EP_OPT_TYPE 0x49
+#define TRN_GNV_IDENTITY_OPT_TYPE 0x4a
+
+/*
+ * Source host hint in VXLAN header: a reserved flag bit (0x40 of the
+ * flags byte, in rsvd2) marks it, the host IP takes rsvd3 and rsvd4.
+ * This overlaps the VXLAN-GBP group id, transitd refuses hint_hdr
+ * droplets when identity policy is loaded.
+ */
+#define TRN_VXLAN_HINT_FLAG 0x4
+
+/*
+ * VXLAN-GBP: the G flag (0x80 of the flags byte, in rsvd2) marks the
+ * security identity of the source in rsvd3[1] and rsvd3[2].
+ */
+#define TRN_VXLAN_GBP_FLAG 0x8
 
 /* Scaled endpoint messages type */
 #define TRN_SCALED_EP_MODIFY 0x4d // (M: Modify)
@@ -68,7 +85,26 @@
 #define __inline inline __attribute__((always_inline))
 #endif
 
-const int appendTail = 0;
+/*
+ * TRAN_XDP_FEAT_* set by transitd before load. Being the only .rodata
+ * variable, the verifier sees it as constant and prunes disabled paths.
+ */
+const volatile __u32 trn_features = TRAN_XDP_FEAT_DEFAULT;
+
+#define trn_feature(feat) (trn_features & (feat))
+
+/*
+ * Objects built with -DTRN_XDP_ROLE=<trn_xdp_role_t> serve one interface
+ * role only, role checks fold at compile time and the overlay parsing
+ * path of the other role is left out.
+ */
+#ifdef TRN_XDP_ROLE
+#define trn_itf_role(pkt) (TRN_XDP_ROLE)
+#define TRN_ROLE_ENABLED(role) ((role) == TRN_XDP_ROLE)
+#else
+#define trn_itf_role(pkt) ((pkt)->itf->role)
+#define TRN_ROLE_ENABLED(role) 1
+#endif
 
 struct trn_gnv_scaled_ep_data {
 	__u8 msg_type;
@@ -86,6 +122,19 @@ struct trn_gnv_scaled_ep_opt {
 	struct trn_gnv_scaled_ep_data scaled_ep_data;
 } __attribute__((packed, aligned(4)));
 
+/* Optional, follows the scaled endpoint option */
+struct trn_gnv_identity_opt {
+	__be16 opt_class;
+	__u8 type;
+	__u8 length : 5;
+	__u8 r3 : 1;
+	__u8 r2 : 1;
+	__u8 r1 : 1;
+	/* opt data */
+	__be16 identity;
+	__u16 rsvd;
+} __attribute__((packed, aligned(4)));
+
 struct trn_gnv_rts_data {
 	__u8 match_flow : 1;
 	struct remote_endpoint_t host;
@@ -135,6 +184,36 @@ struct vxlanhdr {
 	__u8 rsvd4;
 };
 
+/*
+ * Parse descriptor the transit program leaves in the XDP metadata area
+ * before tail calling a stage of jmp_table, so stages reuse its parsing.
+ * Offsets are from the start of the frame, zero if not parsed. The
+ * kernel limits metadata to 32 bytes.
+ */
+struct trn_xdp_meta {
+	__u16 flags;        // TRN_XDP_META_*
+	__u8 l3_off;        // outer IP
+	__u8 l4_off;        // outer UDP
+	__u16 ovl_off;      // VXLAN or Geneve header
+	__u16 inner_l2_off;
+	__u16 inner_l3_off; // inner IP or ARP
+	__u16 inner_l4_off; // inner TCP or UDP
+	__u32 vni;
+	__u32 hash;         // inner flow hash
+	__u32 ep_hip;       // host of the target endpoint
+	__u8 stage;         // jmp_table slot of the running stage
+	__u8 action;        // verdict of the running pipeline
+	__u16 chain;        // DFT chain of the flow, below TRAN_MAX_CHAIN
+	__u16 rsvd;
+} __attribute__((packed, aligned(4)));
+
+_Static_assert(sizeof(struct trn_xdp_meta) <= 32,
+	       "XDP metadata is limited to 32 bytes");
+
+#define TRN_XDP_META_HASH (1 << 0)  // hash is valid
+#define TRN_XDP_META_EP (1 << 1)    // target endpoint resolved
+#define TRN_XDP_META_CHAIN (1 << 2) // chain selected from the DFT
+
 struct transit_packet {
 	void *data;
 	void *data_end;
@@ -147,6 +226,8 @@ struct transit_packet {
 
 	__u16 ent_idx;       // entrance index in tunnel_iface_t
 	__u8 itf_mac[6];
+	__u32 ent_ip;        // IP of the entrance matched by dest MAC
+	__u32 miss_ip;       // IPv4 endpoint missed in the VNI, 0 if none
 
 	/* xdp*/
 	struct xdp_md *xdp;
@@ -174,7 +255,8 @@ struct transit_packet {
 	
 	/* overlay network ID */
 	__u32 vni;
-	__u32 pad1;
+	__u16 src_identity;  // security identity stamped by the source, or 0
+	__u16 pad1;
 
 	/* Inner ethernet */
 	struct ethhdr *inner_eth;
@@ -185,29 +267,72 @@ struct transit_packet {
 	/* Inner IP */
 	struct iphdr *inner_ip;
 
+	/* Inner IPv6 */
+	struct ipv6hdr *inner_ip6;
+
 	/* Inner udp */
 	struct udphdr *inner_udp;
 
 	/* Inner tcp */
 	struct tcphdr *inner_tcp;
 
+	/* Handed to tail-called stages */
+	struct trn_xdp_meta meta;
+
 	flow_ctx_t fctx;	// keep this at last
 
 	// TODO: Inner UDP or TCP
 } __attribute__((packed, aligned(8)));
 
-struct xdp_hints_src {
-	__u16 flags;
-	__u32 vni;
-	__u32 saddr;
-	unsigned char h_source[6];
-} __attribute__((aligned(4))) __attribute__((packed));
+/* Neighbor discovery, RFC 4861 */
+#define TRN_NDP_NS 135
+#define TRN_NDP_NA 136
+#define TRN_NDP_OPT_SLLA 1
+#define TRN_NDP_OPT_TLLA 2
+#define TRN_NDP_HOP_LIMIT 255
+#define TRN_NDP_NA_FLAGS 0x60000000   // solicited | override
+
+/* Solicitation or advertisement carrying one link-layer address option */
+struct trn_ndp_msg {
+	struct icmp6hdr icmp;
+	__be32 target[4];
+	__u8 opt_type;
+	__u8 opt_len;        // in units of 8 octets
+	unsigned char lladdr[6];
+} __attribute__((packed));
+
+/* Parse descriptor left by the transit program, NULL if there is none */
+__ALWAYS_INLINE__
+static inline struct trn_xdp_meta *trn_get_xdp_meta(struct xdp_md *ctx)
+{
+	struct trn_xdp_meta *meta = (void *)(long)ctx->data_meta;
 
+	if (meta + 1 > (void *)(long)ctx->data)
+		return NULL;
+
+	return meta;
+}
+
+/* Hash of the inner 5-tuple, the flow must be parsed into fctx */
 __ALWAYS_INLINE__
 static inline __u32 trn_get_inner_packet_hash(struct transit_packet *pkt)
 {
-	// TODO: Just the source IP for now, change to the 4-tuples
-	return jhash_2words(pkt->inner_ip->saddr, 0, INIT_JHASH_SEED);
+	ipv4_flow_t *flow = &pkt->fctx.flow;
+
+	return jhash_3words(flow->saddr, flow->daddr,
+			    ((__u32)flow->sport << 16 | flow->dport) ^
+			    flow->protocol, INIT_JHASH_SEED);
+}
+
+/* Hash of an inner IPv6 flow, l4 holds its ports if any */
+__ALWAYS_INLINE__
+static inline __u32 trn_ipv6_flow_hash(struct ipv6hdr *ip6, __u32 l4)
+{
+	__be32 *s = ip6->saddr.in6_u.u6_addr32;
+	__be32 *d = ip6->daddr.in6_u.u6_addr32;
+
+	return jhash_3words(s[0] ^ s[1] ^ s[2] ^ s[3], d[0] ^ d[1] ^ d[2] ^ d[3],
+			    l4 ^ ip6->nexthdr, INIT_JHASH_SEED);
 }
 
 // wyue -- need double check
@@ -224,6 +349,13 @@ static inline __u8 trn_append_src(void *data, void *data_end,
 	return 0; 
 }
 
+/* Broadcast and multicast MACs have the group bit set */
+__ALWAYS_INLINE__
+static inline int trn_is_bum(const unsigned char *mac)
+{
+	return mac[0] & 1;
+}
+
 __ALWAYS_INLINE__
 static __be32 trn_get_vni(const __u8 *vni)
 {
@@ -232,9 +364,17 @@ static __be32 trn_get_vni(const __u8 *vni)
 }
 
 __ALWAYS_INLINE__
-static void trn_mod_vni(struct vxlanhdr *vxlan) {
-	// vxlan->rsvd3[0] = 0x80; // test
-	// vxlan->rsvd1 |= 0x1; // Test
+static void trn_set_vxlan_hint(struct vxlanhdr *vxlan, __be32 hip)
+{
+	/* Big endian! */
+	__u8 *ip = (__u8 *)&hip;
+
+	vxlan->rsvd2 |= TRN_VXLAN_HINT_FLAG;
+	vxlan->rsvd2 &= ~TRN_VXLAN_GBP_FLAG;
+	vxlan->rsvd3[0] = ip[0];
+	vxlan->rsvd3[1] = ip[1];
+	vxlan->rsvd3[2] = ip[2];
+	vxlan->rsvd4 = ip[3];
 }
 
 static void trn_set_vni(__be32 src, __u8 *vni)
@@ -280,7 +420,8 @@ __ALWAYS_INLINE__
 static inline void trn_update_l4_csum_port(__u64 *csum, __be16 old_port,
 					   __be16 new_port)
 {
-	*csum = (~*csum & 0xffff) + ~old_port + new_port;
+	/* ~ promotes to int, keep the complement 16 bits wide */
+	*csum = (~*csum & 0xffff) + (__u16)~old_port + new_port;
 	*csum = trn_csum_fold_helper(*csum);
 }
 
@@ -466,6 +607,42 @@ static inline void trn_set_src_dst_ip_csum(struct iphdr *ip,
 		  ip->saddr, ip->daddr, ip->check);
 }
 
+/*
+ * Redirect the packet to daddr from the transit's own address, applying
+ * the endpoint's precomputed checksum delta incrementally (RFC 1624)
+ * instead of summing the whole header again.
+ */
+__ALWAYS_INLINE__
+static inline void trn_redirect_ip_csum(struct iphdr *ip, __u32 daddr,
+					__u16 csum_delta, void *data_end)
+{
+	__u64 csum;
+
+	csum = (__u16)~ip->check + (__u16)~(ip->saddr & 0xffff) +
+	       (__u16)~(ip->saddr >> 16) + csum_delta;
+
+	ip->ttl--;
+	trn_set_src_ip(ip, data_end, ip->daddr);
+	trn_set_dst_ip(ip, data_end, daddr);
+	ip->check = trn_csum_fold_helper(csum);
+
+	bpf_debug("Modified IP Address, src: 0x%x, dst: 0x%x, csum: 0x%x\n",
+		  ip->saddr, ip->daddr, ip->check);
+}
+
+/* Set the DSCP of an IP header keeping ECN, the checksum is updated */
+__ALWAYS_INLINE__
+static inline void trn_set_ip_dscp(struct iphdr *ip, __u8 dscp)
+{
+	__u16 *word = (__u16 *)ip;
+	__u16 old = *word;
+	__u64 csum;
+
+	ip->tos = (dscp << 2) | (ip->tos & 0x3);
+	csum = (__u16)~ip->check + (__u16)~old + *word;
+	ip->check = trn_csum_fold_helper(csum);
+}
+
 __ALWAYS_INLINE__
 static inline void trn_inner_l4_csum_update(struct transit_packet *pkt,
 					    __u32 old_addr, __u32 new_addr)
@@ -482,6 +659,11 @@ static inline void trn_inner_l4_csum_update(struct transit_packet *pkt,
 			return;
 		}
 
+		/* Zero UDP checksum over IPv4 means none */
+		if (!pkt->inner_udp->check) {
+			return;
+		}
+
 		__u64 cs = pkt->inner_udp->check;
 		trn_update_l4_csum(&cs, old_addr, new_addr);
 		pkt->inner_udp->check = cs;
@@ -43,6 +43,7 @@
 
 #include "trn_datamodel.h"
 #include "trn_kern.h"
+#include "trn_transit_xdp_stage.h"
 
 int _version SEC("version") = 1;
 
@@ -50,8 +51,10 @@ SEC("transit_drop_proc")
 int _transit_drop_proc(struct xdp_md *ctx)
 {
 	/* A simple program for now, no shared state, and may be invoked on XDP_DROP */
+	__u64 start = bpf_ktime_get_ns();
+
 	bpf_debug("[Transit:%d:] drop PROC\n", __LINE__);
-	return XDP_DROP;
+	return trn_stage_next(ctx, start, XDP_DROP);
 }
 
 char _license[] SEC("license") = "GPL";
@@ -43,6 +43,7 @@
 
 #include "trn_datamodel.h"
 #include "trn_kern.h"
+#include "trn_transit_xdp_stage.h"
 
 int _version SEC("version") = 1;
 
@@ -50,8 +51,10 @@ SEC("transit_pass_proc")
 int _transit_pass_proc(struct xdp_md *ctx)
 {
 	/* A simple program for now, no shared state, and may be invoked on XDP_PASS */
+	__u64 start = bpf_ktime_get_ns();
+
 	bpf_debug("[Transit_pass:%d] pass PROC\n", ctx->ingress_ifindex);
-	return XDP_PASS;
+	return trn_stage_next(ctx, start, XDP_PASS);
 }
 
 char _license[] SEC("license") = "GPL";
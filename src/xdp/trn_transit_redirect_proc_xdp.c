@@ -43,6 +43,7 @@
 
 #include "trn_datamodel.h"
 #include "trn_kern.h"
+#include "trn_transit_xdp_stage.h"
 //#include "trn_transit_xdp_stages_maps.h"
 
 int _version SEC("version") = 1;
@@ -52,7 +53,15 @@ int _transit_redirect_proc(struct xdp_md *ctx)
 {
 	/* Simple example program that gets share same maps with transit XDP
 		can be invoked on redirect */
+	struct trn_xdp_meta *meta = trn_get_xdp_meta(ctx);
+	__u64 start = bpf_ktime_get_ns();
+
 	bpf_debug("[Transit:%d:] redirect processing\n", __LINE__);
+
+	/* Headers are already parsed by the transit program */
+	if (meta)
+		bpf_debug("[Transit:%d:] vni: %d, inner L3 at %d\n",
+			  __LINE__, meta->vni, meta->inner_l3_off);
 #if 0
 	int map_idx = 0;
 
@@ -95,7 +104,7 @@ int _transit_redirect_proc(struct xdp_md *ctx)
 
 	bpf_debug("[Transit:%d:] found all inner maps!\n", __LINE__);
 #endif
-	return XDP_REDIRECT;
+	return trn_stage_next(ctx, start, XDP_REDIRECT);
 }
 
 char _license[] SEC("license") = "GPL";
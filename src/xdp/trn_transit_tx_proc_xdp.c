@@ -43,6 +43,7 @@
 
 #include "trn_datamodel.h"
 #include "trn_kern.h"
+#include "trn_transit_xdp_stage.h"
 
 int _version SEC("version") = 1;
 
@@ -50,8 +51,10 @@ SEC("transit_tx_proc")
 int _transit_tx_proc(struct xdp_md *ctx)
 {
 	/* A simple program for now, no shared state, and may be invoked on XDP_TX */
+	__u64 start = bpf_ktime_get_ns();
+
 	bpf_debug("[Transit:%d:] tx PROC\n", __LINE__);
-	return XDP_TX;
+	return trn_stage_next(ctx, start, XDP_TX);
 }
 
 char _license[] SEC("license") = "GPL";
@@ -47,13 +47,15 @@
 #include "trn_datamodel.h"
 #include "trn_transit_xdp_maps.h"
 #include "trn_kern.h"
+#include "trn_transit_xdp_stage.h"
 
 int _version SEC("version") = 1;
 
 int pkt_not_add_tail = 1;
 int pkt_not_add_head = 1;
 
-const int EP_NOT_FOUND = 5; // use this const as a new xdp_action, which indicates this packet shall be forwarded to the user space via AF_XDP.
+#define EP_NOT_FOUND 5 // use this value as a new xdp_action, which indicates this packet shall be forwarded to the user space via AF_XDP.
+#define BUM_FLOOD 6 // new xdp_action too, the packet is replicated to the flood list of its VNI, see trn_flood.
 
 static __inline int trn_rewrite_remote_mac(struct transit_packet *pkt)
 {
@@ -128,93 +130,910 @@ static __inline int trn_decapsulate_and_redirect(struct transit_packet *pkt,
 	return bpf_redirect_map(&interfaces_map, ifindex, 0);
 }
 
-#if sgSupport
-static __inline int trn_sg_check(struct transit_packet *pkt) {
-
-	sg_cidr_key_t sgkey;
-	struct security_group_t *sg_entry = NULL;
-
-	sgkey.vni = pkt->vni;
-	sgkey.src_ip = pkt->inner_ip->saddr;
-	sgkey.dst_ip = pkt->inner_ip->daddr;
-	sgkey.protocol = pkt->inner_ip->protocol;
-	sgkey.prefixlen = SG_IPV4_PREFIX; // ??
-
-	// check egress
-	sgkey.direction = 0;
-	sgkey.port = 30011;
-
-	bpf_debug("[Transit:%d] XXXXX port=%d, prefixlen=%d",
-			sgkey.vni, sgkey.port, sgkey.prefixlen);
-	bpf_debug("  XXXXX proto=%d, src_ip:0x%x, dst_ip:0x%x ",
-			sgkey.protocol,
-			bpf_ntohl(sgkey.src_ip),
-			bpf_ntohl(sgkey.dst_ip));
-	sg_entry = bpf_map_lookup_elem(&sg_cidr_map, &sgkey);
-	if (sg_entry == NULL) {
-		bpf_debug("[Transit:%d XXXXX] Drop: no matching sg entry found: %d - %d\n",
-			pkt->itf_idx, sgkey.port, sgkey.vni);
+/* Port ranges of a compiled port table the destination port falls in */
+static __inline __u64 trn_sg_port_ranges(struct sg_ports_t *ports, __u16 port)
+{
+	__u32 i = 0, step;
+
+#pragma unroll
+	for (step = TRAN_MAX_SG_INTERVALS / 2; step; step >>= 1) {
+		if (i + step < ports->nintervals &&
+		    ports->start[(i + step) & (TRAN_MAX_SG_INTERVALS - 1)] <= port)
+			i += step;
+	}
+
+	return ports->ranges[i & (TRAN_MAX_SG_INTERVALS - 1)];
+}
+
+/*
+ * Match one direction of a packet against the compiled rules of its VNI,
+ * remote is the address on the far side. Every remote prefix length in
+ * use is probed once, longest first, for the packet's protocol and for
+ * protocol agnostic rules.
+ */
+static __inline int trn_sg_match(struct transit_packet *pkt,
+				 struct sg_vni_t *sgv, __u8 direction,
+				 __be32 remote, __u16 port)
+{
+	__u8 protocol = pkt->inner_ip->protocol;
+	__u64 ranges = ~0ULL, prefixes, any;
+	struct sg_ports_t *ports;
+	sg_ports_key_t pkey;
+	sg_rule_key_t key;
+	__u64 *allowed;
+	int len;
+
+	prefixes = sgv->prefixes[direction & 1];
+	any = sgv->any_prefixes[direction & 1];
+
+	if (protocol == IPPROTO_TCP || protocol == IPPROTO_UDP) {
+		pkey.vni = pkt->vni;
+		pkey.direction = direction;
+		pkey.protocol = protocol;
+		pkey.gen = sgv->gen;
+		pkey.rsvd = 0;
+		ports = bpf_map_lookup_elem(&sg_ports_map, &pkey);
+		ranges = ports ? trn_sg_port_ranges(ports, port) : 0;
+	}
+
+	if (!ranges)
+		prefixes = 0;
+
+	key.vni = pkt->vni;
+	key.direction = direction;
+	key.gen = sgv->gen;
+
+#pragma unroll
+	for (len = 32; len >= 0; len--) {
+		if (!((prefixes | any) & (1ULL << len)))
+			continue;
+
+		key.remote_ip = len ? remote & bpf_htonl(~0U << (32 - len)) : 0;
+		key.prefixlen = len;
+
+		if (prefixes & (1ULL << len)) {
+			key.protocol = protocol;
+			allowed = bpf_map_lookup_elem(&sg_rules_map, &key);
+			if (allowed && (*allowed & ranges))
+				return 1;
+		}
+
+		if (any & (1ULL << len)) {
+			key.protocol = TRAN_SG_PROTO_ANY;
+			if (bpf_map_lookup_elem(&sg_rules_map, &key))
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * A packet passes if the egress rules of its source and the ingress
+ * rules of its destination allow it, VNIs without rules are not
+ * classified. Ports are taken from the inner flow.
+ */
+static __inline int trn_sg_check(struct transit_packet *pkt)
+{
+	ipv4_flow_t *flow = &pkt->fctx.flow;
+	struct sg_vni_t *sgv;
+	__u16 port;
+
+	sgv = bpf_map_lookup_elem(&sg_vni_map, &pkt->vni);
+	if (!sgv)
+		return XDP_PASS;
+
+	port = bpf_ntohs(flow->dport);
+
+	if (!trn_sg_match(pkt, sgv, TRAN_SG_EGRESS, flow->daddr, port) ||
+	    !trn_sg_match(pkt, sgv, TRAN_SG_INGRESS, flow->saddr, port)) {
+		bpf_debug("[Transit:%d] Drop: no matching sg rule vni:%d port:%d\n",
+			  pkt->itf_idx, pkt->vni, port);
 		return XDP_DROP;
 	}
 
-   // check ingress;
-	sgkey.direction = 1;
-	sgkey.src_ip = sgkey.dst_ip;
-	sgkey.dst_ip = pkt->inner_ip->saddr;
+	return XDP_PASS;
+}
 
-	if (sgkey.protocol == IPPROTO_TCP) {
-		pkt->inner_tcp = (void *)pkt->inner_ip + sizeof(*pkt->inner_ip);
+/*
+ * Verdict of the identity policy between the source and dst_id, the
+ * most specific of exact port, any port and any protocol entries
+ * decides. Pairs without a verdict are denied.
+ */
+static __inline int trn_sg_identity_check(struct transit_packet *pkt,
+					  __u16 dst_id)
+{
+	ipv4_flow_t *flow = &pkt->fctx.flow;
+	sg_identity_key_t key;
+	__u32 *verdict;
+
+	key.vni = pkt->vni;
+	key.src_id = pkt->src_identity;
+	key.dst_id = dst_id;
+	key.port = bpf_ntohs(flow->dport);
+	key.protocol = flow->protocol;
+	key.rsvd = 0;
+
+	verdict = bpf_map_lookup_elem(&sg_identity_map, &key);
+	if (!verdict && key.port) {
+		key.port = 0;
+		verdict = bpf_map_lookup_elem(&sg_identity_map, &key);
+	}
+	if (!verdict) {
+		key.protocol = TRAN_SG_PROTO_ANY;
+		verdict = bpf_map_lookup_elem(&sg_identity_map, &key);
+	}
 
-		if (pkt->inner_tcp + 1 > pkt->data_end) {
-			bpf_debug("[Transit:%d] ABORTED: Bad inner TCP frame\n",
-				pkt->itf_idx);
-			return XDP_ABORTED;
+	if (!verdict || *verdict != TRAN_SG_ALLOW) {
+		bpf_debug("[Transit:%d] Drop: identity %d to %d denied\n",
+			  pkt->itf_idx, pkt->src_identity, dst_id);
+		return XDP_DROP;
+	}
+
+	return XDP_PASS;
+}
+
+/*
+ * Packets between endpoints with security identities are checked by the
+ * identity policy, others by the security group rules of their VNI.
+ */
+static __inline int trn_policy_check(struct transit_packet *pkt,
+				     endpoint_t *ep)
+{
+	if (trn_feature(TRAN_XDP_FEAT_IDENTITY) && pkt->src_identity &&
+	    ep && ep->identity)
+		return trn_sg_identity_check(pkt, ep->identity);
+
+	if (trn_feature(TRAN_XDP_FEAT_SG))
+		return trn_sg_check(pkt);
+
+	return XDP_PASS;
+}
+
+/*
+ * Connection tracking key of a flow, ordered so both directions map to
+ * the same entry. daddr is the destination before scaled endpoint NAT,
+ * replies are rewritten to it. Returns the side of the flow in the key.
+ */
+static __inline __u8 trn_ct_key(ipv4_flow_t *flow, __be32 daddr, __u32 vni,
+				contrack_key_t *key)
+{
+	__u8 side = flow->saddr > daddr ||
+		    (flow->saddr == daddr && flow->sport > flow->dport);
+
+	key->vni = vni;
+	key->tuple.protocol = flow->protocol;
+	key->tuple.saddr = side ? daddr : flow->saddr;
+	key->tuple.daddr = side ? flow->saddr : daddr;
+	key->tuple.sport = side ? flow->dport : flow->sport;
+	key->tuple.dport = side ? flow->sport : flow->dport;
+
+	return side;
+}
+
+/*
+ * Returns 1 if the packet belongs to a live connection and advances its
+ * state: a packet of the other side establishes it, TCP RST or FIN of
+ * both sides closes it. Stale connections and SYNs reusing a closing one
+ * are classified again.
+ */
+static __inline int trn_ct_track(struct transit_packet *pkt,
+				 contrack_key_t *key, __u8 side)
+{
+	__u8 protocol = key->tuple.protocol;
+	__u64 now = bpf_ktime_get_ns();
+	contrack_t *ct;
+
+	ct = bpf_map_lookup_elem(&contrack_map, key);
+	if (!ct)
+		return 0;
+
+	/* Other CPUs may have stamped it after now was read */
+	if (now > ct->last_seen +
+	    TRAN_CT_TIMEOUT(protocol, ct->state) * 1000000000ULL)
+		goto stale;
+
+	if (side != ct->orig && ct->state == TRAN_CT_NEW)
+		ct->state = TRAN_CT_ESTABLISHED;
+
+	if (protocol == IPPROTO_TCP) {
+		if (pkt->inner_tcp->syn && !pkt->inner_tcp->ack &&
+		    ct->state == TRAN_CT_CLOSING)
+			goto stale;
+
+		if (pkt->inner_tcp->rst) {
+			ct->state = TRAN_CT_CLOSING;
+		} else if (pkt->inner_tcp->fin) {
+			ct->fin |= 1 << side;
+			if (ct->fin == 0x3)
+				ct->state = TRAN_CT_CLOSING;
 		}
-		sgkey.port = pkt->inner_tcp->dest; // check dst first
-	} else if (sgkey.protocol == IPPROTO_UDP) {
-		pkt->inner_udp = (void *)pkt->inner_ip + sizeof(*pkt->inner_ip);
+	}
 
-		if (pkt->inner_udp + 1 > pkt->data_end) {
-			bpf_debug("[Transit:%d] ABORTED: Bad inner UDP oframe\n",
-				  pkt->itf_idx);
-			return XDP_ABORTED;
+	ct->last_seen = now;
+	return 1;
+
+stale:
+	bpf_map_delete_elem(&contrack_map, key);
+	return 0;
+}
+
+/* Track the connection a packet allowed by the security groups opens */
+static __inline void trn_ct_open(contrack_key_t *key, __u8 side)
+{
+	contrack_t ct;
+
+	__builtin_memset(&ct, 0, sizeof(ct));
+	ct.last_seen = bpf_ktime_get_ns();
+	ct.state = TRAN_CT_NEW;
+	ct.orig = side;
+
+	bpf_map_update_elem(&contrack_map, key, &ct, BPF_NOEXIST);
+}
+
+static __inline flow_cache_stats_t *trn_flow_cache_stats(void)
+{
+	__u32 key = 0;
+
+	return bpf_map_lookup_elem(&flow_cache_stats_map, &key);
+}
+
+static __inline flow_cache_entry_t *trn_flow_cache_lookup(ipv4_flow_t *flow,
+							  __u32 vni, __u32 *gen)
+{
+	flow_cache_stats_t *stats = trn_flow_cache_stats();
+	flow_cache_entry_t *fc;
+	__u32 slot = TRAN_FLOW_GEN_SLOT(vni);
+	__u32 *cur_gen;
+
+	/* Read generation before any classification lookup, an update racing
+	 * with this packet leaves the entry it inserts stale */
+	cur_gen = bpf_map_lookup_elem(&flow_gen_map, &slot);
+	*gen = cur_gen ? *cur_gen : 0;
+
+	fc = bpf_map_lookup_elem(&flow_cache_map, flow);
+	if (fc && fc->gen != *gen) {
+		bpf_map_delete_elem(&flow_cache_map, flow);
+		if (stats)
+			stats->evict++;
+		fc = NULL;
+	}
+
+	if (stats) {
+		if (fc)
+			stats->hit++;
+		else
+			stats->miss++;
+	}
+
+	return fc;
+}
+
+static __inline void trn_flow_cache_insert(ipv4_flow_t *flow, __u32 gen,
+					   __u32 action, endpoint_t *ep)
+{
+	flow_cache_stats_t *stats = trn_flow_cache_stats();
+	flow_cache_entry_t fc;
+
+	__builtin_memset(&fc, 0, sizeof(fc));
+	fc.gen = gen;
+	fc.action = action;
+	if (ep)
+		__builtin_memcpy(&fc.ep, ep, sizeof(fc.ep));
+
+	if (!bpf_map_update_elem(&flow_cache_map, flow, &fc, BPF_ANY) && stats)
+		stats->insert++;
+}
+
+/*
+ * Pick the backend of a scaled endpoint with the highest jhash weight
+ * for the flow hash (rendezvous hashing).
+ */
+static __inline int trn_scaled_ep_select(struct scaled_ep_t *sep, __u32 hash,
+					 __u32 *rip)
+{
+	__u32 best = 0;
+	__u32 weight;
+	int found = -1;
+	__u32 i;
+
+#pragma unroll
+	for (i = 0; i < TRAN_MAX_REMOTES; i++) {
+		if (i >= sep->nremotes)
+			break;
+
+		weight = jhash_2words(hash, sep->remote_ips[i], 0);
+		if (found < 0 || weight > best) {
+			best = weight;
+			*rip = sep->remote_ips[i];
+			found = 0;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * Direct server return: tell the backend host in the scaled endpoint
+ * option which addresses its replies take to reach the client from the
+ * VIP. Reply bytes are accounted from the client's TCP acks as they no
+ * longer pass transit.
+ */
+static __inline void trn_scaled_ep_dsr(struct transit_packet *pkt,
+				       struct scaled_ep_flow_t *fl, __u32 vip)
+{
+	struct trn_gnv_scaled_ep_opt *opt = pkt->overlay.geneve.scaled_ep_opt;
+	ipv4_flow_t *flow = &pkt->fctx.flow;
+	scaled_ep_stats_t *stats;
+	__u32 key = 0;
+	__u32 ack;
+
+	if (opt + 1 > pkt->data_end || pkt->inner_eth + 1 > pkt->data_end)
+		return;
+
+	opt->type = TRN_GNV_SCALED_EP_OPT_TYPE;
+	opt->length = sizeof(opt->scaled_ep_data) >> 2;
+	opt->scaled_ep_data.msg_type = TRN_SCALED_EP_MODIFY;
+	opt->scaled_ep_data.target.saddr = vip;
+	opt->scaled_ep_data.target.daddr = flow->saddr;
+	opt->scaled_ep_data.target.sport = flow->dport;
+	opt->scaled_ep_data.target.dport = flow->sport;
+	trn_set_mac(opt->scaled_ep_data.target.h_source,
+		    pkt->inner_eth->h_dest);
+	trn_set_mac(opt->scaled_ep_data.target.h_dest,
+		    pkt->inner_eth->h_source);
+
+	/* Overlay payload changed, same as the hint header */
+	pkt->udp->check = 0;
+
+	if (flow->protocol != IPPROTO_TCP || pkt->inner_tcp + 1 > pkt->data_end ||
+	    !pkt->inner_tcp->ack)
+		return;
+
+	ack = bpf_ntohl(pkt->inner_tcp->ack_seq);
+	if (fl->acked && (__s32)(ack - fl->ack) <= 0)
+		return;
+
+	stats = bpf_map_lookup_elem(&scaled_ep_stats_map, &key);
+	if (fl->acked && stats)
+		stats->dsr_bytes += ack - fl->ack;
+
+	fl->ack = ack;
+	fl->acked = 1;
+}
+
+/*
+ * Load balance flows to scaled endpoints: the first packet of a flow to
+ * a VIP pins it to a backend in scaled_fwd_map, later packets keep that
+ * backend whatever happens to the backend set. Replies of the backend
+ * are rewritten back to the VIP from scaled_rev_map, unless the scaled
+ * endpoint uses direct server return over Geneve. The inner flow is
+ * updated so the flow cache and endpoint lookup see the rewritten one.
+ */
+static __inline void trn_scaled_ep_nat(struct transit_packet *pkt)
+{
+	ipv4_flow_t *flow = &pkt->fctx.flow;
+	struct scaled_ep_flow_t *fl;
+	struct scaled_ep_flow_t new_fl;
+	struct scaled_ep_t *sep;
+	scaled_ep_stats_t *stats;
+	endpoint_key_t epkey;
+	ipv4_flow_t rflow;
+	__u32 vip = flow->daddr;
+	__u32 *addr;
+	__u32 key = 0;
+	__u32 rip;
+
+	addr = bpf_map_lookup_elem(&scaled_rev_map, flow);
+	if (addr) {
+		vip = *addr;
+		trn_set_src_dst_inner_ip_csum(pkt, vip, flow->daddr);
+		flow->saddr = vip;
+		return;
+	}
+
+	fl = bpf_map_lookup_elem(&scaled_fwd_map, flow);
+	if (!fl) {
+		epkey.vni = pkt->vni;
+		epkey.ip = vip;
+		sep = bpf_map_lookup_elem(&scaled_eps_map, &epkey);
+		if (!sep || trn_scaled_ep_select(sep, pkt->meta.hash, &rip))
+			return;
+
+		__builtin_memset(&new_fl, 0, sizeof(new_fl));
+		new_fl.rip = rip;
+		new_fl.dsr = (sep->flags & TRAN_SCALED_EP_DSR) &&
+			     trn_itf_role(pkt) == XDP_FTN;
+
+		if (new_fl.dsr) {
+			stats = bpf_map_lookup_elem(&scaled_ep_stats_map, &key);
+			if (stats)
+				stats->dsr_flows++;
+			trn_scaled_ep_dsr(pkt, &new_fl, vip);
+		} else {
+			__builtin_memcpy(&rflow, flow, sizeof(rflow));
+			rflow.daddr = rip;
+			trn_reverse_ipv4_tuple(&rflow);
+			bpf_map_update_elem(&scaled_rev_map, &rflow, &vip,
+					    BPF_ANY);
 		}
-		sgkey.port = pkt->inner_udp->dest;
+
+		bpf_map_update_elem(&scaled_fwd_map, flow, &new_fl, BPF_ANY);
+
+		bpf_debug("[Transit:%d] Flow to VIP 0x%x pinned to 0x%x\n",
+			  pkt->itf_idx, bpf_ntohl(vip), bpf_ntohl(rip));
 	} else {
-		bpf_debug("[Transit:%d] PASS: Non supported frame, proto: %d\n",
-			pkt->itf_idx, sgkey.protocol);
-		return XDP_PASS;
+		rip = fl->rip;
+		if (fl->dsr && trn_itf_role(pkt) == XDP_FTN)
+			trn_scaled_ep_dsr(pkt, fl, vip);
+	}
+
+	trn_set_src_dst_inner_ip_csum(pkt, flow->saddr, rip);
+	flow->daddr = rip;
+}
+
+/*
+ * Select the chain of a flow from the Maglev table of a DFT, tables too
+ * large for dft_t are looked up in the DFT's own array map.
+ */
+static __inline int trn_dft_select_chain(__u32 dft_id, __u32 hash,
+					 __u32 *chain)
+{
+	struct dft_t *dft;
+	__u32 *entry;
+	void *table;
+	__u32 idx;
+
+	dft = bpf_map_lookup_elem(&dfts_map, &dft_id);
+	if (!dft || !dft->table_len)
+		return -1;
+
+	idx = hash % dft->table_len;
+	if (dft->table_len <= TRAN_MAX_MAGLEV_TABLE_SIZE) {
+		if (idx >= TRAN_MAX_MAGLEV_TABLE_SIZE)
+			return -1;
+		*chain = dft->table[idx];
+		return 0;
+	}
+
+	table = bpf_map_lookup_elem(&dft_tables_map, &dft_id);
+	if (!table)
+		return -1;
+
+	entry = bpf_map_lookup_elem(table, &idx);
+	if (!entry)
+		return -1;
+
+	*chain = *entry;
+	return 0;
+}
+
+/*
+ * Head and middle FTNs of a chain pass the packet on to the next FTN
+ * from their own address, the overlay is left untouched.
+ */
+static __inline int trn_ftn_forward(struct transit_packet *pkt,
+				    struct ftn_t *ftn)
+{
+	__be32 old_saddr = pkt->ip->saddr;
+	__be32 old_daddr = pkt->ip->daddr;
+	__u64 csum;
+
+	trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, ftn->next_ip,
+				pkt->data_end);
+	trn_set_src_mac(pkt->eth, pkt->eth->h_dest);
+	trn_set_dst_mac(pkt->eth, ftn->next_mac);
+
+	if (pkt->udp->check) {
+		csum = pkt->udp->check;
+		trn_update_l4_csum(&csum, old_saddr, pkt->ip->saddr);
+		trn_update_l4_csum(&csum, old_daddr, pkt->ip->daddr);
+		pkt->udp->check = csum ? csum : 0xffff;
+	}
+
+	bpf_debug("[Transit:%d] TX: FTN hop %d to next 0x%x\n",
+		  pkt->itf_idx, ftn->position, bpf_ntohl(ftn->next_ip));
+	return XDP_TX;
+}
+
+/*
+ * Hand a flow missing its endpoint to the tail FTN of its chain, where
+ * flows of the chain are looked up. The VxLAN overlay becomes the Geneve
+ * overlay FTNs expect, Geneve and VxLAN headers are the same size so
+ * only the options are new. Returns EP_NOT_FOUND if the chain or its
+ * tail FTN is unknown.
+ */
+static __inline int trn_chain_forward(struct transit_packet *pkt,
+				      __u32 chain_id)
+{
+	struct trn_gnv_scaled_ep_opt *sep_opt;
+	struct trn_gnv_rts_opt *rts_opt;
+	struct genevehdr *gnv;
+	struct chain_t *chain;
+	struct ftn_t *ftn;
+	struct ethhdr *eth;
+	struct iphdr *ip;
+	struct udphdr *udp;
+	void *data_end;
+	unsigned char rts_mac[6], smac[6];
+	int grow = sizeof(*rts_opt) + sizeof(*sep_opt);
+	__be32 rts_ip, saddr;
+	__u16 tot_len, udp_len;
+	__be16 sport;
+	__u64 csum = 0;
+
+	if (trn_itf_role(pkt) != XDP_FWD)
+		return EP_NOT_FOUND;
+
+	chain = bpf_map_lookup_elem(&chains_map, &chain_id);
+	if (!chain)
+		return EP_NOT_FOUND;
+
+	ftn = bpf_map_lookup_elem(&ftns_map, &chain->tail_ftn);
+	if (!ftn)
+		return EP_NOT_FOUND;
+
+	/* The sender is returned to once the tail resolved the endpoint */
+	rts_ip = pkt->ip->saddr;
+	trn_set_mac(rts_mac, pkt->eth->h_source);
+	saddr = pkt->ip->daddr;
+	trn_set_mac(smac, pkt->eth->h_dest);
+	tot_len = bpf_ntohs(pkt->ip->tot_len) + grow;
+	udp_len = bpf_ntohs(pkt->udp->len) + grow;
+	sport = pkt->udp->source;
+
+	if (bpf_xdp_adjust_head(pkt->xdp, -grow)) {
+		bpf_debug("[Transit:%d] DROP: no headroom for Geneve options\n",
+			  pkt->itf_idx);
+		return XDP_DROP;
+	}
+
+	eth = (void *)(long)pkt->xdp->data;
+	data_end = (void *)(long)pkt->xdp->data_end;
+	ip = (void *)(eth + 1);
+	udp = (void *)(ip + 1);
+	gnv = (void *)(udp + 1);
+	rts_opt = (void *)(gnv + 1);
+	sep_opt = (void *)(rts_opt + 1);
+	if (sep_opt + 1 > data_end)
+		return XDP_DROP;
+
+	trn_set_dst_mac(eth, ftn->mac);
+	trn_set_src_mac(eth, smac);
+	eth->h_proto = bpf_htons(ETH_P_IP);
+
+	__builtin_memset(ip, 0, sizeof(*ip));
+	ip->version = IPVERSION;
+	ip->ihl = sizeof(*ip) >> 2;
+	ip->tot_len = bpf_htons(tot_len);
+	ip->ttl = TRN_DEFAULT_TTL;
+	ip->protocol = IPPROTO_UDP;
+	ip->saddr = saddr;
+	ip->daddr = ftn->ip;
+	trn_ipv4_csum_inline(ip, &csum);
+	ip->check = csum;
+
+	udp->source = sport;
+	udp->dest = GEN_DSTPORT;
+	udp->len = bpf_htons(udp_len);
+	udp->check = 0;
+
+	__builtin_memset(gnv, 0, sizeof(*gnv) + sizeof(*rts_opt) +
+			 sizeof(*sep_opt));
+	gnv->opt_len = grow / 4;
+	gnv->proto_type = bpf_htons(ETH_P_TEB);
+	trn_set_vni(pkt->vni, gnv->vni);
+
+	rts_opt->opt_class = bpf_htons(TRN_GNV_OPT_CLASS);
+	rts_opt->type = TRN_GNV_RTS_OPT_TYPE;
+	rts_opt->length = sizeof(rts_opt->rts_data) / 4;
+	rts_opt->rts_data.host.ip = rts_ip;
+	trn_set_mac(rts_opt->rts_data.host.mac, rts_mac);
+
+	sep_opt->opt_class = bpf_htons(TRN_GNV_OPT_CLASS);
+	sep_opt->type = TRN_GNV_SCALED_EP_OPT_TYPE;
+	sep_opt->length = sizeof(sep_opt->scaled_ep_data) / 4;
+
+	pkt->meta.inner_l2_off += grow;
+	pkt->meta.inner_l3_off += grow;
+	if (pkt->meta.inner_l4_off)
+		pkt->meta.inner_l4_off += grow;
+
+	bpf_debug("[Transit:%d] TX: chain %d to tail FTN 0x%x\n",
+		  pkt->itf_idx, chain_id, bpf_ntohl(ftn->ip));
+	return XDP_TX;
+}
+
+/*
+ * Rewrite outer addresses toward the target host, the IP checksum is
+ * updated from the endpoint's precomputed delta. When enabled on the
+ * droplet, also pick the outer UDP source port from the inner flow so
+ * receivers' RSS and underlay ECMP can tell flows apart. A non-zero
+ * UDP checksum is updated for the pseudo header and port changes.
+ */
+static __inline void trn_rewrite_outer(struct transit_packet *pkt,
+				       ipv4_flow_t *flow, endpoint_t *ep)
+{
+	__be32 old_saddr = pkt->ip->saddr;
+	__be32 old_daddr = pkt->ip->daddr;
+	__be16 old_sport = pkt->udp->source;
+	__u64 csum;
+
+	if (ep->csum_delta)
+		trn_redirect_ip_csum(pkt->ip, ep->hip, ep->csum_delta,
+				     pkt->data_end);
+	else
+		trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, ep->hip,
+					pkt->data_end);
+
+	if (pkt->itf->options & TRAN_ITF_OPT_SPORT_HASH) {
+		pkt->udp->source = bpf_htons(TRAN_UDP_SPORT_MIN |
+					     (pkt->meta.hash & TRAN_UDP_SPORT_MASK));
+	}
+
+	if (!pkt->udp->check)
+		return;
+
+	csum = pkt->udp->check;
+	trn_update_l4_csum(&csum, old_saddr, pkt->ip->saddr);
+	trn_update_l4_csum(&csum, old_daddr, pkt->ip->daddr);
+	trn_update_l4_csum_port(&csum, old_sport, pkt->udp->source);
+	pkt->udp->check = csum ? csum : 0xffff;
+}
+
+/*
+ * Carry the source host hint in the overlay header, the packet keeps its
+ * size. Geneve uses the RTS option, VXLAN its reserved bits which only
+ * fit the host IP; receivers take the MAC from the outer source MAC, the
+ * same the trailer carries. UDP checksum is optional over IPv4, clear it
+ * rather than recompute over the modified header.
+ */
+static __inline void trn_set_hint_hdr(struct transit_packet *pkt, __be32 hip)
+{
+	if (trn_itf_role(pkt) == XDP_FTN) {
+		pkt->overlay.geneve.rts_opt->type = TRN_GNV_RTS_OPT_TYPE;
+		pkt->overlay.geneve.rts_opt->rts_data.host.ip = hip;
+		trn_set_mac(pkt->overlay.geneve.rts_opt->rts_data.host.mac,
+			    pkt->eth->h_source);
+	} else {
+		trn_set_vxlan_hint(pkt->overlay.vxlan, hip);
+	}
+
+	pkt->udp->check = 0;
+}
+
+/*
+ * North-south egress of a gateway endpoint: the source is NATed to its
+ * elastic IP and the inner frame leaves decapsulated on the external
+ * interface. Returns EP_NOT_FOUND if the source has no elastic IP.
+ */
+static __inline int trn_eip_snat(struct transit_packet *pkt)
+{
+	struct eip_gw_t *gw;
+	endpoint_key_t epkey;
+	eip_stats_t *stats;
+	__u32 key = 0, *eip;
+	int off;
+
+	epkey.vni = pkt->vni;
+	epkey.ip = pkt->inner_ip->saddr;
+	eip = bpf_map_lookup_elem(&eip_map, &epkey);
+	gw = bpf_map_lookup_elem(&eip_gw_map, &key);
+	if (!eip || !gw || !gw->ifindex)
+		return EP_NOT_FOUND;
+
+	if (pkt->inner_ip->ttl <= 1) {
+		bpf_debug("[Transit:%d] DROP: ttl of gateway ep 0x%x\n",
+			  pkt->itf_idx, bpf_ntohl(epkey.ip));
+		return XDP_DROP;
 	}
 
-	bpf_debug("[Transit:%d] XXXXX port=%d, prefixlen=%d",
-			sgkey.vni, sgkey.port, sgkey.prefixlen);
-	bpf_debug("  XXXXX proto=%d, src_ip:0x%x, dst_ip:0x%x ",
-			sgkey.protocol,
-			bpf_ntohl(sgkey.src_ip),
-			bpf_ntohl(sgkey.dst_ip));
-	sg_entry = bpf_map_lookup_elem(&sg_cidr_map, &sgkey);
-	if (sg_entry == NULL) {
-		// other follow up logic should be added here
-		bpf_debug("[Transit:%d XXXXX] Drop: no matching sg entry found: %d - %d\n",
-			pkt->itf_idx, sgkey.port, sgkey.vni);
+	pkt->inner_ip->ttl--;
+	trn_set_src_dst_inner_ip_csum(pkt, *eip, pkt->inner_ip->daddr);
+	trn_set_src_mac(pkt->inner_eth, gw->mac);
+	trn_set_dst_mac(pkt->inner_eth, gw->gw_mac);
+
+	stats = bpf_map_lookup_elem(&eip_stats_map, &key);
+	if (stats)
+		stats->snat_pkts++;
+
+	off = (void *)pkt->inner_eth - pkt->data;
+	if (bpf_xdp_adjust_head(pkt->xdp, off)) {
+		bpf_debug("[Transit:%d] DROP: failed to decapsulate for eip\n",
+			  pkt->itf_idx);
 		return XDP_DROP;
 	}
 
-	bpf_debug("[Transit:%d XXXXX] Pass: matching sg entry found: %d - 0x%x\n",
-		sgkey.vni, sgkey.port, bpf_ntohl(pkt->inner_ip->daddr));
+	return bpf_redirect_map(&eip_devmap, 0, 0);
+}
+
+/*
+ * Endpoint lookup of a tenant packet. With the miss guard, keys never
+ * stored in endpoints_map are told apart by ep_bloom_map and a miss
+ * records the key for the upcall admission.
+ */
+static __inline endpoint_t *trn_lookup_endpoint(struct transit_packet *pkt,
+						endpoint_key_t *epkey)
+{
+	endpoint_t *ep = NULL;
+
+	if (!trn_feature(TRAN_XDP_FEAT_MISS_GUARD) ||
+	    !bpf_map_peek_elem(&ep_bloom_map, epkey))
+		ep = bpf_map_lookup_elem(&endpoints_map, epkey);
+
+	if (!ep)
+		pkt->miss_ip = epkey->ip;
+	return ep;
+}
+
+static __inline rate_limit_stats_t *trn_rate_limit_stats(__u32 vni)
+{
+	rate_limit_stats_t zero, *stats;
+
+	stats = bpf_map_lookup_elem(&rate_limit_stats_map, &vni);
+	if (stats)
+		return stats;
+
+	__builtin_memset(&zero, 0, sizeof(zero));
+	bpf_map_update_elem(&rate_limit_stats_map, &vni, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&rate_limit_stats_map, &vni);
+}
+
+/*
+ * Look up this CPU's token bucket key in buckets, rates of 0 are
+ * unlimited. Buckets are refilled by whole TRAN_RL_REFILL_NS periods on
+ * use and start full when created or their rates changed generation.
+ */
+static __inline rate_bucket_t *trn_token_bucket(void *buckets, void *key,
+						__u64 pps, __u64 bps,
+						__u32 gen)
+{
+	rate_bucket_t *b, nb;
+	__u64 now, ticks;
+
+	now = bpf_ktime_get_ns();
+	b = bpf_map_lookup_elem(buckets, key);
+	if (!b || b->gen != gen) {
+		nb.refill_ns = now;
+		nb.pkt_tokens = pps * TRAN_RL_BURST_MS;
+		nb.byte_tokens = bps * TRAN_RL_BURST_MS;
+		nb.gen = gen;
+		nb.rsvd = 0;
+		bpf_map_update_elem(buckets, key, &nb, BPF_ANY);
+		return bpf_map_lookup_elem(buckets, key);
+	}
+
+	ticks = (now - b->refill_ns) / TRAN_RL_REFILL_NS;
+	if (ticks) {
+		b->refill_ns += ticks * TRAN_RL_REFILL_NS;
+		if (ticks > TRAN_RL_BURST_MS)
+			ticks = TRAN_RL_BURST_MS;
+		b->pkt_tokens += pps * ticks;
+		if (b->pkt_tokens > pps * TRAN_RL_BURST_MS)
+			b->pkt_tokens = pps * TRAN_RL_BURST_MS;
+		b->byte_tokens += bps * ticks;
+		if (b->byte_tokens > bps * TRAN_RL_BURST_MS)
+			b->byte_tokens = bps * TRAN_RL_BURST_MS;
+	}
+	return b;
+}
+
+/* Returns 1 if bucket b lacks the tokens of a packet of len bytes */
+static __inline int trn_token_short(rate_bucket_t *b, __u64 pps, __u64 bps,
+				    __u32 len)
+{
+	return (pps && b->pkt_tokens < TRAN_RL_TOKEN) ||
+	       (bps && b->byte_tokens < (__u64)len * TRAN_RL_TOKEN);
+}
+
+/* Charge a packet of len bytes that trn_token_short let through to b */
+static __inline void trn_token_charge(rate_bucket_t *b, __u64 pps, __u64 bps,
+				      __u32 len)
+{
+	if (pps)
+		b->pkt_tokens -= TRAN_RL_TOKEN;
+	if (bps)
+		b->byte_tokens -= (__u64)len * TRAN_RL_TOKEN;
+}
+
+/*
+ * Charge a packet of len bytes to this CPU's token bucket key in
+ * buckets. Returns 1 if the packet is out of profile.
+ */
+static __inline int trn_token_take(void *buckets, void *key, __u64 pps,
+				   __u64 bps, __u32 gen, __u32 len)
+{
+	rate_bucket_t *b;
+
+	b = trn_token_bucket(buckets, key, pps, bps, gen);
+	if (!b)
+		return 0;
+	if (trn_token_short(b, pps, bps, len))
+		return 1;
+
+	trn_token_charge(b, pps, bps, len);
+	return 0;
+}
+
+/*
+ * Police a forwarded packet by the policers of its VNI and of its
+ * destination endpoint, daddr 0 polices by the VNI only. Tokens are
+ * charged only if both policers let the packet through, out of profile
+ * packets are dropped, or marked with a lower effort outer DSCP for the
+ * underlay to shed first.
+ */
+static __inline int trn_rate_limit(struct transit_packet *pkt, __be32 daddr)
+{
+	endpoint_key_t key = { .vni = pkt->vni, .ip = 0 };
+	__u32 len = bpf_xdp_get_buff_len(pkt->xdp);
+	struct rate_limit_t *vrl, *erl = NULL;
+	rate_bucket_t *vb = NULL, *eb = NULL;
+	rate_limit_stats_t *stats;
+	__u8 action;
+
+	vrl = bpf_map_lookup_elem(&rate_limits_map, &key);
+	if (vrl) {
+		vb = trn_token_bucket(&rate_buckets_map, &key, vrl->pps,
+				      vrl->bps, vrl->gen);
+		if (vb && trn_token_short(vb, vrl->pps, vrl->bps, len)) {
+			action = vrl->action;
+			goto out;
+		}
+	}
+
+	if (daddr) {
+		key.ip = daddr;
+		erl = bpf_map_lookup_elem(&rate_limits_map, &key);
+	}
+	if (erl) {
+		eb = trn_token_bucket(&rate_buckets_map, &key, erl->pps,
+				      erl->bps, erl->gen);
+		if (eb && trn_token_short(eb, erl->pps, erl->bps, len)) {
+			action = erl->action;
+			goto out;
+		}
+	}
+
+	if (vrl && vb)
+		trn_token_charge(vb, vrl->pps, vrl->bps, len);
+	if (erl && eb)
+		trn_token_charge(eb, erl->pps, erl->bps, len);
 	return XDP_PASS;
+
+out:
+	stats = trn_rate_limit_stats(pkt->vni);
+	if (action == TRAN_RL_MARK) {
+		if (stats)
+			stats->marked++;
+		trn_set_ip_dscp(pkt->ip, TRAN_RL_MARK_DSCP);
+		return XDP_PASS;
+	}
+
+	bpf_debug("[Transit:%d] DROP: vni:%d over rate limit\n",
+		  pkt->itf_idx, pkt->vni);
+	if (stats) {
+		stats->dropped++;
+		stats->dropped_bytes += len;
+	}
+	return XDP_DROP;
 }
-#endif
 
 static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 {
 	endpoint_t *ep;
 	endpoint_key_t epkey;
+	flow_cache_entry_t *fc;
 	int action = XDP_PASS;
 	ipv4_flow_t *flow = &pkt->fctx.flow;
+	contrack_key_t ctkey;
+	__be32 daddr;
 	__u64 csum = 0;
 	__u16 len = 0;
 	__be32 tip = 0;
+	__u32 gen, chain_id;
+	int tracked = 0;
+	__u8 side = 0;
+	int hint;
 
 	pkt->inner_ip = (void *)pkt->inner_eth + sizeof(*pkt->inner_eth);
 
@@ -222,27 +1041,7 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 		bpf_debug("[Transit:%d] ABORTED: Bad inner IP frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
-
-#if sgSupport
-	action = trn_sg_check(pkt);
-	if (action != XDP_PASS) {
-		bpf_debug("[Transit:%d XXXX] No SG entry found, drop it: \n", pkt->itf_idx);
-		return action;
-	}
-#endif
-
-	/* Look up target endpoint */
-	epkey.vni = pkt->vni;
-	epkey.ip = pkt->inner_ip->daddr;
-	ep = bpf_map_lookup_elem(&endpoints_map, &epkey);
-	if (!ep) {
-		bpf_debug("[Transit:%d] DROP: inner IP forwarding failed to find endpoint "
-			"vni:0x%x ip:0x%x\n", pkt->itf_idx, epkey.vni, bpf_ntohl(epkey.ip));
-		return EP_NOT_FOUND;
-	}
-
-	bpf_debug("[Transit]: XXXX found endpoint: vni:0x%x ip:0x%x, hip: 0x%x\n", 
-			epkey.vni, bpf_ntohl(epkey.ip), bpf_ntohl(ep->hip));
+	pkt->meta.inner_l3_off = pkt->meta.inner_l2_off + sizeof(*pkt->inner_eth);
 
 	memset((void *)&pkt->fctx, 0, sizeof(flow_ctx_t));
 
@@ -263,6 +1062,7 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 
 		flow->sport = pkt->inner_tcp->source;
 		flow->dport = pkt->inner_tcp->dest;
+		pkt->meta.inner_l4_off = pkt->meta.inner_l3_off + sizeof(*pkt->inner_ip);
 	} else if (flow->protocol == IPPROTO_UDP) {
 		pkt->inner_udp = (void *)pkt->inner_ip + sizeof(*pkt->inner_ip);
 
@@ -274,8 +1074,84 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 
 		flow->sport = pkt->inner_udp->source;
 		flow->dport = pkt->inner_udp->dest;
+		pkt->meta.inner_l4_off = pkt->meta.inner_l3_off + sizeof(*pkt->inner_ip);
+	}
+
+	pkt->meta.hash = trn_get_inner_packet_hash(pkt);
+	pkt->meta.flags |= TRN_XDP_META_HASH;
+
+	daddr = flow->daddr;
+	if (trn_feature(TRAN_XDP_FEAT_SCALED_EP))
+		trn_scaled_ep_nat(pkt);
+
+	/* Packets of tracked connections are not classified */
+	if (trn_feature(TRAN_XDP_FEAT_CONNTRACK)) {
+		side = trn_ct_key(flow, daddr, pkt->vni, &ctkey);
+		tracked = trn_ct_track(pkt, &ctkey, side);
+	}
+
+	/* Established flow, skip classification and reuse its rewrite */
+	fc = trn_flow_cache_lookup(flow, pkt->vni, &gen);
+	if (fc && !(tracked && fc->action == XDP_DROP)) {
+		if (fc->action != XDP_TX)
+			return fc->action;
+		if (trn_feature(TRAN_XDP_FEAT_CONNTRACK) && !tracked)
+			trn_ct_open(&ctkey, side);
+		ep = &fc->ep;
+		goto rewrite;
+	}
+
+	/* Look up target endpoint, its identity is needed by the policy */
+	epkey.vni = pkt->vni;
+	epkey.ip = pkt->inner_ip->daddr;
+	ep = trn_lookup_endpoint(pkt, &epkey);
+
+	if (!tracked) {
+		action = trn_policy_check(pkt, ep);
+		if (action != XDP_PASS) {
+			bpf_debug("[Transit:%d XXXX] No SG entry found, drop it: \n", pkt->itf_idx);
+			if (action == XDP_DROP)
+				trn_flow_cache_insert(flow, gen, XDP_DROP, NULL);
+			return action;
+		}
+	}
+
+	if (!ep) {
+		bpf_debug("[Transit:%d] DROP: inner IP forwarding failed to find endpoint "
+			"vni:0x%x ip:0x%x\n", pkt->itf_idx, epkey.vni, bpf_ntohl(epkey.ip));
+		if (trn_feature(TRAN_XDP_FEAT_EIP) && trn_itf_role(pkt) == XDP_FWD) {
+			action = trn_eip_snat(pkt);
+			if (action != EP_NOT_FOUND)
+				return action;
+		}
+		if (!trn_dft_select_chain(pkt->itf->dft_id, pkt->meta.hash,
+					  &chain_id)) {
+			pkt->meta.chain = chain_id;
+			pkt->meta.flags |= TRN_XDP_META_CHAIN;
+			bpf_debug("[Transit:%d] Flow maps to chain %d of DFT %d\n",
+				  pkt->itf_idx, chain_id, pkt->itf->dft_id);
+			return trn_chain_forward(pkt, chain_id);
+		}
+		return EP_NOT_FOUND;
 	}
 
+	bpf_debug("[Transit]: XXXX found endpoint: vni:0x%x ip:0x%x, hip: 0x%x\n", 
+			epkey.vni, bpf_ntohl(epkey.ip), bpf_ntohl(ep->hip));
+
+	/* Only flows that are forwarded to an endpoint get a connection */
+	if (trn_feature(TRAN_XDP_FEAT_CONNTRACK) && !tracked)
+		trn_ct_open(&ctkey, side);
+
+	trn_flow_cache_insert(flow, gen, XDP_TX, ep);
+
+rewrite:
+	if (trn_feature(TRAN_XDP_FEAT_RATE_LIMIT) &&
+	    trn_rate_limit(pkt, pkt->inner_ip->daddr) == XDP_DROP)
+		return XDP_DROP;
+
+	pkt->meta.ep_hip = ep->hip;
+	pkt->meta.flags |= TRN_XDP_META_EP;
+
 /* get rid of this direct path logic for now.  --wyue 4/1/2022 */
 #if turnOn
 	/* Generate Direct Path request */
@@ -312,53 +1188,45 @@ static __inline int trn_process_inner_ip(struct transit_packet *pkt)
 	trn_set_dst_mac(pkt->inner_eth, ep->mac);
 
 	/* Keep overlay header, update outer header destinations */
-	if (appendTail && flow->protocol != IPPROTO_ICMP && !pkt_not_add_tail) {
-        //trn_mod_vni(pkt->overlay.vxlan);
+	hint = trn_feature(TRAN_XDP_FEAT_APPEND_TAIL) && flow->protocol != IPPROTO_ICMP;
+	if (hint) {
 		tip = pkt->ip->saddr;
-    }
-	trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, ep->hip, pkt->data_end);
+	}
+	trn_rewrite_outer(pkt, flow, ep);
 	trn_set_src_mac(pkt->eth, pkt->eth->h_dest);
 	trn_set_dst_mac(pkt->eth, ep->hmac);
 
-	if (appendTail && flow->protocol != IPPROTO_ICMP && !pkt_not_add_tail) {
-		struct xdp_hints_src *h_src;
-		__u8 offset = sizeof(*h_src);
+	if (hint && (pkt->itf->options & TRAN_ITF_OPT_HINT_HDR)) {
+		trn_set_hint_hdr(pkt, tip);
+	} else if (hint && !pkt_not_add_tail) {
+		struct xdp_hints_src h_src;
+		__u32 offset = bpf_ntohs(pkt->ip->tot_len) + sizeof(struct ethhdr);
 
-		__u16 ip_tot_len = bpf_ntohs(pkt->ip->tot_len);
-
-		if (ip_tot_len < 2) {
+		if (offset < sizeof(struct ethhdr) + 2) {
 			return XDP_DROP;
 		}
 
-#if 0
-		pkt_not_add_tail = bpf_xdp_adjust_tail(pkt->xdp, sizeof(struct xdp_hints_src));
-		if (pkt_not_add_tail) {
-			bpf_debug("[Transit:%d] XXXX TX: bpf_xdp_adjust_tail failed", __LINE__);
-			return XDP_DROP;
+		/*
+		 * Jumbo frames may carry the tail in a fragment, the hint is
+		 * written through the helper rather than past data_end.
+		 */
+		if (offset + sizeof(h_src) > bpf_xdp_get_buff_len(pkt->xdp)) {
+			return XDP_ABORTED;
 		}
-#endif
 
-		ip_tot_len &= 0xFFF; // Max 4095
-		if ((void *)pkt->data + ip_tot_len + sizeof(struct xdp_hints_src) + sizeof(struct ethhdr) > pkt->data_end) {
+		h_src.vni = pkt->vni;
+		h_src.saddr = tip;
+		h_src.flags = TRAN_HINTS_SRC_FLAGS;
+		trn_set_mac(h_src.h_source, pkt->eth->h_source);
+
+		if (bpf_xdp_store_bytes(pkt->xdp, offset, &h_src, sizeof(h_src))) {
 			return XDP_ABORTED;
 		}
-
-		h_src = (void *)pkt->data + ip_tot_len + sizeof(struct ethhdr);
-		h_src->vni = pkt->vni;
-		h_src->saddr = tip;
-		h_src->flags = 0x5354;
-
-		h_src->h_source[0] = pkt->eth->h_source[0];
-		h_src->h_source[1] = pkt->eth->h_source[1];
-		h_src->h_source[2] = pkt->eth->h_source[2];
-		h_src->h_source[3] = pkt->eth->h_source[3];
-		h_src->h_source[4] = pkt->eth->h_source[4];
-		h_src->h_source[5] = pkt->eth->h_source[5];
 		
 		bpf_debug("   XXXX appendInfo   vni: %d saddr:0x%x h_source:%x ..\n",
-				h_src->vni,
-				bpf_ntohl(h_src->saddr), 
-				bpf_ntohl(*(__u32 *)h_src->h_source));
+				h_src.vni,
+				bpf_ntohl(h_src.saddr), 
+				bpf_ntohl(*(__u32 *)h_src.h_source));
 	}
 
 	bpf_debug("[Transit:%d] XXXX TX: Forward IP pkt from vni:%d ip:0x%x\n",
@@ -385,83 +1253,279 @@ static __inline int trn_process_inner_arp(struct transit_packet *pkt)
 		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.inner_l3_off = pkt->meta.inner_l2_off + sizeof(*pkt->inner_eth);
+
+	if (pkt->inner_arp->ar_pro != bpf_htons(ETH_P_IP) ||
+	    pkt->inner_arp->ar_hrd != bpf_htons(ARPHRD_ETHER)) {
+		bpf_debug("[Transit:%d] DROP: inner ARP unsupported protocol"
+			  " or Hardware type!\n", pkt->itf_idx);
+		return XDP_DROP;
+	}
+
+	if (pkt->inner_arp->ar_op != bpf_htons(ARPOP_REQUEST)) {
+		/* Gratuitous ARP replies are broadcast */
+		if (trn_feature(TRAN_XDP_FEAT_BUM) &&
+		    trn_is_bum(pkt->inner_eth->h_dest)) {
+			return BUM_FLOOD;
+		}
+		bpf_debug("[Transit:%d] DROP: not inner ARP REQUEST\n",
+			pkt->itf_idx);
+		return XDP_DROP;
+	}
+
+	sha = (unsigned char *)(pkt->inner_arp + 1);
+
+	if (sha + ETH_ALEN > pkt->data_end) {
+		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, sender ha overrun\n",
+			  pkt->itf_idx);
+		return XDP_ABORTED;
+	}
+
+	sip = (__u32 *)(sha + ETH_ALEN);
+
+	if (sip + 1 > pkt->data_end) {
+		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, sender ip overrun\n",
+			  pkt->itf_idx);
+		return XDP_ABORTED;
+	}
+
+	tha = (unsigned char *)sip + sizeof(__u32);
+
+	if (tha + ETH_ALEN > pkt->data_end) {
+		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, target ha overrun\n",
+			  pkt->itf_idx);
+		return XDP_ABORTED;
+	}
+
+	tip = (__u32 *)(tha + ETH_ALEN);
+
+	if (tip + 1 > pkt->data_end) {
+		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, target ip overrun\n",
+			  pkt->itf_idx);
+		return XDP_ABORTED;
+	}
+
+	/* Gratuitous ARP announces the sender, nobody to answer for */
+	if (trn_feature(TRAN_XDP_FEAT_BUM) && *sip == *tip) {
+		return BUM_FLOOD;
+	}
+
+	/* Valid inner ARP request, look up target endpoint */
+	epkey.vni = pkt->vni;
+	epkey.ip = *tip;
+	ep = trn_lookup_endpoint(pkt, &epkey);
+	if (!ep) {
+		bpf_debug("[Transit:%d] DROP: inner ARP Request failed to find endpoint "
+			"vni:0x%x ip:0x%x\n", pkt->itf_idx, epkey.vni, bpf_ntohl(epkey.ip));
+		return EP_NOT_FOUND;
+	}
+
+	/* Modify pkt for inner ARP response */
+	pkt->inner_arp->ar_op = bpf_htons(ARPOP_REPLY);
+	trn_set_mac(tha, sha);
+	trn_set_mac(sha, ep->mac);
+
+	__u32 tmp_ip = *sip;
+	*sip = *tip;
+	*tip = tmp_ip;
+
+	/* Modify inner EitherHdr, pretend it's from target */
+	trn_set_dst_mac(pkt->inner_eth, pkt->inner_eth->h_source);
+	trn_set_src_mac(pkt->inner_eth, ep->mac);
+
+	/* Keep overlay header, swap outer IP header */
+	trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, pkt->ip->saddr, pkt->data_end);
+	trn_swap_src_dst_mac(pkt->data);
+
+	bpf_debug("[Transit:%d] TX: ARP respond for vni:%d ip:0x%x\n",
+		pkt->itf_idx, pkt->vni, bpf_ntohl(*sip));
+	bpf_debug("[Transit:%d] TX:     To ip:0x%x host:0x%x\n",
+		pkt->itf_idx, bpf_ntohl(*tip), bpf_ntohl(pkt->ip->daddr));
+
+	return XDP_TX;
+}
+
+/*
+ * Answer a tenant neighbor solicitation for a known IPv6 endpoint, the
+ * frame is turned into the advertisement in place as ARP requests are.
+ * Returns XDP_PASS for solicitations left to forwarding: DAD probes have
+ * no source address, unicast NUD ones usually no link-layer option.
+ */
+static __inline int trn_process_inner_ndp(struct transit_packet *pkt)
+{
+	struct ipv6hdr *ip6 = pkt->inner_ip6;
+	struct trn_ndp_msg *ndp = (void *)(ip6 + 1);
+	__be32 *saddr = ip6->saddr.in6_u.u6_addr32;
+	__be32 *daddr = ip6->daddr.in6_u.u6_addr32;
+	endpoint_key6_t epkey;
+	endpoint_t *ep;
+	struct {
+		__be32 saddr[4];
+		__be32 daddr[4];
+		__be32 len;
+		__be32 nexthdr;
+	} ph;
+	int csum, i;
+
+	if (ndp + 1 > pkt->data_end)
+		return XDP_PASS;
+
+	if (ip6->hop_limit != TRN_NDP_HOP_LIMIT || ndp->icmp.icmp6_code ||
+	    ip6->payload_len != bpf_htons(sizeof(*ndp)) ||
+	    ndp->opt_type != TRN_NDP_OPT_SLLA || ndp->opt_len != 1 ||
+	    !(saddr[0] | saddr[1] | saddr[2] | saddr[3]))
+		return XDP_PASS;
+
+	epkey.vni = pkt->vni;
+#pragma unroll
+	for (i = 0; i < 4; i++)
+		epkey.ip[i] = ndp->target[i];
+
+	ep = bpf_map_lookup_elem(&endpoints6_map, &epkey);
+	if (!ep) {
+		bpf_debug("[Transit:%d] DROP: inner NS failed to find endpoint "
+			  "vni:0x%x ip:..%x\n", pkt->itf_idx, epkey.vni,
+			  bpf_ntohl(epkey.ip[3]));
+		return EP_NOT_FOUND;
+	}
+
+	/* Advertise the target to the solicitor */
+#pragma unroll
+	for (i = 0; i < 4; i++) {
+		ph.daddr[i] = saddr[i];
+		ph.saddr[i] = ndp->target[i];
+		daddr[i] = ph.daddr[i];
+		saddr[i] = ph.saddr[i];
+	}
+	ph.len = bpf_htonl(sizeof(*ndp));
+	ph.nexthdr = bpf_htonl(IPPROTO_ICMPV6);
+
+	ndp->icmp.icmp6_type = TRN_NDP_NA;
+	ndp->icmp.icmp6_cksum = 0;
+	ndp->icmp.icmp6_dataun.un_data32[0] = bpf_htonl(TRN_NDP_NA_FLAGS);
+	ndp->opt_type = TRN_NDP_OPT_TLLA;
+	trn_set_mac(ndp->lladdr, ep->mac);
+
+	csum = bpf_csum_diff(NULL, 0, &ph, sizeof(ph), 0);
+	csum = bpf_csum_diff(NULL, 0, ndp, sizeof(*ndp), csum);
+	ndp->icmp.icmp6_cksum = trn_csum_fold_helper((__u32)csum);
+
+	/* Modify inner EtherHdr, pretend it's from target */
+	trn_set_dst_mac(pkt->inner_eth, pkt->inner_eth->h_source);
+	trn_set_src_mac(pkt->inner_eth, ep->mac);
+
+	/* Keep overlay header, swap outer IP header */
+	trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, pkt->ip->saddr, pkt->data_end);
+	trn_swap_src_dst_mac(pkt->data);
 
-	if (pkt->inner_arp->ar_pro != bpf_htons(ETH_P_IP) ||
-	    pkt->inner_arp->ar_hrd != bpf_htons(ARPHRD_ETHER)) {
-		bpf_debug("[Transit:%d] DROP: inner ARP unsupported protocol"
-			  " or Hardware type!\n", pkt->itf_idx);
-		return XDP_DROP;
-	}
+	bpf_debug("[Transit:%d] TX: NA respond for vni:%d ip:..%x\n",
+		  pkt->itf_idx, pkt->vni, bpf_ntohl(epkey.ip[3]));
 
-	if (pkt->inner_arp->ar_op != bpf_htons(ARPOP_REQUEST)) {
-		bpf_debug("[Transit:%d] DROP: not inner ARP REQUEST\n",
-			pkt->itf_idx);
-		return XDP_DROP;
-	}
+	return XDP_TX;
+}
 
-	sha = (unsigned char *)(pkt->inner_arp + 1);
+/*
+ * IPv6 counterpart of trn_process_inner_ip. Flows are not cached and
+ * security groups, identities and conntrack are IPv4 only, so IPv6 is
+ * dropped outright, neighbor solicitations included, while any policy
+ * feature is on rather than forwarded unchecked. Policers are keyed by
+ * IPv4 endpoints, IPv6 is held to the policer of its VNI only.
+ */
+static __inline int trn_process_inner_ipv6(struct transit_packet *pkt)
+{
+	struct icmp6hdr *icmp;
+	endpoint_key6_t epkey;
+	endpoint_t *ep;
+	__u32 *ports, l4 = 0;
+	int action, i;
 
-	if (sha + ETH_ALEN > pkt->data_end) {
-		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, sender ha overrun\n",
+	pkt->inner_ip6 = (void *)pkt->inner_eth + sizeof(*pkt->inner_eth);
+
+	if (pkt->inner_ip6 + 1 > pkt->data_end) {
+		bpf_debug("[Transit:%d] ABORTED: Bad inner IPv6 frame\n",
 			  pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.inner_l3_off = pkt->meta.inner_l2_off + sizeof(*pkt->inner_eth);
 
-	sip = (__u32 *)(sha + ETH_ALEN);
-
-	if (sip + 1 > pkt->data_end) {
-		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, sender ip overrun\n",
+	if (trn_feature(TRAN_XDP_FEAT_SG) || trn_feature(TRAN_XDP_FEAT_IDENTITY)) {
+		bpf_debug("[Transit:%d] DROP: inner IPv6 with security policy on\n",
 			  pkt->itf_idx);
-		return XDP_ABORTED;
+		return XDP_DROP;
 	}
 
-	tha = (unsigned char *)sip + sizeof(__u32);
+	/* Respond to tenant neighbor solicitation if needed */
+	if (trn_itf_role(pkt) == XDP_FWD &&
+	    pkt->inner_ip6->nexthdr == IPPROTO_ICMPV6) {
+		icmp = (void *)(pkt->inner_ip6 + 1);
+		if (icmp + 1 > pkt->data_end) {
+			bpf_debug("[Transit:%d] ABORTED: Bad inner ICMPv6 frame\n",
+				  pkt->itf_idx);
+			return XDP_ABORTED;
+		}
 
-	if (tha + ETH_ALEN > pkt->data_end) {
-		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, target ha overrun\n",
-			  pkt->itf_idx);
-		return XDP_ABORTED;
+		if (icmp->icmp6_type == TRN_NDP_NS) {
+			action = trn_process_inner_ndp(pkt);
+			if (action != XDP_PASS)
+				return action;
+		}
 	}
 
-	tip = (__u32 *)(tha + ETH_ALEN);
-
-	if (tip + 1 > pkt->data_end) {
-		bpf_debug("[Transit:%d] ABORTED: Bad inner ARP frame, target ip overrun\n",
+	/* Multicast, DAD included, goes to every host of the VNI */
+	if (trn_feature(TRAN_XDP_FEAT_BUM) && trn_itf_role(pkt) == XDP_FWD &&
+	    trn_is_bum(pkt->inner_eth->h_dest)) {
+		bpf_debug("[Transit:%d] Flooding inner IPv6 multicast\n",
 			  pkt->itf_idx);
-		return XDP_ABORTED;
+		return BUM_FLOOD;
 	}
 
-	/* Valid inner ARP request, look up target endpoint */
+	if (pkt->inner_ip6->nexthdr == IPPROTO_TCP ||
+	    pkt->inner_ip6->nexthdr == IPPROTO_UDP) {
+		ports = (void *)(pkt->inner_ip6 + 1);
+		if (ports + 1 > pkt->data_end) {
+			bpf_debug("[Transit:%d] ABORTED: Bad inner IPv6 L4 frame\n",
+				  pkt->itf_idx);
+			return XDP_ABORTED;
+		}
+		l4 = *ports;
+		pkt->meta.inner_l4_off = pkt->meta.inner_l3_off +
+					 sizeof(*pkt->inner_ip6);
+	}
+
+	pkt->meta.hash = trn_ipv6_flow_hash(pkt->inner_ip6, l4);
+	pkt->meta.flags |= TRN_XDP_META_HASH;
+
+	/* Look up target endpoint */
 	epkey.vni = pkt->vni;
-	epkey.ip = *tip;
-	ep = bpf_map_lookup_elem(&endpoints_map, &epkey);
+#pragma unroll
+	for (i = 0; i < 4; i++)
+		epkey.ip[i] = pkt->inner_ip6->daddr.in6_u.u6_addr32[i];
+
+	ep = bpf_map_lookup_elem(&endpoints6_map, &epkey);
 	if (!ep) {
-		bpf_debug("[Transit:%d] DROP: inner ARP Request failed to find endpoint "
-			"vni:0x%x ip:0x%x\n", pkt->itf_idx, epkey.vni, bpf_ntohl(epkey.ip));
-		return EP_NOT_FOUND;
+		bpf_debug("[Transit:%d] DROP: inner IPv6 forwarding failed to find endpoint "
+			  "vni:0x%x ip:..%x\n", pkt->itf_idx, epkey.vni,
+			  bpf_ntohl(epkey.ip[3]));
+		return XDP_DROP;
 	}
 
-	/* Modify pkt for inner ARP response */
-	pkt->inner_arp->ar_op = bpf_htons(ARPOP_REPLY);
-	trn_set_mac(tha, sha);
-	trn_set_mac(sha, ep->mac);
+	if (trn_feature(TRAN_XDP_FEAT_RATE_LIMIT) &&
+	    trn_rate_limit(pkt, 0) == XDP_DROP)
+		return XDP_DROP;
 
-	__u32 tmp_ip = *sip;
-	*sip = *tip;
-	*tip = tmp_ip;
+	pkt->meta.ep_hip = ep->hip;
+	pkt->meta.flags |= TRN_XDP_META_EP;
 
-	/* Modify inner EitherHdr, pretend it's from target */
-	trn_set_dst_mac(pkt->inner_eth, pkt->inner_eth->h_source);
-	trn_set_src_mac(pkt->inner_eth, ep->mac);
+	/* Modify inner EtherHdr */
+	trn_set_dst_mac(pkt->inner_eth, ep->mac);
 
-	/* Keep overlay header, swap outer IP header */
-	trn_set_src_dst_ip_csum(pkt->ip, pkt->ip->daddr, pkt->ip->saddr, pkt->data_end);
-	trn_swap_src_dst_mac(pkt->data);
+	/* Keep overlay header, update outer header destinations */
+	trn_rewrite_outer(pkt, &pkt->fctx.flow, ep);
+	trn_set_src_mac(pkt->eth, pkt->eth->h_dest);
+	trn_set_dst_mac(pkt->eth, ep->hmac);
 
-	bpf_debug("[Transit:%d] TX: ARP respond for vni:%d ip:0x%x\n",
-		pkt->itf_idx, pkt->vni, bpf_ntohl(*sip));
-	bpf_debug("[Transit:%d] TX:     To ip:0x%x host:0x%x\n",
-		pkt->itf_idx, bpf_ntohl(*tip), bpf_ntohl(pkt->ip->daddr));
+	bpf_debug("[Transit:%d] TX: Forward IPv6 pkt in vni:%d to host:0x%x\n",
+		  pkt->itf_idx, pkt->vni, bpf_ntohl(pkt->ip->daddr));
 
 	return XDP_TX;
 }
@@ -475,12 +1539,29 @@ static __inline int trn_process_inner_eth(struct transit_packet *pkt)
 	}
 
 	/* Respond to tenant ARP request if needed */
-	if (pkt->itf->role == XDP_FWD &&
+	if (trn_itf_role(pkt) == XDP_FWD &&
 		pkt->inner_eth->h_proto == bpf_htons(ETH_P_ARP)) {
 		bpf_debug("[Transit:%d] Processing inner ARP\n", pkt->itf_idx);
 		return trn_process_inner_arp(pkt);
 	}
 
+	if (pkt->inner_eth->h_proto == bpf_htons(ETH_P_IPV6)) {
+		bpf_debug("[Transit:%d] Processing inner IPv6\n", pkt->itf_idx);
+		return trn_process_inner_ipv6(pkt);
+	}
+
+	/*
+	 * Broadcast and multicast, and unicast frames not resolved by
+	 * endpoint lookup (non-IP), go to every host of the VNI
+	 */
+	if (trn_feature(TRAN_XDP_FEAT_BUM) && trn_itf_role(pkt) == XDP_FWD &&
+	    (trn_is_bum(pkt->inner_eth->h_dest) ||
+	     pkt->inner_eth->h_proto != bpf_htons(ETH_P_IP))) {
+		bpf_debug("[Transit:%d] Flooding inner BUM frame\n",
+			  pkt->itf_idx);
+		return BUM_FLOOD;
+	}
+
 	if (pkt->inner_eth->h_proto != bpf_htons(ETH_P_IP)) {
 		bpf_debug(
 			"[Transit:%d] DROP: non-IP/ARP inner packet, protocol %d\n",
@@ -494,11 +1575,14 @@ static __inline int trn_process_inner_eth(struct transit_packet *pkt)
 
 static __inline int trn_process_geneve(struct transit_packet *pkt)
 {
+	struct ftn_t *ftn;
+
 	pkt->overlay.geneve.hdr = (void *)pkt->udp + sizeof(*pkt->udp);
 	if (pkt->overlay.geneve.hdr + 1 > pkt->data_end) {
 		bpf_debug("[Transit:%d] ABORTED: Bad Geneve frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.ovl_off = pkt->meta.l4_off + sizeof(*pkt->udp);
 
 	if (pkt->overlay.geneve.hdr->proto_type != bpf_htons(ETH_P_TEB)) {
 		bpf_debug(
@@ -539,6 +1623,23 @@ static __inline int trn_process_geneve(struct transit_packet *pkt)
 	}
 	pkt->overlay.geneve.gnv_hdr_len += sizeof(*pkt->overlay.geneve.scaled_ep_opt);
 
+	pkt->src_identity = 0;
+	if (pkt->overlay.geneve.gnv_opt_len > pkt->overlay.geneve.gnv_hdr_len) {
+		struct trn_gnv_identity_opt *id_opt =
+			(void *)pkt->overlay.geneve.scaled_ep_opt +
+			sizeof(*pkt->overlay.geneve.scaled_ep_opt);
+
+		if (id_opt + 1 > pkt->data_end ||
+		    id_opt->opt_class != TRN_GNV_OPT_CLASS ||
+		    id_opt->type != TRN_GNV_IDENTITY_OPT_TYPE) {
+			bpf_debug("[Transit:%d] ABORTED: Bad Geneve identity option\n",
+				  pkt->itf_idx);
+			return XDP_ABORTED;
+		}
+		pkt->src_identity = bpf_ntohs(id_opt->identity);
+		pkt->overlay.geneve.gnv_hdr_len += sizeof(*id_opt);
+	}
+
 	if (pkt->overlay.geneve.gnv_hdr_len != pkt->overlay.geneve.gnv_opt_len) {
 		bpf_debug("[Transit:%d] ABORTED: Bad Geneve option size\n", pkt->itf_idx);
 		return XDP_ABORTED;
@@ -548,10 +1649,18 @@ static __inline int trn_process_geneve(struct transit_packet *pkt)
 	pkt->vni = trn_get_vni(pkt->overlay.geneve.hdr->vni);
 
 	pkt->inner_eth = (void *)pkt->overlay.geneve.hdr + pkt->overlay.geneve.gnv_hdr_len;
+	pkt->meta.vni = pkt->vni;
+	pkt->meta.inner_l2_off = pkt->meta.ovl_off + pkt->overlay.geneve.gnv_hdr_len;
 
 	bpf_debug("[Transit:%d] XXX received packet at %d(vni = %d)\n",
 			  __LINE__, pkt->itf_idx, pkt->vni);
 
+	/* Only the tail of a chain resolves the endpoint */
+	ftn = bpf_map_lookup_elem(&ftns_map, &pkt->itf->ftn_id);
+	if (ftn && ftn->position != TRAN_FTN_TYPE_TAIL) {
+		return trn_ftn_forward(pkt, ftn);
+	}
+
 	return trn_process_inner_eth(pkt);
 }
 
@@ -562,10 +1671,18 @@ static __inline int trn_process_vxlan(struct transit_packet *pkt)
 		bpf_debug("[Transit:%d] ABORTED: Bad VxLan frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.ovl_off = pkt->meta.l4_off + sizeof(*pkt->udp);
 
 	pkt->vni = trn_get_vni(pkt->overlay.vxlan->vni);
 
+	pkt->src_identity = 0;
+	if (pkt->overlay.vxlan->rsvd2 & TRN_VXLAN_GBP_FLAG)
+		pkt->src_identity = pkt->overlay.vxlan->rsvd3[1] << 8 |
+				    pkt->overlay.vxlan->rsvd3[2];
+
 	pkt->inner_eth = (void *)(pkt->overlay.vxlan + 1);
+	pkt->meta.vni = pkt->vni;
+	pkt->meta.inner_l2_off = pkt->meta.ovl_off + sizeof(*pkt->overlay.vxlan);
 
 	bpf_debug("[Transit:%d] XXX received packet at %d(vni = %d)\n",
 			  __LINE__, pkt->itf_idx, pkt->vni);
@@ -582,10 +1699,11 @@ static __inline int trn_process_udp(struct transit_packet *pkt)
 		bpf_debug("[Transit:%d] ABORTED: Bad UDP frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.l4_off = pkt->meta.l3_off + sizeof(*pkt->ip);
 
-	if (pkt->udp->dest == GEN_DSTPORT && pkt->itf->role == XDP_FTN) {
+	if (trn_itf_role(pkt) == XDP_FTN && pkt->udp->dest == GEN_DSTPORT) {
 		return trn_process_geneve(pkt);
-	} else if (pkt->udp->dest == VXL_DSTPORT && pkt->itf->role == XDP_FWD) {
+	} else if (trn_itf_role(pkt) == XDP_FWD && pkt->udp->dest == VXL_DSTPORT) {
 		return trn_process_vxlan(pkt);
 	}
 
@@ -603,10 +1721,11 @@ static __inline int trn_process_ip(struct transit_packet *pkt)
 		bpf_debug("[Transit:%d] ABORTED: Bad IP frame\n", pkt->itf_idx);
 		return XDP_ABORTED;
 	}
+	pkt->meta.l3_off = sizeof(*pkt->eth);
 
-	if (pkt->ip->daddr != pkt->itf->entrances[pkt->ent_idx].ip) {
+	if (pkt->ip->daddr != pkt->ent_ip) {
 		bpf_debug("[Transit:%d] ABORTED: IP frame mismatch 0x%x-0x%x\n",
-			pkt->itf_idx, pkt->ip->daddr, pkt->itf->entrances[pkt->ent_idx].ip);
+			pkt->itf_idx, pkt->ip->daddr, pkt->ent_ip);
 		return XDP_ABORTED;
 	}
 
@@ -629,7 +1748,9 @@ static __inline int trn_process_ip(struct transit_packet *pkt)
 
 static __inline int trn_process_eth(struct transit_packet *pkt)
 {
-	__u16 i;
+	entrance_key_t entkey;
+	entrance_t *ent;
+
 	pkt->eth = pkt->data;
 
 	if (pkt->eth + 1 > pkt->data_end) {
@@ -647,59 +1768,375 @@ static __inline int trn_process_eth(struct transit_packet *pkt)
 	bpf_debug("[Transit:%d] XXX received packet at %d(%d)\n",
 			  __LINE__, pkt->itf_idx, pkt->itf->num_entrances);
 
-	// there's some logic error in assigning entrances for each itf
-	for (i = 0; i < pkt->itf->num_entrances && i < TRAN_MAX_ZGC_ENTRANCES; i++) {
-		if (trn_is_mac_equal(pkt->eth->h_dest, pkt->itf->entrances[i].mac)) {
-
-			bpf_debug("[Transit:%d] XXX received packet at mac:%x..%x\n",
-					i, pkt->eth->h_dest[0], pkt->eth->h_dest[5]);
+	/* Entrances are indexed by (ifindex, mac), cost doesn't grow with
+	 * the number of entrances announced on the droplet */
+	__builtin_memset(&entkey, 0, sizeof(entkey));
+	entkey.iface_index = pkt->itf_idx;
+	trn_set_mac(entkey.mac, pkt->eth->h_dest);
 
-			pkt->ent_idx = i;/* Packet is destinated to us */
-			trn_set_mac(pkt->itf_mac, pkt->eth->h_dest);
-			return trn_process_ip(pkt);
-		} 
+	ent = bpf_map_lookup_elem(&entrances_map, &entkey);
+	if (!ent) {
+		bpf_debug("[Transit:%d] ABORTED: Ethernet frame not for us, mac:%x..%x\n",
+			pkt->itf_idx, pkt->eth->h_dest[0], pkt->eth->h_dest[5]);
+		return XDP_ABORTED;
 	}
 
-	bpf_debug("[Transit:%d] ABORTED: Ethernet frame not for us, mac:%x..%x\n",
-		pkt->itf_idx, pkt->eth->h_dest[0], pkt->eth->h_dest[5]);
-	return XDP_ABORTED;
+	bpf_debug("[Transit:%d] XXX received packet at mac:%x..%x\n",
+			ent->idx, pkt->eth->h_dest[0], pkt->eth->h_dest[5]);
+
+	pkt->ent_idx = ent->idx;/* Packet is destinated to us */
+	pkt->ent_ip = ent->ip;
+	trn_set_mac(pkt->itf_mac, pkt->eth->h_dest);
+	return trn_process_ip(pkt);
 }
 
-SEC("transit")
-int _transit(struct xdp_md *ctx)
+/*
+ * Hash the inner flow of an overlay packet. All tunnel traffic between a
+ * compute node and an entrance shares one outer 5-tuple and lands on one
+ * RSS queue, the inner flow is what tells flows apart. Flows toward
+ * endpoints not known yet are not hashed, their misses must reach the
+ * AF_XDP socket of the queue they came in.
+ */
+static __inline int trn_get_inner_flow_hash(void *data, void *data_end,
+					    __u32 *hash)
 {
-	if (appendTail) {
-		//__u8 apendlen = sizeof(struct xdp_hints_src);
-		//bpf_debug("[Transit::%d] XXXX Tx: addr: %x, len=%d\n", 
-		//		__LINE__, ctx->data, ctx->data_end - ctx->data);
-		pkt_not_add_tail = bpf_xdp_adjust_tail(ctx, sizeof(struct xdp_hints_src));
-		if (pkt_not_add_tail) {
-			bpf_debug("[Transit:%d] XXXX TX: Appending IP pkt failed.\n", __LINE__);
-		} else {
-			//__u16 len = ctx->data_end - ctx->data;
-			//bpf_debug("[Transit:%d] XXXX TX: Appending IP pkt succeeded(len=%d -- %d).\n", 
-			//	__LINE__, len, apendlen);
+	struct ethhdr *eth = data;
+	struct iphdr *ip, *inner_ip;
+	struct udphdr *udp;
+	struct vxlanhdr *vxl;
+	struct genevehdr *gnv;
+	struct ethhdr *inner_eth;
+	struct ipv6hdr *inner_ip6;
+	endpoint_key6_t ep6key;
+	endpoint_key_t epkey;
+	__u32 *ports, l4 = 0, vni;
+
+	ip = (void *)(eth + 1);
+	if (ip + 1 > data_end || eth->h_proto != bpf_htons(ETH_P_IP) ||
+	    ip->protocol != IPPROTO_UDP)
+		return 1;
+
+	udp = (void *)(ip + 1);
+	if (udp + 1 > data_end)
+		return 1;
+
+	if (TRN_ROLE_ENABLED(XDP_FWD) && udp->dest == VXL_DSTPORT) {
+		vxl = (void *)(udp + 1);
+		if (vxl + 1 > data_end)
+			return 1;
+		vni = trn_get_vni(vxl->vni);
+		inner_eth = (void *)(vxl + 1);
+	} else if (TRN_ROLE_ENABLED(XDP_FTN) && udp->dest == GEN_DSTPORT) {
+		gnv = (void *)(udp + 1);
+		if (gnv + 1 > data_end)
+			return 1;
+		vni = trn_get_vni(gnv->vni);
+		inner_eth = (void *)(gnv + 1) + gnv->opt_len * 4;
+	} else {
+		return 1;
+	}
+
+	inner_ip6 = (void *)(inner_eth + 1);
+	if (inner_ip6 + 1 <= data_end &&
+	    inner_eth->h_proto == bpf_htons(ETH_P_IPV6)) {
+		if (trn_is_bum(inner_eth->h_dest))
+			return 1;
+
+		if (inner_ip6->nexthdr == IPPROTO_TCP ||
+		    inner_ip6->nexthdr == IPPROTO_UDP) {
+			ports = (void *)(inner_ip6 + 1);
+			if (ports + 1 > data_end)
+				return 1;
+			l4 = *ports;
 		}
+
+		ep6key.vni = vni;
+		__builtin_memcpy(ep6key.ip, &inner_ip6->daddr, sizeof(ep6key.ip));
+		if (!bpf_map_lookup_elem(&endpoints6_map, &ep6key))
+			return 1;
+
+		*hash = trn_ipv6_flow_hash(inner_ip6, l4);
+		return 0;
 	}
 
-	struct transit_packet pkt;
-	pkt.data = (void *)(long)ctx->data;
-	pkt.data_end = (void *)(long)ctx->data_end;
-	pkt.xdp = ctx;
-	pkt.itf_idx = ctx->ingress_ifindex;
+	inner_ip = (void *)(inner_eth + 1);
+	if (inner_ip + 1 > data_end ||
+	    inner_eth->h_proto != bpf_htons(ETH_P_IP))
+		return 1;
+
+	/* BUM frames are replicated from the RX CPU, see trn_flood */
+	if (trn_is_bum(inner_eth->h_dest))
+		return 1;
+
+	if (inner_ip->protocol == IPPROTO_TCP ||
+	    inner_ip->protocol == IPPROTO_UDP) {
+		ports = (void *)(inner_ip + 1);
+		if (ports + 1 > data_end)
+			return 1;
+		l4 = *ports;
+	}
+
+	epkey.vni = vni;
+	epkey.ip = inner_ip->daddr;
+	if (!bpf_map_lookup_elem(&endpoints_map, &epkey))
+		return 1;
+
+	*hash = jhash_3words(inner_ip->saddr, inner_ip->daddr,
+			     l4 ^ inner_ip->protocol, INIT_JHASH_SEED);
+	return 0;
+}
+
+/* Redirect to a worker CPU through cpu_map, returns 0 if redirected */
+static __inline int trn_cpu_spread(struct xdp_md *ctx, int *action)
+{
+	void *data = (void *)(long)ctx->data;
+	void *data_end = (void *)(long)ctx->data_end;
+	cpu_spread_stats_t *stats;
+	cpu_spread_cfg_t *cfg;
+	__u32 key = 0, hash, idx, *cpu;
+
+	/* cpu_map runs the CPUMAP stage of the tenant object only */
+	if (!TRN_ROLE_ENABLED(XDP_FWD))
+		return 1;
+
+	cfg = bpf_map_lookup_elem(&cpu_spread_cfg_map, &key);
+	if (!cfg || !cfg->num_cpus || cfg->num_cpus > TRAN_MAX_SPREAD_CPUS)
+		return 1;
+
+	/* Non-overlay frames, ARP, BUM and misses are handled on the RX CPU */
+	if (trn_get_inner_flow_hash(data, data_end, &hash))
+		return 1;
+
+	idx = hash % cfg->num_cpus;
+	cpu = bpf_map_lookup_elem(&cpus_available, &idx);
+	if (!cpu)
+		return 1;
+
+	*action = bpf_redirect_map(&cpu_map, *cpu, 0);
+	if (*action != XDP_REDIRECT)
+		return 1;
+
+	stats = bpf_map_lookup_elem(&cpu_spread_stats_map, &key);
+	if (stats)
+		stats->redirected++;
+
+	return 0;
+}
+
+static __inline int trn_transit(struct xdp_md *ctx, struct transit_packet *pkt)
+{
+	pkt->xdp = ctx;
+	pkt->itf_idx = ctx->ingress_ifindex;
+	__builtin_memset(&pkt->meta, 0, sizeof(pkt->meta));
+	pkt->miss_ip = 0;
 	
 	// maybe get rid of this check?
-	pkt.itf = bpf_map_lookup_elem(&if_config_map, &pkt.itf_idx);
-	if (!pkt.itf) {
+	pkt->itf = bpf_map_lookup_elem(&if_config_map, &pkt->itf_idx);
+	if (!pkt->itf) {
 		bpf_debug("[Transit:%d] ABORTED: Failed to lookup ingress config for %d\n",
-			  __LINE__, pkt.itf_idx);
+			  __LINE__, pkt->itf_idx);
 		return XDP_ABORTED;
 	}
 
+	/* Trailer hints grow the packet, header hints keep its size */
+	if (trn_feature(TRAN_XDP_FEAT_APPEND_TAIL) &&
+	    !(pkt->itf->options & TRAN_ITF_OPT_HINT_HDR)) {
+		pkt_not_add_tail = bpf_xdp_adjust_tail(ctx, sizeof(struct xdp_hints_src));
+		if (pkt_not_add_tail) {
+			bpf_debug("[Transit:%d] XXXX TX: Appending IP pkt failed.\n", __LINE__);
+		}
+	}
+
+	pkt->data = (void *)(long)ctx->data;
+	pkt->data_end = (void *)(long)ctx->data_end;
+
 	//bpf_debug("[Transit:%d] XXX received packet at %d\n",
-	//		  __LINE__, pkt.itf_idx);
+	//		  __LINE__, pkt->itf_idx);
+
+	return trn_process_eth(pkt);
+}
+
+/*
+ * Leave the parse descriptor in front of the frame for the stage about
+ * to be tail called. Packet pointers are invalidated, only ctx is valid
+ * afterwards. Drivers without metadata support leave stages without it.
+ */
+static __inline void trn_export_xdp_meta(struct xdp_md *ctx,
+					 struct transit_packet *pkt)
+{
+	struct trn_xdp_meta *meta;
+
+	if (bpf_xdp_adjust_meta(ctx, -(int)sizeof(*meta))) {
+		bpf_debug("[Transit:%d] No room for XDP metadata\n", __LINE__);
+		return;
+	}
+
+	meta = trn_get_xdp_meta(ctx);
+	if (meta)
+		__builtin_memcpy(meta, &pkt->meta, sizeof(*meta));
+}
+
+/*
+ * Tail call the first stage of the verdict's pipeline. Verdicts without
+ * stages, per stage_cfg_map, skip the tail call and metadata altogether.
+ * Returns only if no stage ran.
+ */
+static __inline void trn_run_stages(struct xdp_md *ctx,
+				    struct transit_packet *pkt,
+				    __u32 prog, int action)
+{
+	__u32 key = 0, *mask;
+
+	mask = bpf_map_lookup_elem(&stage_cfg_map, &key);
+	if (!mask || !(*mask & (1 << prog)))
+		return;
+
+	pkt->meta.stage = TRAN_STAGE_SLOT(prog, 0);
+	pkt->meta.action = action;
+	trn_export_xdp_meta(ctx, pkt);
+	bpf_tail_call(ctx, &jmp_table, TRAN_STAGE_SLOT(prog, 0));
+}
+
+static __inline flood_stats_t *trn_flood_stats(__u32 vni)
+{
+	flood_stats_t zero, *stats;
+
+	stats = bpf_map_lookup_elem(&flood_stats_map, &vni);
+	if (stats)
+		return stats;
+
+	__builtin_memset(&zero, 0, sizeof(zero));
+	bpf_map_update_elem(&flood_stats_map, &vni, &zero, BPF_NOEXIST);
+	return bpf_map_lookup_elem(&flood_stats_map, &vni);
+}
+
+/*
+ * Replicate a BUM frame to the flood list of its VNI. The devmap of the
+ * VNI in flood_devmaps_map has exactly one slot per host under the cap,
+ * so the broadcast makes no more copies than the list needs. Slot idx
+ * runs the egress program of that slot, which rewrites its copy toward
+ * host idx. Only VxLAN frames are flooded, copies are rewritten as such.
+ */
+static __inline int trn_flood(struct transit_packet *pkt)
+{
+	struct flood_list_t *fl;
+	flood_stats_t *stats;
+	void *devmap;
+
+	stats = trn_flood_stats(pkt->vni);
+	if (stats)
+		stats->frames++;
+
+	if (trn_itf_role(pkt) != XDP_FWD) {
+		bpf_debug("[Transit:%d] DROP: Geneve BUM frame of vni:%d\n",
+			  pkt->itf_idx, pkt->vni);
+		if (stats)
+			stats->rejected++;
+		return XDP_DROP;
+	}
+
+	fl = bpf_map_lookup_elem(&flood_lists_map, &pkt->vni);
+	devmap = bpf_map_lookup_elem(&flood_devmaps_map, &pkt->vni);
+	if (!fl || !fl->nhosts || !devmap) {
+		bpf_debug("[Transit:%d] DROP: no flood list of vni:%d\n",
+			  pkt->itf_idx, pkt->vni);
+		if (stats)
+			stats->dropped++;
+		return XDP_DROP;
+	}
+
+	if (fl->cap && fl->nhosts > fl->cap && stats)
+		stats->capped++;
+
+	return bpf_redirect_map(devmap, 0, BPF_F_BROADCAST);
+}
+
+/*
+ * Decide whether a packet missing its endpoint may go to the slow path.
+ * Keys the slow path failed to resolve are dropped until their negative
+ * cache entry expires; otherwise the source host and the VNI must each
+ * have an upcall token left. Returns XDP_DROP if throttled, else
+ * EP_NOT_FOUND.
+ */
+static __inline int trn_admit_upcall(struct transit_packet *pkt)
+{
+	endpoint_key_t epkey = { .vni = pkt->vni, .ip = pkt->miss_ip };
+	upcall_key_t ukey;
+	upcall_stats_t *stats;
+	upcall_cfg_t *cfg;
+	__u64 *expiry;
+	__u32 key = 0;
+
+	stats = bpf_map_lookup_elem(&upcall_stats_map, &key);
+	cfg = bpf_map_lookup_elem(&upcall_cfg_map, &key);
+	if (!cfg || !stats)
+		return EP_NOT_FOUND;
+
+	if (epkey.ip) {
+		expiry = bpf_map_lookup_elem(&miss_neg_map, &epkey);
+		if (expiry && bpf_ktime_get_ns() < *expiry) {
+			stats->negative++;
+			return XDP_DROP;
+		}
+	}
+
+	if (pkt->ip + 1 > pkt->data_end)
+		return XDP_DROP;
+
+	ukey.vni = TRAN_UPCALL_HOST_VNI;
+	ukey.hip = pkt->ip->saddr;
+	if (trn_token_take(&upcall_buckets_map, &ukey, cfg->host_pps, 0,
+			   cfg->gen, 0)) {
+		stats->throttled_host++;
+		return XDP_DROP;
+	}
+
+	ukey.vni = pkt->vni;
+	ukey.hip = 0;
+	if (trn_token_take(&upcall_buckets_map, &ukey, cfg->vni_pps, 0,
+			   cfg->gen, 0)) {
+		stats->throttled_vni++;
+		return XDP_DROP;
+	}
+
+	stats->admitted++;
+	return EP_NOT_FOUND;
+}
+
+/* Hand a packet the endpoint of which is unknown to the AF_XDP slow path */
+static __inline int trn_redirect_to_xsk(struct xdp_md *ctx,
+					struct transit_packet *pkt)
+{
+	/*
+	 * A set entry here means that the corresponding quie_id
+	 * has an active AF_XDP socket bound to it. Sockets are keyed
+	 * by interface role so FWD and FTN queues don't collide.
+	 */
+	__u32 rx_q_index = ctx->rx_queue_index;
+	bpf_debug("Going to send packet to rx_queue with index: %u", __LINE__, rx_q_index);
+	if (pkt->itf && rx_q_index < TRAN_MAX_XSK_QUEUES) {
+		__u32 xsk_key = TRAN_XSK_MAP_KEY(trn_itf_role(pkt), rx_q_index);
+
+		if (bpf_map_lookup_elem(&xsks_map, &xsk_key)) {
+			bpf_debug("Sending packet to user space via AF_XDP\n",
+				  __LINE__);
+			return bpf_redirect_map(&xsks_map, xsk_key, 0);
+		}
+	}
+	// if the packet forwarding to the userspace fails, drop the packet.
+	return XDP_DROP;
+}
 
-	int action = trn_process_eth(&pkt);
+SEC("transit")
+int _transit(struct xdp_md *ctx)
+{
+	struct transit_packet pkt;
+	int action;
+
+	if (!trn_cpu_spread(ctx, &action))
+		return action;
+
+	action = trn_transit(ctx, &pkt);
 
 	/* The agent may tail-call this program, override XDP_TX to
 	 * redirect to egress instead */
@@ -707,35 +2144,29 @@ int _transit(struct xdp_md *ctx)
 		action = bpf_redirect_map(&interfaces_map, pkt.itf_idx, 0);
 */
 	if (action == XDP_PASS) {
-		__u32 key = TRAN_PASS_PROG;
-		bpf_tail_call(pkt.xdp, &jmp_table, key);
+		trn_run_stages(ctx, &pkt, TRAN_PASS_PROG, XDP_PASS);
 		return xdpcap_exit(ctx, &xdpcap_hook, XDP_PASS);
 	}
 
-    if (action == EP_NOT_FOUND) {
-        /*
-         * A set entry here means that the corresponding quie_id
-         * has an active AF_XDP socket bound to it.
-         */
-        __u32 rx_q_index = ctx->rx_queue_index;
-        bpf_debug("Going to send packet to rx_queue with index: %u", __LINE__, rx_q_index);
-        if (bpf_map_lookup_elem(&xsks_map, &(rx_q_index))) {
-            bpf_debug("Sending packet to user space via AF_XDP\n",
-                      __LINE__);
-            return bpf_redirect_map(&xsks_map, rx_q_index, 0);
-        }
-        // if the packet forwarding to the userspace fails, drop the packet.
-        action = XDP_DROP;
-    }
+	if (action == EP_NOT_FOUND && trn_feature(TRAN_XDP_FEAT_MISS_GUARD))
+		action = trn_admit_upcall(&pkt);
+
+	if (action == EP_NOT_FOUND) {
+		action = trn_redirect_to_xsk(ctx, &pkt);
+		if (action == XDP_REDIRECT)
+			return action;
+	}
+
+	if (action == BUM_FLOOD)
+		action = trn_flood(&pkt);
+
 	if (action == XDP_DROP) {
-		__u32 key = TRAN_DROP_PROG;
-		bpf_tail_call(pkt.xdp, &jmp_table, key);
+		trn_run_stages(ctx, &pkt, TRAN_DROP_PROG, XDP_DROP);
 		return xdpcap_exit(ctx, &xdpcap_hook, XDP_DROP);
 	}
 
 	if (action == XDP_TX) {
-		__u32 key = TRAN_TX_PROG;
-		bpf_tail_call(pkt.xdp, &jmp_table, key);
+		trn_run_stages(ctx, &pkt, TRAN_TX_PROG, XDP_TX);
 		return xdpcap_exit(ctx, &xdpcap_hook, XDP_TX);
 	}
 
@@ -743,12 +2174,277 @@ int _transit(struct xdp_md *ctx)
 		return xdpcap_exit(ctx, &xdpcap_hook, XDP_ABORTED);
 
 	if (action == XDP_REDIRECT) {
-		__u32 key = TRAN_REDIRECT_PROG;
-		bpf_tail_call(pkt.xdp, &jmp_table, key);
+		trn_run_stages(ctx, &pkt, TRAN_REDIRECT_PROG, XDP_REDIRECT);
 		return xdpcap_exit(ctx, &xdpcap_hook, XDP_REDIRECT);
 	}
 
 	return xdpcap_exit(ctx, &xdpcap_hook, XDP_PASS);
 }
 
+/*
+ * Second stage of RX spreading, runs on the worker CPU picked by
+ * trn_cpu_spread. CPUMAP programs can't XDP_TX nor tail call programs
+ * attached to other hooks, so hairpin through interfaces_map instead,
+ * and the stage pipeline and xdpcap are not run. Misses are kept on the
+ * RX CPU, only endpoints removed after spreading miss here. The original
+ * rx queue is lost, CPUMAP reports every frame on queue 0, so those go
+ * to the slow path socket of queue 0.
+ */
+SEC("xdp_cpumap/transit")
+int _transit_cpumap(struct xdp_md *ctx)
+{
+	struct transit_packet pkt;
+	cpu_spread_stats_t *stats;
+	__u32 key = 0;
+	int action;
+
+	stats = bpf_map_lookup_elem(&cpu_spread_stats_map, &key);
+	if (stats)
+		stats->processed++;
+
+	action = trn_transit(ctx, &pkt);
+
+	if (action == XDP_TX && pkt.itf)
+		return bpf_redirect_map(&interfaces_map, trn_itf_role(&pkt), 0);
+
+	if (action == EP_NOT_FOUND) {
+		if (stats)
+			stats->missed++;
+		return trn_redirect_to_xsk(ctx, &pkt);
+	}
+
+	/* BUM frames are not spread, see trn_get_inner_flow_hash */
+	if (action == XDP_ABORTED || action == XDP_TX || action == BUM_FLOOD)
+		return XDP_DROP;
+
+	return action;
+}
+
+/*
+ * Egress of the copy of a BUM frame in devmap slot idx of its VNI, on
+ * the CPU that ran trn_flood. Slot idx sends to host idx of the flood
+ * list. Slots past the cap or list end, left while transitd resizes the
+ * devmap, and copies toward the source host are dropped. The outer
+ * source becomes the entrance the frame came in.
+ */
+static __inline int trn_flood_copy(struct xdp_md *ctx, __u32 idx)
+{
+	void *data = (void *)(long)ctx->data;
+	void *data_end = (void *)(long)ctx->data_end;
+	struct ethhdr *eth = data;
+	struct iphdr *ip;
+	struct udphdr *udp;
+	struct vxlanhdr *vxlan;
+	struct flood_list_t *fl;
+	struct flood_host_t *host;
+	flood_stats_t *stats;
+	__u32 vni, n;
+
+	ip = (void *)(eth + 1);
+	udp = (void *)(ip + 1);
+	vxlan = (void *)(udp + 1);
+	if (vxlan + 1 > data_end)
+		return XDP_DROP;
+
+	vni = trn_get_vni(vxlan->vni);
+	fl = bpf_map_lookup_elem(&flood_lists_map, &vni);
+	if (!fl)
+		return XDP_DROP;
+
+	n = fl->nhosts;
+	if (fl->cap && fl->cap < n)
+		n = fl->cap;
+	if (idx >= n || idx >= TRAN_MAX_FLOOD)
+		return XDP_DROP;
+
+	host = &fl->hosts[idx];
+	if (host->ip == ip->saddr)
+		return XDP_DROP;
+
+	trn_set_src_dst_ip_csum(ip, ip->daddr, host->ip, data_end);
+	udp->check = 0;
+	trn_set_src_mac(data, eth->h_dest);
+	trn_set_dst_mac(data, host->mac);
+
+	stats = bpf_map_lookup_elem(&flood_stats_map, &vni);
+	if (stats)
+		stats->copies++;
+
+	return XDP_PASS;
+}
+
+/*
+ * Devmap egress programs can't tell the slot they run for, so slot
+ * hi * 8 + lo runs _transit_flood_<hi>_<lo>, see trn_update_flood_devmap.
+ */
+#define TRN_FLOOD_SLOT_PROG(hi, lo)					\
+	SEC("xdp_devmap/transit_flood")					\
+	int _transit_flood_##hi##_##lo(struct xdp_md *ctx)		\
+	{								\
+		return trn_flood_copy(ctx, hi * 8 + lo);		\
+	}
+
+#define TRN_FLOOD_SLOT_PROGS(hi)					\
+	TRN_FLOOD_SLOT_PROG(hi, 0)					\
+	TRN_FLOOD_SLOT_PROG(hi, 1)					\
+	TRN_FLOOD_SLOT_PROG(hi, 2)					\
+	TRN_FLOOD_SLOT_PROG(hi, 3)					\
+	TRN_FLOOD_SLOT_PROG(hi, 4)					\
+	TRN_FLOOD_SLOT_PROG(hi, 5)					\
+	TRN_FLOOD_SLOT_PROG(hi, 6)					\
+	TRN_FLOOD_SLOT_PROG(hi, 7)
+
+_Static_assert(TRAN_MAX_FLOOD == 64, "one flood program per devmap slot");
+
+TRN_FLOOD_SLOT_PROGS(0)
+TRN_FLOOD_SLOT_PROGS(1)
+TRN_FLOOD_SLOT_PROGS(2)
+TRN_FLOOD_SLOT_PROGS(3)
+TRN_FLOOD_SLOT_PROGS(4)
+TRN_FLOOD_SLOT_PROGS(5)
+TRN_FLOOD_SLOT_PROGS(6)
+TRN_FLOOD_SLOT_PROGS(7)
+
+/*
+ * Ingress of the external interface of gateway endpoints. Frames to an
+ * elastic IP are NATed to their endpoint and sent to its host in VXLAN
+ * over the tenant interface, others go to the stack. The translated flow
+ * is classified like tenant traffic toward the endpoint, external
+ * sources have no security identity.
+ */
+SEC("xdp/transit_eip")
+int _transit_eip(struct xdp_md *ctx)
+{
+	struct transit_packet pkt;
+	struct ethhdr *eth;
+	struct iphdr *ip;
+	struct udphdr *udp;
+	struct vxlanhdr *vxlan;
+	struct eip_gw_t *gw;
+	endpoint_key_t *epkey;
+	endpoint_t *ep;
+	eip_stats_t *stats;
+	ipv4_flow_t *flow = &pkt.fctx.flow;
+	contrack_key_t ctkey;
+	__u32 key = 0, ports = 0, hash;
+	__u8 side = 0, tracked = 0;
+	__u16 len;
+	__u64 csum = 0;
+	int encap = sizeof(*eth) + sizeof(*ip) + sizeof(*udp) + sizeof(*vxlan);
+
+	pkt.data = (void *)(long)ctx->data;
+	pkt.data_end = (void *)(long)ctx->data_end;
+	pkt.inner_eth = pkt.data;
+	pkt.inner_ip = (void *)(pkt.inner_eth + 1);
+	pkt.inner_tcp = NULL;
+	pkt.inner_udp = NULL;
+	if (pkt.inner_ip + 1 > pkt.data_end ||
+	    pkt.inner_eth->h_proto != bpf_htons(ETH_P_IP))
+		return XDP_PASS;
+
+	epkey = bpf_map_lookup_elem(&eip_rev_map, &pkt.inner_ip->daddr);
+	if (!epkey)
+		return XDP_PASS;
+
+	stats = bpf_map_lookup_elem(&eip_stats_map, &key);
+	gw = bpf_map_lookup_elem(&eip_gw_map, &key);
+	ep = bpf_map_lookup_elem(&endpoints_map, epkey);
+	if (!gw || !ep || pkt.inner_ip->ttl <= 1) {
+		bpf_debug("[Transit] DROP: eip 0x%x has no endpoint\n",
+			  bpf_ntohl(pkt.inner_ip->daddr));
+		goto drop;
+	}
+
+	__builtin_memset(flow, 0, sizeof(*flow));
+	if (pkt.inner_ip->protocol == IPPROTO_TCP) {
+		pkt.inner_tcp = (void *)(pkt.inner_ip + 1);
+		if (pkt.inner_tcp + 1 > pkt.data_end)
+			goto drop;
+		flow->sport = pkt.inner_tcp->source;
+		flow->dport = pkt.inner_tcp->dest;
+		ports = *(__u32 *)pkt.inner_tcp;
+	} else if (pkt.inner_ip->protocol == IPPROTO_UDP) {
+		pkt.inner_udp = (void *)(pkt.inner_ip + 1);
+		if (pkt.inner_udp + 1 > pkt.data_end)
+			goto drop;
+		flow->sport = pkt.inner_udp->source;
+		flow->dport = pkt.inner_udp->dest;
+		ports = *(__u32 *)pkt.inner_udp;
+	}
+	hash = jhash_2words(pkt.inner_ip->saddr, ports, INIT_JHASH_SEED);
+
+	pkt.xdp = ctx;
+	pkt.itf_idx = ctx->ingress_ifindex;
+	pkt.vni = epkey->vni;
+	pkt.src_identity = 0;
+	flow->saddr = pkt.inner_ip->saddr;
+	flow->daddr = epkey->ip;
+	flow->protocol = pkt.inner_ip->protocol;
+
+	if (trn_feature(TRAN_XDP_FEAT_CONNTRACK)) {
+		side = trn_ct_key(flow, flow->daddr, pkt.vni, &ctkey);
+		tracked = trn_ct_track(&pkt, &ctkey, side);
+	}
+
+	if (!tracked && trn_policy_check(&pkt, ep) != XDP_PASS) {
+		bpf_debug("[Transit] DROP: eip 0x%x denied from 0x%x\n",
+			  bpf_ntohl(pkt.inner_ip->daddr),
+			  bpf_ntohl(pkt.inner_ip->saddr));
+		goto drop;
+	}
+
+	if (trn_feature(TRAN_XDP_FEAT_CONNTRACK) && !tracked)
+		trn_ct_open(&ctkey, side);
+
+	pkt.inner_ip->ttl--;
+	trn_set_src_dst_inner_ip_csum(&pkt, pkt.inner_ip->saddr, epkey->ip);
+	trn_set_src_mac(pkt.inner_eth, gw->tunnel_mac);
+	trn_set_dst_mac(pkt.inner_eth, ep->mac);
+	len = bpf_xdp_get_buff_len(ctx);
+
+	if (bpf_xdp_adjust_head(ctx, -encap))
+		return XDP_DROP;
+
+	eth = (void *)(long)ctx->data;
+	ip = (void *)(eth + 1);
+	udp = (void *)(ip + 1);
+	vxlan = (void *)(udp + 1);
+	if (vxlan + 1 > (void *)(long)ctx->data_end)
+		return XDP_DROP;
+
+	trn_set_dst_mac(eth, ep->hmac);
+	trn_set_src_mac(eth, gw->tunnel_mac);
+	eth->h_proto = bpf_htons(ETH_P_IP);
+
+	__builtin_memset(ip, 0, sizeof(*ip));
+	ip->version = IPVERSION;
+	ip->ihl = sizeof(*ip) >> 2;
+	ip->tot_len = bpf_htons(len + encap - sizeof(*eth));
+	ip->ttl = TRN_DEFAULT_TTL;
+	ip->protocol = IPPROTO_UDP;
+	ip->saddr = gw->tunnel_ip;
+	ip->daddr = ep->hip;
+	trn_ipv4_csum_inline(ip, &csum);
+	ip->check = csum;
+
+	udp->source = bpf_htons(TRAN_UDP_SPORT_MIN | (hash & TRAN_UDP_SPORT_MASK));
+	udp->dest = VXL_DSTPORT;
+	udp->len = bpf_htons(len + sizeof(*udp) + sizeof(*vxlan));
+	udp->check = 0;
+
+	__builtin_memset(vxlan, 0, sizeof(*vxlan));
+	vxlan->i_flag = 1;
+	trn_set_vni(epkey->vni, vxlan->vni);
+
+	if (stats)
+		stats->dnat_pkts++;
+
+	return bpf_redirect_map(&interfaces_map, TRAN_ITF_MAP_TENANT, 0);
+
+drop:
+	if (stats)
+		stats->dropped++;
+	return XDP_DROP;
+}
+
 char _license[] SEC("license") = "GPL";
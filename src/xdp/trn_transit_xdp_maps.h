@@ -31,14 +31,6 @@
 
 #include "trn_datamodel.h"
 
-struct bpf_map_def SEC("maps") jmp_table = {
-	.type = BPF_MAP_TYPE_PROG_ARRAY,
-	.key_size = sizeof(__u32),
-	.value_size = sizeof(__u32),
-	.max_entries = TRAN_MAX_PROG,
-};
-BPF_ANNOTATE_KV_PAIR(jmp_table, __u32, __u32);
-
 struct bpf_map_def SEC("maps") endpoints_map = {
 	.type = BPF_MAP_TYPE_HASH,
 	.key_size = sizeof(endpoint_key_t),
@@ -48,51 +40,317 @@ struct bpf_map_def SEC("maps") endpoints_map = {
 };
 BPF_ANNOTATE_KV_PAIR(endpoints_map, endpoint_key_t, endpoint_t);
 
-#if connTrack
+/* Keys ever stored in endpoints_map, absent keys skip its probe */
+struct bpf_map_def SEC("maps") ep_bloom_map = {
+	.type = BPF_MAP_TYPE_BLOOM_FILTER,
+	.key_size = 0,
+	.value_size = sizeof(endpoint_key_t),
+	.max_entries = TRAN_MAX_NEP,
+	.map_flags = 0,
+};
+
+/* Keys the slow path could not resolve, valued by expiry time in ns */
+struct bpf_map_def SEC("maps") miss_neg_map = {
+	.type = BPF_MAP_TYPE_LRU_HASH,
+	.key_size = sizeof(endpoint_key_t),
+	.value_size = sizeof(__u64),
+	.max_entries = TRAN_MAX_MISS_NEG,
+};
+BPF_ANNOTATE_KV_PAIR(miss_neg_map, endpoint_key_t, __u64);
+
+struct bpf_map_def SEC("maps") upcall_cfg_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(upcall_cfg_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(upcall_cfg_map, __u32, upcall_cfg_t);
+
+struct bpf_map_def SEC("maps") upcall_buckets_map = {
+	.type = BPF_MAP_TYPE_LRU_PERCPU_HASH,
+	.key_size = sizeof(upcall_key_t),
+	.value_size = sizeof(rate_bucket_t),
+	.max_entries = TRAN_MAX_UPCALL_BUCKETS,
+};
+BPF_ANNOTATE_KV_PAIR(upcall_buckets_map, upcall_key_t, rate_bucket_t);
+
+struct bpf_map_def SEC("maps") upcall_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(upcall_stats_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(upcall_stats_map, __u32, upcall_stats_t);
+
+struct bpf_map_def SEC("maps") endpoints6_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(endpoint_key6_t),
+	.value_size = sizeof(endpoint_t),
+	.max_entries = TRAN_MAX_NEP,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(endpoints6_map, endpoint_key6_t, endpoint_t);
+
+/* Connections of all VNIs, the least recently used evicted per CPU */
 struct bpf_map_def SEC("maps") contrack_map = {
 	.type = BPF_MAP_TYPE_LRU_HASH,
 	.key_size = sizeof(contrack_key_t),
 	.value_size = sizeof(contrack_t),
-	.max_entries = TRAN_MAX_NEP,
-	.map_flags = 0,
+	.max_entries = TRAN_MAX_CT,
+	.map_flags = BPF_F_NO_COMMON_LRU,
 };
 BPF_ANNOTATE_KV_PAIR(contrack_map, contrack_key_t, contrack_t);
-#endif
 
-#if sgSupport
-struct bpf_map_def SEC("maps") sg_cidr_map = {
-	.type = BPF_MAP_TYPE_LPM_TRIE,
-	.key_size = sizeof(sg_cidr_key_t),
-	.value_size = sizeof(security_group_t),
-	.max_entries = TRAN_MAX_CIDRS,
+struct bpf_map_def SEC("maps") sg_vni_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct sg_vni_t),
+	.max_entries = TRAN_MAX_SG_VNI,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(sg_vni_map, __u32, struct sg_vni_t);
+
+/* Both generations of the security group classifier */
+struct bpf_map_def SEC("maps") sg_rules_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(sg_rule_key_t),
+	.value_size = sizeof(__u64),
+	.max_entries = 2 * TRAN_MAX_SG_RULES,
 	.map_flags = BPF_F_NO_PREALLOC,
 };
-BPF_ANNOTATE_KV_PAIR(sg_cidr_map, sg_cidr_key_t, security_group_t);
+BPF_ANNOTATE_KV_PAIR(sg_rules_map, sg_rule_key_t, __u64);
 
-struct bpf_map_def SEC("maps") security_group_map = {
+struct bpf_map_def SEC("maps") sg_ports_map = {
 	.type = BPF_MAP_TYPE_HASH,
-	.key_size = sizeof(security_group_key_t),
-	.value_size = sizeof(security_group_t),
-	.max_entries = TRAN_MAX_NEP,
+	.key_size = sizeof(sg_ports_key_t),
+	.value_size = sizeof(struct sg_ports_t),
+	.max_entries = 2 * TRAN_SG_DIRS * 2 * TRAN_MAX_SG_VNI,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(sg_ports_map, sg_ports_key_t, struct sg_ports_t);
+
+struct bpf_map_def SEC("maps") sg_identity_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(sg_identity_key_t),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_SG_IDENTITY_RULES,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(sg_identity_map, sg_identity_key_t, __u32);
+
+/* Flows are steered to a CPU by RSS, keep LRU lists per CPU */
+struct bpf_map_def SEC("maps") flow_cache_map = {
+	.type = BPF_MAP_TYPE_LRU_HASH,
+	.key_size = sizeof(ipv4_flow_t),
+	.value_size = sizeof(flow_cache_entry_t),
+	.max_entries = TRAN_MAX_FLOW_CACHE,
+	.map_flags = BPF_F_NO_COMMON_LRU,
+};
+BPF_ANNOTATE_KV_PAIR(flow_cache_map, ipv4_flow_t, flow_cache_entry_t);
+
+/* Bumped by transitd on endpoint/SG updates of VNIs hashed to a slot */
+struct bpf_map_def SEC("maps") flow_gen_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_FLOW_GEN_SLOTS,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(flow_gen_map, __u32, __u32);
+
+struct bpf_map_def SEC("maps") flow_cache_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(flow_cache_stats_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(flow_cache_stats_map, __u32, flow_cache_stats_t);
+
+struct bpf_map_def SEC("maps") dfts_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct dft_t),
+	.max_entries = TRAN_MAX_DFT,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(dfts_map, __u32, struct dft_t);
+
+/* Per-DFT array of chain ids, inner map fd is set by transitd */
+struct bpf_map_def SEC("maps") dft_tables_map = {
+	.type = BPF_MAP_TYPE_ARRAY_OF_MAPS,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_DFT,
 	.map_flags = 0,
 };
-BPF_ANNOTATE_KV_PAIR(security_group_map, security_group_key_t, security_group_t);
+BPF_ANNOTATE_KV_PAIR(dft_tables_map, __u32, __u32);
 
-struct bpf_map_def SEC("maps") port_range_map = {
+struct bpf_map_def SEC("maps") chains_map = {
 	.type = BPF_MAP_TYPE_HASH,
-	.key_size = sizeof(port_range_key_t),
-	.value_size = sizeof(port_range_t),
-	.max_entries = TRAN_MAX_NEP,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct chain_t),
+	.max_entries = TRAN_MAX_CHAIN,
 	.map_flags = 0,
 };
-BPF_ANNOTATE_KV_PAIR(port_range_map, port_range_key_t, port_range_t);
-#endif
+BPF_ANNOTATE_KV_PAIR(chains_map, __u32, struct chain_t);
+
+struct bpf_map_def SEC("maps") ftns_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct ftn_t),
+	.max_entries = TRAN_MAX_FTN,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(ftns_map, __u32, struct ftn_t);
+
+struct bpf_map_def SEC("maps") scaled_eps_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(endpoint_key_t),
+	.value_size = sizeof(struct scaled_ep_t),
+	.max_entries = TRAN_MAX_SCALED_EP,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(scaled_eps_map, endpoint_key_t, struct scaled_ep_t);
+
+/* Backend a flow to a VIP is pinned to */
+struct bpf_map_def SEC("maps") scaled_fwd_map = {
+	.type = BPF_MAP_TYPE_LRU_HASH,
+	.key_size = sizeof(ipv4_flow_t),
+	.value_size = sizeof(struct scaled_ep_flow_t),
+	.max_entries = TRAN_MAX_CACHE_SIZE,
+};
+BPF_ANNOTATE_KV_PAIR(scaled_fwd_map, ipv4_flow_t, struct scaled_ep_flow_t);
+
+/* VIP replies of a backend are sent from, keyed by the reply flow */
+struct bpf_map_def SEC("maps") scaled_rev_map = {
+	.type = BPF_MAP_TYPE_LRU_HASH,
+	.key_size = sizeof(ipv4_flow_t),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_CACHE_SIZE,
+};
+BPF_ANNOTATE_KV_PAIR(scaled_rev_map, ipv4_flow_t, __u32);
+
+struct bpf_map_def SEC("maps") scaled_ep_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(scaled_ep_stats_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(scaled_ep_stats_map, __u32, scaled_ep_stats_t);
+
+struct bpf_map_def SEC("maps") flood_lists_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct flood_list_t),
+	.max_entries = TRAN_MAX_FLOOD_VNI,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(flood_lists_map, __u32, struct flood_list_t);
+
+struct bpf_map_def SEC("maps") flood_stats_map = {
+	.type = BPF_MAP_TYPE_LRU_PERCPU_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(flood_stats_t),
+	.max_entries = TRAN_MAX_FLOOD_VNI,
+};
+BPF_ANNOTATE_KV_PAIR(flood_stats_map, __u32, flood_stats_t);
+
+/*
+ * Per-VNI devmap with one slot of the tenant interface per flooded host,
+ * slot idx runs the flood program of idx. Inner map fd is set by transitd
+ */
+struct bpf_map_def SEC("maps") flood_devmaps_map = {
+	.type = BPF_MAP_TYPE_HASH_OF_MAPS,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_FLOOD_VNI,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(flood_devmaps_map, __u32, __u32);
+
+/* Elastic IP of a gateway endpoint */
+struct bpf_map_def SEC("maps") eip_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(endpoint_key_t),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_EIP,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(eip_map, endpoint_key_t, __u32);
+
+/* Gateway endpoint an elastic IP is mapped to */
+struct bpf_map_def SEC("maps") eip_rev_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(endpoint_key_t),
+	.max_entries = TRAN_MAX_EIP,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(eip_rev_map, __u32, endpoint_key_t);
+
+struct bpf_map_def SEC("maps") eip_gw_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct eip_gw_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(eip_gw_map, __u32, struct eip_gw_t);
+
+/* External interface of eip_gw_map for redirect */
+struct bpf_map_def SEC("maps") eip_devmap = {
+	.type = BPF_MAP_TYPE_DEVMAP,
+	.key_size = sizeof(int),
+	.value_size = sizeof(int),
+	.max_entries = 1,
+};
+BPF_ANNOTATE_KV_PAIR(eip_devmap, int, int);
+
+struct bpf_map_def SEC("maps") eip_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(eip_stats_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(eip_stats_map, __u32, eip_stats_t);
+
+/* Policers by endpoint_key_t, ip 0 for the VNI */
+struct bpf_map_def SEC("maps") rate_limits_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(endpoint_key_t),
+	.value_size = sizeof(struct rate_limit_t),
+	.max_entries = TRAN_MAX_RATE_LIMITS,
+	.map_flags = BPF_F_NO_PREALLOC,
+};
+BPF_ANNOTATE_KV_PAIR(rate_limits_map, endpoint_key_t, struct rate_limit_t);
+
+/* Per-CPU buckets, refilled by the CPU policing so cores never contend */
+struct bpf_map_def SEC("maps") rate_buckets_map = {
+	.type = BPF_MAP_TYPE_LRU_PERCPU_HASH,
+	.key_size = sizeof(endpoint_key_t),
+	.value_size = sizeof(rate_bucket_t),
+	.max_entries = TRAN_MAX_RATE_LIMITS,
+};
+BPF_ANNOTATE_KV_PAIR(rate_buckets_map, endpoint_key_t, rate_bucket_t);
+
+struct bpf_map_def SEC("maps") rate_limit_stats_map = {
+	.type = BPF_MAP_TYPE_LRU_PERCPU_HASH,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(rate_limit_stats_t),
+	.max_entries = TRAN_MAX_RATE_LIMITS,
+};
+BPF_ANNOTATE_KV_PAIR(rate_limit_stats_map, __u32, rate_limit_stats_t);
 
 struct bpf_map_def SEC("maps") xsks_map = {
         .type = BPF_MAP_TYPE_XSKMAP,
         .key_size = sizeof(int),
         .value_size = sizeof(int),
-        .max_entries = 64, /* Assume netdev has no more than 64 queues */
+        .max_entries = XDP_ROLE_MAX * TRAN_MAX_XSK_QUEUES,
 };
 
 #if turnOn
@@ -115,6 +373,16 @@ struct bpf_map_def SEC("maps") if_config_map = {
 };
 BPF_ANNOTATE_KV_PAIR(if_config_map, __u32, struct tunnel_iface_t);
 
+/* Entrances of all droplets keyed by (ifindex, mac) */
+struct bpf_map_def SEC("maps") entrances_map = {
+	.type = BPF_MAP_TYPE_HASH,
+	.key_size = sizeof(entrance_key_t),
+	.value_size = sizeof(entrance_t),
+	.max_entries = TRAN_MAX_ITF * TRAN_MAX_ZGC_ENTRANCES,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(entrances_map, entrance_key_t, entrance_t);
+
 /* Host specific interface map used for packet redirect */
 struct bpf_map_def SEC("maps") interfaces_map = {
 	.type = BPF_MAP_TYPE_DEVMAP,
@@ -124,6 +392,50 @@ struct bpf_map_def SEC("maps") interfaces_map = {
 };
 BPF_ANNOTATE_KV_PAIR(interface_map, int, int);
 
+/* Worker CPUs tunnel flows are spread to, see trn_cpu_spread */
+struct bpf_map_def SEC("maps") cpu_map = {
+	.type = BPF_MAP_TYPE_CPUMAP,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(struct bpf_cpumap_val),
+	.max_entries = TRAN_MAX_CPUS,
+};
+
+struct bpf_map_def SEC("maps") cpus_available = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_SPREAD_CPUS,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(cpus_available, __u32, __u32);
+
+struct bpf_map_def SEC("maps") cpu_spread_cfg_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(cpu_spread_cfg_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(cpu_spread_cfg_map, __u32, cpu_spread_cfg_t);
+
+struct bpf_map_def SEC("maps") cpu_spread_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(cpu_spread_stats_t),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(cpu_spread_stats_map, __u32, cpu_spread_stats_t);
+
+struct bpf_map_def SEC("maps") stage_cfg_map = {
+	.type = BPF_MAP_TYPE_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = 1,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(stage_cfg_map, __u32, __u32);
+
 #if turnOn
 struct bpf_map_def SEC("maps") oam_queue_map = {
 	.type = BPF_MAP_TYPE_QUEUE,
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file trn_transit_xdp_stage.h
+ * @author Wei  Yue          (@w-yue)
+ *
+ * @brief Defines the stage pipeline shared by transit XDP and its stages
+ *
+ * @copyright Copyright (c) 2020-2022 The Authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#pragma once
+
+#include <linux/bpf.h>
+
+#include "extern/bpf_helpers.h"
+
+#include "trn_datamodel.h"
+#include "trn_kern.h"
+
+struct bpf_map_def SEC("maps") jmp_table = {
+	.type = BPF_MAP_TYPE_PROG_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(__u32),
+	.max_entries = TRAN_MAX_STAGE_SLOTS,
+};
+BPF_ANNOTATE_KV_PAIR(jmp_table, __u32, __u32);
+
+struct bpf_map_def SEC("maps") stage_stats_map = {
+	.type = BPF_MAP_TYPE_PERCPU_ARRAY,
+	.key_size = sizeof(__u32),
+	.value_size = sizeof(stage_stats_t),
+	.max_entries = TRAN_MAX_STAGE_SLOTS,
+	.map_flags = 0,
+};
+BPF_ANNOTATE_KV_PAIR(stage_stats_map, __u32, stage_stats_t);
+
+/*
+ * Ends a stage started at start (bpf_ktime_get_ns): accounts its run and
+ * tail calls the next stage of the pipeline. Returns action if the stage
+ * was the last one, changed the verdict or the frame has no descriptor.
+ */
+__ALWAYS_INLINE__
+static inline int trn_stage_next(struct xdp_md *ctx, __u64 start, int action)
+{
+	struct trn_xdp_meta *meta = trn_get_xdp_meta(ctx);
+	stage_stats_t *stats;
+	__u32 slot;
+
+	if (!meta)
+		return action;
+
+	slot = meta->stage;
+	stats = bpf_map_lookup_elem(&stage_stats_map, &slot);
+	if (stats) {
+		stats->runs++;
+		stats->run_ns += bpf_ktime_get_ns() - start;
+	}
+
+	if (action != meta->action || (slot + 1) % TRAN_MAX_STAGES == 0)
+		return action;
+
+	meta->stage = slot + 1;
+	bpf_tail_call(ctx, &jmp_table, slot + 1);
+	return action;
+}